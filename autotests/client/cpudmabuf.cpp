@@ -0,0 +1,176 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "cpudmabuf.h"
+#include "../../src/server/drm_fourcc.h"
+// Qt
+#include <QTemporaryFile>
+
+#include <config-kwayland.h>
+// system
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if HAVE_LINUX_UDMABUF_H
+#include <linux/udmabuf.h>
+#endif
+
+using namespace KWayland::Server;
+
+int CpuDmabufBuffer::s_liveBuffers = 0;
+
+static bool writeAll(int fd, const uchar *data, size_t size)
+{
+    size_t offset = 0;
+    while (offset < size) {
+        const ssize_t written = write(fd, data + offset, size - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        offset += written;
+    }
+    return true;
+}
+
+static int createFile()
+{
+#if HAVE_MEMFD
+    const int fd = memfd_create("kwayland-cpu-dmabuf", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd != -1) {
+        return fd;
+    }
+#endif
+    QTemporaryFile file;
+    if (!file.open()) {
+        return -1;
+    }
+    // the file is unlinked again once file goes out of scope, the duplicate keeps it alive
+    return fcntl(file.handle(), F_DUPFD_CLOEXEC, 0);
+}
+
+#if HAVE_LINUX_UDMABUF_H
+static int wrapUdmabuf(int memfd, size_t size)
+{
+    // udmabuf wants whole pages and a memfd which cannot shrink underneath it
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    const size_t alignedSize = (size + pageSize - 1) / pageSize * pageSize;
+    if (ftruncate(memfd, alignedSize) != 0 || fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK) != 0) {
+        return -1;
+    }
+    const int device = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (device == -1) {
+        return -1;
+    }
+    udmabuf_create create = {};
+    create.memfd = memfd;
+    create.flags = UDMABUF_FLAGS_CLOEXEC;
+    create.offset = 0;
+    create.size = alignedSize;
+    const int dmabuf = ioctl(device, UDMABUF_CREATE, &create);
+    close(device);
+    return dmabuf;
+}
+#endif
+
+int createCpuDmabuf(const uchar *data, size_t size)
+{
+    const int fd = createFile();
+    if (fd == -1) {
+        return -1;
+    }
+    if (!writeAll(fd, data, size)) {
+        close(fd);
+        return -1;
+    }
+#if HAVE_LINUX_UDMABUF_H
+    const int dmabuf = wrapUdmabuf(fd, size);
+    if (dmabuf != -1) {
+        close(fd);
+        return dmabuf;
+    }
+#endif
+    return fd;
+}
+
+CpuDmabufBuffer::CpuDmabufBuffer(int fd, uchar *map, size_t mapSize, uint32_t offset, uint32_t stride,
+                                 uint32_t format, const QSize &size)
+    : LinuxDmabufUnstableV1Buffer(format, size)
+    , m_fd(fd)
+    , m_map(map)
+    , m_mapSize(mapSize)
+    , m_offset(offset)
+    , m_stride(stride)
+{
+    s_liveBuffers++;
+}
+
+CpuDmabufBuffer::~CpuDmabufBuffer()
+{
+    munmap(m_map, m_mapSize);
+    close(m_fd);
+    s_liveBuffers--;
+}
+
+QImage CpuDmabufBuffer::image() const
+{
+    // DRM formats are little endian, matching QImage's 32 bit formats
+    return QImage(m_map + m_offset, size().width(), size().height(), m_stride,
+                  format() == DRM_FORMAT_ARGB8888 ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+}
+
+LinuxDmabufUnstableV1Buffer *CpuDmabufImpl::importBuffer(const QVector<LinuxDmabufUnstableV1Interface::Plane> &planes,
+                                                         uint32_t format,
+                                                         const QSize &size,
+                                                         LinuxDmabufUnstableV1Interface::Flags flags)
+{
+    Q_UNUSED(flags)
+    if (failImport || planes.count() != 1) {
+        return nullptr;
+    }
+    if (format != DRM_FORMAT_ARGB8888 && format != DRM_FORMAT_XRGB8888) {
+        return nullptr;
+    }
+    const auto &plane = planes.first();
+    if (plane.modifier != DRM_FORMAT_MOD_LINEAR && plane.modifier != DRM_FORMAT_MOD_INVALID) {
+        return nullptr;
+    }
+    if (plane.stride < uint32_t(size.width()) * 4) {
+        return nullptr;
+    }
+    const size_t mapSize = size_t(plane.offset) + size_t(plane.stride) * size.height();
+    void *map = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, plane.fd, 0);
+    if (map == MAP_FAILED) {
+        return nullptr;
+    }
+    importCount++;
+    return new CpuDmabufBuffer(plane.fd, static_cast<uchar*>(map), mapSize, plane.offset, plane.stride, format, size);
+}
+
+QHash<uint32_t, QSet<uint64_t>> CpuDmabufImpl::supportedFormats()
+{
+    return {
+        {DRM_FORMAT_ARGB8888, {DRM_FORMAT_MOD_LINEAR}},
+        {DRM_FORMAT_XRGB8888, {DRM_FORMAT_MOD_LINEAR, DRM_FORMAT_MOD_INVALID}}
+    };
+}
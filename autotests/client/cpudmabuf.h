@@ -0,0 +1,82 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWAYLAND_TEST_CPUDMABUF_H
+#define KWAYLAND_TEST_CPUDMABUF_H
+
+#include <QImage>
+
+#include "../../src/server/linuxdmabuf_v1_interface.h"
+
+/**
+ * Creates a file descriptor holding @p size bytes of @p data which can be passed
+ * as a dmabuf plane. If /dev/udmabuf is usable this is a real dmabuf wrapping a
+ * memfd, otherwise the memfd (or a temporary file) itself is returned.
+ *
+ * The caller owns the returned file descriptor, on failure -1 is returned.
+ **/
+int createCpuDmabuf(const uchar *data, size_t size);
+
+/**
+ * A linux-dmabuf buffer imported by mapping the first plane into memory.
+ **/
+class CpuDmabufBuffer : public KWayland::Server::LinuxDmabufUnstableV1Buffer
+{
+public:
+    CpuDmabufBuffer(int fd, uchar *map, size_t mapSize, uint32_t offset, uint32_t stride,
+                    uint32_t format, const QSize &size);
+    ~CpuDmabufBuffer() override;
+
+    /**
+     * The content of the buffer, only valid as long as the buffer exists.
+     **/
+    QImage image() const;
+
+    static int s_liveBuffers;
+
+private:
+    int m_fd;
+    uchar *m_map;
+    size_t m_mapSize;
+    uint32_t m_offset;
+    uint32_t m_stride;
+};
+
+/**
+ * Imports single plane ARGB8888 and XRGB8888 buffers with a linear or implicit
+ * modifier by mapping them, no GPU involved.
+ **/
+class CpuDmabufImpl : public KWayland::Server::LinuxDmabufUnstableV1Interface::Impl
+{
+public:
+    KWayland::Server::LinuxDmabufUnstableV1Buffer *importBuffer(const QVector<KWayland::Server::LinuxDmabufUnstableV1Interface::Plane> &planes,
+                                                                uint32_t format,
+                                                                const QSize &size,
+                                                                KWayland::Server::LinuxDmabufUnstableV1Interface::Flags flags) override;
+
+    /**
+     * The formats to announce through LinuxDmabufUnstableV1Interface::setSupportedFormatsWithModifiers.
+     **/
+    static QHash<uint32_t, QSet<uint64_t>> supportedFormats();
+
+    int importCount = 0;
+    bool failImport = false;
+};
+
+#endif
@@ -25,12 +25,16 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../src/client/event_queue.h"
 #include "../../src/client/datadevicemanager.h"
 #include "../../src/client/datasource.h"
+#include "../../src/client/datatransfer_p.h"
 #include "../../src/client/registry.h"
 #include "../../src/server/display.h"
 #include "../../src/server/datadevicemanager_interface.h"
 #include "../../src/server/datasource_interface.h"
 // Wayland
 #include <wayland-client.h>
+// system
+#include <fcntl.h>
+#include <unistd.h>
 
 class TestDataSource : public QObject
 {
@@ -44,6 +48,7 @@ private Q_SLOTS:
     void testTargetAccepts();
     void testRequestSend();
     void testRequestSendOnUnbound();
+    void testSendToStalledReceiver();
     void testCancel();
     void testServerGet();
     void testDestroy();
@@ -270,6 +275,38 @@ void TestDataSource::testRequestSendOnUnbound()
     sds->requestData(QStringLiteral("text/plain"), -1);
 }
 
+void TestDataSource::testSendToStalledReceiver()
+{
+    // this test verifies that sending data gives up if the receiver stops reading
+    using namespace KWayland::Client;
+    using namespace KWayland::Server;
+
+    QSignalSpy dataSourceCreatedSpy(m_dataDeviceManagerInterface, &DataDeviceManagerInterface::dataSourceCreated);
+    QVERIFY(dataSourceCreatedSpy.isValid());
+
+    QScopedPointer<DataSource> dataSource(m_dataDeviceManager->createDataSource());
+    QVERIFY(dataSource->isValid());
+    QSignalSpy dataSentSpy(dataSource.data(), &DataSource::dataSent);
+    QVERIFY(dataSentSpy.isValid());
+    // more than fits into the pipe
+    const QString plain = QStringLiteral("text/plain");
+    dataSource->setData(plain, QByteArray(1024 * 1024, 'x'));
+    QVERIFY(dataSourceCreatedSpy.wait());
+
+    int pipeFds[2];
+    QVERIFY(pipe2(pipeFds, O_CLOEXEC) == 0);
+    // takes ownership of the write end, the read end never gets read
+    dataSourceCreatedSpy.first().first().value<DataSourceInterface*>()->requestData(plain, pipeFds[1]);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(dataSentSpy.wait(DataTransfer::s_timeout * 2));
+    QVERIFY(timer.elapsed() >= DataTransfer::s_timeout / 2);
+    QCOMPARE(dataSentSpy.first().first().toString(), plain);
+    QCOMPARE(dataSentSpy.first().last().value<qint64>(), qint64(-1));
+    close(pipeFds[0]);
+}
+
 void TestDataSource::testCancel()
 {
     using namespace KWayland::Client;
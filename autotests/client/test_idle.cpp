@@ -45,6 +45,7 @@ private Q_SLOTS:
     void testServerSimulateUserActivity();
     void testIdleInhibit();
     void testIdleInhibitBlocksTimeout();
+    void testMultipleTimeouts();
 
 private:
     Display *m_display = nullptr;
@@ -285,5 +286,50 @@ void IdleTest::testIdleInhibitBlocksTimeout()
     m_display->dispatchEvents();
 }
 
+void IdleTest::testMultipleTimeouts()
+{
+    // this test verifies that timeouts with different durations expire independently
+    // and that one input event resumes all of them
+    QScopedPointer<IdleTimeout> timeout1(m_idle->getTimeout(5000, m_seat));
+    QVERIFY(timeout1->isValid());
+    QScopedPointer<IdleTimeout> timeout2(m_idle->getTimeout(6500, m_seat));
+    QVERIFY(timeout2->isValid());
+    QSignalSpy idle1Spy(timeout1.data(), &IdleTimeout::idle);
+    QVERIFY(idle1Spy.isValid());
+    QSignalSpy idle2Spy(timeout2.data(), &IdleTimeout::idle);
+    QVERIFY(idle2Spy.isValid());
+    QSignalSpy resumed1Spy(timeout1.data(), &IdleTimeout::resumeFromIdle);
+    QVERIFY(resumed1Spy.isValid());
+    QSignalSpy resumed2Spy(timeout2.data(), &IdleTimeout::resumeFromIdle);
+    QVERIFY(resumed2Spy.isValid());
+    m_connection->flush();
+
+    // activity in between moves both deadlines
+    QTest::qWait(2000);
+    m_seatInterface->setTimestamp(1);
+    QVERIFY(!idle1Spy.wait(2500));
+    QVERIFY(idle1Spy.wait());
+    QVERIFY(idle2Spy.isEmpty());
+    QVERIFY(idle2Spy.wait());
+    QCOMPARE(idle1Spy.count(), 1);
+
+    m_seatInterface->setTimestamp(2);
+    QVERIFY(resumed1Spy.wait());
+    if (resumed2Spy.isEmpty()) {
+        QVERIFY(resumed2Spy.wait());
+    }
+    QCOMPARE(resumed1Spy.count(), 1);
+    QCOMPARE(resumed2Spy.count(), 1);
+
+    // both are counting again
+    QVERIFY(idle1Spy.wait(6000));
+    QCOMPARE(idle1Spy.count(), 2);
+
+    timeout1.reset();
+    timeout2.reset();
+    m_connection->flush();
+    m_display->dispatchEvents();
+}
+
 QTEST_GUILESS_MAIN(IdleTest)
 #include "test_idle.moc"
@@ -0,0 +1,452 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/linuxdmabuf.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/buffer_interface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/drm_fourcc.h"
+#include "../../src/server/surface_interface.h"
+#include "cpudmabuf.h"
+// Wayland
+#include <wayland-client-protocol.h>
+#include <wayland-linux-dmabuf-unstable-v1-client-protocol.h>
+// system
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+Q_DECLARE_OPAQUE_POINTER(wl_buffer*)
+Q_DECLARE_METATYPE(wl_buffer*)
+
+class TestLinuxDmabuf : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TestLinuxDmabuf(QObject *parent = nullptr);
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testFormats();
+    void testFormatsChanged();
+    void testVersionWithoutMainDevice();
+    void testCreate_data();
+    void testCreate();
+    void testCreateImmediate();
+    void testImportFailed();
+    void testRelease();
+
+private:
+    int createPlane(const QImage &image);
+    KWayland::Server::SurfaceInterface *createSurface(KWayland::Client::Surface **surface);
+
+    KWayland::Server::Display *m_display = nullptr;
+    KWayland::Server::CompositorInterface *m_compositorInterface = nullptr;
+    KWayland::Server::LinuxDmabufUnstableV1Interface *m_linuxDmabufInterface = nullptr;
+    CpuDmabufImpl m_impl;
+
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::LinuxDmabuf *m_linuxDmabuf = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-linux-dmabuf-0");
+
+TestLinuxDmabuf::TestLinuxDmabuf(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void TestLinuxDmabuf::init()
+{
+    using namespace KWayland::Server;
+    using namespace KWayland::Client;
+
+    qRegisterMetaType<wl_buffer*>();
+
+    delete m_display;
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_compositorInterface = m_display->createCompositor(m_display);
+    m_compositorInterface->create();
+    QVERIFY(m_compositorInterface->isValid());
+
+    m_impl.importCount = 0;
+    m_impl.failImport = false;
+    m_linuxDmabufInterface = m_display->createLinuxDmabufInterface(m_display);
+    m_linuxDmabufInterface->setImpl(&m_impl);
+    m_linuxDmabufInterface->setSupportedFormatsWithModifiers(CpuDmabufImpl::supportedFormats());
+    // the first render node, needed for the dmabuf feedback
+    m_linuxDmabufInterface->setMainDevice(makedev(226, 128));
+    m_linuxDmabufInterface->create();
+    QVERIFY(m_linuxDmabufInterface->isValid());
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new Registry();
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+    m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+
+    const auto linuxDmabuf = m_registry->interface(Registry::Interface::LinuxDmabufUnstableV1);
+    QVERIFY(linuxDmabuf.version >= 3u);
+    m_linuxDmabuf = m_registry->createLinuxDmabuf(linuxDmabuf.name, linuxDmabuf.version, this);
+    QVERIFY(m_linuxDmabuf->isValid());
+    QCOMPARE(m_linuxDmabuf->eventQueue(), m_queue);
+    QSignalSpy formatAnnouncedSpy(m_linuxDmabuf, &LinuxDmabuf::formatAnnounced);
+    QVERIFY(formatAnnouncedSpy.isValid());
+    QVERIFY(formatAnnouncedSpy.wait());
+}
+
+void TestLinuxDmabuf::cleanup()
+{
+#define CLEANUP(variable) \
+    if (variable) { \
+        delete variable; \
+        variable = nullptr; \
+    }
+    CLEANUP(m_linuxDmabuf)
+    CLEANUP(m_compositor)
+    CLEANUP(m_queue)
+    CLEANUP(m_registry)
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_connection)
+    CLEANUP(m_display)
+#undef CLEANUP
+    // the display takes all imported buffers down with it
+    QCOMPARE(CpuDmabufBuffer::s_liveBuffers, 0);
+}
+
+int TestLinuxDmabuf::createPlane(const QImage &image)
+{
+    return createCpuDmabuf(image.constBits(), image.sizeInBytes());
+}
+
+KWayland::Server::SurfaceInterface *TestLinuxDmabuf::createSurface(KWayland::Client::Surface **surface)
+{
+    using namespace KWayland::Server;
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    if (!surfaceCreatedSpy.isValid()) {
+        return nullptr;
+    }
+    *surface = m_compositor->createSurface(this);
+    if (!surfaceCreatedSpy.wait()) {
+        return nullptr;
+    }
+    return surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+}
+
+void TestLinuxDmabuf::testFormats()
+{
+    // version 3 announces every format with its modifiers, version 4 through the format table
+    using namespace KWayland::Client;
+    QTRY_COMPARE(m_linuxDmabuf->supportedFormats().count(), 2);
+    const auto formats = m_linuxDmabuf->supportedFormats();
+    QCOMPARE(formats.value(DRM_FORMAT_ARGB8888), QVector<quint64>{DRM_FORMAT_MOD_LINEAR});
+    QCOMPARE(formats.value(DRM_FORMAT_XRGB8888).count(), 2);
+    QVERIFY(m_linuxDmabuf->isFormatSupported(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR));
+    QVERIFY(m_linuxDmabuf->isFormatSupported(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_INVALID));
+    QVERIFY(m_linuxDmabuf->isFormatSupported(DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR));
+    QVERIFY(!m_linuxDmabuf->isFormatSupported(DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_INVALID));
+    QVERIFY(!m_linuxDmabuf->isFormatSupported(DRM_FORMAT_NV12, DRM_FORMAT_MOD_LINEAR));
+}
+
+void TestLinuxDmabuf::testFormatsChanged()
+{
+    // a changed format table reaches bound clients only through the dmabuf feedback
+    using namespace KWayland::Client;
+    if (wl_proxy_get_version(reinterpret_cast<wl_proxy*>(static_cast<zwp_linux_dmabuf_v1*>(*m_linuxDmabuf))) < 4) {
+        QSKIP("The dmabuf feedback requires version 4");
+    }
+    QTRY_COMPARE(m_linuxDmabuf->supportedFormats().count(), 2);
+    QSignalSpy formatAnnouncedSpy(m_linuxDmabuf, &LinuxDmabuf::formatAnnounced);
+    QVERIFY(formatAnnouncedSpy.isValid());
+    m_linuxDmabufInterface->setSupportedFormatsWithModifiers({
+        {DRM_FORMAT_XRGB8888, {DRM_FORMAT_MOD_LINEAR}},
+        {DRM_FORMAT_NV12, {DRM_FORMAT_MOD_LINEAR}}
+    });
+    QVERIFY(formatAnnouncedSpy.wait());
+    QCOMPARE(formatAnnouncedSpy.count(), 1);
+    QCOMPARE(formatAnnouncedSpy.first().at(0).value<quint32>(), quint32(DRM_FORMAT_NV12));
+    QCOMPARE(formatAnnouncedSpy.first().at(1).value<quint64>(), quint64(DRM_FORMAT_MOD_LINEAR));
+    QCOMPARE(m_linuxDmabuf->supportedFormats().count(), 2);
+    QVERIFY(m_linuxDmabuf->isFormatSupported(DRM_FORMAT_NV12, DRM_FORMAT_MOD_LINEAR));
+    QVERIFY(m_linuxDmabuf->isFormatSupported(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR));
+    QVERIFY(!m_linuxDmabuf->isFormatSupported(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_INVALID));
+    QVERIFY(!m_linuxDmabuf->isFormatSupported(DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR));
+}
+
+void TestLinuxDmabuf::testVersionWithoutMainDevice()
+{
+    // the dmabuf feedback needs a main device, without one version 3 gets announced
+    using namespace KWayland::Client;
+    using namespace KWayland::Server;
+    QSignalSpy announcedSpy(m_registry, &Registry::linuxDmabufAnnounced);
+    QVERIFY(announcedSpy.isValid());
+    QScopedPointer<LinuxDmabufUnstableV1Interface> linuxDmabufInterface(m_display->createLinuxDmabufInterface());
+    linuxDmabufInterface->setImpl(&m_impl);
+    linuxDmabufInterface->setSupportedFormatsWithModifiers(CpuDmabufImpl::supportedFormats());
+    linuxDmabufInterface->create();
+    QVERIFY(announcedSpy.wait());
+    QCOMPARE(announcedSpy.first().last().value<quint32>(), 3u);
+
+    // setting the device afterwards does not change the announced version
+    linuxDmabufInterface->setMainDevice(makedev(226, 128));
+    QScopedPointer<LinuxDmabuf> linuxDmabuf(m_registry->createLinuxDmabuf(announcedSpy.first().first().value<quint32>(), 3));
+    QVERIFY(linuxDmabuf->isValid());
+    QTRY_COMPARE(linuxDmabuf->supportedFormats().count(), 2);
+}
+
+void TestLinuxDmabuf::testCreate_data()
+{
+    QTest::addColumn<quint32>("format");
+    QTest::addColumn<quint64>("modifier");
+    QTest::addColumn<bool>("alpha");
+
+    QTest::newRow("argb8888") << quint32(DRM_FORMAT_ARGB8888) << quint64(DRM_FORMAT_MOD_LINEAR) << true;
+    QTest::newRow("xrgb8888") << quint32(DRM_FORMAT_XRGB8888) << quint64(DRM_FORMAT_MOD_INVALID) << false;
+}
+
+void TestLinuxDmabuf::testCreate()
+{
+    // the asynchronous import: the client waits for created before using the buffer
+    using namespace KWayland::Client;
+    using namespace KWayland::Server;
+    QFETCH(quint32, format);
+    QFETCH(quint64, modifier);
+    QFETCH(bool, alpha);
+
+    QImage image(QSize(64, 32), alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    image.fill(Qt::red);
+    const int fd = createPlane(image);
+    QVERIFY(fd != -1);
+
+    QScopedPointer<LinuxDmabufParams> params(m_linuxDmabuf->createParams());
+    QVERIFY(params->isValid());
+    QSignalSpy createdSpy(params.data(), &LinuxDmabufParams::created);
+    QVERIFY(createdSpy.isValid());
+    QSignalSpy failedSpy(params.data(), &LinuxDmabufParams::failed);
+    QVERIFY(failedSpy.isValid());
+    params->addPlane(fd, 0, 0, image.bytesPerLine(), modifier);
+    params->create(image.size(), format, LinuxDmabufParams::Flag::YInverted);
+    QVERIFY(createdSpy.wait());
+    QVERIFY(failedSpy.isEmpty());
+    // the request got flushed, thus the fd got duplicated
+    close(fd);
+    QCOMPARE(m_impl.importCount, 1);
+    QCOMPARE(CpuDmabufBuffer::s_liveBuffers, 1);
+
+    wl_buffer *buffer = createdSpy.first().first().value<wl_buffer*>();
+    QVERIFY(buffer);
+
+    Surface *surface = nullptr;
+    SurfaceInterface *serverSurface = createSurface(&surface);
+    QVERIFY(serverSurface);
+    QSignalSpy damagedSpy(serverSurface, &SurfaceInterface::damaged);
+    QVERIFY(damagedSpy.isValid());
+    surface->attachBuffer(buffer);
+    surface->damage(QRect(QPoint(0, 0), image.size()));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+
+    QVERIFY(serverSurface->buffer());
+    auto dmabuf = dynamic_cast<CpuDmabufBuffer*>(serverSurface->buffer()->linuxDmabufBuffer());
+    QVERIFY(dmabuf);
+    QCOMPARE(dmabuf->format(), format);
+    QCOMPARE(dmabuf->size(), image.size());
+    QCOMPARE(dmabuf->image(), image);
+
+    delete surface;
+    wl_buffer_destroy(buffer);
+    QTRY_COMPARE(CpuDmabufBuffer::s_liveBuffers, 0);
+}
+
+void TestLinuxDmabuf::testCreateImmediate()
+{
+    // create_immed skips the roundtrip, the buffer can be used right away
+    using namespace KWayland::Client;
+    using namespace KWayland::Server;
+
+    QImage image(QSize(32, 32), QImage::Format_RGB32);
+    image.fill(Qt::blue);
+    const int fd = createPlane(image);
+    QVERIFY(fd != -1);
+
+    Surface *surface = nullptr;
+    SurfaceInterface *serverSurface = createSurface(&surface);
+    QVERIFY(serverSurface);
+    QSignalSpy damagedSpy(serverSurface, &SurfaceInterface::damaged);
+    QVERIFY(damagedSpy.isValid());
+
+    QScopedPointer<LinuxDmabufParams> params(m_linuxDmabuf->createParams());
+    params->addPlane(fd, 0, 0, image.bytesPerLine(), DRM_FORMAT_MOD_LINEAR);
+    wl_buffer *buffer = params->createImmediate(image.size(), DRM_FORMAT_XRGB8888);
+    QVERIFY(buffer);
+    params.reset();
+    surface->attachBuffer(buffer);
+    surface->damage(QRect(QPoint(0, 0), image.size()));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+    close(fd);
+
+    QCOMPARE(m_impl.importCount, 1);
+    auto dmabuf = dynamic_cast<CpuDmabufBuffer*>(serverSurface->buffer()->linuxDmabufBuffer());
+    QVERIFY(dmabuf);
+    QCOMPARE(dmabuf->image(), image);
+
+    delete surface;
+    wl_buffer_destroy(buffer);
+    QTRY_COMPARE(CpuDmabufBuffer::s_liveBuffers, 0);
+}
+
+void TestLinuxDmabuf::testImportFailed()
+{
+    // a failed import is reported to the client and the planes are closed by the server
+    using namespace KWayland::Client;
+
+    QImage image(QSize(16, 16), QImage::Format_RGB32);
+    image.fill(Qt::black);
+    const int fd = createPlane(image);
+    QVERIFY(fd != -1);
+
+    m_impl.failImport = true;
+    QScopedPointer<LinuxDmabufParams> params(m_linuxDmabuf->createParams());
+    QSignalSpy createdSpy(params.data(), &LinuxDmabufParams::created);
+    QVERIFY(createdSpy.isValid());
+    QSignalSpy failedSpy(params.data(), &LinuxDmabufParams::failed);
+    QVERIFY(failedSpy.isValid());
+    params->addPlane(fd, 0, 0, image.bytesPerLine(), DRM_FORMAT_MOD_LINEAR);
+    params->create(image.size(), DRM_FORMAT_XRGB8888);
+    QVERIFY(failedSpy.wait());
+    QVERIFY(createdSpy.isEmpty());
+    QCOMPARE(m_impl.importCount, 0);
+    QCOMPARE(CpuDmabufBuffer::s_liveBuffers, 0);
+    close(fd);
+}
+
+struct ReleaseListener
+{
+    static void release(void *data, wl_buffer *buffer)
+    {
+        Q_UNUSED(buffer)
+        reinterpret_cast<ReleaseListener*>(data)->released++;
+    }
+    int released = 0;
+};
+
+static const wl_buffer_listener s_releaseListener = {
+    ReleaseListener::release
+};
+
+void TestLinuxDmabuf::testRelease()
+{
+    // the compositor releases the buffer as soon as the surface got another one
+    using namespace KWayland::Client;
+    using namespace KWayland::Server;
+
+    QImage image(QSize(16, 16), QImage::Format_RGB32);
+    image.fill(Qt::green);
+    const int fd = createPlane(image);
+    QVERIFY(fd != -1);
+
+    QVector<wl_buffer*> buffers;
+    for (int i = 0; i < 2; ++i) {
+        QScopedPointer<LinuxDmabufParams> params(m_linuxDmabuf->createParams());
+        params->addPlane(fd, 0, 0, image.bytesPerLine(), DRM_FORMAT_MOD_LINEAR);
+        buffers << params->createImmediate(image.size(), DRM_FORMAT_XRGB8888);
+        QVERIFY(buffers.last());
+    }
+    ReleaseListener listener;
+    wl_buffer_add_listener(buffers.first(), &s_releaseListener, &listener);
+
+    Surface *surface = nullptr;
+    SurfaceInterface *serverSurface = createSurface(&surface);
+    QVERIFY(serverSurface);
+    QSignalSpy damagedSpy(serverSurface, &SurfaceInterface::damaged);
+    QVERIFY(damagedSpy.isValid());
+    surface->attachBuffer(buffers.first());
+    surface->damage(QRect(QPoint(0, 0), image.size()));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+    close(fd);
+    QCOMPARE(m_impl.importCount, 2);
+    QCOMPARE(listener.released, 0);
+
+    surface->attachBuffer(buffers.last());
+    surface->damage(QRect(QPoint(0, 0), image.size()));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+    QTRY_COMPARE(listener.released, 1);
+
+    // both buffers share the dmabuf, destroying one keeps the other imported
+    wl_buffer_destroy(buffers.first());
+    QTRY_COMPARE(CpuDmabufBuffer::s_liveBuffers, 1);
+    auto dmabuf = dynamic_cast<CpuDmabufBuffer*>(serverSurface->buffer()->linuxDmabufBuffer());
+    QVERIFY(dmabuf);
+    QCOMPARE(dmabuf->image(), image);
+
+    delete surface;
+    wl_buffer_destroy(buffers.last());
+    QTRY_COMPARE(CpuDmabufBuffer::s_liveBuffers, 0);
+}
+
+QTEST_GUILESS_MAIN(TestLinuxDmabuf)
+#include "test_linux_dmabuf.moc"
@@ -24,6 +24,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../src/client/connection_thread.h"
 #include "../../src/client/event_queue.h"
 #include "../../src/client/remote_access.h"
+#include "../../src/client/remote_frame_reader.h"
 #include "../../src/client/registry.h"
 #include "../../src/client/output.h"
 // server
@@ -52,6 +53,11 @@ private Q_SLOTS:
     void testSendReleaseCrossScreen();
     void testSendClientGone();
     void testSendReceiveClientGone();
+    void testReuseBuffer();
+    void testReuseBufferHandles();
+    void testDropFrames();
+    void testDropFramesVersion1();
+    void testFrameReader();
 
 private:
     Display *m_display = nullptr;
@@ -63,7 +69,8 @@ class MockupClient : public QObject
 {
     Q_OBJECT
 public:
-    MockupClient(QObject *parent = nullptr);
+    // a version of 0 binds the version announced by the server
+    MockupClient(QObject *parent = nullptr, quint32 version = 0);
     ~MockupClient();
 
     void bindOutput(int index);
@@ -78,7 +85,7 @@ public:
 
 static const QString s_socketName = QStringLiteral("kwayland-test-remote-access-0");
 
-MockupClient::MockupClient(QObject *parent)
+MockupClient::MockupClient(QObject *parent, quint32 version)
     : QObject(parent)
 {
     // setup connection
@@ -108,7 +115,7 @@ MockupClient::MockupClient(QObject *parent)
 
     remoteAccess = registry->createRemoteAccessManager(
                                             registry->interface(Registry::Interface::RemoteAccessManager).name,
-                                            registry->interface(Registry::Interface::RemoteAccessManager).version,
+                                            version ? version : registry->interface(Registry::Interface::RemoteAccessManager).version,
                                             this);
     QVERIFY(remoteAccess->isValid());
     connection->flush();
@@ -484,5 +491,314 @@ void RemoteAccessTest::testSendReceiveClientGone()
     QVERIFY(!m_remoteAccessInterface->isBound());
 }
 
+void RemoteAccessTest::testReuseBuffer()
+{
+    // this test verifies that a returned buffer is used again for the next frame
+    auto *client = new MockupClient(this);
+    client->bindOutput(0);
+    m_display->dispatchEvents();
+
+    QSignalSpy bufferReadySpy(client->remoteAccess, &RemoteAccessManager::bufferReady);
+    QVERIFY(bufferReadySpy.isValid());
+    QSignalSpy bufferReleasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    QVERIFY(bufferReleasedSpy.isValid());
+
+    BufferHandle *buf = new BufferHandle();
+    QTemporaryFile *tmpFile = new QTemporaryFile(this);
+    tmpFile->open();
+
+    buf->setFd(tmpFile->handle());
+    buf->setSize(50, 50);
+    buf->setFormat(100500);
+    buf->setStride(7800);
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf);
+
+    // the first frame is damaged completely
+    QVERIFY(bufferReadySpy.wait());
+    auto rbuf = const_cast<RemoteBuffer *>(bufferReadySpy.takeFirst()[1].value<const RemoteBuffer *>());
+    QSignalSpy frameReadySpy(rbuf, &RemoteBuffer::frameReady);
+    QVERIFY(frameReadySpy.isValid());
+    QVERIFY(frameReadySpy.wait());
+    QCOMPARE(rbuf->width(), 50u);
+    QCOMPARE(rbuf->damage(), QRegion(0, 0, 50, 50));
+
+    // returning the frame releases the buffer while the client keeps it
+    rbuf->done();
+    client->connection->flush();
+    QVERIFY(bufferReleasedSpy.wait());
+    QVERIFY(bufferReleasedSpy.first().first().value<const BufferHandle *>() == buf);
+    QVERIFY(rbuf->isValid());
+
+    // the next frame reuses the buffer
+    buf->setDamage(QRegion(10, 10, 5, 5));
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf);
+    QVERIFY(frameReadySpy.wait());
+    QCOMPARE(frameReadySpy.count(), 2);
+    QVERIFY(bufferReadySpy.isEmpty());
+    QCOMPARE(rbuf->damage(), QRegion(10, 10, 5, 5));
+    QCOMPARE(m_remoteAccessInterface->deliveredFrames(), quint64(2));
+
+    // releasing the buffer returns the frame as well
+    delete rbuf;
+    client->connection->flush();
+    QVERIFY(bufferReleasedSpy.wait());
+    QCOMPARE(bufferReleasedSpy.count(), 2);
+
+    // cleanup
+    delete buf;
+    delete client;
+    m_display->dispatchEvents();
+    QVERIFY(!m_remoteAccessInterface->isBound());
+}
+
+void RemoteAccessTest::testReuseBufferHandles()
+{
+    // this test verifies that a compositor passing the BufferHandles of its swapchain again gets the buffers reused
+    auto *client = new MockupClient(this);
+    client->bindOutput(0);
+    m_display->dispatchEvents();
+
+    QVector<RemoteBuffer *> remoteBuffers;
+    int frames = 0;
+    connect(client->remoteAccess, &RemoteAccessManager::bufferReady, this,
+        [this, &remoteBuffers, &frames] (const void *output, const RemoteBuffer *buffer) {
+            Q_UNUSED(output)
+            auto remoteBuffer = const_cast<RemoteBuffer *>(buffer);
+            remoteBuffers << remoteBuffer;
+            connect(remoteBuffer, &RemoteBuffer::frameReady, this,
+                [remoteBuffer, &frames] {
+                    frames++;
+                    remoteBuffer->done();
+                }
+            );
+        }
+    );
+    QSignalSpy bufferReleasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    QVERIFY(bufferReleasedSpy.isValid());
+
+    // double buffering
+    BufferHandle *swapchain[2];
+    for (int i = 0; i < 2; ++i) {
+        QTemporaryFile *tmpFile = new QTemporaryFile(this);
+        tmpFile->open();
+        swapchain[i] = new BufferHandle();
+        swapchain[i]->setFd(tmpFile->handle());
+        swapchain[i]->setSize(50, 50);
+        swapchain[i]->setFormat(100500);
+        swapchain[i]->setStride(7800);
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        BufferHandle *buf = swapchain[i % 2];
+        buf->setDamage(QRegion(i, i, 5, 5));
+        m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf);
+        QTRY_COMPARE(frames, i + 1);
+        client->connection->flush();
+        QTRY_COMPARE(bufferReleasedSpy.count(), i + 1);
+        QVERIFY(bufferReleasedSpy.last().first().value<const BufferHandle *>() == buf);
+    }
+    // one buffer per BufferHandle, not per frame
+    QCOMPARE(remoteBuffers.count(), 2);
+    QCOMPARE(m_remoteAccessInterface->deliveredFrames(), quint64(6));
+
+    // cleanup
+    qDeleteAll(remoteBuffers);
+    client->connection->flush();
+    delete swapchain[0];
+    delete swapchain[1];
+    delete client;
+    m_display->dispatchEvents();
+    QVERIFY(!m_remoteAccessInterface->isBound());
+}
+
+void RemoteAccessTest::testDropFrames()
+{
+    // this test verifies that frames are dropped for a client holding too many of them
+    QCOMPARE(m_remoteAccessInterface->maxBuffersInFlight(), 0);
+    m_remoteAccessInterface->setMaxBuffersInFlight(1);
+    QCOMPARE(m_remoteAccessInterface->maxBuffersInFlight(), 1);
+    auto *client = new MockupClient(this);
+    client->bindOutput(0);
+    m_display->dispatchEvents();
+
+    QSignalSpy bufferReadySpy(client->remoteAccess, &RemoteAccessManager::bufferReady);
+    QVERIFY(bufferReadySpy.isValid());
+    QSignalSpy bufferReleasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    QVERIFY(bufferReleasedSpy.isValid());
+
+    BufferHandle *buf1 = new BufferHandle();
+    QTemporaryFile *tmpFile1 = new QTemporaryFile(this);
+    tmpFile1->open();
+    buf1->setFd(tmpFile1->handle());
+    buf1->setSize(50, 50);
+    buf1->setFormat(100500);
+    buf1->setStride(7800);
+
+    BufferHandle *buf2 = new BufferHandle();
+    QTemporaryFile *tmpFile2 = new QTemporaryFile(this);
+    tmpFile2->open();
+    buf2->setFd(tmpFile2->handle());
+    buf2->setSize(50, 50);
+    buf2->setFormat(100500);
+    buf2->setStride(7800);
+
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf1);
+    QVERIFY(bufferReadySpy.wait());
+    auto rbuf = const_cast<RemoteBuffer *>(bufferReadySpy.takeFirst()[1].value<const RemoteBuffer *>());
+    QSignalSpy frameReadySpy(rbuf, &RemoteBuffer::frameReady);
+    QVERIFY(frameReadySpy.isValid());
+    QVERIFY(frameReadySpy.wait());
+
+    // the client still reads the first frame, the second one is dropped
+    buf2->setDamage(QRegion(0, 0, 10, 10));
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf2);
+    QCOMPARE(bufferReleasedSpy.count(), 1);
+    QVERIFY(bufferReleasedSpy.takeFirst().first().value<const BufferHandle *>() == buf2);
+    QCOMPARE(m_remoteAccessInterface->deliveredFrames(), quint64(1));
+    QCOMPARE(m_remoteAccessInterface->droppedFrames(), quint64(1));
+
+    rbuf->done();
+    client->connection->flush();
+    QVERIFY(bufferReleasedSpy.wait());
+    QVERIFY(bufferReleasedSpy.takeFirst().first().value<const BufferHandle *>() == buf1);
+
+    // the damage of the dropped frame is carried over to the next one
+    buf1->setDamage(QRegion(20, 20, 10, 10));
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf1);
+    QVERIFY(frameReadySpy.wait());
+    QVERIFY(bufferReadySpy.isEmpty());
+    QCOMPARE(rbuf->damage(), QRegion(0, 0, 10, 10) + QRegion(20, 20, 10, 10));
+    QCOMPARE(m_remoteAccessInterface->deliveredFrames(), quint64(2));
+
+    // cleanup
+    delete rbuf;
+    client->connection->flush();
+    QVERIFY(bufferReleasedSpy.wait());
+    delete buf1;
+    delete buf2;
+    delete client;
+    m_display->dispatchEvents();
+    QVERIFY(!m_remoteAccessInterface->isBound());
+}
+
+void RemoteAccessTest::testDropFramesVersion1()
+{
+    // this test verifies that clients of version 1 get every frame, they cannot return one without destroying the buffer
+    m_remoteAccessInterface->setMaxBuffersInFlight(1);
+    auto *client = new MockupClient(this, 1);
+    client->bindOutput(0);
+    m_display->dispatchEvents();
+
+    QSignalSpy bufferReadySpy(client->remoteAccess, &RemoteAccessManager::bufferReady);
+    QVERIFY(bufferReadySpy.isValid());
+    QSignalSpy bufferReleasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    QVERIFY(bufferReleasedSpy.isValid());
+
+    BufferHandle *buf1 = new BufferHandle();
+    QTemporaryFile *tmpFile1 = new QTemporaryFile(this);
+    tmpFile1->open();
+    buf1->setFd(tmpFile1->handle());
+    buf1->setSize(50, 50);
+    buf1->setFormat(100500);
+    buf1->setStride(7800);
+
+    BufferHandle *buf2 = new BufferHandle();
+    QTemporaryFile *tmpFile2 = new QTemporaryFile(this);
+    tmpFile2->open();
+    buf2->setFd(tmpFile2->handle());
+    buf2->setSize(50, 50);
+    buf2->setFormat(100500);
+    buf2->setStride(7800);
+
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf1);
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf2);
+    QVERIFY(bufferReadySpy.wait());
+    if (bufferReadySpy.count() < 2) {
+        QVERIFY(bufferReadySpy.wait());
+    }
+    QCOMPARE(bufferReadySpy.count(), 2);
+    QVERIFY(bufferReleasedSpy.isEmpty());
+    QCOMPARE(m_remoteAccessInterface->deliveredFrames(), quint64(2));
+    QCOMPARE(m_remoteAccessInterface->droppedFrames(), quint64(0));
+
+    // cleanup, destroying the buffers returns the frames
+    delete bufferReadySpy[0][1].value<const RemoteBuffer *>();
+    delete bufferReadySpy[1][1].value<const RemoteBuffer *>();
+    client->connection->flush();
+    QTRY_COMPARE(bufferReleasedSpy.count(), 2);
+    delete buf1;
+    delete buf2;
+    delete client;
+    m_display->dispatchEvents();
+    QVERIFY(!m_remoteAccessInterface->isBound());
+}
+
+void RemoteAccessTest::testFrameReader()
+{
+    // this test verifies that the frame reader maps the frames and returns them
+    auto *client = new MockupClient(this);
+    client->bindOutput(0);
+    m_display->dispatchEvents();
+
+    RemoteFrameReader reader(client->remoteAccess);
+    QSignalSpy frameReadSpy(&reader, &RemoteFrameReader::frameRead);
+    QVERIFY(frameReadSpy.isValid());
+    QImage received;
+    connect(&reader, &RemoteFrameReader::frameRead, this,
+        [&received] (const void *output, const QImage &image, const QRegion &damage) {
+            Q_UNUSED(output)
+            Q_UNUSED(damage)
+            received = image.copy();
+        }
+    );
+    QSignalSpy bufferReleasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    QVERIFY(bufferReleasedSpy.isValid());
+
+    QImage image(50, 50, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    QTemporaryFile *tmpFile = new QTemporaryFile(this);
+    QVERIFY(tmpFile->open());
+    tmpFile->write(reinterpret_cast<const char *>(image.constBits()), image.sizeInBytes());
+    tmpFile->flush();
+
+    BufferHandle *buf = new BufferHandle();
+    buf->setFd(tmpFile->handle());
+    buf->setSize(50, 50);
+    buf->setFormat(0x34325258); // DRM_FORMAT_XRGB8888
+    buf->setStride(image.bytesPerLine());
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf);
+
+    QVERIFY(frameReadSpy.wait());
+    QCOMPARE(frameReadSpy.first().at(2).value<QRegion>(), QRegion(0, 0, 50, 50));
+    QCOMPARE(received.size(), QSize(50, 50));
+    QCOMPARE(received.pixel(10, 10), QColor(Qt::red).rgb());
+    QVERIFY(bufferReleasedSpy.wait());
+
+    // the next frame arrives in the same mapping
+    image.fill(Qt::blue);
+    tmpFile->seek(0);
+    tmpFile->write(reinterpret_cast<const char *>(image.constBits()), image.sizeInBytes());
+    tmpFile->flush();
+    buf->setDamage(QRegion(0, 0, 10, 10));
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface[0], buf);
+
+    QVERIFY(frameReadSpy.wait());
+    QCOMPARE(frameReadSpy.last().at(2).value<QRegion>(), QRegion(0, 0, 10, 10));
+    QCOMPARE(received.pixel(10, 10), QColor(Qt::blue).rgb());
+    QVERIFY(bufferReleasedSpy.wait());
+    QCOMPARE(reader.framesRead(), quint64(2));
+    QVERIFY(reader.maxLatency() >= reader.averageLatency());
+    QVERIFY(reader.averageLatency() > 0);
+
+    reader.resetStatistics();
+    QCOMPARE(reader.framesRead(), quint64(0));
+
+    // cleanup
+    delete buf;
+    delete client;
+    m_display->dispatchEvents();
+    QVERIFY(!m_remoteAccessInterface->isBound());
+}
+
 QTEST_GUILESS_MAIN(RemoteAccessTest)
 #include "test_remote_access.moc"
@@ -24,7 +24,9 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../src/client/compositor.h"
 #include "../../src/client/datadevice.h"
 #include "../../src/client/datadevicemanager.h"
+#include "../../src/client/dataoffer.h"
 #include "../../src/client/datasource.h"
+#include "../../src/client/datatransfer_p.h"
 #include "../../src/client/event_queue.h"
 #include "../../src/client/keyboard.h"
 #include "../../src/client/registry.h"
@@ -35,10 +37,14 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../src/server/datadevicemanager_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/seat_interface.h"
+// system
+#include <unistd.h>
 
 using namespace KWayland::Client;
 using namespace KWayland::Server;
 
+Q_DECLARE_METATYPE(KWayland::Server::SeatInterface::ClipboardCacheMode)
+
 
 class SelectionTest : public QObject
 {
@@ -47,6 +53,11 @@ private Q_SLOTS:
     void init();
     void cleanup();
     void testClearOnEnter();
+    void testTransfer_data();
+    void testTransfer();
+    void testClipboardCache_data();
+    void testClipboardCache();
+    void testStalledSender();
 
 private:
     Display *m_display = nullptr;
@@ -268,5 +279,225 @@ void SelectionTest::testClearOnEnter()
     QVERIFY(selectionClearedClient1Spy.wait());
 }
 
+void SelectionTest::testTransfer_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("fromFile");
+    QTest::addColumn<bool>("toFile");
+
+    QTest::newRow("empty") << 0 << false << false;
+    QTest::newRow("small") << 10 << false << false;
+    QTest::newRow("large") << 4 * 1024 * 1024 << false << false;
+    QTest::newRow("large/from file") << 4 * 1024 * 1024 << true << false;
+    QTest::newRow("large/to file") << 4 * 1024 * 1024 << false << true;
+    QTest::newRow("large/from file/to file") << 4 * 1024 * 1024 << true << true;
+}
+
+void SelectionTest::testTransfer()
+{
+    // this test verifies the asynchronous transfer helpers of DataSource and DataOffer
+    QFETCH(int, size);
+    QByteArray payload(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        payload[i] = char(i % 251);
+    }
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.first().first().value<SurfaceInterface*>());
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+
+    const QString mimeType = QStringLiteral("application/octet-stream");
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    QSignalSpy sendRequestedSpy(dataSource.data(), &DataSource::sendDataRequested);
+    QVERIFY(sendRequestedSpy.isValid());
+    QSignalSpy dataSentSpy(dataSource.data(), &DataSource::dataSent);
+    QVERIFY(dataSentSpy.isValid());
+    QTemporaryFile sourceFile;
+    QFETCH(bool, fromFile);
+    if (fromFile) {
+        QVERIFY(sourceFile.open());
+        QCOMPARE(sourceFile.write(payload), qint64(size));
+        QVERIFY(sourceFile.flush());
+        QVERIFY(dataSource->setFile(mimeType, sourceFile.handle()));
+    } else {
+        dataSource->setData(mimeType, payload);
+    }
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.first().first().value<quint32>(), dataSource.data());
+
+    // pass focus to client 2
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface*>());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    auto offer = m_client2.dataDevice->offeredSelection();
+    QVERIFY(offer);
+    QCOMPARE(offer->offeredMimeTypes().count(), 1);
+    QCOMPARE(offer->offeredMimeTypes().first().name(), mimeType);
+
+    QFETCH(bool, toFile);
+    if (toFile) {
+        QTemporaryFile targetFile;
+        QVERIFY(targetFile.open());
+        QSignalSpy receivedToFileSpy(offer, &DataOffer::receivedToFile);
+        QVERIFY(receivedToFileSpy.isValid());
+        QVERIFY(offer->receiveToFile(mimeType, targetFile.handle()));
+        QVERIFY(receivedToFileSpy.wait());
+        QCOMPARE(receivedToFileSpy.first().first().toString(), mimeType);
+        QCOMPARE(receivedToFileSpy.first().last().value<qint64>(), qint64(size));
+        targetFile.seek(0);
+        QCOMPARE(targetFile.readAll(), payload);
+    } else {
+        QSignalSpy dataReceivedSpy(offer, &DataOffer::dataReceived);
+        QVERIFY(dataReceivedSpy.isValid());
+        offer->receiveData(mimeType);
+        QVERIFY(dataReceivedSpy.wait());
+        QCOMPARE(dataReceivedSpy.first().first().toString(), mimeType);
+        const QByteArray received = dataReceivedSpy.first().last().toByteArray();
+        QVERIFY(!received.isNull());
+        QCOMPARE(received, payload);
+    }
+
+    // the source served the request itself
+    if (dataSentSpy.isEmpty()) {
+        QVERIFY(dataSentSpy.wait());
+    }
+    QCOMPARE(dataSentSpy.first().first().toString(), mimeType);
+    QCOMPARE(dataSentSpy.first().last().value<qint64>(), qint64(size));
+    QVERIFY(sendRequestedSpy.isEmpty());
+}
+
+void SelectionTest::testClipboardCache_data()
+{
+    QTest::addColumn<SeatInterface::ClipboardCacheMode>("mode");
+    QTest::addColumn<int>("sendsBeforePaste");
+
+    QTest::newRow("on request") << SeatInterface::ClipboardCacheMode::OnRequest << 0;
+    QTest::newRow("eager") << SeatInterface::ClipboardCacheMode::Eager << 1;
+}
+
+void SelectionTest::testClipboardCache()
+{
+    // this test verifies that repeated pastes are served by the compositor's clipboard cache
+    QFETCH(SeatInterface::ClipboardCacheMode, mode);
+    m_seatInterface->setClipboardCacheMode(mode);
+    QCOMPARE(m_seatInterface->clipboardCacheMode(), mode);
+    m_seatInterface->setClipboardCacheMimeTypes({QStringLiteral("text/*")});
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.first().first().value<SurfaceInterface*>());
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+
+    const QByteArray text = QByteArrayLiteral("Hello World");
+    const QByteArray image(1024, 'x');
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    QSignalSpy dataSentSpy(dataSource.data(), &DataSource::dataSent);
+    QVERIFY(dataSentSpy.isValid());
+    dataSource->setData(QStringLiteral("text/plain"), text);
+    dataSource->setData(QStringLiteral("image/png"), image);
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.first().first().value<quint32>(), dataSource.data());
+
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface*>());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    auto offer = m_client2.dataDevice->offeredSelection();
+    QVERIFY(offer);
+
+    QFETCH(int, sendsBeforePaste);
+    QTRY_COMPARE(dataSentSpy.count(), sendsBeforePaste);
+    QTRY_COMPARE(m_seatInterface->clipboardCacheSize(), qint64(sendsBeforePaste ? text.size() : 0));
+
+    QSignalSpy dataReceivedSpy(offer, &DataOffer::dataReceived);
+    QVERIFY(dataReceivedSpy.isValid());
+    offer->receiveData(QStringLiteral("text/plain"));
+    QVERIFY(dataReceivedSpy.wait());
+    QCOMPARE(dataReceivedSpy.last().last().toByteArray(), text);
+    // the source sends its data only once, the paste gets served from the fetch of the cache
+    QTRY_COMPARE(m_seatInterface->clipboardCacheSize(), qint64(text.size()));
+    QTRY_COMPARE(dataSentSpy.count(), 1);
+    QCOMPARE(m_seatInterface->clipboardCacheHits(), quint64(sendsBeforePaste));
+    QCOMPARE(m_seatInterface->clipboardCacheMisses(), quint64(1 - sendsBeforePaste));
+
+    // the next paste does not reach the source
+    offer->receiveData(QStringLiteral("text/plain"));
+    QVERIFY(dataReceivedSpy.wait());
+    QCOMPARE(dataReceivedSpy.last().last().toByteArray(), text);
+    QCOMPARE(m_seatInterface->clipboardCacheHits(), quint64(sendsBeforePaste + 1));
+    QCOMPARE(m_seatInterface->clipboardCacheMisses(), quint64(1 - sendsBeforePaste));
+
+    // mime types not matching the configured ones are always forwarded
+    offer->receiveData(QStringLiteral("image/png"));
+    QVERIFY(dataReceivedSpy.wait());
+    QCOMPARE(dataReceivedSpy.last().last().toByteArray(), image);
+    QTRY_COMPARE(dataSentSpy.count(), 2);
+    QCOMPARE(m_seatInterface->clipboardCacheSize(), qint64(text.size()));
+
+    // a new selection drops the cached data
+    m_seatInterface->setSelection(nullptr);
+    QCOMPARE(m_seatInterface->clipboardCacheSize(), qint64(0));
+    m_seatInterface->resetClipboardCacheStatistics();
+    QCOMPARE(m_seatInterface->clipboardCacheHits(), quint64(0));
+    QCOMPARE(m_seatInterface->clipboardCacheMisses(), quint64(0));
+}
+
+void SelectionTest::testStalledSender()
+{
+    // this test verifies that a source which never writes its data does not block the receiver forever
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.first().first().value<SurfaceInterface*>());
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+
+    const QString mimeType = QStringLiteral("text/plain");
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    QSignalSpy sendRequestedSpy(dataSource.data(), &DataSource::sendDataRequested);
+    QVERIFY(sendRequestedSpy.isValid());
+    dataSource->offer(mimeType);
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.first().first().value<quint32>(), dataSource.data());
+
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface*>());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    auto offer = m_client2.dataDevice->offeredSelection();
+    QVERIFY(offer);
+
+    QSignalSpy dataReceivedSpy(offer, &DataOffer::dataReceived);
+    QVERIFY(dataReceivedSpy.isValid());
+    offer->receiveData(mimeType);
+    QVERIFY(sendRequestedSpy.wait());
+    // the source keeps the pipe open without writing into it
+    const qint32 fd = sendRequestedSpy.first().last().value<qint32>();
+    QVERIFY(fd != -1);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(dataReceivedSpy.wait(DataTransfer::s_timeout * 2));
+    QVERIFY(timer.elapsed() >= DataTransfer::s_timeout / 2);
+    QCOMPARE(dataReceivedSpy.first().first().toString(), mimeType);
+    QVERIFY(dataReceivedSpy.first().last().toByteArray().isNull());
+    close(fd);
+}
+
 QTEST_GUILESS_MAIN(SelectionTest)
 #include "test_selection.moc"
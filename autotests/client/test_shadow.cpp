@@ -46,6 +46,8 @@ private Q_SLOTS:
     void testCreateShadow();
     void testShadowElements();
     void testSurfaceDestroy();
+    void testTileCache();
+    void testClientTileCache();
 
 private:
     Display *m_display = nullptr;
@@ -301,5 +303,182 @@ void ShadowTest::testSurfaceDestroy()
     QCOMPARE(shadowDestroyedSpy.count(), 1);
 }
 
+void ShadowTest::testTileCache()
+{
+    // this test verifies that identical tiles of different shadows share one cache entry
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface1(m_compositor->createSurface());
+    QScopedPointer<Surface> surface2(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    if (surfaceCreatedSpy.count() < 2) {
+        QVERIFY(surfaceCreatedSpy.wait());
+    }
+    auto serverSurface1 = surfaceCreatedSpy.at(0).first().value<SurfaceInterface*>();
+    auto serverSurface2 = surfaceCreatedSpy.at(1).first().value<SurfaceInterface*>();
+    QSignalSpy shadowChangedSpy1(serverSurface1, &SurfaceInterface::shadowChanged);
+    QVERIFY(shadowChangedSpy1.isValid());
+    QSignalSpy shadowChangedSpy2(serverSurface2, &SurfaceInterface::shadowChanged);
+    QVERIFY(shadowChangedSpy2.isValid());
+
+    QImage cornerImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    cornerImage.fill(Qt::red);
+    QImage edgeImage(QSize(1, 10), QImage::Format_ARGB32_Premultiplied);
+    edgeImage.fill(Qt::blue);
+
+    // both shadows attach their own buffers with the same content
+    QScopedPointer<Shadow> shadow1(m_shadow->createShadow(surface1.data()));
+    shadow1->attachTopLeft(m_shm->createBuffer(cornerImage));
+    shadow1->attachTopRight(m_shm->createBuffer(cornerImage));
+    shadow1->attachLeft(m_shm->createBuffer(edgeImage));
+    shadow1->commit();
+    surface1->commit(Surface::CommitFlag::None);
+    QScopedPointer<Shadow> shadow2(m_shadow->createShadow(surface2.data()));
+    shadow2->attachTopLeft(m_shm->createBuffer(cornerImage));
+    shadow2->attachLeft(m_shm->createBuffer(edgeImage));
+    shadow2->commit();
+    surface2->commit(Surface::CommitFlag::None);
+    QVERIFY(shadowChangedSpy2.wait());
+    if (shadowChangedSpy1.isEmpty()) {
+        QVERIFY(shadowChangedSpy1.wait());
+    }
+    auto serverShadow1 = serverSurface1->shadow();
+    auto serverShadow2 = serverSurface2->shadow();
+    QVERIFY(serverShadow1);
+    QVERIFY(serverShadow2);
+
+    // nothing gets hashed before it is needed
+    QCOMPARE(m_shadowInterface->cachedTileCount(), 0);
+    QCOMPARE(serverShadow1->tileKey(ShadowInterface::Tile::Top), quint64(0));
+    QVERIFY(serverShadow1->tileImage(ShadowInterface::Tile::Top).isNull());
+
+    const quint64 cornerKey = serverShadow1->tileKey(ShadowInterface::Tile::TopLeft);
+    QVERIFY(cornerKey != 0);
+    QCOMPARE(serverShadow1->tileKey(ShadowInterface::Tile::TopRight), cornerKey);
+    QCOMPARE(serverShadow2->tileKey(ShadowInterface::Tile::TopLeft), cornerKey);
+    const quint64 edgeKey = serverShadow2->tileKey(ShadowInterface::Tile::Left);
+    QVERIFY(edgeKey != 0);
+    QVERIFY(edgeKey != cornerKey);
+    QCOMPARE(serverShadow1->tileKey(ShadowInterface::Tile::Left), edgeKey);
+    QCOMPARE(m_shadowInterface->cachedTileCount(), 2);
+    QCOMPARE(m_shadowInterface->cachedTileBytes(), qint64(cornerImage.sizeInBytes() + edgeImage.sizeInBytes()));
+    QCOMPARE(serverShadow1->tileImage(ShadowInterface::Tile::TopLeft), cornerImage);
+    QCOMPARE(serverShadow2->tileImage(ShadowInterface::Tile::Left), edgeImage);
+
+    // changing a tile to new content adds an entry
+    QImage otherImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    otherImage.fill(Qt::green);
+    shadow2->attachTopLeft(m_shm->createBuffer(otherImage));
+    shadow2->commit();
+    surface2->commit(Surface::CommitFlag::None);
+    QVERIFY(shadowChangedSpy2.wait());
+    QVERIFY(serverShadow2->tileKey(ShadowInterface::Tile::TopLeft) != cornerKey);
+    QCOMPARE(serverShadow2->tileImage(ShadowInterface::Tile::TopLeft), otherImage);
+    QCOMPARE(m_shadowInterface->cachedTileCount(), 3);
+
+    // destroying the shadows releases all entries
+    QSignalSpy shadowDestroyedSpy1(serverShadow1.data(), &QObject::destroyed);
+    QVERIFY(shadowDestroyedSpy1.isValid());
+    QSignalSpy shadowDestroyedSpy2(serverShadow2.data(), &QObject::destroyed);
+    QVERIFY(shadowDestroyedSpy2.isValid());
+    shadow1.reset();
+    shadow2.reset();
+    QVERIFY(shadowDestroyedSpy2.wait());
+    if (shadowDestroyedSpy1.isEmpty()) {
+        QVERIFY(shadowDestroyedSpy1.wait());
+    }
+    QCOMPARE(m_shadowInterface->cachedTileCount(), 0);
+    QCOMPARE(m_shadowInterface->cachedTileBytes(), qint64(0));
+}
+
+void ShadowTest::testClientTileCache()
+{
+    // this test verifies that shadows attaching the same images share the Buffers
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface1(m_compositor->createSurface());
+    QScopedPointer<Surface> surface2(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    if (surfaceCreatedSpy.count() < 2) {
+        QVERIFY(surfaceCreatedSpy.wait());
+    }
+    auto serverSurface1 = surfaceCreatedSpy.at(0).first().value<SurfaceInterface*>();
+    auto serverSurface2 = surfaceCreatedSpy.at(1).first().value<SurfaceInterface*>();
+    QSignalSpy shadowChangedSpy1(serverSurface1, &SurfaceInterface::shadowChanged);
+    QVERIFY(shadowChangedSpy1.isValid());
+    QSignalSpy shadowChangedSpy2(serverSurface2, &SurfaceInterface::shadowChanged);
+    QVERIFY(shadowChangedSpy2.isValid());
+
+    // there is one cache per pool
+    ShadowTileCache *cache = ShadowTileCache::forPool(m_shm);
+    QVERIFY(cache);
+    QCOMPARE(ShadowTileCache::forPool(m_shm), cache);
+    QCOMPARE(cache->pool(), m_shm);
+    QCOMPARE(cache->count(), 0);
+
+    QImage cornerImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    cornerImage.fill(Qt::red);
+    QImage edgeImage(QSize(1, 10), QImage::Format_ARGB32_Premultiplied);
+    edgeImage.fill(Qt::blue);
+
+    QScopedPointer<Shadow> shadow1(m_shadow->createShadow(surface1.data()));
+    shadow1->setTileCache(cache);
+    QCOMPARE(shadow1->tileCache(), cache);
+    shadow1->attachTopLeft(cornerImage);
+    shadow1->attachLeft(edgeImage);
+    shadow1->commit();
+    surface1->commit(Surface::CommitFlag::None);
+    QScopedPointer<Shadow> shadow2(m_shadow->createShadow(surface2.data()));
+    shadow2->setTileCache(cache);
+    shadow2->attachTopLeft(cornerImage);
+    shadow2->attachLeft(edgeImage);
+    shadow2->commit();
+    surface2->commit(Surface::CommitFlag::None);
+
+    // only one Buffer per distinct image got created
+    QCOMPARE(cache->count(), 2);
+    QCOMPARE(cache->bytes(), qint64(cornerImage.sizeInBytes() + edgeImage.sizeInBytes()));
+
+    QVERIFY(shadowChangedSpy2.wait());
+    if (shadowChangedSpy1.isEmpty()) {
+        QVERIFY(shadowChangedSpy1.wait());
+    }
+    auto serverShadow1 = serverSurface1->shadow();
+    auto serverShadow2 = serverSurface2->shadow();
+    QVERIFY(serverShadow1);
+    QVERIFY(serverShadow2);
+    QCOMPARE(serverShadow1->topLeft(), serverShadow2->topLeft());
+    QCOMPARE(serverShadow1->left(), serverShadow2->left());
+    QCOMPARE(serverShadow1->topLeft()->data(), cornerImage);
+    QCOMPARE(serverShadow2->left()->data(), edgeImage);
+
+    // acquiring the same content again hands out the shared Buffer
+    Buffer::Ptr buffer = cache->acquire(cornerImage);
+    QVERIFY(buffer.toStrongRef()->isUsed());
+    QCOMPARE(cache->count(), 2);
+    cache->release(buffer);
+    QVERIFY(buffer.toStrongRef()->isUsed());
+
+    // replacing a tile releases the reference on the previous one
+    QImage otherImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    otherImage.fill(Qt::green);
+    shadow1->attachTopLeft(otherImage);
+    QCOMPARE(cache->count(), 3);
+    shadow2->attachTopLeft(m_shm->createBuffer(otherImage));
+    QCOMPARE(cache->count(), 2);
+    QVERIFY(!buffer.toStrongRef()->isUsed());
+    shadow1->commit();
+    surface1->commit(Surface::CommitFlag::None);
+    QVERIFY(shadowChangedSpy1.wait());
+    QCOMPARE(serverShadow1->topLeft()->data(), otherImage);
+
+    // destroying the shadows releases all references
+    shadow1.reset();
+    QCOMPARE(cache->count(), 1);
+    shadow2.reset();
+    QCOMPARE(cache->count(), 0);
+    QCOMPARE(cache->bytes(), qint64(0));
+}
+
 QTEST_GUILESS_MAIN(ShadowTest)
 #include "test_shadow.moc"
@@ -45,6 +45,7 @@ private Q_SLOTS:
 
     void testCreate();
     void testSurfaceDestroy();
+    void testRegion();
 
 private:
     KWayland::Server::Display *m_display;
@@ -211,5 +212,75 @@ void TestBlur::testSurfaceDestroy()
     QVERIFY(blurDestroyedSpy.wait());
 }
 
+void TestBlur::testRegion()
+{
+    // this test verifies the region metadata and that unchanged regions are not announced
+    using namespace KWayland::Server;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+
+    auto serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    QSignalSpy blurChanged(serverSurface, &SurfaceInterface::blurChanged);
+    QVERIFY(blurChanged.isValid());
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    const QRegion region = QRegion(0, 0, 10, 20) + QRegion(20, 0, 10, 20);
+    QScopedPointer<KWayland::Client::Blur> blur(m_blurManager->createBlur(surface.data()));
+    blur->setRegion(m_compositor->createRegion(region, nullptr));
+    blur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(blurChanged.wait());
+
+    auto serverBlur = serverSurface->blur();
+    QVERIFY(serverBlur);
+    QCOMPARE(serverBlur->region(), region);
+    QCOMPARE(serverBlur->boundingRect(), QRect(0, 0, 30, 20));
+    QCOMPARE(serverBlur->rectCount(), 2);
+    QCOMPARE(serverBlur->damagedRegion(QRegion(5, 5, 20, 5)), QRegion(5, 5, 5, 5) + QRegion(20, 5, 5, 5));
+    QVERIFY(serverBlur->damagedRegion(QRegion(0, 30, 10, 10)).isEmpty());
+    QVERIFY(serverBlur->damagedRegion(QRegion(12, 0, 6, 20)).isEmpty());
+
+    // committing the same region again does not announce a change
+    QSignalSpy regionChangedSpy(serverBlur.data(), &BlurInterface::regionChanged);
+    QVERIFY(regionChangedSpy.isValid());
+    blur->setRegion(m_compositor->createRegion(region, nullptr));
+    blur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(regionChangedSpy.isEmpty());
+
+    // neither does replacing the blur with one for the same region
+    QScopedPointer<KWayland::Client::Blur> blur2(m_blurManager->createBlur(surface.data()));
+    blur2->setRegion(m_compositor->createRegion(region, nullptr));
+    blur2->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(blurChanged.count(), 1);
+    QVERIFY(serverSurface->blur() != serverBlur);
+    QCOMPARE(serverSurface->blur()->region(), region);
+
+    // a different region is announced
+    QSignalSpy regionChangedSpy2(serverSurface->blur().data(), &BlurInterface::regionChanged);
+    QVERIFY(regionChangedSpy2.isValid());
+    blur2->setRegion(m_compositor->createRegion(QRegion(0, 0, 10, 10), nullptr));
+    blur2->commit();
+    QVERIFY(regionChangedSpy2.wait());
+    QCOMPARE(serverSurface->blur()->boundingRect(), QRect(0, 0, 10, 10));
+    QCOMPARE(serverSurface->blur()->rectCount(), 1);
+    QCOMPARE(serverSurface->blur()->damagedRegion(QRegion(5, 5, 10, 10)), QRegion(5, 5, 5, 5));
+
+    // a new blur with a different region changes the blur of the surface
+    QScopedPointer<KWayland::Client::Blur> blur3(m_blurManager->createBlur(surface.data()));
+    blur3->setRegion(m_compositor->createRegion(region, nullptr));
+    blur3->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(blurChanged.wait());
+    QCOMPARE(serverSurface->blur()->region(), region);
+}
+
 QTEST_GUILESS_MAIN(TestBlur)
 #include "test_wayland_blur.moc"
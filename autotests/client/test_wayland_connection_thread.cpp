@@ -46,6 +46,7 @@ private Q_SLOTS:
     void testConnectionThread();
     void testConnectFd();
     void testConnectFdNoSocketName();
+    void testStatistics();
 
 private:
     KWayland::Server::Display *m_display;
@@ -297,5 +298,96 @@ void TestWaylandConnectionThread::testConnectFdNoSocketName()
     delete connectionThread;
 }
 
+void TestWaylandConnectionThread::testStatistics()
+{
+    using namespace KWayland::Client;
+    using namespace KWayland::Server;
+    QVERIFY(!m_display->isStatisticsEnabled());
+    m_display->setStatisticsEnabled(true);
+    QVERIFY(m_display->isStatisticsEnabled());
+    QVERIFY(m_display->statistics().clients.isEmpty());
+
+    ConnectionThread *connection = new ConnectionThread;
+    QSignalSpy connectedSpy(connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    connection->setSocketName(s_socketName);
+
+    QThread *connectionThread = new QThread(this);
+    connection->moveToThread(connectionThread);
+    connectionThread->start();
+    connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    QScopedPointer<Registry> registry(new Registry);
+    QSignalSpy announcedSpy(registry.data(), &Registry::interfacesAnnounced);
+    QVERIFY(announcedSpy.isValid());
+    registry->create(connection);
+    QScopedPointer<EventQueue> queue(new EventQueue);
+    queue->setup(connection);
+    registry->setEventQueue(queue.data());
+    registry->setup();
+    QVERIFY(announcedSpy.wait());
+
+    auto findMessage = [] (const Display::ClientStatistics &client, const QByteArray &interface, const QByteArray &message) {
+        auto it = std::find_if(client.messages.constBegin(), client.messages.constEnd(),
+            [&interface, &message] (const Display::MessageStatistics &m) {
+                return m.interface == interface && m.message == message;
+            }
+        );
+        return it == client.messages.constEnd() ? Display::MessageStatistics() : *it;
+    };
+    auto statistics = m_display->statistics();
+    QCOMPARE(statistics.clients.count(), 1);
+    auto client = statistics.clients.first();
+    QCOMPARE(client.processId, getpid());
+
+    // the registry got created and a roundtrip announced the shm global
+    const auto getRegistry = findMessage(client, QByteArrayLiteral("wl_display"), QByteArrayLiteral("get_registry"));
+    QCOMPARE(getRegistry.count, quint64(1));
+    QVERIFY(!getRegistry.event);
+    QCOMPARE(getRegistry.opcode, 1u);
+    QCOMPARE(getRegistry.bytes, quint64(12));
+    const auto global = findMessage(client, QByteArrayLiteral("wl_registry"), QByteArrayLiteral("global"));
+    QCOMPARE(global.count, quint64(1));
+    QVERIFY(global.event);
+    QCOMPARE(global.bytes, quint64(28));
+    QCOMPARE(global.handlerTime, qint64(0));
+    const auto sync = findMessage(client, QByteArrayLiteral("wl_display"), QByteArrayLiteral("sync"));
+    QVERIFY(sync.count > 0);
+    const auto done = findMessage(client, QByteArrayLiteral("wl_callback"), QByteArrayLiteral("done"));
+    QCOMPARE(done.count, sync.count);
+
+    quint64 requests = 0;
+    quint64 events = 0;
+    for (const auto &message : client.messages) {
+        if (message.event) {
+            events += message.count;
+        } else {
+            requests += message.count;
+        }
+    }
+    QCOMPARE(client.requests, requests);
+    QCOMPARE(client.events, events);
+    QVERIFY(statistics.flushes > 0);
+
+    m_display->resetStatistics();
+    statistics = m_display->statistics();
+    QCOMPARE(statistics.flushes, quint64(0));
+    QCOMPARE(statistics.clients.count(), 1);
+    QCOMPARE(statistics.clients.first().requests, quint64(0));
+    QVERIFY(statistics.clients.first().messages.isEmpty());
+
+    // disabling discards the counters
+    m_display->setStatisticsEnabled(false);
+    QVERIFY(m_display->statistics().clients.isEmpty());
+
+    registry.reset();
+    queue.reset();
+    connection->deleteLater();
+    connectionThread->quit();
+    connectionThread->wait();
+    delete connectionThread;
+}
+
 QTEST_GUILESS_MAIN(TestWaylandConnectionThread)
 #include "test_wayland_connection_thread.moc"
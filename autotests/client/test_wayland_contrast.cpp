@@ -48,6 +48,7 @@ private Q_SLOTS:
 
     void testCreate();
     void testSurfaceDestroy();
+    void testUnchanged();
 
 private:
     KWayland::Server::Display *m_display;
@@ -221,5 +222,68 @@ void TestContrast::testSurfaceDestroy()
     QVERIFY(contrastDestroyedSpy.wait());
 }
 
+void TestContrast::testUnchanged()
+{
+    // this test verifies that committing the same contrast again is not announced
+    using namespace KWayland::Server;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+
+    auto serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    QSignalSpy contrastChanged(serverSurface, &SurfaceInterface::contrastChanged);
+    QVERIFY(contrastChanged.isValid());
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    const QRegion region = QRegion(0, 0, 10, 20) + QRegion(20, 0, 10, 20);
+    QScopedPointer<KWayland::Client::Contrast> contrast(m_contrastManager->createContrast(surface.data()));
+    contrast->setRegion(m_compositor->createRegion(region, nullptr));
+    contrast->setContrast(0.2);
+    contrast->setIntensity(2.0);
+    contrast->setSaturation(1.7);
+    contrast->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(contrastChanged.wait());
+
+    auto serverContrast = serverSurface->contrast();
+    QVERIFY(serverContrast);
+    QCOMPARE(serverContrast->boundingRect(), QRect(0, 0, 30, 20));
+    QCOMPARE(serverContrast->rectCount(), 2);
+    QCOMPARE(serverContrast->damagedRegion(QRegion(5, 5, 20, 5)), QRegion(5, 5, 5, 5) + QRegion(20, 5, 5, 5));
+
+    // the same values again are no change
+    QSignalSpy changedSpy(serverContrast.data(), &ContrastInterface::changed);
+    QVERIFY(changedSpy.isValid());
+    contrast->setRegion(m_compositor->createRegion(region, nullptr));
+    contrast->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(changedSpy.isEmpty());
+
+    // a replacement with the same values is not announced either
+    QScopedPointer<KWayland::Client::Contrast> contrast2(m_contrastManager->createContrast(surface.data()));
+    contrast2->setRegion(m_compositor->createRegion(region, nullptr));
+    contrast2->setContrast(0.2);
+    contrast2->setIntensity(2.0);
+    contrast2->setSaturation(1.7);
+    contrast2->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(contrastChanged.count(), 1);
+    QVERIFY(serverSurface->contrast() != serverContrast);
+
+    // but changing a value is
+    QSignalSpy changedSpy2(serverSurface->contrast().data(), &ContrastInterface::changed);
+    QVERIFY(changedSpy2.isValid());
+    contrast2->setIntensity(1.0);
+    contrast2->commit();
+    QVERIFY(changedSpy2.wait());
+    QCOMPARE(wl_fixed_from_double(serverSurface->contrast()->intensity()), wl_fixed_from_double(1.0));
+    QCOMPARE(serverSurface->contrast()->rectCount(), 2);
+}
+
 QTEST_GUILESS_MAIN(TestContrast)
 #include "test_wayland_contrast.moc"
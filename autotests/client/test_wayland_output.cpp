@@ -43,6 +43,7 @@ private Q_SLOTS:
     void testRegistry();
     void testModeChanges();
     void testScaleChange();
+    void testBatchedChange();
 
     void testSubPixel_data();
     void testSubPixel();
@@ -354,6 +355,60 @@ void TestWaylandOutput::testScaleChange()
     QCOMPARE(output.scale(), 4);
 }
 
+void TestWaylandOutput::testBatchedChange()
+{
+    using namespace KWayland::Server;
+    KWayland::Client::Registry registry;
+    QSignalSpy announced(&registry, SIGNAL(outputAnnounced(quint32,quint32)));
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    wl_display_flush(m_connection->display());
+    QVERIFY(announced.wait());
+
+    KWayland::Client::Output output;
+    QSignalSpy outputChanged(&output, SIGNAL(changed()));
+    QVERIFY(outputChanged.isValid());
+    output.setup(registry.bindOutput(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    wl_display_flush(m_connection->display());
+    QVERIFY(outputChanged.wait());
+
+    // a batch only notifies the client once all changes are committed
+    outputChanged.clear();
+    QSignalSpy serverScaleChanged(m_serverOutput, &OutputInterface::scaleChanged);
+    QVERIFY(serverScaleChanged.isValid());
+    m_serverOutput->beginChange();
+    m_serverOutput->setGlobalPosition(QPoint(1920, 0));
+    m_serverOutput->setManufacturer(QStringLiteral("KDE"));
+    m_serverOutput->beginChange();
+    m_serverOutput->setModel(QStringLiteral("Plasma Display"));
+    m_serverOutput->setScale(2);
+    m_serverOutput->setCurrentMode(QSize(1280, 1024), 90000);
+    m_serverOutput->commitChange();
+    // the server side state and signals are not deferred
+    QCOMPARE(serverScaleChanged.count(), 1);
+    QCOMPARE(m_serverOutput->scale(), 2);
+    QVERIFY(!outputChanged.wait(100));
+    m_serverOutput->commitChange();
+
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(output.globalPosition(), QPoint(1920, 0));
+    QCOMPARE(output.manufacturer(), QStringLiteral("KDE"));
+    QCOMPARE(output.model(), QStringLiteral("Plasma Display"));
+    QCOMPARE(output.scale(), 2);
+    QCOMPARE(output.pixelSize(), QSize(1280, 1024));
+    QCOMPARE(output.refreshRate(), 90000);
+    // all changes are terminated by a single done
+    QVERIFY(!outputChanged.wait(100));
+    QCOMPARE(outputChanged.count(), 1);
+
+    // an empty batch does not send anything
+    m_serverOutput->beginChange();
+    m_serverOutput->commitChange();
+    QVERIFY(!outputChanged.wait(100));
+    QCOMPARE(outputChanged.count(), 1);
+}
+
 void TestWaylandOutput::testSubPixel_data()
 {
     using namespace KWayland::Client;
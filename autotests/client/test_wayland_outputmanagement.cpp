@@ -60,6 +60,10 @@ private Q_SLOTS:
     void testExampleConfig();
     void testScale();
 
+    void testTest();
+    void testValidation();
+    void testApplyChanges();
+
     void testRemoval();
 
 private:
@@ -547,6 +551,200 @@ void TestWaylandOutputManagement::testScale()
 #endif
 }
 
+void TestWaylandOutputManagement::testTest()
+{
+    // a dry run is answered by the server without involving the compositor
+    createConfig();
+    auto config = m_outputConfiguration;
+    KWayland::Client::OutputDevice *output = m_clientOutputs.first();
+
+    QSignalSpy serverApplySpy(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested);
+    QVERIFY(serverApplySpy.isValid());
+    QSignalSpy testPassedSpy(config, &OutputConfiguration::testPassed);
+    QVERIFY(testPassedSpy.isValid());
+    QSignalSpy testFailedSpy(config, &OutputConfiguration::testFailed);
+    QVERIFY(testFailedSpy.isValid());
+    QSignalSpy outputChangedSpy(output, &KWayland::Client::OutputDevice::changed);
+    QVERIFY(outputChangedSpy.isValid());
+
+    config->setMode(output, m_modes.last().id);
+    config->setScaleF(output, 2.0);
+    config->test();
+    QVERIFY(testPassedSpy.wait());
+    QCOMPARE(testFailedSpy.count(), 0);
+
+    // the pending changes are kept and can be adjusted
+    config->setScaleF(output, 8.0);
+    config->test();
+    QVERIFY(testFailedSpy.wait());
+    QCOMPARE(testPassedSpy.count(), 1);
+
+    config->setScaleF(output, 1.5);
+    config->test();
+    QVERIFY(testPassedSpy.wait());
+    QCOMPARE(testPassedSpy.count(), 2);
+
+    config->setEnabled(output, OutputDevice::Enablement::Disabled);
+    config->test();
+    QVERIFY(testFailedSpy.wait());
+    QCOMPARE(testFailedSpy.count(), 2);
+
+    QCOMPARE(serverApplySpy.count(), 0);
+    QCOMPARE(outputChangedSpy.count(), 0);
+    QCOMPARE(m_serverOutputs.first()->currentModeId(), 1);
+}
+
+void TestWaylandOutputManagement::testValidation()
+{
+    // a second output to the right of the existing one
+    auto serverOutput = m_serverOutputs.first();
+    auto secondOutput = m_display->createOutputDevice(this);
+    OutputDeviceInterface::Mode mode;
+    mode.id = 0;
+    mode.size = QSize(1024, 768);
+    mode.flags = OutputDeviceInterface::ModeFlags(OutputDeviceInterface::ModeFlag::Current);
+    secondOutput->addMode(mode);
+    secondOutput->setGlobalPosition(QPoint(1024, 1920));
+    secondOutput->create();
+
+    createConfig();
+    auto config = m_outputConfiguration;
+    KWayland::Client::OutputDevice *output = m_clientOutputs.first();
+
+    OutputConfigurationInterface *configurationInterface = nullptr;
+    connect(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested,
+        [&configurationInterface] (OutputConfigurationInterface *c) {
+            configurationInterface = c;
+        }
+    );
+    QSignalSpy serverApplySpy(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested);
+    QVERIFY(serverApplySpy.isValid());
+    config->apply();
+    QVERIFY(serverApplySpy.wait());
+    QVERIFY(configurationInterface);
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::Valid);
+
+    QSignalSpy testFailedSpy(config, &OutputConfiguration::testFailed);
+    QVERIFY(testFailedSpy.isValid());
+    QSignalSpy testPassedSpy(config, &OutputConfiguration::testPassed);
+    QVERIFY(testPassedSpy.isValid());
+    auto testConfig = [&] {
+        const int responses = testFailedSpy.count() + testPassedSpy.count();
+        config->test();
+        QTRY_COMPARE(testFailedSpy.count() + testPassedSpy.count(), responses + 1);
+    };
+
+    // overlapping
+    config->setPosition(output, QPoint(512, 1920));
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::OverlappingOutputs);
+
+    // leaving a gap
+    config->setPosition(output, QPoint(0, 0));
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::DisconnectedOutputs);
+
+    // the rotated output is narrower
+    config->setPosition(output, QPoint(256, 1920));
+    config->setTransform(output, OutputDevice::Transform::Rotated90);
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::Valid);
+    QCOMPARE(testPassedSpy.count(), 1);
+    config->setPosition(output, QPoint(512, 1920));
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::OverlappingOutputs);
+
+    // scaling it down closes the overlap again
+    config->setTransform(output, OutputDevice::Transform::Normal);
+    config->setScaleF(output, 2.0);
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::Valid);
+    QCOMPARE(testPassedSpy.count(), 2);
+
+    // a clone of the second output at the same position with the same size
+    config->setScaleF(output, 1.0);
+    config->setPosition(output, QPoint(1024, 1920));
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::Valid);
+    QCOMPARE(testPassedSpy.count(), 3);
+
+    // 1024 pixels at a scale of 1.75 are 585.14 logical pixels, a pixel off is tolerated both ways
+    config->setScaleF(output, 1.75);
+    config->setPosition(output, QPoint(1024 - 584, 1920));
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::Valid);
+    config->setPosition(output, QPoint(1024 - 586, 1920));
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::Valid);
+    QCOMPARE(testPassedSpy.count(), 5);
+    config->setPosition(output, QPoint(1024 - 588, 1920));
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::DisconnectedOutputs);
+    config->setPosition(output, QPoint(1024 - 582, 1920));
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::OverlappingOutputs);
+    config->setScaleF(output, 2.0);
+    config->setPosition(output, QPoint(512, 1920));
+    testConfig();
+    QCOMPARE(testPassedSpy.count(), 6);
+
+    // scale bounds are set by the compositor
+    m_outputManagementInterface->setScaleRange(1.0, 1.5);
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::InvalidScale);
+    m_outputManagementInterface->setScaleRange(0.5, 4.0);
+
+    // an invalid mode makes the whole configuration invalid
+    config->setMode(output, 42);
+    testConfig();
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::InvalidMode);
+    QCOMPARE(testPassedSpy.count(), 6);
+
+    // with validation enabled the compositor does not see invalid configurations
+    QSignalSpy failedSpy(config, &OutputConfiguration::failed);
+    QVERIFY(failedSpy.isValid());
+    m_outputManagementInterface->setValidationEnabled(true);
+    config->apply();
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(serverApplySpy.count(), 1);
+    QCOMPARE(configurationInterface->validate(), OutputConfigurationInterface::ValidationResult::Valid);
+
+    QCOMPARE(serverOutput->globalPosition(), QPoint(0, 1920));
+    m_display->removeOutputDevice(secondOutput);
+}
+
+void TestWaylandOutputManagement::testApplyChanges()
+{
+    createConfig();
+    auto config = m_outputConfiguration;
+    KWayland::Client::OutputDevice *output = m_clientOutputs.first();
+    QSignalSpy outputDoneSpy(output, &KWayland::Client::OutputDevice::done);
+    QVERIFY(outputDoneSpy.isValid());
+    QSignalSpy configAppliedSpy(config, &OutputConfiguration::applied);
+    QVERIFY(configAppliedSpy.isValid());
+
+    connect(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested,
+        [] (OutputConfigurationInterface *c) {
+            c->applyChanges();
+            c->setApplied();
+        }
+    );
+
+    config->setMode(output, m_modes.first().id);
+    config->setTransform(output, OutputDevice::Transform::Rotated90);
+    config->setPosition(output, QPoint(13, 37));
+    config->setScaleF(output, 2.0);
+    config->setEnabled(output, OutputDevice::Enablement::Disabled);
+    config->apply();
+
+    QVERIFY(configAppliedSpy.wait());
+    // all changes are sent with a single done before applied
+    QCOMPARE(outputDoneSpy.count(), 1);
+    QCOMPARE(output->pixelSize(), m_modes.first().size);
+    QCOMPARE(output->transform(), OutputDevice::Transform::Rotated90);
+    QCOMPARE(output->globalPosition(), QPoint(13, 37));
+    QCOMPARE(output->scaleF(), 2.0);
+    QCOMPARE(output->enabled(), OutputDevice::Enablement::Disabled);
+}
 
 QTEST_GUILESS_MAIN(TestWaylandOutputManagement)
 #include "test_wayland_outputmanagement.moc"
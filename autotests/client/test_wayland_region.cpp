@@ -43,6 +43,7 @@ private Q_SLOTS:
     void testCreateUniquePtr();
     void testAdd();
     void testRemove();
+    void testBatched();
     void testDestroy();
     void testDisconnect();
 
@@ -259,6 +260,60 @@ void TestRegion::testRemove()
     QCOMPARE(serverRegion->region(), compareRegion);
 }
 
+void TestRegion::testBatched()
+{
+    // this test verifies that many add and subtract requests applied at once result
+    // in the same region as applying them one after the other
+    using namespace KWayland::Client;
+    using namespace KWayland::Server;
+    QSignalSpy regionCreatedSpy(m_compositorInterface, &CompositorInterface::regionCreated);
+    QVERIFY(regionCreatedSpy.isValid());
+
+    std::unique_ptr<Region> region(m_compositor->createRegion());
+    QVERIFY(regionCreatedSpy.wait());
+    auto serverRegion = regionCreatedSpy.first().first().value<RegionInterface*>();
+
+    QRegion compareRegion;
+    // overlapping rects of different heights
+    for (int i = 0; i < 50; ++i) {
+        const QRect rect(i * 3, i * 2, 20, 10 + i % 7);
+        region->add(rect);
+        compareRegion = compareRegion.united(rect);
+    }
+    for (int i = 0; i < 10; ++i) {
+        const QRect rect(i * 15, 0, 5, 200);
+        region->subtract(rect);
+        compareRegion = compareRegion.subtracted(rect);
+    }
+    // abutting and contained rects
+    for (const QRect &rect : {QRect(200, 0, 10, 10), QRect(210, 0, 10, 10), QRect(202, 2, 3, 3), QRect(200, 10, 20, 10)}) {
+        region->add(rect);
+        compareRegion = compareRegion.united(rect);
+    }
+
+    // the region gets only computed once requested
+    QSignalSpy regionChangedSpy(serverRegion, &RegionInterface::regionChanged);
+    QVERIFY(regionChangedSpy.isValid());
+    region->add(QRect(0, 300, 10, 10));
+    compareRegion = compareRegion.united(QRect(0, 300, 10, 10));
+    QVERIFY(regionChangedSpy.wait());
+    QCOMPARE(regionChangedSpy.count(), 1);
+    QCOMPARE(regionChangedSpy.last().first().value<QRegion>(), compareRegion);
+    QCOMPARE(serverRegion->region(), compareRegion);
+    QCOMPARE(serverRegion->region().rectCount(), compareRegion.rectCount());
+
+    // further requests apply to the computed region
+    region->subtract(QRect(0, 0, 50, 50));
+    compareRegion = compareRegion.subtracted(QRect(0, 0, 50, 50));
+    region->add(QRect(10, 10, 5, 5));
+    compareRegion = compareRegion.united(QRect(10, 10, 5, 5));
+    QVERIFY(regionChangedSpy.wait());
+    if (regionChangedSpy.count() < 3) {
+        QVERIFY(regionChangedSpy.wait());
+    }
+    QCOMPARE(serverRegion->region(), compareRegion);
+}
+
 void TestRegion::testDestroy()
 {
     using namespace KWayland::Client;
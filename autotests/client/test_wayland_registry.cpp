@@ -32,6 +32,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../src/client/pointergestures.h"
 #include "../../src/client/idleinhibit.h"
 #include "../../src/client/seat.h"
+#include "../../src/client/shm_pool.h"
 #include "../../src/client/relativepointer.h"
 #include "../../src/client/server_decoration.h"
 #include "../../src/client/shell.h"
@@ -43,6 +44,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../src/server/display.h"
 #include "../../src/server/dpms_interface.h"
 #include "../../src/server/idleinhibit_interface.h"
+#include "../../src/server/linuxdmabuf_v1_interface.h"
 #include "../../src/server/output_interface.h"
 #include "../../src/server/seat_interface.h"
 #include "../../src/server/shell_interface.h"
@@ -62,6 +64,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include <wayland-client-protocol.h>
 #include <wayland-dpms-client-protocol.h>
 #include <wayland-idle-inhibit-unstable-v1-client-protocol.h>
+#include <wayland-linux-dmabuf-unstable-v1-client-protocol.h>
 #include <wayland-server-decoration-client-protocol.h>
 #include <wayland-text-input-v0-client-protocol.h>
 #include <wayland-text-input-v2-client-protocol.h>
@@ -99,6 +102,7 @@ private Q_SLOTS:
     void testBindPointerGesturesUnstableV1();
     void testBindPointerConstraintsUnstableV1();
     void testBindIdleIhibitManagerUnstableV1();
+    void testBindLinuxDmabufUnstableV1();
     void testGlobalSync();
     void testGlobalSyncThreaded();
     void testRemoval();
@@ -106,6 +110,8 @@ private Q_SLOTS:
     void testDestroy();
     void testAnnounceMultiple();
     void testAnnounceMultipleOutputDevices();
+    void testBindAll();
+    void testLazyObject();
 
 private:
     KWayland::Server::Display *m_display;
@@ -208,6 +214,7 @@ void TestWaylandRegistry::init()
     m_idleInhibit = m_display->createIdleInhibitManager(KWayland::Server::IdleInhibitManagerInterfaceVersion::UnstableV1);
     m_idleInhibit->create();
     QCOMPARE(m_idleInhibit->interfaceVersion(), KWayland::Server::IdleInhibitManagerInterfaceVersion::UnstableV1);
+    m_display->createLinuxDmabufInterface(m_display)->create();
 }
 
 void TestWaylandRegistry::cleanup()
@@ -370,6 +377,11 @@ void TestWaylandRegistry::testBindIdleIhibitManagerUnstableV1()
     TEST_BIND(KWayland::Client::Registry::Interface::IdleInhibitManagerUnstableV1, SIGNAL(idleInhibitManagerUnstableV1Announced(quint32,quint32)), bindIdleInhibitManagerUnstableV1, zwp_idle_inhibit_manager_v1_destroy)
 }
 
+void TestWaylandRegistry::testBindLinuxDmabufUnstableV1()
+{
+    TEST_BIND(KWayland::Client::Registry::Interface::LinuxDmabufUnstableV1, SIGNAL(linuxDmabufAnnounced(quint32,quint32)), bindLinuxDmabufUnstableV1, zwp_linux_dmabuf_v1_destroy)
+}
+
 #undef TEST_BIND
 
 void TestWaylandRegistry::testRemoval()
@@ -877,5 +889,109 @@ void TestWaylandRegistry::testAnnounceMultipleOutputDevices()
     QCOMPARE(registry.interface(Registry::Interface::OutputDevice).version, outputDeviceAnnouncedSpy.first().last().value<quint32>());
 }
 
+void TestWaylandRegistry::testBindAll()
+{
+    // this test verifies that bindAll creates the wrappers for all requested globals
+    using namespace KWayland::Client;
+    // add a second output, bindAll should create both
+    m_display->createOutput()->create();
+
+    ConnectionThread connection;
+    connection.setSocketName(s_socketName);
+    QSignalSpy connectedSpy(&connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    connection.initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    Registry registry;
+    // not yet created, nothing to bind
+    QVERIFY(registry.bindAll({Registry::Interface::Compositor}).isEmpty());
+    QSignalSpy syncSpy(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(syncSpy.isValid());
+    registry.create(&connection);
+    registry.setup();
+    QVERIFY(syncSpy.wait());
+
+    QSignalSpy boundSpy(&registry, &Registry::interfacesBound);
+    QVERIFY(boundSpy.isValid());
+    const auto objects = registry.bindAll({Registry::Interface::Compositor,
+                                           Registry::Interface::Output,
+                                           Registry::Interface::Shm,
+                                           Registry::Interface::XdgShellStable}, this);
+    // xdg_wm_base is not announced by the server
+    QCOMPARE(objects.count(), 4);
+    QVERIFY(qobject_cast<Compositor*>(objects.at(0)));
+    QVERIFY(qobject_cast<Output*>(objects.at(1)));
+    QVERIFY(qobject_cast<Output*>(objects.at(2)));
+    QVERIFY(objects.at(1) != objects.at(2));
+    QVERIFY(qobject_cast<ShmPool*>(objects.at(3)));
+    for (QObject *object : objects) {
+        QCOMPARE(object->parent(), this);
+    }
+    auto output = qobject_cast<Output*>(objects.at(1));
+    QVERIFY(output->isValid());
+    QSignalSpy outputChangedSpy(output, &Output::changed);
+    QVERIFY(outputChangedSpy.isValid());
+    QVERIFY(boundSpy.wait());
+    QCOMPARE(boundSpy.count(), 1);
+    // the initial events of the bound outputs got delivered before the sync
+    QCOMPARE(outputChangedSpy.count(), 1);
+
+    qDeleteAll(objects);
+}
+
+void TestWaylandRegistry::testLazyObject()
+{
+    // this test verifies that Registry::object creates the wrapper on first use only
+    using namespace KWayland::Client;
+    ConnectionThread connection;
+    connection.setSocketName(s_socketName);
+    QSignalSpy connectedSpy(&connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    connection.initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    Registry registry;
+    QVERIFY(!registry.object(Registry::Interface::Compositor));
+    QSignalSpy syncSpy(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(syncSpy.isValid());
+    registry.create(&connection);
+    registry.setup();
+    QVERIFY(syncSpy.wait());
+
+    // nothing got bound while announcing
+    QVERIFY(registry.findChildren<Compositor*>().isEmpty());
+    auto compositor = registry.object<Compositor>(Registry::Interface::Compositor);
+    QVERIFY(compositor);
+    QVERIFY(compositor->isValid());
+    QCOMPARE(compositor->parent(), &registry);
+    QCOMPARE(registry.object<Compositor>(Registry::Interface::Compositor), compositor);
+    QCOMPARE(registry.object(Registry::Interface::Compositor), compositor);
+    QCOMPARE(registry.findChildren<Compositor*>().count(), 1);
+    // not announced and unknown interfaces
+    QVERIFY(!registry.object(Registry::Interface::XdgShellStable));
+    QVERIFY(!registry.object(Registry::Interface::Unknown));
+
+    // removing the global creates a new wrapper for the next announced one
+    auto output = registry.object<Output>(Registry::Interface::Output);
+    QVERIFY(output);
+    QSignalSpy outputAnnouncedSpy(&registry, &Registry::outputAnnounced);
+    QVERIFY(outputAnnouncedSpy.isValid());
+    auto serverOutput = m_display->createOutput();
+    serverOutput->create();
+    QVERIFY(outputAnnouncedSpy.wait());
+    // the used global is still there
+    QCOMPARE(registry.object<Output>(Registry::Interface::Output), output);
+    QSignalSpy removedSpy(output, &Output::removed);
+    QVERIFY(removedSpy.isValid());
+    delete m_output;
+    m_output = nullptr;
+    QVERIFY(removedSpy.wait());
+    auto newOutput = registry.object<Output>(Registry::Interface::Output);
+    QVERIFY(newOutput);
+    QVERIFY(newOutput != output);
+    QCOMPARE(registry.interface(Registry::Interface::Output).name, outputAnnouncedSpy.first().first().value<quint32>());
+}
+
 QTEST_GUILESS_MAIN(TestWaylandRegistry)
 #include "test_wayland_registry.moc"
@@ -52,6 +52,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include <wayland-client-protocol.h>
 
 #include <linux/input.h>
+#include <config-kwayland.h>
 // System
 #include <fcntl.h>
 #include <unistd.h>
@@ -91,7 +92,7 @@ private Q_SLOTS:
     void testTouch();
     void testDisconnect();
     void testPointerEnterOnUnboundSurface();
-    // TODO: add test for keymap
+    void testKeymap();
 
 private:
     KWayland::Server::Display *m_display;
@@ -2406,5 +2407,67 @@ void TestWaylandSeat::testPointerEnterOnUnboundSurface()
     QVERIFY(!clientErrorSpy.wait(100));
 }
 
+void TestWaylandSeat::testKeymap()
+{
+    // this test verifies the keymap handling through SeatInterface::setKeymap(QByteArray)
+    // and Keyboard::readKeymap
+    using namespace KWayland::Client;
+    using namespace KWayland::Server;
+
+    QSignalSpy keyboardSpy(m_seat, &Seat::hasKeyboardChanged);
+    QVERIFY(keyboardSpy.isValid());
+    m_seatInterface->setHasKeyboard(true);
+    QVERIFY(keyboardSpy.wait());
+
+    QScopedPointer<Keyboard> keyboard(m_seat->createKeyboard());
+    QVERIFY(keyboard->isValid());
+    QSignalSpy keymapChangedSpy(keyboard.data(), &Keyboard::keymapChanged);
+    QVERIFY(keymapChangedSpy.isValid());
+
+    const QByteArray us = QByteArrayLiteral("xkb_keymap { xkb_symbols \"us\" };");
+    const QByteArray de = QByteArrayLiteral("xkb_keymap { xkb_symbols \"de\" };");
+    QVERIFY(m_seatInterface->setKeymap(us));
+    QVERIFY(m_seatInterface->isKeymapXkbCompatible());
+    QCOMPARE(m_seatInterface->keymapSize(), quint32(us.size() + 1));
+    const int usFd = m_seatInterface->keymapFileDescriptor();
+    QVERIFY(usFd != -1);
+    QVERIFY(keymapChangedSpy.wait());
+
+    int fd = keymapChangedSpy.last().first().toInt();
+    quint32 size = keymapChangedSpy.last().last().value<quint32>();
+    QCOMPARE(size, quint32(us.size() + 1));
+    QCOMPARE(Keyboard::readKeymap(fd, size), us);
+    // the client cannot modify the keymap shared with all other clients
+    QCOMPARE(write(fd, "x", 1), ssize_t(-1));
+    QCOMPARE(Keyboard::readKeymap(fd, size), us);
+#if HAVE_MEMFD
+    // the read-only fallback passes the write check as well, only seals protect against reopening
+    const int seals = fcntl(fd, F_GET_SEALS);
+    QVERIFY(seals != -1);
+    QCOMPARE(seals & (F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW), F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW);
+#endif
+    // a size exceeding the file is rejected
+    QVERIFY(Keyboard::readKeymap(fd, size + 4096).isNull());
+    QVERIFY(Keyboard::readKeymap(fd, 0).isNull());
+    close(fd);
+
+    // switching the layout forth and back reuses the file
+    QVERIFY(m_seatInterface->setKeymap(de));
+    QVERIFY(m_seatInterface->keymapFileDescriptor() != usFd);
+    QVERIFY(keymapChangedSpy.wait());
+    fd = keymapChangedSpy.last().first().toInt();
+    size = keymapChangedSpy.last().last().value<quint32>();
+    QCOMPARE(Keyboard::readKeymap(fd, size), de);
+    close(fd);
+
+    QVERIFY(m_seatInterface->setKeymap(us));
+    QCOMPARE(m_seatInterface->keymapFileDescriptor(), usFd);
+    QVERIFY(keymapChangedSpy.wait());
+    fd = keymapChangedSpy.last().first().toInt();
+    size = keymapChangedSpy.last().last().value<quint32>();
+    QCOMPARE(Keyboard::readKeymap(fd, size), us);
+    close(fd);
+}
+
 QTEST_GUILESS_MAIN(TestWaylandSeat)
 #include "test_wayland_seat.moc"
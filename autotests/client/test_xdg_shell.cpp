@@ -455,6 +455,81 @@ void XdgShellTest::testClose()
     QVERIFY(destroyedSpy.wait());
 }
 
+void XdgShellTest::testMaxSize()
+{
+    if (m_version == XdgShellInterfaceVersion::UnstableV5) {
+        QSKIP("xdg-shell v5 does not support size constraints");
+    }
+    qRegisterMetaType<OutputInterface*>();
+    // this test verifies changing the window maxSize
+    QSignalSpy xdgSurfaceCreatedSpy(m_xdgShellInterface, &XdgShellInterface::surfaceCreated);
+    QVERIFY(xdgSurfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QScopedPointer<XdgShellSurface> xdgSurface(m_xdgShell->createSurface(surface.data()));
+    QVERIFY(xdgSurfaceCreatedSpy.wait());
+    auto serverXdgSurface = xdgSurfaceCreatedSpy.first().first().value<XdgShellSurfaceInterface*>();
+    QVERIFY(serverXdgSurface);
+
+    QSignalSpy maxSizeSpy(serverXdgSurface, &XdgShellSurfaceInterface::maxSizeChanged);
+    QVERIFY(maxSizeSpy.isValid());
+
+    xdgSurface->setMaxSize(QSize(100, 100));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(maxSizeSpy.wait());
+    QCOMPARE(maxSizeSpy.count(), 1);
+    QCOMPARE(maxSizeSpy.last().at(0).value<QSize>(), QSize(100,100));
+    QCOMPARE(serverXdgSurface->maximumSize(), QSize(100, 100));
+
+    xdgSurface->setMaxSize(QSize(200, 200));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(maxSizeSpy.wait());
+    QCOMPARE(maxSizeSpy.count(), 2);
+    QCOMPARE(maxSizeSpy.last().at(0).value<QSize>(), QSize(200,200));
+    QCOMPARE(serverXdgSurface->maximumSize(), QSize(200, 200));
+
+    // a size of 0 means unlimited
+    xdgSurface->setMaxSize(QSize(0, 0));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(maxSizeSpy.wait());
+    QCOMPARE(maxSizeSpy.count(), 3);
+    QCOMPARE(serverXdgSurface->maximumSize(), QSize(INT32_MAX, INT32_MAX));
+}
+
+
+void XdgShellTest::testMinSize()
+{
+    if (m_version == XdgShellInterfaceVersion::UnstableV5) {
+        QSKIP("xdg-shell v5 does not support size constraints");
+    }
+    qRegisterMetaType<OutputInterface*>();
+    // this test verifies changing the window minSize
+    QSignalSpy xdgSurfaceCreatedSpy(m_xdgShellInterface, &XdgShellInterface::surfaceCreated);
+    QVERIFY(xdgSurfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QScopedPointer<XdgShellSurface> xdgSurface(m_xdgShell->createSurface(surface.data()));
+    QVERIFY(xdgSurfaceCreatedSpy.wait());
+    auto serverXdgSurface = xdgSurfaceCreatedSpy.first().first().value<XdgShellSurfaceInterface*>();
+    QVERIFY(serverXdgSurface);
+
+    QSignalSpy minSizeSpy(serverXdgSurface, &XdgShellSurfaceInterface::minSizeChanged);
+    QVERIFY(minSizeSpy.isValid());
+
+    xdgSurface->setMinSize(QSize(200, 200));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(minSizeSpy.wait());
+    QCOMPARE(minSizeSpy.count(), 1);
+    QCOMPARE(minSizeSpy.last().at(0).value<QSize>(), QSize(200,200));
+    QCOMPARE(serverXdgSurface->minimumSize(), QSize(200, 200));
+
+    xdgSurface->setMinSize(QSize(100, 100));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(minSizeSpy.wait());
+    QCOMPARE(minSizeSpy.count(), 2);
+    QCOMPARE(minSizeSpy.last().at(0).value<QSize>(), QSize(100,100));
+    QCOMPARE(serverXdgSurface->minimumSize(), QSize(100, 100));
+}
+
+
 void XdgShellTest::testConfigureStates_data()
 {
     QTest::addColumn<XdgShellSurfaceInterface::States>("serverStates");
@@ -571,3 +646,94 @@ void XdgShellTest::testConfigureMultipleAcks()
     QCOMPARE(sizeChangedSpy.count(), 3);
     QCOMPARE(xdgSurface->size(), QSize(30, 40));
 }
+
+void XdgShellTest::testConfigureCoalesce()
+{
+    qRegisterMetaType<XdgShellSurface::States>();
+    // this test verifies that configures are merged while one is not acknowledged
+    SURFACE
+
+    QSignalSpy configureSpy(xdgSurface.data(), &XdgShellSurface::configureRequested);
+    QVERIFY(configureSpy.isValid());
+    QSignalSpy ackSpy(serverXdgSurface, &XdgShellSurfaceInterface::configureAcknowledged);
+    QVERIFY(ackSpy.isValid());
+
+    QCOMPARE(serverXdgSurface->configurePolicy(), XdgShellSurfaceInterface::ConfigurePolicy::Immediate);
+    serverXdgSurface->setConfigurePolicy(XdgShellSurfaceInterface::ConfigurePolicy::Coalesce);
+    QCOMPARE(serverXdgSurface->configurePolicy(), XdgShellSurfaceInterface::ConfigurePolicy::Coalesce);
+
+    const quint32 serial1 = serverXdgSurface->configure(XdgShellSurfaceInterface::States(), QSize(10, 20));
+    QVERIFY(serial1 != 0);
+    QVERIFY(serverXdgSurface->isConfigurePending());
+    // the following configures are merged into one
+    const quint32 serial2 = serverXdgSurface->configure(XdgShellSurfaceInterface::States(), QSize(20, 30));
+    QVERIFY(serial2 != serial1);
+    QCOMPARE(serverXdgSurface->configure(XdgShellSurfaceInterface::State::Activated, QSize(30, 40)), serial2);
+
+    QVERIFY(configureSpy.wait());
+    QCOMPARE(configureSpy.count(), 1);
+    QCOMPARE(configureSpy.first().at(0).toSize(), QSize(10, 20));
+    QCOMPARE(configureSpy.first().at(2).value<quint32>(), serial1);
+    QVERIFY(!configureSpy.wait(100));
+
+    // acknowledging sends the merged configure with the latest state
+    xdgSurface->ackConfigure(serial1);
+    QVERIFY(configureSpy.wait());
+    QCOMPARE(configureSpy.count(), 2);
+    QCOMPARE(configureSpy.last().at(0).toSize(), QSize(30, 40));
+    QCOMPARE(configureSpy.last().at(1).value<XdgShellSurface::States>(), XdgShellSurface::States(XdgShellSurface::State::Activated));
+    QCOMPARE(configureSpy.last().at(2).value<quint32>(), serial2);
+    QCOMPARE(ackSpy.count(), 1);
+    QCOMPARE(ackSpy.first().first().value<quint32>(), serial1);
+    QVERIFY(serverXdgSurface->isConfigurePending());
+
+    xdgSurface->ackConfigure(serial2);
+    QVERIFY(ackSpy.wait());
+    QCOMPARE(ackSpy.count(), 2);
+    QCOMPARE(ackSpy.last().first().value<quint32>(), serial2);
+    QVERIFY(!serverXdgSurface->isConfigurePending());
+}
+
+void XdgShellTest::testConfigureCoalesceUntilCommit()
+{
+    // this test verifies that a merged configure is only sent once the acknowledged one got committed
+    SURFACE
+
+    QSignalSpy configureSpy(xdgSurface.data(), &XdgShellSurface::configureRequested);
+    QVERIFY(configureSpy.isValid());
+    QSignalSpy ackSpy(serverXdgSurface, &XdgShellSurfaceInterface::configureAcknowledged);
+    QVERIFY(ackSpy.isValid());
+    QSignalSpy committedSpy(serverXdgSurface, &XdgShellSurfaceInterface::configureCommitted);
+    QVERIFY(committedSpy.isValid());
+
+    serverXdgSurface->setConfigurePolicy(XdgShellSurfaceInterface::ConfigurePolicy::CoalesceUntilCommit);
+    const quint32 serial1 = serverXdgSurface->configure(XdgShellSurfaceInterface::States(), QSize(10, 20));
+    const quint32 serial2 = serverXdgSurface->configure(XdgShellSurfaceInterface::States(), QSize(20, 30));
+    QVERIFY(configureSpy.wait());
+    QCOMPARE(configureSpy.count(), 1);
+
+    xdgSurface->ackConfigure(serial1);
+    QVERIFY(ackSpy.wait());
+    QCOMPARE(configureSpy.count(), 1);
+    QVERIFY(committedSpy.isEmpty());
+
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(committedSpy.count(), 1);
+    QCOMPARE(committedSpy.first().at(0).value<quint32>(), serial1);
+    const qint64 ackLatency = committedSpy.first().at(1).value<qint64>();
+    const qint64 commitLatency = committedSpy.first().at(2).value<qint64>();
+    QVERIFY(ackLatency >= 0);
+    QVERIFY(commitLatency >= ackLatency);
+
+    // the commit released the merged configure
+    QVERIFY(configureSpy.wait());
+    QCOMPARE(configureSpy.count(), 2);
+    QCOMPARE(configureSpy.last().at(0).toSize(), QSize(20, 30));
+    QCOMPARE(configureSpy.last().at(2).value<quint32>(), serial2);
+
+    // a commit without acknowledging does not report anything
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(!committedSpy.wait(100));
+    QCOMPARE(committedSpy.count(), 1);
+}
@@ -68,9 +68,13 @@ private Q_SLOTS:
     void testTransient();
     void testPing();
     void testClose();
+    void testMaxSize();
+    void testMinSize();
     void testConfigureStates_data();
     void testConfigureStates();
     void testConfigureMultipleAcks();
+    void testConfigureCoalesce();
+    void testConfigureCoalesceUntilCommit();
 
 protected:
     XdgShellInterface *m_xdgShellInterface = nullptr;
@@ -29,9 +29,6 @@ public:
         XdgShellTest(KWayland::Server::XdgShellInterfaceVersion::Stable) {}
 
 private Q_SLOTS:
-    void testMaxSize();
-    void testMinSize();
-
     void testPopup_data();
     void testPopup();
 
@@ -41,36 +38,6 @@ private Q_SLOTS:
     void testWindowGeometry();
 };
 
-void XdgShellTestStable::testMaxSize()
-{
-    qRegisterMetaType<OutputInterface*>();
-    // this test verifies changing the window maxSize
-    QSignalSpy xdgSurfaceCreatedSpy(m_xdgShellInterface, &XdgShellInterface::surfaceCreated);
-    QVERIFY(xdgSurfaceCreatedSpy.isValid());
-    QScopedPointer<Surface> surface(m_compositor->createSurface());
-    QScopedPointer<XdgShellSurface> xdgSurface(m_xdgShell->createSurface(surface.data()));
-    QVERIFY(xdgSurfaceCreatedSpy.wait());
-    auto serverXdgSurface = xdgSurfaceCreatedSpy.first().first().value<XdgShellSurfaceInterface*>();
-    QVERIFY(serverXdgSurface);
-
-    QSignalSpy maxSizeSpy(serverXdgSurface, &XdgShellSurfaceInterface::maxSizeChanged);
-    QVERIFY(maxSizeSpy.isValid());
-
-    xdgSurface->setMaxSize(QSize(100, 100));
-    surface->commit(Surface::CommitFlag::None);
-    QVERIFY(maxSizeSpy.wait());
-    QCOMPARE(maxSizeSpy.count(), 1);
-    QCOMPARE(maxSizeSpy.last().at(0).value<QSize>(), QSize(100,100));
-    QCOMPARE(serverXdgSurface->maximumSize(), QSize(100, 100));
-
-    xdgSurface->setMaxSize(QSize(200, 200));
-    surface->commit(Surface::CommitFlag::None);
-    QVERIFY(maxSizeSpy.wait());
-    QCOMPARE(maxSizeSpy.count(), 2);
-    QCOMPARE(maxSizeSpy.last().at(0).value<QSize>(), QSize(200,200));
-    QCOMPARE(serverXdgSurface->maximumSize(), QSize(200, 200));
-}
-
 
 void XdgShellTestStable::testPopup_data()
 {
@@ -129,36 +96,6 @@ void XdgShellTestStable::testPopup()
     QCOMPARE(serverXdgPopup->transientFor().data(), serverXdgTopLevel->surface());
 }
 
-void XdgShellTestStable::testMinSize()
-{
-    qRegisterMetaType<OutputInterface*>();
-    // this test verifies changing the window minSize
-    QSignalSpy xdgSurfaceCreatedSpy(m_xdgShellInterface, &XdgShellInterface::surfaceCreated);
-    QVERIFY(xdgSurfaceCreatedSpy.isValid());
-    QScopedPointer<Surface> surface(m_compositor->createSurface());
-    QScopedPointer<XdgShellSurface> xdgSurface(m_xdgShell->createSurface(surface.data()));
-    QVERIFY(xdgSurfaceCreatedSpy.wait());
-    auto serverXdgSurface = xdgSurfaceCreatedSpy.first().first().value<XdgShellSurfaceInterface*>();
-    QVERIFY(serverXdgSurface);
-
-    QSignalSpy minSizeSpy(serverXdgSurface, &XdgShellSurfaceInterface::minSizeChanged);
-    QVERIFY(minSizeSpy.isValid());
-
-    xdgSurface->setMinSize(QSize(200, 200));
-    surface->commit(Surface::CommitFlag::None);
-    QVERIFY(minSizeSpy.wait());
-    QCOMPARE(minSizeSpy.count(), 1);
-    QCOMPARE(minSizeSpy.last().at(0).value<QSize>(), QSize(200,200));
-    QCOMPARE(serverXdgSurface->minimumSize(), QSize(200, 200));
-
-    xdgSurface->setMinSize(QSize(100, 100));
-    surface->commit(Surface::CommitFlag::None);
-    QVERIFY(minSizeSpy.wait());
-    QCOMPARE(minSizeSpy.count(), 2);
-    QCOMPARE(minSizeSpy.last().at(0).value<QSize>(), QSize(100,100));
-    QCOMPARE(serverXdgSurface->minimumSize(), QSize(100, 100));
-}
-
 //top level then toplevel
 void XdgShellTestStable::testMultipleRoles1()
 {
@@ -0,0 +1,369 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/display.h"
+#include "../../src/server/clientconnection.h"
+// Wayland
+#include <wayland-client.h>
+// system
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+
+using namespace KWayland::Server;
+
+Q_DECLARE_METATYPE(KWayland::Server::ClientConnection::Limit)
+
+/**
+ * A well-behaved client doing roundtrips in its own thread.
+ **/
+class RoundtripClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RoundtripClient(wl_display *display)
+        : m_display(display)
+    {
+    }
+
+public Q_SLOTS:
+    void roundtrip()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        wl_display_roundtrip(m_display);
+        emit done(timer.elapsed());
+    }
+
+Q_SIGNALS:
+    void done(qint64 msecs);
+
+private:
+    wl_display *m_display;
+};
+
+class TestClientLimits : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testDefaultLimits();
+    void testRequestFlood();
+    void testRequestFloodDisconnect();
+    void testQueuedBytesDisconnect();
+    void testFlushDefersDisconnect();
+    void testLatency_data();
+    void testLatency();
+
+private:
+    ClientConnection *connectClient(wl_display **clientDisplay);
+
+    Display *m_display = nullptr;
+    QVector<wl_display*> m_clients;
+};
+
+static void sendSyncs(wl_display *display, int count)
+{
+    // the callbacks are never destroyed, the server's done and delete_id events are never read
+    for (int i = 0; i < count; ++i) {
+        wl_display_sync(display);
+    }
+    wl_display_flush(display);
+}
+
+void TestClientLimits::initTestCase()
+{
+    qRegisterMetaType<KWayland::Server::ClientConnection::Limit>();
+}
+
+void TestClientLimits::init()
+{
+    m_display = new Display(this);
+    m_display->start(Display::StartMode::ConnectClientsOnly);
+    QVERIFY(m_display->isRunning());
+}
+
+void TestClientLimits::cleanup()
+{
+    for (wl_display *client : qAsConst(m_clients)) {
+        wl_display_disconnect(client);
+    }
+    m_clients.clear();
+    delete m_display;
+    m_display = nullptr;
+}
+
+ClientConnection *TestClientLimits::connectClient(wl_display **clientDisplay)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        return nullptr;
+    }
+    ClientConnection *connection = m_display->createClient(sv[0]);
+    // takes ownership of the fd
+    *clientDisplay = wl_display_connect_to_fd(sv[1]);
+    if (*clientDisplay) {
+        m_clients << *clientDisplay;
+    }
+    return connection;
+}
+
+void TestClientLimits::testDefaultLimits()
+{
+    // the limits of the Display apply to existing and new connections
+    QCOMPARE(m_display->clientLimits().requestsPerDispatch, 0);
+    QCOMPARE(m_display->clientLimits().queuedBytes, qint64(0));
+    QCOMPARE(m_display->clientLimits().disconnectTimeout, 0);
+
+    wl_display *client = nullptr;
+    ClientConnection *before = connectClient(&client);
+    QVERIFY(before);
+    QVERIFY(client);
+    QCOMPARE(before->limits().requestsPerDispatch, 0);
+
+    ClientConnection::Limits limits;
+    limits.requestsPerDispatch = 10;
+    limits.queuedBytes = 1024;
+    limits.disconnectTimeout = 500;
+    m_display->setClientLimits(limits);
+    QCOMPARE(before->limits().requestsPerDispatch, 10);
+    QCOMPARE(before->limits().queuedBytes, qint64(1024));
+    QCOMPARE(before->limits().disconnectTimeout, 500);
+
+    ClientConnection *after = connectClient(&client);
+    QVERIFY(after);
+    QVERIFY(client);
+    QCOMPARE(after->limits().requestsPerDispatch, 10);
+    QCOMPARE(after->limits().queuedBytes, qint64(1024));
+    QCOMPARE(after->limits().disconnectTimeout, 500);
+
+    // a single connection can get other limits
+    ClientConnection::Limits trusted;
+    after->setLimits(trusted);
+    QCOMPARE(after->limits().requestsPerDispatch, 0);
+    QCOMPARE(before->limits().requestsPerDispatch, 10);
+}
+
+void TestClientLimits::testRequestFlood()
+{
+    ClientConnection::Limits limits;
+    limits.requestsPerDispatch = 50;
+    m_display->setClientLimits(limits);
+
+    wl_display *flooding = nullptr;
+    ClientConnection *floodingConnection = connectClient(&flooding);
+    QVERIFY(floodingConnection);
+    QVERIFY(flooding);
+    wl_display *wellBehaved = nullptr;
+    ClientConnection *wellBehavedConnection = connectClient(&wellBehaved);
+    QVERIFY(wellBehavedConnection);
+    QVERIFY(wellBehaved);
+
+    QSignalSpy floodingExceededSpy(floodingConnection, &ClientConnection::limitExceeded);
+    QVERIFY(floodingExceededSpy.isValid());
+    QSignalSpy floodingDisconnectedSpy(floodingConnection, &ClientConnection::disconnected);
+    QVERIFY(floodingDisconnectedSpy.isValid());
+    QSignalSpy wellBehavedExceededSpy(wellBehavedConnection, &ClientConnection::limitExceeded);
+    QVERIFY(wellBehavedExceededSpy.isValid());
+
+    sendSyncs(wellBehaved, 10);
+    sendSyncs(flooding, 200);
+    QVERIFY(floodingExceededSpy.wait());
+    QCOMPARE(floodingExceededSpy.count(), 1);
+    QCOMPARE(floodingExceededSpy.first().first().value<ClientConnection::Limit>(), ClientConnection::Limit::Requests);
+
+    // another burst belongs to the same violation
+    sendSyncs(flooding, 200);
+    QVERIFY(!floodingExceededSpy.wait(200));
+    QCOMPARE(floodingExceededSpy.count(), 1);
+
+    // without a timeout the client only gets reported
+    QVERIFY(floodingDisconnectedSpy.isEmpty());
+    QVERIFY(floodingConnection->client());
+    QVERIFY(wellBehavedExceededSpy.isEmpty());
+}
+
+void TestClientLimits::testRequestFloodDisconnect()
+{
+    wl_display *flooding = nullptr;
+    ClientConnection *floodingConnection = connectClient(&flooding);
+    QVERIFY(floodingConnection);
+    QVERIFY(flooding);
+    wl_display *wellBehaved = nullptr;
+    ClientConnection *wellBehavedConnection = connectClient(&wellBehaved);
+    QVERIFY(wellBehavedConnection);
+    QVERIFY(wellBehaved);
+
+    ClientConnection::Limits limits;
+    limits.requestsPerDispatch = 50;
+    limits.disconnectTimeout = 100;
+    floodingConnection->setLimits(limits);
+
+    QSignalSpy exceededSpy(floodingConnection, &ClientConnection::limitExceeded);
+    QVERIFY(exceededSpy.isValid());
+    QSignalSpy floodingDisconnectedSpy(floodingConnection, &ClientConnection::disconnected);
+    QVERIFY(floodingDisconnectedSpy.isValid());
+    QSignalSpy wellBehavedDisconnectedSpy(wellBehavedConnection, &ClientConnection::disconnected);
+    QVERIFY(wellBehavedDisconnectedSpy.isValid());
+
+    // keeps flooding until the server gives up on the client
+    for (int i = 0; i < 50 && floodingDisconnectedSpy.isEmpty(); ++i) {
+        sendSyncs(flooding, 200);
+        sendSyncs(wellBehaved, 1);
+        floodingDisconnectedSpy.wait(20);
+    }
+    QCOMPARE(floodingDisconnectedSpy.count(), 1);
+    QCOMPARE(exceededSpy.count(), 1);
+    QCOMPARE(exceededSpy.first().first().value<ClientConnection::Limit>(), ClientConnection::Limit::Requests);
+    QVERIFY(!floodingConnection->client());
+
+    // the other client is not affected
+    QVERIFY(wellBehavedDisconnectedSpy.isEmpty());
+    QVERIFY(wellBehavedConnection->client());
+    QCOMPARE(m_display->connections().count(), 1);
+}
+
+void TestClientLimits::testQueuedBytesDisconnect()
+{
+    ClientConnection::Limits limits;
+    limits.queuedBytes = 4096;
+    limits.disconnectTimeout = 100;
+    m_display->setClientLimits(limits);
+
+    wl_display *stalled = nullptr;
+    ClientConnection *stalledConnection = connectClient(&stalled);
+    QVERIFY(stalledConnection);
+    QVERIFY(stalled);
+    wl_display *wellBehaved = nullptr;
+    ClientConnection *wellBehavedConnection = connectClient(&wellBehaved);
+    QVERIFY(wellBehavedConnection);
+    QVERIFY(wellBehaved);
+
+    QSignalSpy exceededSpy(stalledConnection, &ClientConnection::limitExceeded);
+    QVERIFY(exceededSpy.isValid());
+    QSignalSpy stalledDisconnectedSpy(stalledConnection, &ClientConnection::disconnected);
+    QVERIFY(stalledDisconnectedSpy.isValid());
+    QSignalSpy wellBehavedExceededSpy(wellBehavedConnection, &ClientConnection::limitExceeded);
+    QVERIFY(wellBehavedExceededSpy.isValid());
+
+    // each sync queues a done and a delete_id event the client never reads
+    for (int i = 0; i < 50 && stalledDisconnectedSpy.isEmpty(); ++i) {
+        sendSyncs(stalled, 20);
+        stalledDisconnectedSpy.wait(20);
+    }
+    QCOMPARE(stalledDisconnectedSpy.count(), 1);
+    QCOMPARE(exceededSpy.count(), 1);
+    QCOMPARE(exceededSpy.first().first().value<ClientConnection::Limit>(), ClientConnection::Limit::QueuedBytes);
+
+    QVERIFY(wellBehavedExceededSpy.isEmpty());
+    QVERIFY(wellBehavedConnection->client());
+}
+
+void TestClientLimits::testFlushDefersDisconnect()
+{
+    // a flush can happen within a request handler, so it must not destroy the client
+    ClientConnection::Limits limits;
+    limits.queuedBytes = 4096;
+    limits.disconnectTimeout = 1;
+    m_display->setClientLimits(limits);
+
+    wl_display *stalled = nullptr;
+    ClientConnection *stalledConnection = connectClient(&stalled);
+    QVERIFY(stalledConnection);
+    QVERIFY(stalled);
+
+    QSignalSpy exceededSpy(stalledConnection, &ClientConnection::limitExceeded);
+    QVERIFY(exceededSpy.isValid());
+    QSignalSpy disconnectedSpy(stalledConnection, &ClientConnection::disconnected);
+    QVERIFY(disconnectedSpy.isValid());
+
+    sendSyncs(stalled, 1000);
+    m_display->dispatchEvents();
+    m_display->flushClients();
+    QThread::msleep(10);
+    m_display->flushClients();
+    QVERIFY(exceededSpy.isEmpty());
+    QVERIFY(disconnectedSpy.isEmpty());
+    QVERIFY(stalledConnection->client());
+
+    QVERIFY(disconnectedSpy.wait());
+    QCOMPARE(exceededSpy.count(), 1);
+    QCOMPARE(exceededSpy.first().first().value<ClientConnection::Limit>(), ClientConnection::Limit::QueuedBytes);
+}
+
+void TestClientLimits::testLatency_data()
+{
+    QTest::addColumn<int>("syncs");
+
+    QTest::newRow("flooding") << 500;
+    QTest::newRow("stalled") << 20;
+}
+
+void TestClientLimits::testLatency()
+{
+    // a client flooding the server or not reading its events must not delay the others
+    QFETCH(int, syncs);
+    ClientConnection::Limits limits;
+    limits.requestsPerDispatch = 50;
+    limits.queuedBytes = 4096;
+    m_display->setClientLimits(limits);
+
+    wl_display *abusive = nullptr;
+    ClientConnection *abusiveConnection = connectClient(&abusive);
+    QVERIFY(abusiveConnection);
+    QVERIFY(abusive);
+    wl_display *wellBehaved = nullptr;
+    QVERIFY(connectClient(&wellBehaved));
+    QVERIFY(wellBehaved);
+
+    QSignalSpy exceededSpy(abusiveConnection, &ClientConnection::limitExceeded);
+    QVERIFY(exceededSpy.isValid());
+
+    QThread clientThread;
+    RoundtripClient client(wellBehaved);
+    client.moveToThread(&clientThread);
+    clientThread.start();
+    // delivered queued into the thread of the server
+    QVector<qint64> latencies;
+    connect(&client, &RoundtripClient::done, this, [&latencies] (qint64 msecs) { latencies << msecs; });
+
+    for (int i = 0; i < 20; ++i) {
+        sendSyncs(abusive, syncs);
+        QMetaObject::invokeMethod(&client, "roundtrip", Qt::QueuedConnection);
+        QTRY_COMPARE_WITH_TIMEOUT(latencies.count(), i + 1, 1000);
+    }
+    clientThread.quit();
+    clientThread.wait();
+    const qint64 maxLatency = *std::max_element(latencies.constBegin(), latencies.constEnd());
+
+    QVERIFY(!exceededSpy.isEmpty());
+    QVERIFY(abusiveConnection->client());
+    // generous to not fail on a loaded machine, it is a few msec usually
+    QVERIFY2(maxLatency < 250, qPrintable(QStringLiteral("roundtrip took %1 msec").arg(maxLatency)));
+}
+
+QTEST_GUILESS_MAIN(TestClientLimits)
+#include "test_client_limits.moc"
@@ -22,9 +22,11 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 // WaylandServer
 #include "../../src/server/display.h"
 #include "../../src/server/clientconnection.h"
+#include "../../src/server/compositor_interface.h"
 #include "../../src/server/outputmanagement_interface.h"
 #include "../../src/server/output_interface.h"
 // Wayland
+#include <wayland-client.h>
 #include <wayland-server.h>
 // system
 #include <sys/types.h>
@@ -44,6 +46,8 @@ private Q_SLOTS:
     void testConnectNoSocket();
     void testOutputManagement();
     void testAutoSocketName();
+    void testFlushPolicy();
+    void testDispatchThread();
 };
 
 void TestWaylandServerDisplay::testSocketName()
@@ -239,6 +243,111 @@ void TestWaylandServerDisplay::testAutoSocketName()
     QCOMPARE(display1.socketName(), QStringLiteral("wayland-1"));
 }
 
+void TestWaylandServerDisplay::testFlushPolicy()
+{
+    Display display;
+    QCOMPARE(display.flushPolicy(), Display::FlushPolicy::Immediate);
+    display.start(Display::StartMode::ConnectClientsOnly);
+    QVERIFY(display.isRunning());
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    auto client = display.createClient(sv[0]);
+    QVERIFY(client);
+    QCOMPARE(ClientConnection::get(client->client()), client);
+    // the wl_display resource of the client
+    wl_resource *resource = wl_client_get_object(client->client(), 1);
+    QVERIFY(resource);
+    char buffer[64];
+
+    // flushing the client is deferred to the next flush of all clients
+    display.setFlushPolicy(Display::FlushPolicy::Explicit);
+    QCOMPARE(display.flushPolicy(), Display::FlushPolicy::Explicit);
+    wl_resource_post_event(resource, WL_DISPLAY_DELETE_ID, 42);
+    client->flush();
+    QCOMPARE(recv(sv[1], buffer, sizeof(buffer), MSG_DONTWAIT), ssize_t(-1));
+    display.flushClients();
+    QCOMPARE(recv(sv[1], buffer, sizeof(buffer), MSG_DONTWAIT), ssize_t(12));
+
+    display.setFlushPolicy(Display::FlushPolicy::Immediate);
+    wl_resource_post_event(resource, WL_DISPLAY_DELETE_ID, 43);
+    client->flush();
+    QCOMPARE(recv(sv[1], buffer, sizeof(buffer), MSG_DONTWAIT), ssize_t(12));
+
+    wl_client *native = client->client();
+    wl_client_destroy(native);
+    QVERIFY(!ClientConnection::get(native));
+    close(sv[1]);
+}
+
+void TestWaylandServerDisplay::testDispatchThread()
+{
+    QThread *originThread = QThread::currentThread();
+    QScopedPointer<Display> display(new Display);
+    display->setDispatchMode(Display::DispatchMode::DedicatedThread);
+    display->start(Display::StartMode::ConnectClientsOnly);
+    QVERIFY(display->isRunning());
+    QVERIFY(display->dispatchThread());
+    QCOMPARE(display->thread(), display->dispatchThread());
+
+    // globals and clients are created in the dispatch thread
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+    CompositorInterface *compositor = nullptr;
+    ClientConnection *connection = nullptr;
+    QMetaObject::invokeMethod(display.data(),
+        [&display, &compositor, &connection, &sv] {
+            compositor = display->createCompositor(display.data());
+            compositor->create();
+            connection = display->createClient(sv[0]);
+        }, Qt::BlockingQueuedConnection
+    );
+    QVERIFY(compositor);
+    QVERIFY(compositor->isValid());
+    QVERIFY(connection);
+
+    // the dispatch thread answers while this thread blocks in the roundtrips
+    wl_display *client = wl_display_connect_to_fd(sv[1]);
+    QVERIFY(client);
+    wl_registry *registry = wl_display_get_registry(client);
+    quint32 compositorName = 0;
+    const wl_registry_listener registryListener = {
+        [] (void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version) {
+            Q_UNUSED(registry)
+            Q_UNUSED(version)
+            if (qstrcmp(interface, wl_compositor_interface.name) == 0) {
+                *static_cast<quint32*>(data) = name;
+            }
+        },
+        [] (void *data, wl_registry *registry, uint32_t name) {
+            Q_UNUSED(data)
+            Q_UNUSED(registry)
+            Q_UNUSED(name)
+        }
+    };
+    wl_registry_add_listener(registry, &registryListener, &compositorName);
+    QVERIFY(wl_display_roundtrip(client) >= 0);
+    QVERIFY(compositorName != 0);
+    auto clientCompositor = static_cast<wl_compositor*>(wl_registry_bind(registry, compositorName, &wl_compositor_interface, 1));
+    QVERIFY(clientCompositor);
+    wl_surface *surface = wl_compositor_create_surface(clientCompositor);
+    QVERIFY(wl_display_roundtrip(client) >= 0);
+    QCOMPARE(wl_display_get_error(client), 0);
+
+    // terminating moves the Display back, the globals are gone with the dispatch thread
+    QPointer<CompositorInterface> compositorPointer(compositor);
+    display->terminate();
+    QVERIFY(!display->isRunning());
+    QVERIFY(!display->dispatchThread());
+    QCOMPARE(display->thread(), originThread);
+    QVERIFY(!compositorPointer);
+
+    wl_surface_destroy(surface);
+    wl_compositor_destroy(clientCompositor);
+    wl_registry_destroy(registry);
+    wl_display_disconnect(client);
+    display.reset();
+}
 
 QTEST_GUILESS_MAIN(TestWaylandServerDisplay)
 #include "test_display.moc"
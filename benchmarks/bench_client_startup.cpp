@@ -0,0 +1,198 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+#include <QImage>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/registry.h"
+#include "../src/client/shm_pool.h"
+#include "../src/client/surface.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/surface_interface.h"
+#include "server_globals.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+/**
+ * How far a client gets in its startup within one benchmark iteration.
+ **/
+enum class Stage {
+    Connect,
+    Announce,
+    Bind,
+    FirstFrame
+};
+Q_DECLARE_METATYPE(Stage)
+
+class ClientStartupBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkStartup_data();
+    void benchmarkStartup();
+
+private:
+    void startClient(Stage stage, bool lazy);
+
+    Display *m_display = nullptr;
+    ServerGlobals m_globals;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-client-startup-0");
+
+void ClientStartupBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_globals = createServerGlobals(m_display);
+    // a compositor presenting each committed frame immediately
+    connect(m_globals.compositor, &CompositorInterface::surfaceCreated, this,
+        [] (SurfaceInterface *surface) {
+            connect(surface, &SurfaceInterface::committed, surface,
+                [surface] {
+                    surface->frameRendered(0);
+                }
+            );
+        }
+    );
+}
+
+void ClientStartupBenchmark::cleanupTestCase()
+{
+    delete m_display;
+    m_display = nullptr;
+}
+
+void ClientStartupBenchmark::startClient(Stage stage, bool lazy)
+{
+    ConnectionThread connection;
+    QSignalSpy connectedSpy(&connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    connection.setSocketName(s_socketName);
+    connection.initConnection();
+    QVERIFY(connectedSpy.wait());
+    if (stage == Stage::Connect) {
+        return;
+    }
+
+    EventQueue queue;
+    queue.setup(&connection);
+    Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    registry.setEventQueue(&queue);
+    registry.create(&connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    if (stage == Stage::Announce) {
+        return;
+    }
+
+    Compositor *compositor = nullptr;
+    ShmPool *shm = nullptr;
+    QVector<QObject *> objects;
+    if (lazy) {
+        // only what is needed for the first frame gets bound
+        compositor = registry.object<Compositor>(Registry::Interface::Compositor);
+        shm = registry.object<ShmPool>(Registry::Interface::Shm);
+    } else {
+        // the typical application binding every global it might need during its lifetime
+        QSignalSpy interfacesBoundSpy(&registry, &Registry::interfacesBound);
+        QVERIFY(interfacesBoundSpy.isValid());
+        objects = registry.bindAll({Registry::Interface::Compositor,
+                                    Registry::Interface::Shm,
+                                    Registry::Interface::Seat,
+                                    Registry::Interface::Output,
+                                    Registry::Interface::SubCompositor,
+                                    Registry::Interface::DataDeviceManager,
+                                    Registry::Interface::XdgShellStable,
+                                    Registry::Interface::XdgDecorationUnstableV1,
+                                    Registry::Interface::TextInputManagerUnstableV2,
+                                    Registry::Interface::PointerGesturesUnstableV1,
+                                    Registry::Interface::RelativePointerManagerUnstableV1,
+                                    Registry::Interface::IdleInhibitManagerUnstableV1,
+                                    Registry::Interface::XdgOutputUnstableV1}, &registry);
+        QVERIFY(interfacesBoundSpy.wait());
+        for (QObject *object : qAsConst(objects)) {
+            if (!compositor) {
+                compositor = qobject_cast<Compositor*>(object);
+            }
+            if (!shm) {
+                shm = qobject_cast<ShmPool*>(object);
+            }
+        }
+    }
+    QVERIFY(compositor);
+    QVERIFY(shm);
+    if (stage == Stage::Bind) {
+        return;
+    }
+
+    QScopedPointer<Surface> surface(compositor->createSurface());
+    QVERIFY(surface->isValid());
+    QSignalSpy frameRenderedSpy(surface.data(), &Surface::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    QImage image(QSize(640, 480), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::blue);
+    surface->attachBuffer(shm->createBuffer(image));
+    surface->damage(image.rect());
+    surface->commit(Surface::CommitFlag::FrameCallback);
+    QVERIFY(frameRenderedSpy.wait());
+}
+
+void ClientStartupBenchmark::benchmarkStartup_data()
+{
+    QTest::addColumn<Stage>("stage");
+    QTest::addColumn<bool>("lazy");
+
+    QTest::newRow("connect") << Stage::Connect << false;
+    QTest::newRow("announce") << Stage::Announce << false;
+    QTest::newRow("bindAll") << Stage::Bind << false;
+    QTest::newRow("bindAll/first frame") << Stage::FirstFrame << false;
+    QTest::newRow("lazy") << Stage::Bind << true;
+    QTest::newRow("lazy/first frame") << Stage::FirstFrame << true;
+}
+
+void ClientStartupBenchmark::benchmarkStartup()
+{
+    // each iteration is a complete client startup, the stages allow to compute the cost of each step
+    QFETCH(Stage, stage);
+    QFETCH(bool, lazy);
+    QBENCHMARK {
+        startClient(stage, lazy);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(ClientStartupBenchmark)
+#include "bench_client_startup.moc"
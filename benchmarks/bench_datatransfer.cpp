@@ -0,0 +1,270 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/datadevice.h"
+#include "../src/client/datadevicemanager.h"
+#include "../src/client/dataoffer.h"
+#include "../src/client/datasource.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/keyboard.h"
+#include "../src/client/registry.h"
+#include "../src/client/seat.h"
+#include "../src/client/surface.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/surface_interface.h"
+#include "server_globals.h"
+
+#include <unistd.h>
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+/**
+ * How the source side serves the data.
+ **/
+enum class Source {
+    // the application handles sendDataRequested with a QFile write loop on the GUI thread
+    Signal,
+    // DataSource::setData
+    Data,
+    // DataSource::setFile
+    File
+};
+Q_DECLARE_METATYPE(Source)
+
+class DataTransferBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkTransfer_data();
+    void benchmarkTransfer();
+
+private:
+    Display *m_display = nullptr;
+    ServerGlobals m_globals;
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Compositor *m_compositor = nullptr;
+    Seat *m_seat = nullptr;
+    Keyboard *m_keyboard = nullptr;
+    DataDeviceManager *m_ddm = nullptr;
+    DataDevice *m_dataDevice = nullptr;
+    Surface *m_surface = nullptr;
+    quint32 m_serial = 0;
+    QByteArray m_payload;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-datatransfer-0");
+static const QString s_mimeType = QStringLiteral("application/octet-stream");
+static const int s_payloadSize = 100 * 1024 * 1024;
+
+void DataTransferBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_globals = createServerGlobals(m_display);
+
+    m_payload = QByteArray(s_payloadSize, Qt::Uninitialized);
+    for (int i = 0; i < s_payloadSize; ++i) {
+        m_payload[i] = char(i % 251);
+    }
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    QSignalSpy interfacesBoundSpy(&registry, &Registry::interfacesBound);
+    QVERIFY(interfacesBoundSpy.isValid());
+    const auto objects = registry.bindAll({Registry::Interface::Compositor,
+                                           Registry::Interface::Seat,
+                                           Registry::Interface::DataDeviceManager}, this);
+    QCOMPARE(objects.count(), 3);
+    QVERIFY(interfacesBoundSpy.wait());
+    m_compositor = qobject_cast<Compositor*>(objects.at(0));
+    m_seat = qobject_cast<Seat*>(objects.at(1));
+    m_ddm = qobject_cast<DataDeviceManager*>(objects.at(2));
+    QVERIFY(m_compositor);
+    QVERIFY(m_seat);
+    QVERIFY(m_ddm);
+
+    if (!m_seat->hasKeyboard()) {
+        QSignalSpy keyboardChangedSpy(m_seat, &Seat::hasKeyboardChanged);
+        QVERIFY(keyboardChangedSpy.isValid());
+        QVERIFY(keyboardChangedSpy.wait());
+    }
+    m_keyboard = m_seat->createKeyboard(this);
+    m_dataDevice = m_ddm->getDataDevice(m_seat, this);
+    QVERIFY(m_dataDevice->isValid());
+
+    // give keyboard focus to the client, the serial is needed to set the selection
+    QSignalSpy surfaceCreatedSpy(m_globals.compositor, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QSignalSpy keyboardEnteredSpy(m_keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredSpy.isValid());
+    m_surface = m_compositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_globals.seat->setFocusedKeyboardSurface(surfaceCreatedSpy.first().first().value<SurfaceInterface*>());
+    QVERIFY(keyboardEnteredSpy.wait());
+    m_serial = keyboardEnteredSpy.first().first().value<quint32>();
+}
+
+void DataTransferBenchmark::cleanupTestCase()
+{
+    delete m_surface;
+    m_surface = nullptr;
+    delete m_dataDevice;
+    m_dataDevice = nullptr;
+    delete m_keyboard;
+    m_keyboard = nullptr;
+    delete m_ddm;
+    m_ddm = nullptr;
+    delete m_seat;
+    m_seat = nullptr;
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void DataTransferBenchmark::benchmarkTransfer_data()
+{
+    QTest::addColumn<Source>("source");
+    QTest::addColumn<bool>("toFile");
+
+    QTest::newRow("sendDataRequested/receiveData") << Source::Signal << false;
+    QTest::newRow("setData/receiveData") << Source::Data << false;
+    QTest::newRow("setFile/receiveData") << Source::File << false;
+    QTest::newRow("setData/receiveToFile") << Source::Data << true;
+    QTest::newRow("setFile/receiveToFile") << Source::File << true;
+}
+
+void DataTransferBenchmark::benchmarkTransfer()
+{
+    // transfers a 100 MB selection from the client to itself through the compositor
+    QFETCH(Source, source);
+    QScopedPointer<DataSource> dataSource(m_ddm->createDataSource());
+    QTemporaryFile sourceFile;
+    switch (source) {
+    case Source::Signal:
+        dataSource->offer(s_mimeType);
+        connect(dataSource.data(), &DataSource::sendDataRequested, this,
+            [this] (const QString &mimeType, qint32 fd) {
+                Q_UNUSED(mimeType)
+                QFile file;
+                if (file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle)) {
+                    const int chunkSize = 64 * 1024;
+                    for (int offset = 0; offset < m_payload.size(); offset += chunkSize) {
+                        file.write(m_payload.constData() + offset, qMin(chunkSize, m_payload.size() - offset));
+                    }
+                    file.close();
+                } else {
+                    close(fd);
+                }
+            }
+        );
+        break;
+    case Source::Data:
+        dataSource->setData(s_mimeType, m_payload);
+        break;
+    case Source::File:
+        QVERIFY(sourceFile.open());
+        QCOMPARE(sourceFile.write(m_payload), qint64(s_payloadSize));
+        QVERIFY(sourceFile.flush());
+        QVERIFY(dataSource->setFile(s_mimeType, sourceFile.handle()));
+        break;
+    }
+    QSignalSpy selectionOfferedSpy(m_dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedSpy.isValid());
+    m_dataDevice->setSelection(m_serial, dataSource.data());
+    QVERIFY(selectionOfferedSpy.wait());
+    DataOffer *offer = selectionOfferedSpy.last().first().value<DataOffer*>();
+    QVERIFY(offer);
+
+    QFETCH(bool, toFile);
+    QSignalSpy dataReceivedSpy(offer, &DataOffer::dataReceived);
+    QVERIFY(dataReceivedSpy.isValid());
+    QSignalSpy receivedToFileSpy(offer, &DataOffer::receivedToFile);
+    QVERIFY(receivedToFileSpy.isValid());
+    QTemporaryFile targetFile;
+    QVERIFY(targetFile.open());
+
+    QBENCHMARK {
+        if (toFile) {
+            targetFile.seek(0);
+            QVERIFY(offer->receiveToFile(s_mimeType, targetFile.handle()));
+            QVERIFY(receivedToFileSpy.wait(30000));
+            QCOMPARE(receivedToFileSpy.takeFirst().last().value<qint64>(), qint64(s_payloadSize));
+        } else {
+            offer->receiveData(s_mimeType);
+            QVERIFY(dataReceivedSpy.wait(30000));
+            QCOMPARE(dataReceivedSpy.takeFirst().last().toByteArray().size(), s_payloadSize);
+        }
+    }
+
+    m_dataDevice->setSelection(m_serial, nullptr);
+}
+
+QTEST_GUILESS_MAIN(DataTransferBenchmark)
+#include "bench_datatransfer.moc"
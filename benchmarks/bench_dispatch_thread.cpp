@@ -0,0 +1,168 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// server
+#include "../src/server/clientconnection.h"
+#include "../src/server/display.h"
+// Wayland
+#include <wayland-client.h>
+// system
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <functional>
+
+using namespace KWayland::Server;
+
+Q_DECLARE_METATYPE(KWayland::Server::Display::DispatchMode)
+
+/**
+ * A plain client doing roundtrips in its own thread.
+ **/
+class RoundtripClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RoundtripClient(int fd)
+        : m_display(wl_display_connect_to_fd(fd))
+    {
+    }
+    ~RoundtripClient() override
+    {
+        if (m_display) {
+            wl_display_disconnect(m_display);
+        }
+    }
+    bool isValid() const
+    {
+        return m_display != nullptr;
+    }
+
+public Q_SLOTS:
+    void roundtrip()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        wl_display_roundtrip(m_display);
+        emit done(timer.nsecsElapsed());
+    }
+
+Q_SIGNALS:
+    void done(qint64 nsecs);
+
+private:
+    wl_display *m_display;
+};
+
+class DispatchThreadBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkRoundtrip_data();
+    void benchmarkRoundtrip();
+};
+
+// how long a frame blocks the compositor's thread
+static const int s_paintTime = 8;
+
+static void runInDisplayThread(Display *display, const std::function<void()> &function)
+{
+    if (display->dispatchThread()) {
+        QMetaObject::invokeMethod(display, function, Qt::BlockingQueuedConnection);
+    } else {
+        function();
+    }
+}
+
+void DispatchThreadBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWayland::Server::Display::DispatchMode>();
+}
+
+void DispatchThreadBenchmark::benchmarkRoundtrip_data()
+{
+    QTest::addColumn<Display::DispatchMode>("mode");
+
+    QTest::newRow("event loop") << Display::DispatchMode::EventLoop;
+    QTest::newRow("dedicated thread") << Display::DispatchMode::DedicatedThread;
+}
+
+void DispatchThreadBenchmark::benchmarkRoundtrip()
+{
+    // a client does a roundtrip while the compositor's thread paints a frame, measures
+    // the frames and reports the latency the client saw
+    QFETCH(Display::DispatchMode, mode);
+
+    QScopedPointer<Display> display(new Display);
+    display->setDispatchMode(mode);
+    display->start(Display::StartMode::ConnectClientsOnly);
+    QVERIFY(display->isRunning());
+    QCOMPARE(display->dispatchThread() != nullptr, mode == Display::DispatchMode::DedicatedThread);
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+    ClientConnection *connection = nullptr;
+    runInDisplayThread(display.data(), [&display, &connection, &sv] { connection = display->createClient(sv[0]); });
+    QVERIFY(connection);
+
+    QThread clientThread;
+    RoundtripClient *client = new RoundtripClient(sv[1]);
+    QVERIFY(client->isValid());
+    client->moveToThread(&clientThread);
+    clientThread.start();
+
+    QVector<qint64> latencies;
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    const auto doneConnection = connect(client, &RoundtripClient::done, this,
+        [&latencies, &loop] (qint64 nsecs) {
+            latencies << nsecs;
+            loop.quit();
+        }
+    );
+
+    QBENCHMARK {
+        QMetaObject::invokeMethod(client, "roundtrip", Qt::QueuedConnection);
+        QThread::msleep(s_paintTime);
+        const int count = latencies.count();
+        timeout.start(1000);
+        loop.exec();
+        timeout.stop();
+        QCOMPARE(latencies.count(), count + 1);
+    }
+    disconnect(doneConnection);
+
+    clientThread.quit();
+    clientThread.wait();
+    delete client;
+    display.reset();
+
+    std::sort(latencies.begin(), latencies.end());
+    qDebug() << "roundtrip latency median" << latencies.at(latencies.count() / 2) / 1000 << "us, max"
+             << latencies.last() / 1000 << "us with a paint of" << s_paintTime << "ms";
+}
+
+QTEST_GUILESS_MAIN(DispatchThreadBenchmark)
+#include "bench_dispatch_thread.moc"
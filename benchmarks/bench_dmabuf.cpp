@@ -0,0 +1,329 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/linuxdmabuf.h"
+#include "../src/client/registry.h"
+#include "../src/client/shm_pool.h"
+#include "../src/client/surface.h"
+// server
+#include "../src/server/buffer_interface.h"
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/drm_fourcc.h"
+#include "../src/server/surface_interface.h"
+#include "../autotests/client/cpudmabuf.h"
+// Wayland
+#include <wayland-client-protocol.h>
+// system
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+Q_DECLARE_OPAQUE_POINTER(wl_buffer*)
+Q_DECLARE_METATYPE(wl_buffer*)
+
+class DmabufBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkBind_data();
+    void benchmarkBind();
+    void benchmarkImport_data();
+    void benchmarkImport();
+    void benchmarkSubmit_data();
+    void benchmarkSubmit();
+
+private:
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+    LinuxDmabufUnstableV1Interface *m_linuxDmabufInterface = nullptr;
+    CpuDmabufImpl m_impl;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Compositor *m_compositor = nullptr;
+    ShmPool *m_shm = nullptr;
+    LinuxDmabuf *m_linuxDmabuf = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-dmabuf-0");
+
+static bool waitForLiveBuffers(int count)
+{
+    // the import of create_immed and the destruction are not announced to the client,
+    // dispatch until the compositor handled them instead of polling in QTRY_COMPARE steps
+    QDeadlineTimer deadline(5000);
+    while (CpuDmabufBuffer::s_liveBuffers != count) {
+        if (deadline.hasExpired()) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    return true;
+}
+
+void DmabufBenchmark::initTestCase()
+{
+    qRegisterMetaType<wl_buffer*>();
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+    m_compositorInterface = m_display->createCompositor(this);
+    m_compositorInterface->create();
+    m_linuxDmabufInterface = m_display->createLinuxDmabufInterface(this);
+    m_linuxDmabufInterface->setImpl(&m_impl);
+    m_linuxDmabufInterface->setSupportedFormatsWithModifiers(CpuDmabufImpl::supportedFormats());
+    // the first render node, needed for the dmabuf feedback
+    m_linuxDmabufInterface->setMainDevice(makedev(226, 128));
+    m_linuxDmabufInterface->create();
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+    m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+    const auto shm = m_registry->interface(Registry::Interface::Shm);
+    m_shm = m_registry->createShmPool(shm.name, shm.version, this);
+    const auto linuxDmabuf = m_registry->interface(Registry::Interface::LinuxDmabufUnstableV1);
+    m_linuxDmabuf = m_registry->createLinuxDmabuf(linuxDmabuf.name, linuxDmabuf.version, this);
+    QVERIFY(m_compositor->isValid());
+    QVERIFY(m_shm->isValid());
+    QVERIFY(m_linuxDmabuf->isValid());
+}
+
+void DmabufBenchmark::cleanupTestCase()
+{
+    delete m_linuxDmabuf;
+    m_linuxDmabuf = nullptr;
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void DmabufBenchmark::benchmarkBind_data()
+{
+    QTest::addColumn<int>("formatCount");
+    QTest::addColumn<quint32>("version");
+
+    const quint32 maxVersion = m_registry->interface(Registry::Interface::LinuxDmabufUnstableV1).version;
+    for (int formatCount : {16, 256, 1024}) {
+        for (quint32 version = 3; version <= maxVersion; ++version) {
+            QTest::newRow(qPrintable(QStringLiteral("%1/v%2").arg(formatCount).arg(version))) << formatCount << version;
+        }
+    }
+}
+
+void DmabufBenchmark::benchmarkBind()
+{
+    // what every client pays for learning the formats: version 3 gets one event per
+    // format and modifier, version 4 maps the format table the compositor shares
+    QFETCH(int, formatCount);
+    QFETCH(quint32, version);
+
+    QHash<uint32_t, QSet<uint64_t>> formats;
+    for (int i = 0; i < formatCount; ++i) {
+        formats[DRM_FORMAT_XRGB8888 + i / 16].insert(i % 16);
+    }
+    m_linuxDmabufInterface->setSupportedFormatsWithModifiers(formats);
+
+    const auto linuxDmabuf = m_registry->interface(Registry::Interface::LinuxDmabufUnstableV1);
+    QSignalSpy interfacesBoundSpy(m_registry, &Registry::interfacesBound);
+    QVERIFY(interfacesBoundSpy.isValid());
+    QBENCHMARK {
+        QScopedPointer<LinuxDmabuf> client(m_registry->createLinuxDmabuf(linuxDmabuf.name, version));
+        QVERIFY(client->isValid());
+        // the sync of bindAll acts as the roundtrip delivering the formats
+        m_registry->bindAll({});
+        QVERIFY(interfacesBoundSpy.wait());
+        QCOMPARE(client->supportedFormats().count(), formats.count());
+    }
+
+    m_linuxDmabufInterface->setSupportedFormatsWithModifiers(CpuDmabufImpl::supportedFormats());
+}
+
+void DmabufBenchmark::benchmarkImport_data()
+{
+    QTest::addColumn<bool>("immediate");
+
+    QTest::newRow("create") << false;
+    QTest::newRow("createImmediate") << true;
+}
+
+void DmabufBenchmark::benchmarkImport()
+{
+    // what a client pays for each new buffer of its swapchain
+    QFETCH(bool, immediate);
+    QImage image(QSize(1920, 1080), QImage::Format_RGB32);
+    image.fill(Qt::white);
+    const int fd = createCpuDmabuf(image.constBits(), image.sizeInBytes());
+    QVERIFY(fd != -1);
+
+    QBENCHMARK {
+        QScopedPointer<LinuxDmabufParams> params(m_linuxDmabuf->createParams());
+        params->addPlane(fd, 0, 0, image.bytesPerLine(), DRM_FORMAT_MOD_LINEAR);
+        wl_buffer *buffer = nullptr;
+        if (immediate) {
+            buffer = params->createImmediate(image.size(), DRM_FORMAT_XRGB8888);
+            m_connection->flush();
+            QVERIFY(waitForLiveBuffers(1));
+        } else {
+            QSignalSpy createdSpy(params.data(), &LinuxDmabufParams::created);
+            params->create(image.size(), DRM_FORMAT_XRGB8888);
+            QVERIFY(createdSpy.wait());
+            buffer = createdSpy.first().first().value<wl_buffer*>();
+        }
+        QVERIFY(buffer);
+        wl_buffer_destroy(buffer);
+        m_connection->flush();
+        QVERIFY(waitForLiveBuffers(0));
+    }
+    close(fd);
+}
+
+void DmabufBenchmark::benchmarkSubmit_data()
+{
+    QTest::addColumn<bool>("dmabuf");
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("shm/256x256") << false << QSize(256, 256);
+    QTest::newRow("dmabuf/256x256") << true << QSize(256, 256);
+    QTest::newRow("shm/1920x1080") << false << QSize(1920, 1080);
+    QTest::newRow("dmabuf/1920x1080") << true << QSize(1920, 1080);
+}
+
+void DmabufBenchmark::benchmarkSubmit()
+{
+    // a frame: the client renders into its buffer, submits it and the compositor reads it;
+    // shm copies the frame into the pool, the dmabuf is rendered into in place
+    QFETCH(bool, dmabuf);
+    QFETCH(QSize, size);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QSignalSpy damagedSpy(serverSurface, &SurfaceInterface::damaged);
+    QVERIFY(damagedSpy.isValid());
+
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(Qt::black);
+    int fd = -1;
+    uchar *map = nullptr;
+    wl_buffer *buffer = nullptr;
+    if (dmabuf) {
+        fd = createCpuDmabuf(image.constBits(), image.sizeInBytes());
+        QVERIFY(fd != -1);
+        map = static_cast<uchar*>(mmap(nullptr, image.sizeInBytes(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+        QVERIFY(map != MAP_FAILED);
+        QScopedPointer<LinuxDmabufParams> params(m_linuxDmabuf->createParams());
+        params->addPlane(fd, 0, 0, image.bytesPerLine(), DRM_FORMAT_MOD_LINEAR);
+        buffer = params->createImmediate(image.size(), DRM_FORMAT_XRGB8888);
+        QVERIFY(buffer);
+        image = QImage(map, size.width(), size.height(), image.bytesPerLine(), QImage::Format_RGB32);
+    }
+
+    int frame = 0;
+    QBENCHMARK {
+        const QColor color = (++frame % 2) ? Qt::red : Qt::blue;
+        image.fill(color);
+        if (dmabuf) {
+            surface->attachBuffer(buffer);
+        } else {
+            surface->attachBuffer(m_shm->createBuffer(image));
+        }
+        surface->damage(QRect(QPoint(0, 0), size));
+        surface->commit(Surface::CommitFlag::None);
+        QVERIFY(damagedSpy.wait());
+        BufferInterface *serverBuffer = serverSurface->buffer();
+        QVERIFY(serverBuffer);
+        QRgb pixel;
+        if (dmabuf) {
+            pixel = static_cast<CpuDmabufBuffer*>(serverBuffer->linuxDmabufBuffer())->image().pixel(0, 0);
+        } else {
+            pixel = serverBuffer->data().pixel(0, 0);
+        }
+        QCOMPARE(pixel, color.rgb());
+    }
+
+    surface.reset();
+    if (dmabuf) {
+        wl_buffer_destroy(buffer);
+        m_connection->flush();
+        QVERIFY(waitForLiveBuffers(0));
+        munmap(map, image.sizeInBytes());
+        close(fd);
+    }
+}
+
+QTEST_GUILESS_MAIN(DmabufBenchmark)
+#include "bench_dmabuf.moc"
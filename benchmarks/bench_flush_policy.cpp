@@ -0,0 +1,240 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/registry.h"
+#include "../src/client/seat.h"
+#include "../src/client/surface.h"
+#include "../src/client/touch.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/surface_interface.h"
+
+#include "server_globals.h"
+
+// system
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+Q_DECLARE_METATYPE(KWayland::Server::Display::FlushPolicy)
+
+// libwayland writes the events to a client with one sendmsg per flush, the definition
+// in the executable takes precedence over the one of the C library
+static pthread_t s_serverThread;
+static quint64 s_sendmsgCalls = 0;
+
+extern "C" ssize_t sendmsg(int fd, const struct msghdr *message, int flags)
+{
+    if (pthread_equal(pthread_self(), s_serverThread)) {
+        ++s_sendmsgCalls;
+    }
+    return syscall(SYS_sendmsg, fd, message, flags);
+}
+
+class FlushPolicyBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkTouch_data();
+    void benchmarkTouch();
+
+private:
+    struct Client {
+        ConnectionThread *connection = nullptr;
+        QThread *thread = nullptr;
+        EventQueue *queue = nullptr;
+        Registry *registry = nullptr;
+        Compositor *compositor = nullptr;
+        Seat *seat = nullptr;
+        Touch *touch = nullptr;
+        Surface *surface = nullptr;
+        SurfaceInterface *serverSurface = nullptr;
+    };
+    bool setupClient(Client *client);
+    void cleanupClient(Client *client);
+
+    Display *m_display = nullptr;
+    ServerGlobals m_globals;
+    QVector<Client> m_clients;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-flush-policy-0");
+static const int s_clientCount = 10;
+// touch motion events sent to each client per frame
+static const int s_motionCount = 20;
+
+bool FlushPolicyBenchmark::setupClient(Client *client)
+{
+    client->connection = new ConnectionThread;
+    QSignalSpy connectedSpy(client->connection, &ConnectionThread::connected);
+    client->connection->setSocketName(s_socketName);
+    client->thread = new QThread(this);
+    client->connection->moveToThread(client->thread);
+    client->thread->start();
+    client->connection->initConnection();
+    if (!connectedSpy.wait()) {
+        return false;
+    }
+    client->queue = new EventQueue(this);
+    client->queue->setup(client->connection);
+
+    client->registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(client->registry, &Registry::interfacesAnnounced);
+    client->registry->setEventQueue(client->queue);
+    client->registry->create(client->connection);
+    client->registry->setup();
+    if (!interfacesAnnouncedSpy.wait()) {
+        return false;
+    }
+    QSignalSpy interfacesBoundSpy(client->registry, &Registry::interfacesBound);
+    const auto objects = client->registry->bindAll({Registry::Interface::Compositor,
+                                                   Registry::Interface::Seat}, this);
+    if (objects.count() != 2 || !interfacesBoundSpy.wait()) {
+        return false;
+    }
+    client->compositor = qobject_cast<Compositor*>(objects.at(0));
+    client->seat = qobject_cast<Seat*>(objects.at(1));
+    client->touch = client->seat->createTouch(this);
+
+    // the surface gets created after the touch on the server
+    QSignalSpy surfaceCreatedSpy(m_globals.compositor, &CompositorInterface::surfaceCreated);
+    client->surface = client->compositor->createSurface(this);
+    if (!surfaceCreatedSpy.wait()) {
+        return false;
+    }
+    client->serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    return true;
+}
+
+void FlushPolicyBenchmark::cleanupClient(Client *client)
+{
+    delete client->surface;
+    delete client->touch;
+    delete client->seat;
+    delete client->compositor;
+    delete client->registry;
+    delete client->queue;
+    client->connection->deleteLater();
+    client->thread->quit();
+    client->thread->wait();
+    delete client->thread;
+}
+
+void FlushPolicyBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWayland::Server::Display::FlushPolicy>();
+    s_serverThread = pthread_self();
+
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_globals = createServerGlobals(m_display);
+
+    m_clients.resize(s_clientCount);
+    for (int i = 0; i < m_clients.count(); ++i) {
+        QVERIFY(setupClient(&m_clients[i]));
+    }
+    if (s_sendmsgCalls == 0) {
+        QSKIP("sendmsg calls of libwayland cannot be counted");
+    }
+}
+
+void FlushPolicyBenchmark::cleanupTestCase()
+{
+    for (int i = 0; i < m_clients.count(); ++i) {
+        cleanupClient(&m_clients[i]);
+    }
+    m_clients.clear();
+    delete m_display;
+    m_display = nullptr;
+}
+
+void FlushPolicyBenchmark::benchmarkTouch_data()
+{
+    QTest::addColumn<Display::FlushPolicy>("policy");
+
+    QTest::newRow("immediate") << Display::FlushPolicy::Immediate;
+    QTest::newRow("event loop") << Display::FlushPolicy::EventLoop;
+    QTest::newRow("explicit") << Display::FlushPolicy::Explicit;
+}
+
+void FlushPolicyBenchmark::benchmarkTouch()
+{
+    // a touch sequence on the window of each client within one frame, measures until the
+    // last client got its last touch frame and reports the syscalls writing the events
+    QFETCH(Display::FlushPolicy, policy);
+    m_display->setFlushPolicy(policy);
+
+    QSignalSpy frameEndedSpy(m_clients.last().touch, &Touch::frameEnded);
+    QVERIFY(frameEndedSpy.isValid());
+    SeatInterface *seat = m_globals.seat;
+    quint32 timestamp = 0;
+
+    int frames = 0;
+    const quint64 sendmsgCalls = s_sendmsgCalls;
+    QBENCHMARK {
+        frameEndedSpy.clear();
+        for (const Client &client : qAsConst(m_clients)) {
+            seat->setFocusedTouchSurface(client.serverSurface);
+            seat->setTimestamp(++timestamp);
+            const qint32 id = seat->touchDown(QPointF(0, 0));
+            seat->touchFrame();
+            for (int i = 0; i < s_motionCount; ++i) {
+                seat->setTimestamp(++timestamp);
+                seat->touchMove(id, QPointF(i, i));
+                seat->touchFrame();
+            }
+            seat->setTimestamp(++timestamp);
+            seat->touchUp(id);
+            seat->touchFrame();
+        }
+        if (policy == Display::FlushPolicy::Explicit) {
+            // the compositor flushes once it repainted
+            m_display->flushClients();
+        }
+        while (frameEndedSpy.count() < s_motionCount + 2) {
+            QVERIFY(frameEndedSpy.wait());
+        }
+        ++frames;
+    }
+    seat->setFocusedTouchSurface(nullptr);
+    m_display->setFlushPolicy(Display::FlushPolicy::Immediate);
+
+    qDebug() << (s_sendmsgCalls - sendmsgCalls) / qMax(frames, 1) << "sendmsg calls per frame for"
+             << s_clientCount * (s_motionCount + 2) * 2 << "touch events";
+}
+
+QTEST_GUILESS_MAIN(FlushPolicyBenchmark)
+#include "bench_flush_policy.moc"
@@ -0,0 +1,161 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/idle.h"
+#include "../src/client/registry.h"
+#include "../src/client/seat.h"
+// server
+#include "../src/server/display.h"
+#include "../src/server/idle_interface.h"
+#include "../src/server/seat_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+class IdleBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkInputEvent_data();
+    void benchmarkInputEvent();
+
+private:
+    Display *m_display = nullptr;
+    SeatInterface *m_seatInterface = nullptr;
+    IdleInterface *m_idleInterface = nullptr;
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Seat *m_seat = nullptr;
+    Idle *m_idle = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-idle-0");
+
+void IdleBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_seatInterface = m_display->createSeat(this);
+    m_seatInterface->setName(QStringLiteral("seat0"));
+    m_seatInterface->create();
+    m_idleInterface = m_display->createIdle(this);
+    m_idleInterface->create();
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    m_seat = registry.createSeat(registry.interface(Registry::Interface::Seat).name,
+                                 registry.interface(Registry::Interface::Seat).version,
+                                 this);
+    QVERIFY(m_seat->isValid());
+    m_idle = registry.createIdle(registry.interface(Registry::Interface::Idle).name,
+                                 registry.interface(Registry::Interface::Idle).version,
+                                 this);
+    QVERIFY(m_idle->isValid());
+}
+
+void IdleBenchmark::cleanupTestCase()
+{
+    delete m_idle;
+    m_idle = nullptr;
+    delete m_seat;
+    m_seat = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void IdleBenchmark::benchmarkInputEvent_data()
+{
+    QTest::addColumn<int>("timeouts");
+
+    QTest::newRow("0") << 0;
+    QTest::newRow("1") << 1;
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+}
+
+void IdleBenchmark::benchmarkInputEvent()
+{
+    // the cost of an input event must not depend on the number of idle timeouts
+    QFETCH(int, timeouts);
+    QVector<IdleTimeout*> idleTimeouts;
+    for (int i = 0; i < timeouts; ++i) {
+        // a spread of durations as screen lockers, power management and chat clients use
+        idleTimeouts << m_idle->getTimeout(60000 + i * 1000, m_seat, this);
+    }
+    m_connection->flush();
+    m_display->dispatchEvents();
+
+    quint32 timestamp = 0;
+    QBENCHMARK {
+        m_seatInterface->setTimestamp(++timestamp);
+    }
+
+    qDeleteAll(idleTimeouts);
+    m_connection->flush();
+    m_display->dispatchEvents();
+}
+
+QTEST_GUILESS_MAIN(IdleBenchmark)
+#include "bench_idle.moc"
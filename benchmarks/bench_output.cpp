@@ -0,0 +1,228 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/output.h"
+#include "../src/client/registry.h"
+// server
+#include "../src/server/display.h"
+#include "../src/server/output_interface.h"
+#include "../src/server/outputdevice_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+class OutputBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkBind();
+    void benchmarkReconfigure_data();
+    void benchmarkReconfigure();
+
+private:
+    struct Client {
+        ConnectionThread *connection = nullptr;
+        QThread *thread = nullptr;
+        EventQueue *queue = nullptr;
+        Registry *registry = nullptr;
+        QVector<QObject *> objects;
+    };
+    bool setupClient(Client *client);
+    void cleanupClient(Client *client);
+
+    Display *m_display = nullptr;
+    QVector<OutputInterface *> m_outputs;
+    QVector<OutputDeviceInterface *> m_outputDevices;
+    QVector<Client> m_clients;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-output-0");
+static const int s_outputCount = 4;
+static const int s_clientCount = 60;
+
+bool OutputBenchmark::setupClient(Client *client)
+{
+    client->connection = new ConnectionThread;
+    QSignalSpy connectedSpy(client->connection, &ConnectionThread::connected);
+    client->connection->setSocketName(s_socketName);
+    client->thread = new QThread(this);
+    client->connection->moveToThread(client->thread);
+    client->thread->start();
+    client->connection->initConnection();
+    if (!connectedSpy.wait()) {
+        return false;
+    }
+    client->queue = new EventQueue(this);
+    client->queue->setup(client->connection);
+
+    client->registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(client->registry, &Registry::interfacesAnnounced);
+    client->registry->setEventQueue(client->queue);
+    client->registry->create(client->connection);
+    client->registry->setup();
+    if (!interfacesAnnouncedSpy.wait()) {
+        return false;
+    }
+    QSignalSpy interfacesBoundSpy(client->registry, &Registry::interfacesBound);
+    client->objects = client->registry->bindAll({Registry::Interface::Output, Registry::Interface::OutputDevice}, this);
+    return client->objects.count() == 2 * s_outputCount && interfacesBoundSpy.wait();
+}
+
+void OutputBenchmark::cleanupClient(Client *client)
+{
+    qDeleteAll(client->objects);
+    client->objects.clear();
+    delete client->registry;
+    delete client->queue;
+    client->connection->deleteLater();
+    client->thread->quit();
+    client->thread->wait();
+    delete client->thread;
+}
+
+void OutputBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    // a 256 byte edid as reported by most monitors
+    QByteArray edid(256, '\0');
+    for (int i = 0; i < edid.size(); ++i) {
+        edid[i] = char(i);
+    }
+
+    for (int i = 0; i < s_outputCount; ++i) {
+        OutputInterface *output = m_display->createOutput(this);
+        output->setManufacturer(QStringLiteral("KDE"));
+        output->setModel(QStringLiteral("Benchmark Display %1").arg(i));
+        output->setPhysicalSize(QSize(520, 290));
+        output->setGlobalPosition(QPoint(i * 1920, 0));
+        output->addMode(QSize(1280, 720));
+        output->addMode(QSize(1920, 1080), OutputInterface::ModeFlag::Preferred);
+        output->addMode(QSize(2560, 1440));
+        output->setCurrentMode(QSize(1920, 1080));
+        output->create();
+        m_outputs << output;
+
+        OutputDeviceInterface *device = m_display->createOutputDevice(this);
+        device->setManufacturer(QStringLiteral("KDE"));
+        device->setModel(QStringLiteral("Benchmark Display %1").arg(i));
+        device->setSerialNumber(QStringLiteral("0123456789-%1").arg(i));
+        device->setEisaId(QStringLiteral("KDE"));
+        device->setUuid(QByteArray::number(i));
+        device->setEdid(edid);
+        device->setPhysicalSize(QSize(520, 290));
+        device->setGlobalPosition(QPoint(i * 1920, 0));
+        const QVector<QSize> sizes = {QSize(1280, 720), QSize(1920, 1080), QSize(2560, 1440)};
+        for (int j = 0; j < sizes.count(); ++j) {
+            OutputDeviceInterface::Mode mode;
+            mode.id = j;
+            mode.size = sizes.at(j);
+            if (j == 1) {
+                mode.flags = OutputDeviceInterface::ModeFlag::Preferred | OutputDeviceInterface::ModeFlag::Current;
+            }
+            device->addMode(mode);
+        }
+        device->create();
+        m_outputDevices << device;
+    }
+
+    m_clients.resize(s_clientCount);
+    for (int i = 0; i < m_clients.count(); ++i) {
+        QVERIFY(setupClient(&m_clients[i]));
+    }
+}
+
+void OutputBenchmark::cleanupTestCase()
+{
+    for (int i = 0; i < m_clients.count(); ++i) {
+        cleanupClient(&m_clients[i]);
+    }
+    m_clients.clear();
+    delete m_display;
+    m_display = nullptr;
+}
+
+void OutputBenchmark::benchmarkBind()
+{
+    // what every client pays on startup and the compositor on hotplug: the complete output state
+    Client &client = m_clients.first();
+    QSignalSpy interfacesBoundSpy(client.registry, &Registry::interfacesBound);
+    QVERIFY(interfacesBoundSpy.isValid());
+
+    QBENCHMARK {
+        const auto objects = client.registry->bindAll({Registry::Interface::Output, Registry::Interface::OutputDevice});
+        QVERIFY(interfacesBoundSpy.wait());
+        qDeleteAll(objects);
+    }
+}
+
+void OutputBenchmark::benchmarkReconfigure_data()
+{
+    QTest::addColumn<bool>("batched");
+
+    QTest::newRow("immediate") << false;
+    QTest::newRow("batched") << true;
+}
+
+void OutputBenchmark::benchmarkReconfigure()
+{
+    // rearranging all outputs, e.g. after a screen got plugged in
+    QFETCH(bool, batched);
+    Output *lastOutput = qobject_cast<Output*>(m_clients.last().objects.at(s_outputCount - 1));
+    QVERIFY(lastOutput);
+    QSignalSpy changedSpy(lastOutput, &Output::changed);
+    QVERIFY(changedSpy.isValid());
+
+    bool toggle = false;
+    QBENCHMARK {
+        toggle = !toggle;
+        const QSize size = toggle ? QSize(2560, 1440) : QSize(1920, 1080);
+        const int scale = toggle ? 2 : 1;
+        for (int i = 0; i < m_outputs.count(); ++i) {
+            OutputInterface *output = m_outputs.at(i);
+            if (batched) {
+                output->beginChange();
+            }
+            output->setGlobalPosition(QPoint(i * size.width() / scale, 0));
+            output->setScale(scale);
+            output->setCurrentMode(size);
+            if (batched) {
+                output->commitChange();
+            }
+        }
+        while (lastOutput->pixelSize() != size || lastOutput->scale() != scale
+                || lastOutput->globalPosition() != QPoint((s_outputCount - 1) * size.width() / scale, 0)) {
+            QVERIFY(changedSpy.wait());
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(OutputBenchmark)
+#include "bench_output.moc"
@@ -0,0 +1,246 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/outputconfiguration.h"
+#include "../src/client/outputdevice.h"
+#include "../src/client/outputmanagement.h"
+#include "../src/client/registry.h"
+// server
+#include "../src/server/display.h"
+#include "../src/server/outputconfiguration_interface.h"
+#include "../src/server/outputdevice_interface.h"
+#include "../src/server/outputmanagement_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+class OutputManagementBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void benchmarkTest_data();
+    void benchmarkTest();
+    void benchmarkApply_data();
+    void benchmarkApply();
+
+private:
+    void createOutputDevices(int count);
+    void configure(OutputConfiguration *config, bool highResolution);
+
+    Display *m_display = nullptr;
+    OutputManagementInterface *m_outputManagementInterface = nullptr;
+    QVector<OutputDeviceInterface *> m_serverOutputs;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    OutputManagement *m_outputManagement = nullptr;
+    QVector<OutputDevice *> m_outputs;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-outputmanagement-0");
+
+void OutputManagementBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_outputManagementInterface = m_display->createOutputManagement(this);
+    m_outputManagementInterface->create();
+    m_outputManagementInterface->setValidationEnabled(true);
+    connect(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested, this,
+        [] (OutputConfigurationInterface *config) {
+            config->applyChanges();
+            config->setApplied();
+        }
+    );
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    const auto management = m_registry->interface(Registry::Interface::OutputManagement);
+    m_outputManagement = m_registry->createOutputManagement(management.name, management.version, this);
+    QVERIFY(m_outputManagement->isValid());
+}
+
+void OutputManagementBenchmark::cleanupTestCase()
+{
+    delete m_outputManagement;
+    m_outputManagement = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void OutputManagementBenchmark::init()
+{
+    QFETCH(int, outputs);
+    createOutputDevices(outputs);
+}
+
+void OutputManagementBenchmark::cleanup()
+{
+    qDeleteAll(m_outputs);
+    m_outputs.clear();
+    for (auto output : qAsConst(m_serverOutputs)) {
+        m_display->removeOutputDevice(output);
+    }
+    m_serverOutputs.clear();
+}
+
+void OutputManagementBenchmark::createOutputDevices(int count)
+{
+    // a row of identical monitors
+    QSignalSpy outputDeviceAnnouncedSpy(m_registry, &Registry::outputDeviceAnnounced);
+    QVERIFY(outputDeviceAnnouncedSpy.isValid());
+    for (int i = 0; i < count; ++i) {
+        OutputDeviceInterface *output = m_display->createOutputDevice(this);
+        OutputDeviceInterface::Mode mode;
+        mode.id = 0;
+        mode.size = QSize(1920, 1080);
+        mode.flags = OutputDeviceInterface::ModeFlag::Current | OutputDeviceInterface::ModeFlag::Preferred;
+        output->addMode(mode);
+        mode.id = 1;
+        mode.size = QSize(3840, 2160);
+        mode.flags = OutputDeviceInterface::ModeFlags();
+        output->addMode(mode);
+        output->setGlobalPosition(QPoint(i * 1920, 0));
+        output->create();
+        m_serverOutputs << output;
+    }
+    while (outputDeviceAnnouncedSpy.count() < count) {
+        QVERIFY(outputDeviceAnnouncedSpy.wait());
+    }
+
+    QSignalSpy interfacesBoundSpy(m_registry, &Registry::interfacesBound);
+    QVERIFY(interfacesBoundSpy.isValid());
+    const auto objects = m_registry->bindAll({Registry::Interface::OutputDevice}, this);
+    QCOMPARE(objects.count(), count);
+    QVERIFY(interfacesBoundSpy.wait());
+    for (QObject *object : objects) {
+        m_outputs << qobject_cast<OutputDevice*>(object);
+    }
+}
+
+void OutputManagementBenchmark::configure(OutputConfiguration *config, bool highResolution)
+{
+    // switching between 1080p at scale 1 and 2160p at scale 2 keeps the logical layout
+    for (int i = 0; i < m_outputs.count(); ++i) {
+        OutputDevice *output = m_outputs.at(i);
+        config->setMode(output, highResolution ? 1 : 0);
+        config->setScaleF(output, highResolution ? 2.0 : 1.0);
+        config->setPosition(output, QPoint(i * 1920, 0));
+    }
+}
+
+void OutputManagementBenchmark::benchmarkTest_data()
+{
+    QTest::addColumn<int>("outputs");
+
+    QTest::newRow("2") << 2;
+    QTest::newRow("8") << 8;
+    QTest::newRow("32") << 32;
+}
+
+void OutputManagementBenchmark::benchmarkTest()
+{
+    // a dry run as done by a settings module while the user drags outputs around
+    OutputConfiguration *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy testPassedSpy(config, &OutputConfiguration::testPassed);
+    QVERIFY(testPassedSpy.isValid());
+
+    bool highResolution = false;
+    QBENCHMARK {
+        highResolution = !highResolution;
+        configure(config, highResolution);
+        config->test();
+        QVERIFY(testPassedSpy.wait());
+    }
+    delete config;
+}
+
+void OutputManagementBenchmark::benchmarkApply_data()
+{
+    benchmarkTest_data();
+}
+
+void OutputManagementBenchmark::benchmarkApply()
+{
+    // validating, applying and announcing the new layout to the client
+    OutputConfiguration *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy appliedSpy(config, &OutputConfiguration::applied);
+    QVERIFY(appliedSpy.isValid());
+
+    bool highResolution = false;
+    QBENCHMARK {
+        highResolution = !highResolution;
+        configure(config, highResolution);
+        config->apply();
+        QVERIFY(appliedSpy.wait());
+    }
+    QCOMPARE(m_serverOutputs.last()->currentModeId(), highResolution ? 1 : 0);
+    delete config;
+}
+
+QTEST_GUILESS_MAIN(OutputManagementBenchmark)
+#include "bench_outputmanagement.moc"
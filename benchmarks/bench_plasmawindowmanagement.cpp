@@ -0,0 +1,177 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/plasmawindowmanagement.h"
+#include "../src/client/registry.h"
+// server
+#include "../src/server/display.h"
+#include "../src/server/plasmawindowmanagement_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+class PlasmaWindowManagementBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkBind();
+    void benchmarkTitleChange();
+
+private:
+    Display *m_display = nullptr;
+    PlasmaWindowManagementInterface *m_windowManagementInterface = nullptr;
+    QVector<PlasmaWindowInterface*> m_windows;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-plasma-window-management-0");
+static const int s_windowCount = 500;
+
+void PlasmaWindowManagementBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_windowManagementInterface = m_display->createPlasmaWindowManagement(this);
+    m_windowManagementInterface->create();
+    for (int i = 0; i < s_windowCount; ++i) {
+        auto window = m_windowManagementInterface->createWindow(this);
+        window->setTitle(QStringLiteral("Window %1").arg(i));
+        window->setAppId(QStringLiteral("org.kde.bench%1").arg(i % 20));
+        window->setPid(1000 + i % 20);
+        window->setThemedIconName(QStringLiteral("utilities-terminal"));
+        window->setCloseable(true);
+        window->setMinimizeable(true);
+        window->setMaximizeable(true);
+        window->setMovable(true);
+        window->setResizable(true);
+        m_windows << window;
+    }
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+}
+
+void PlasmaWindowManagementBenchmark::cleanupTestCase()
+{
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    qDeleteAll(m_windows);
+    m_windows.clear();
+    delete m_display;
+    m_display = nullptr;
+}
+
+void PlasmaWindowManagementBenchmark::benchmarkBind()
+{
+    // a task manager starting up in a session with many windows, measures until it
+    // knows the state of all windows
+    const auto interface = m_registry->interface(Registry::Interface::PlasmaWindowManagement);
+
+    QElapsedTimer timer;
+    int iterations = 0;
+    timer.start();
+    QBENCHMARK {
+        QScopedPointer<PlasmaWindowManagement> windowManagement(m_registry->createPlasmaWindowManagement(interface.name, interface.version));
+        QSignalSpy windowCreatedSpy(windowManagement.data(), &PlasmaWindowManagement::windowCreated);
+        QVERIFY(windowCreatedSpy.isValid());
+        while (windowCreatedSpy.count() < s_windowCount) {
+            QVERIFY(windowCreatedSpy.wait());
+        }
+        ++iterations;
+    }
+    qDebug() << qRound64(iterations * s_windowCount * 1e9 / qMax(timer.nsecsElapsed(), qint64(1))) << "windows per second";
+}
+
+void PlasmaWindowManagementBenchmark::benchmarkTitleChange()
+{
+    // every window changes its title, e.g. terminals showing the running command
+    const auto interface = m_registry->interface(Registry::Interface::PlasmaWindowManagement);
+    QScopedPointer<PlasmaWindowManagement> windowManagement(m_registry->createPlasmaWindowManagement(interface.name, interface.version));
+    QSignalSpy windowCreatedSpy(windowManagement.data(), &PlasmaWindowManagement::windowCreated);
+    QVERIFY(windowCreatedSpy.isValid());
+    while (windowCreatedSpy.count() < s_windowCount) {
+        QVERIFY(windowCreatedSpy.wait());
+    }
+    QSignalSpy titleChangedSpy(windowCreatedSpy.last().first().value<PlasmaWindow*>(), &PlasmaWindow::titleChanged);
+    QVERIFY(titleChangedSpy.isValid());
+
+    int generation = 0;
+    QElapsedTimer timer;
+    int iterations = 0;
+    timer.start();
+    QBENCHMARK {
+        titleChangedSpy.clear();
+        ++generation;
+        for (int i = 0; i < m_windows.count(); ++i) {
+            m_windows.at(i)->setTitle(QStringLiteral("Window %1 - %2").arg(i).arg(generation));
+        }
+        QVERIFY(titleChangedSpy.wait());
+        ++iterations;
+    }
+    qDebug() << qRound64(iterations * s_windowCount * 1e9 / qMax(timer.nsecsElapsed(), qint64(1))) << "title changes per second";
+}
+
+QTEST_GUILESS_MAIN(PlasmaWindowManagementBenchmark)
+#include "bench_plasmawindowmanagement.moc"
@@ -0,0 +1,244 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// std
+#include <cmath>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/region.h"
+#include "../src/client/registry.h"
+#include "../src/client/surface.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/surface_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+// a sequence of wl_region requests, subtracted rects have a negative width
+typedef QVector<QRect> RegionRequests;
+
+class RegionBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkInputRegion_data();
+    void benchmarkInputRegion();
+    void benchmarkUnited_data();
+    void benchmarkUnited();
+
+private:
+    void addWorkloadRows();
+
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Compositor *m_compositor = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-region-0");
+
+static QRect subtracted(const QRect &rect)
+{
+    return QRect(rect.x(), rect.y(), -rect.width(), rect.height());
+}
+
+static QRegion apply(const RegionRequests &requests)
+{
+    QRegion region;
+    for (const QRect &rect : requests) {
+        if (rect.width() < 0) {
+            region = region.subtracted(QRect(rect.x(), rect.y(), -rect.width(), rect.height()));
+        } else {
+            region = region.united(rect);
+        }
+    }
+    return region;
+}
+
+void RegionBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_compositorInterface = m_display->createCompositor(this);
+    m_compositorInterface->create();
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+    m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+}
+
+void RegionBenchmark::cleanupTestCase()
+{
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void RegionBenchmark::addWorkloadRows()
+{
+    QTest::addColumn<RegionRequests>("requests");
+
+    // input region of a window with rounded corners, one rect per row of the corners
+    RegionRequests rounded;
+    const int radius = 12;
+    for (int y = 0; y < radius; ++y) {
+        const int inset = radius - qRound(std::sqrt(qreal(radius * radius - (radius - y) * (radius - y))));
+        rounded << QRect(inset, y, 800 - 2 * inset, 1);
+        rounded << QRect(inset, 599 - y, 800 - 2 * inset, 1);
+    }
+    rounded << QRect(0, radius, 800, 600 - 2 * radius);
+    QTest::newRow("rounded corners") << rounded;
+
+    // opaque region made of abutting tiles
+    RegionRequests tiles;
+    for (int y = 0; y < 20; ++y) {
+        for (int x = 0; x < 20; ++x) {
+            tiles << QRect(x * 32, y * 32, 32, 32);
+        }
+    }
+    QTest::newRow("abutting tiles") << tiles;
+
+    // scattered overlapping rects, e.g. the opaque parts of a web page
+    RegionRequests overlapping;
+    quint32 seed = 1;
+    auto random = [&seed] (int max) {
+        seed = seed * 1103515245 + 12345;
+        return int((seed >> 16) % quint32(max));
+    };
+    for (int i = 0; i < 300; ++i) {
+        overlapping << QRect(random(1000), random(1000), 10 + random(200), 10 + random(200));
+    }
+    QTest::newRow("overlapping") << overlapping;
+
+    // the overlapping rects with holes punched into them
+    RegionRequests holes = overlapping;
+    for (int i = 0; i < 50; ++i) {
+        holes << subtracted(QRect(random(1000), random(1000), 5 + random(50), 5 + random(50)));
+    }
+    QTest::newRow("add and subtract") << holes;
+}
+
+void RegionBenchmark::benchmarkInputRegion_data()
+{
+    addWorkloadRows();
+}
+
+void RegionBenchmark::benchmarkInputRegion()
+{
+    // sends the requests to a new region and sets it as input region of a surface,
+    // measures until the compositor applied the input region
+    QFETCH(RegionRequests, requests);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    QBENCHMARK {
+        QScopedPointer<Region> region(m_compositor->createRegion());
+        for (const QRect &rect : qAsConst(requests)) {
+            if (rect.width() < 0) {
+                region->subtract(QRect(rect.x(), rect.y(), -rect.width(), rect.height()));
+            } else {
+                region->add(rect);
+            }
+        }
+        surface->setInputRegion(region.data());
+        surface->commit(Surface::CommitFlag::None);
+        QVERIFY(committedSpy.wait());
+    }
+    QCOMPARE(serverSurface->input(), apply(requests));
+}
+
+void RegionBenchmark::benchmarkUnited_data()
+{
+    addWorkloadRows();
+}
+
+void RegionBenchmark::benchmarkUnited()
+{
+    // baseline: applying each request to a QRegion as it arrives
+    QFETCH(RegionRequests, requests);
+
+    QRegion region;
+    QBENCHMARK {
+        region = apply(requests);
+    }
+    qDebug() << requests.count() << "requests," << region.rectCount() << "rects";
+}
+
+QTEST_GUILESS_MAIN(RegionBenchmark)
+#include "bench_region.moc"
@@ -0,0 +1,217 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/registry.h"
+// server
+#include "../src/server/display.h"
+#include "server_globals.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+Q_DECLARE_METATYPE(KWayland::Client::Registry::Interface)
+
+class RegistryBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkAnnounce();
+    void benchmarkBindSequential_data();
+    void benchmarkBindSequential();
+    void benchmarkBindAll_data();
+    void benchmarkBindAll();
+
+private:
+    Display *m_display = nullptr;
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-registry-0");
+
+static const QVector<Registry::Interface> s_shellInterfaces = {
+    Registry::Interface::Compositor,
+    Registry::Interface::Shm,
+    Registry::Interface::Seat,
+    Registry::Interface::Output,
+    Registry::Interface::SubCompositor,
+    Registry::Interface::DataDeviceManager,
+    Registry::Interface::XdgShellStable
+};
+
+static const QVector<Registry::Interface> s_allInterfaces = {
+    Registry::Interface::Compositor,
+    Registry::Interface::Shm,
+    Registry::Interface::Seat,
+    Registry::Interface::Output,
+    Registry::Interface::Shell,
+    Registry::Interface::SubCompositor,
+    Registry::Interface::DataDeviceManager,
+    Registry::Interface::PlasmaShell,
+    Registry::Interface::PlasmaWindowManagement,
+    Registry::Interface::PlasmaVirtualDesktopManagement,
+    Registry::Interface::Idle,
+    Registry::Interface::FakeInput,
+    Registry::Interface::Shadow,
+    Registry::Interface::Blur,
+    Registry::Interface::Contrast,
+    Registry::Interface::Slide,
+    Registry::Interface::Dpms,
+    Registry::Interface::OutputManagement,
+    Registry::Interface::OutputDevice,
+    Registry::Interface::ServerSideDecorationManager,
+    Registry::Interface::TextInputManagerUnstableV0,
+    Registry::Interface::TextInputManagerUnstableV2,
+    Registry::Interface::XdgShellUnstableV6,
+    Registry::Interface::XdgShellStable,
+    Registry::Interface::RelativePointerManagerUnstableV1,
+    Registry::Interface::PointerGesturesUnstableV1,
+    Registry::Interface::PointerConstraintsUnstableV1,
+    Registry::Interface::XdgExporterUnstableV2,
+    Registry::Interface::XdgImporterUnstableV2,
+    Registry::Interface::IdleInhibitManagerUnstableV1,
+    Registry::Interface::XdgOutputUnstableV1,
+    Registry::Interface::XdgDecorationUnstableV1
+};
+
+void RegistryBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    createServerGlobals(m_display);
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+}
+
+void RegistryBenchmark::cleanupTestCase()
+{
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void RegistryBenchmark::benchmarkAnnounce()
+{
+    // measures registry creation until all globals are announced
+    QBENCHMARK {
+        Registry registry;
+        QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+        registry.setEventQueue(m_queue);
+        registry.create(m_connection);
+        registry.setup();
+        QVERIFY(interfacesAnnouncedSpy.wait());
+    }
+}
+
+void RegistryBenchmark::benchmarkBindSequential_data()
+{
+    QTest::addColumn<QVector<Registry::Interface>>("interfaces");
+
+    QTest::newRow("shell") << s_shellInterfaces;
+    QTest::newRow("all") << s_allInterfaces;
+}
+
+void RegistryBenchmark::benchmarkBindSequential()
+{
+    // a roundtrip per global, which is what clients setting up their globals one by one pay
+    QFETCH(QVector<Registry::Interface>, interfaces);
+    Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QSignalSpy interfacesBoundSpy(&registry, &Registry::interfacesBound);
+    QVERIFY(interfacesBoundSpy.isValid());
+
+    QBENCHMARK {
+        QVector<QObject *> objects;
+        for (auto interface : interfaces) {
+            objects << registry.bindAll({interface});
+            QVERIFY(interfacesBoundSpy.wait());
+        }
+        qDeleteAll(objects);
+    }
+}
+
+void RegistryBenchmark::benchmarkBindAll_data()
+{
+    QTest::addColumn<QVector<Registry::Interface>>("interfaces");
+
+    QTest::newRow("shell") << s_shellInterfaces;
+    QTest::newRow("all") << s_allInterfaces;
+}
+
+void RegistryBenchmark::benchmarkBindAll()
+{
+    QFETCH(QVector<Registry::Interface>, interfaces);
+    Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QSignalSpy interfacesBoundSpy(&registry, &Registry::interfacesBound);
+    QVERIFY(interfacesBoundSpy.isValid());
+
+    QBENCHMARK {
+        const auto objects = registry.bindAll(interfaces);
+        QVERIFY(interfacesBoundSpy.wait());
+        qDeleteAll(objects);
+    }
+}
+
+QTEST_GUILESS_MAIN(RegistryBenchmark)
+#include "bench_registry.moc"
@@ -0,0 +1,256 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/output.h"
+#include "../src/client/registry.h"
+#include "../src/client/remote_access.h"
+#include "../src/client/remote_frame_reader.h"
+// server
+#include "../src/server/display.h"
+#include "../src/server/output_interface.h"
+#include "../src/server/remote_access_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+Q_DECLARE_METATYPE(const BufferHandle *)
+Q_DECLARE_METATYPE(const RemoteBuffer *)
+Q_DECLARE_METATYPE(const void *)
+
+class RemoteAccessBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkFrame_data();
+    void benchmarkFrame();
+    void benchmarkCapture_data();
+    void benchmarkCapture();
+
+private:
+    Display *m_display = nullptr;
+    OutputInterface *m_outputInterface = nullptr;
+    RemoteAccessManagerInterface *m_remoteAccessInterface = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Output *m_output = nullptr;
+    RemoteAccessManager *m_remoteAccess = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-remote-access-0");
+
+void RemoteAccessBenchmark::initTestCase()
+{
+    qRegisterMetaType<const BufferHandle *>();
+    qRegisterMetaType<const RemoteBuffer *>();
+    qRegisterMetaType<const void *>();
+
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_outputInterface = m_display->createOutput(this);
+    m_outputInterface->create();
+    m_remoteAccessInterface = m_display->createRemoteAccessManager(this);
+    m_remoteAccessInterface->create();
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto output = m_registry->interface(Registry::Interface::Output);
+    m_output = m_registry->createOutput(output.name, output.version, this);
+    const auto remoteAccess = m_registry->interface(Registry::Interface::RemoteAccessManager);
+    m_remoteAccess = m_registry->createRemoteAccessManager(remoteAccess.name, remoteAccess.version, this);
+    QVERIFY(m_output->isValid());
+    QVERIFY(m_remoteAccess->isValid());
+
+    QSignalSpy interfacesBoundSpy(m_registry, &Registry::interfacesBound);
+    QVERIFY(interfacesBoundSpy.isValid());
+    m_registry->bindAll({});
+    QVERIFY(interfacesBoundSpy.wait());
+    m_display->dispatchEvents();
+    QVERIFY(m_remoteAccessInterface->isBound());
+}
+
+void RemoteAccessBenchmark::cleanupTestCase()
+{
+    delete m_remoteAccess;
+    m_remoteAccess = nullptr;
+    delete m_output;
+    m_output = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void RemoteAccessBenchmark::benchmarkFrame_data()
+{
+    QTest::addColumn<bool>("reuse");
+
+    QTest::newRow("release") << false;
+    QTest::newRow("reuse") << true;
+}
+
+void RemoteAccessBenchmark::benchmarkFrame()
+{
+    // a frame of a screen recording: announce, read and return it; releasing the buffer
+    // after each frame creates a new remote buffer and passes the fd again
+    QFETCH(bool, reuse);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    BufferHandle buf;
+    buf.setFd(file.handle());
+    buf.setSize(1920, 1080);
+    buf.setStride(1920 * 4);
+    buf.setFormat(0x34325258); // DRM_FORMAT_XRGB8888
+    buf.setDamage(QRegion(0, 0, 64, 64));
+
+    QSignalSpy bufferReadySpy(m_remoteAccess, &RemoteAccessManager::bufferReady);
+    QVERIFY(bufferReadySpy.isValid());
+    QSignalSpy bufferReleasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    QVERIFY(bufferReleasedSpy.isValid());
+
+    RemoteBuffer *rbuf = nullptr;
+    QBENCHMARK {
+        QScopedPointer<QSignalSpy> frameReadySpy;
+        if (rbuf) {
+            frameReadySpy.reset(new QSignalSpy(rbuf, &RemoteBuffer::frameReady));
+        }
+        m_remoteAccessInterface->sendBufferReady(m_outputInterface, &buf);
+        if (!rbuf) {
+            QVERIFY(bufferReadySpy.wait());
+            rbuf = const_cast<RemoteBuffer *>(bufferReadySpy.takeFirst()[1].value<const RemoteBuffer *>());
+            frameReadySpy.reset(new QSignalSpy(rbuf, &RemoteBuffer::frameReady));
+        }
+        QVERIFY(frameReadySpy->wait());
+
+        if (reuse) {
+            rbuf->done();
+        } else {
+            delete rbuf;
+            rbuf = nullptr;
+        }
+        m_connection->flush();
+        QVERIFY(bufferReleasedSpy.wait());
+    }
+    delete rbuf;
+    m_connection->flush();
+}
+
+void RemoteAccessBenchmark::benchmarkCapture_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("1920x1080") << QSize(1920, 1080);
+    QTest::newRow("3840x2160") << QSize(3840, 2160);
+}
+
+void RemoteAccessBenchmark::benchmarkCapture()
+{
+    // end to end capture: the compositor renders a synthetic frame, the reader maps it
+    // and the consumer copies the damaged area, as an encoder would
+    QFETCH(QSize, size);
+    const int stride = size.width() * 4;
+    const QRect patch(0, 0, 64, 64);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QVERIFY(file.resize(qint64(stride) * size.height()));
+    uchar *pixels = file.map(0, file.size());
+    QVERIFY(pixels);
+    BufferHandle buf;
+    buf.setFd(file.handle());
+    buf.setSize(size.width(), size.height());
+    buf.setStride(stride);
+    buf.setFormat(0x34325258); // DRM_FORMAT_XRGB8888
+    buf.setDamage(patch);
+
+    RemoteFrameReader reader(m_remoteAccess);
+    QRgb captured = 0;
+    connect(&reader, &RemoteFrameReader::frameRead, this,
+        [&captured] (const void *output, const QImage &image, const QRegion &damage) {
+            Q_UNUSED(output)
+            const QImage copy = image.copy(damage.boundingRect());
+            captured = copy.pixel(0, 0);
+        }
+    );
+    QSignalSpy bufferReleasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    QVERIFY(bufferReleasedSpy.isValid());
+
+    quint32 frame = 0;
+    QBENCHMARK {
+        const QRgb color = qRgb(0, 0, ++frame & 0xff);
+        for (int y = patch.top(); y <= patch.bottom(); ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(pixels + y * stride);
+            std::fill(line + patch.left(), line + patch.right() + 1, color);
+        }
+        m_remoteAccessInterface->sendBufferReady(m_outputInterface, &buf);
+        QVERIFY(bufferReleasedSpy.wait());
+        QCOMPARE(captured, color);
+    }
+    qDebug() << "average latency" << reader.averageLatency() / 1000 << "us, max" << reader.maxLatency() / 1000 << "us";
+    file.unmap(pixels);
+}
+
+QTEST_GUILESS_MAIN(RemoteAccessBenchmark)
+#include "bench_remote_access.moc"
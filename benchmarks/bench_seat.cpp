@@ -0,0 +1,221 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/keyboard.h"
+#include "../src/client/pointer.h"
+#include "../src/client/registry.h"
+#include "../src/client/seat.h"
+#include "../src/client/surface.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/surface_interface.h"
+
+#include "server_globals.h"
+
+#include <linux/input.h>
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+class SeatBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkFanOut_data();
+    void benchmarkFanOut();
+
+private:
+    struct Client {
+        ConnectionThread *connection = nullptr;
+        QThread *thread = nullptr;
+        EventQueue *queue = nullptr;
+        Registry *registry = nullptr;
+        Compositor *compositor = nullptr;
+        Seat *seat = nullptr;
+        Pointer *pointer = nullptr;
+        Keyboard *keyboard = nullptr;
+        Surface *surface = nullptr;
+        SurfaceInterface *serverSurface = nullptr;
+    };
+    bool setupClient(Client *client);
+    void cleanupClient(Client *client);
+
+    Display *m_display = nullptr;
+    ServerGlobals m_globals;
+    QVector<Client> m_clients;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-seat-0");
+static const int s_clientCount = 50;
+// pointer motion events sent to each client per benchmark iteration
+static const int s_motionCount = 20;
+
+bool SeatBenchmark::setupClient(Client *client)
+{
+    client->connection = new ConnectionThread;
+    QSignalSpy connectedSpy(client->connection, &ConnectionThread::connected);
+    client->connection->setSocketName(s_socketName);
+    client->thread = new QThread(this);
+    client->connection->moveToThread(client->thread);
+    client->thread->start();
+    client->connection->initConnection();
+    if (!connectedSpy.wait()) {
+        return false;
+    }
+    client->queue = new EventQueue(this);
+    client->queue->setup(client->connection);
+
+    client->registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(client->registry, &Registry::interfacesAnnounced);
+    client->registry->setEventQueue(client->queue);
+    client->registry->create(client->connection);
+    client->registry->setup();
+    if (!interfacesAnnouncedSpy.wait()) {
+        return false;
+    }
+    QSignalSpy interfacesBoundSpy(client->registry, &Registry::interfacesBound);
+    const auto objects = client->registry->bindAll({Registry::Interface::Compositor,
+                                                   Registry::Interface::Seat}, this);
+    if (objects.count() != 2 || !interfacesBoundSpy.wait()) {
+        return false;
+    }
+    client->compositor = qobject_cast<Compositor*>(objects.at(0));
+    client->seat = qobject_cast<Seat*>(objects.at(1));
+    client->pointer = client->seat->createPointer(this);
+    client->keyboard = client->seat->createKeyboard(this);
+
+    // the surface gets created after the pointer and keyboard on the server
+    QSignalSpy surfaceCreatedSpy(m_globals.compositor, &CompositorInterface::surfaceCreated);
+    client->surface = client->compositor->createSurface(this);
+    if (!surfaceCreatedSpy.wait()) {
+        return false;
+    }
+    client->serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    return true;
+}
+
+void SeatBenchmark::cleanupClient(Client *client)
+{
+    delete client->surface;
+    delete client->keyboard;
+    delete client->pointer;
+    delete client->seat;
+    delete client->compositor;
+    delete client->registry;
+    delete client->queue;
+    client->connection->deleteLater();
+    client->thread->quit();
+    client->thread->wait();
+    delete client->thread;
+}
+
+void SeatBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_globals = createServerGlobals(m_display);
+
+    m_clients.resize(s_clientCount);
+    for (int i = 0; i < m_clients.count(); ++i) {
+        QVERIFY(setupClient(&m_clients[i]));
+    }
+}
+
+void SeatBenchmark::cleanupTestCase()
+{
+    for (int i = 0; i < m_clients.count(); ++i) {
+        cleanupClient(&m_clients[i]);
+    }
+    m_clients.clear();
+    delete m_display;
+    m_display = nullptr;
+}
+
+void SeatBenchmark::benchmarkFanOut_data()
+{
+    QTest::addColumn<int>("clients");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("10") << 10;
+    QTest::newRow("50") << s_clientCount;
+}
+
+void SeatBenchmark::benchmarkFanOut()
+{
+    // the pointer moves over the windows of all clients, clicks and types into each
+    // of them, measures until the last client got its last key
+    QFETCH(int, clients);
+    const Client &last = m_clients.at(clients - 1);
+    QSignalSpy keyChangedSpy(last.keyboard, &Keyboard::keyChanged);
+    QVERIFY(keyChangedSpy.isValid());
+    SeatInterface *seat = m_globals.seat;
+    quint32 timestamp = 0;
+
+    QElapsedTimer timer;
+    int iterations = 0;
+    timer.start();
+    QBENCHMARK {
+        keyChangedSpy.clear();
+        for (int i = 0; i < clients; ++i) {
+            SurfaceInterface *surface = m_clients.at(i).serverSurface;
+            seat->setTimestamp(++timestamp);
+            seat->setPointerPos(QPointF(0, 0));
+            seat->setFocusedPointerSurface(surface);
+            for (int j = 0; j < s_motionCount; ++j) {
+                seat->setTimestamp(++timestamp);
+                seat->setPointerPos(QPointF(j, j));
+            }
+            seat->setTimestamp(++timestamp);
+            seat->pointerButtonPressed(BTN_LEFT);
+            seat->setTimestamp(++timestamp);
+            seat->pointerButtonReleased(BTN_LEFT);
+
+            seat->setFocusedKeyboardSurface(surface);
+            seat->setTimestamp(++timestamp);
+            seat->keyPressed(KEY_A);
+            seat->setTimestamp(++timestamp);
+            seat->keyReleased(KEY_A);
+        }
+        while (keyChangedSpy.count() < 2) {
+            QVERIFY(keyChangedSpy.wait());
+        }
+        seat->setFocusedPointerSurface(nullptr);
+        seat->setFocusedKeyboardSurface(nullptr);
+        ++iterations;
+    }
+    // enter, motions, press and release for the pointer, enter, press and release for the keyboard
+    const int events = clients * (s_motionCount + 6);
+    qDebug() << qRound64(iterations * events * 1e9 / qMax(timer.nsecsElapsed(), qint64(1))) << "input events per second";
+}
+
+QTEST_GUILESS_MAIN(SeatBenchmark)
+#include "bench_seat.moc"
@@ -0,0 +1,232 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/datadevice.h"
+#include "../src/client/datadevicemanager.h"
+#include "../src/client/datasource.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/registry.h"
+#include "../src/client/seat.h"
+#include "../src/client/surface.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/datadevice_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/surface_interface.h"
+#include "server_globals.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+class SelectionBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkFocusChange_data();
+    void benchmarkFocusChange();
+
+private:
+    struct Client {
+        ConnectionThread *connection = nullptr;
+        QThread *thread = nullptr;
+        EventQueue *queue = nullptr;
+        Registry *registry = nullptr;
+        Compositor *compositor = nullptr;
+        Seat *seat = nullptr;
+        DataDeviceManager *ddm = nullptr;
+        DataDevice *dataDevice = nullptr;
+        Surface *surface = nullptr;
+        SurfaceInterface *serverSurface = nullptr;
+    };
+    bool setupClient(Client *client);
+    void cleanupClient(Client *client);
+
+    Display *m_display = nullptr;
+    ServerGlobals m_globals;
+    QVector<Client> m_clients;
+    DataSource *m_dataSource = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-selection-0");
+static const int s_clientCount = 50;
+
+// roughly what an office suite offers for a copied paragraph
+static const QStringList s_mimeTypes = {
+    QStringLiteral("text/plain;charset=utf-8"),
+    QStringLiteral("text/plain"),
+    QStringLiteral("UTF8_STRING"),
+    QStringLiteral("STRING"),
+    QStringLiteral("TEXT"),
+    QStringLiteral("COMPOUND_TEXT"),
+    QStringLiteral("text/html"),
+    QStringLiteral("text/richtext"),
+    QStringLiteral("text/rtf"),
+    QStringLiteral("application/rtf"),
+    QStringLiteral("application/x-openoffice-embed-source-xml;windows_formatname=\"Star Embed Source (XML)\""),
+    QStringLiteral("application/x-openoffice-objectdescriptor-xml;windows_formatname=\"Star Object Descriptor (XML)\""),
+    QStringLiteral("application/x-openoffice-link-source;windows_formatname=\"Link Source\""),
+    QStringLiteral("application/x-openoffice-link;windows_formatname=\"Link\""),
+    QStringLiteral("application/x-openoffice-gdimetafile;windows_formatname=\"GDIMetaFile\""),
+    QStringLiteral("application/x-openoffice-emf;windows_formatname=\"Image EMF\""),
+    QStringLiteral("application/x-openoffice-wmf;windows_formatname=\"Image WMF\""),
+    QStringLiteral("application/x-openoffice-bitmap;windows_formatname=\"Bitmap\""),
+    QStringLiteral("application/x-openoffice-dif;windows_formatname=\"DIF\""),
+    QStringLiteral("application/x-openoffice-sylk;windows_formatname=\"Sylk\""),
+    QStringLiteral("application/x-libreoffice-tsvc"),
+    QStringLiteral("image/png"),
+    QStringLiteral("image/bmp"),
+    QStringLiteral("image/svg+xml"),
+    QStringLiteral("text/csv")
+};
+
+bool SelectionBenchmark::setupClient(Client *client)
+{
+    client->connection = new ConnectionThread;
+    QSignalSpy connectedSpy(client->connection, &ConnectionThread::connected);
+    client->connection->setSocketName(s_socketName);
+    client->thread = new QThread(this);
+    client->connection->moveToThread(client->thread);
+    client->thread->start();
+    client->connection->initConnection();
+    if (!connectedSpy.wait()) {
+        return false;
+    }
+    client->queue = new EventQueue(this);
+    client->queue->setup(client->connection);
+
+    client->registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(client->registry, &Registry::interfacesAnnounced);
+    client->registry->setEventQueue(client->queue);
+    client->registry->create(client->connection);
+    client->registry->setup();
+    if (!interfacesAnnouncedSpy.wait()) {
+        return false;
+    }
+    QSignalSpy interfacesBoundSpy(client->registry, &Registry::interfacesBound);
+    const auto objects = client->registry->bindAll({Registry::Interface::Compositor,
+                                                   Registry::Interface::Seat,
+                                                   Registry::Interface::DataDeviceManager}, this);
+    if (objects.count() != 3 || !interfacesBoundSpy.wait()) {
+        return false;
+    }
+    client->compositor = qobject_cast<Compositor*>(objects.at(0));
+    client->seat = qobject_cast<Seat*>(objects.at(1));
+    client->ddm = qobject_cast<DataDeviceManager*>(objects.at(2));
+    client->dataDevice = client->ddm->getDataDevice(client->seat, this);
+
+    QSignalSpy surfaceCreatedSpy(m_globals.compositor, &CompositorInterface::surfaceCreated);
+    client->surface = client->compositor->createSurface(this);
+    if (!surfaceCreatedSpy.wait()) {
+        return false;
+    }
+    client->serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    return true;
+}
+
+void SelectionBenchmark::cleanupClient(Client *client)
+{
+    delete client->surface;
+    delete client->dataDevice;
+    delete client->ddm;
+    delete client->seat;
+    delete client->compositor;
+    delete client->registry;
+    delete client->queue;
+    client->connection->deleteLater();
+    client->thread->quit();
+    client->thread->wait();
+    delete client->thread;
+}
+
+void SelectionBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_globals = createServerGlobals(m_display);
+
+    m_clients.resize(s_clientCount);
+    for (int i = 0; i < m_clients.count(); ++i) {
+        QVERIFY(setupClient(&m_clients[i]));
+    }
+
+    // the first client owns the selection
+    Client &owner = m_clients.first();
+    QSignalSpy selectionChangedSpy(m_globals.seat, &SeatInterface::selectionChanged);
+    QVERIFY(selectionChangedSpy.isValid());
+    m_globals.seat->setFocusedKeyboardSurface(owner.serverSurface);
+    m_dataSource = owner.ddm->createDataSource(this);
+    for (const QString &mimeType : s_mimeTypes) {
+        m_dataSource->offer(mimeType);
+    }
+    owner.dataDevice->setSelection(m_display->serial(), m_dataSource);
+    QVERIFY(selectionChangedSpy.wait());
+    QVERIFY(m_globals.seat->selection());
+    QCOMPARE(m_globals.seat->selection()->selection()->mimeTypes().count(), s_mimeTypes.count());
+}
+
+void SelectionBenchmark::cleanupTestCase()
+{
+    delete m_dataSource;
+    m_dataSource = nullptr;
+    for (int i = 0; i < m_clients.count(); ++i) {
+        cleanupClient(&m_clients[i]);
+    }
+    m_clients.clear();
+    delete m_display;
+    m_display = nullptr;
+}
+
+void SelectionBenchmark::benchmarkFocusChange_data()
+{
+    QTest::addColumn<int>("clients");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("50") << s_clientCount;
+}
+
+void SelectionBenchmark::benchmarkFocusChange()
+{
+    // moving keyboard focus through the clients replays the selection offer to each of them
+    QFETCH(int, clients);
+    Client &last = m_clients[clients - 1];
+    QSignalSpy selectionOfferedSpy(last.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedSpy.isValid());
+
+    QBENCHMARK {
+        for (int i = 1; i < clients; ++i) {
+            m_globals.seat->setFocusedKeyboardSurface(m_clients.at(i).serverSurface);
+        }
+        QVERIFY(selectionOfferedSpy.wait());
+        m_globals.seat->setFocusedKeyboardSurface(nullptr);
+    }
+}
+
+QTEST_GUILESS_MAIN(SelectionBenchmark)
+#include "bench_selection.moc"
@@ -0,0 +1,311 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/registry.h"
+#include "../src/client/shadow.h"
+#include "../src/client/shm_pool.h"
+#include "../src/client/surface.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/shadow_interface.h"
+#include "../src/server/surface_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+class ShadowBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkTiles_data();
+    void benchmarkTiles();
+    void benchmarkStartup_data();
+    void benchmarkStartup();
+
+private:
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+    ShadowManagerInterface *m_shadowInterface = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Compositor *m_compositor = nullptr;
+    ShmPool *m_shm = nullptr;
+    ShadowManager *m_shadow = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-shadow-0");
+static const int s_windowCount = 200;
+static const int s_shadowSize = 64;
+
+static const ShadowInterface::Tile s_tiles[] = {
+    ShadowInterface::Tile::Left,
+    ShadowInterface::Tile::TopLeft,
+    ShadowInterface::Tile::Top,
+    ShadowInterface::Tile::TopRight,
+    ShadowInterface::Tile::Right,
+    ShadowInterface::Tile::BottomRight,
+    ShadowInterface::Tile::Bottom,
+    ShadowInterface::Tile::BottomLeft
+};
+
+static void attachTiles(Shadow *shadow, const QVector<Buffer::Ptr> &buffers)
+{
+    shadow->attachLeft(buffers.at(0));
+    shadow->attachTopLeft(buffers.at(1));
+    shadow->attachTop(buffers.at(2));
+    shadow->attachTopRight(buffers.at(3));
+    shadow->attachRight(buffers.at(4));
+    shadow->attachBottomRight(buffers.at(5));
+    shadow->attachBottom(buffers.at(6));
+    shadow->attachBottomLeft(buffers.at(7));
+}
+
+void ShadowBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+    m_compositorInterface = m_display->createCompositor(this);
+    m_compositorInterface->create();
+    m_shadowInterface = m_display->createShadowManager(this);
+    m_shadowInterface->create();
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+    m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+    const auto shm = m_registry->interface(Registry::Interface::Shm);
+    m_shm = m_registry->createShmPool(shm.name, shm.version, this);
+    QVERIFY(m_shm->isValid());
+    const auto shadow = m_registry->interface(Registry::Interface::Shadow);
+    m_shadow = m_registry->createShadowManager(shadow.name, shadow.version, this);
+    QVERIFY(m_shadow->isValid());
+}
+
+void ShadowBenchmark::cleanupTestCase()
+{
+    delete m_shadow;
+    m_shadow = nullptr;
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void ShadowBenchmark::benchmarkTiles_data()
+{
+    QTest::addColumn<bool>("sharedTheme");
+
+    QTest::newRow("shared theme") << true;
+    QTest::newRow("unique") << false;
+}
+
+void ShadowBenchmark::benchmarkTiles()
+{
+    // every window of a decoration theme attaches its own buffers with the same
+    // content, measures updating the shadows of all windows and fetching the
+    // tiles a compositor would upload
+    QFETCH(bool, sharedTheme);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    std::vector<std::unique_ptr<Surface>> surfaces;
+    std::vector<std::unique_ptr<Shadow>> shadows;
+    QVector<QVector<Buffer::Ptr>> buffers;
+    for (int i = 0; i < s_windowCount; ++i) {
+        surfaces.emplace_back(m_compositor->createSurface());
+        shadows.emplace_back(m_shadow->createShadow(surfaces.back().get()));
+        // without a shared theme each window gets a slightly different shadow
+        const QColor color = sharedTheme ? QColor(0, 0, 0, 128) : QColor(0, 0, 0, i % 256);
+        QImage corner(s_shadowSize, s_shadowSize, QImage::Format_ARGB32_Premultiplied);
+        corner.fill(color);
+        QImage leftRight(s_shadowSize, 1, QImage::Format_ARGB32_Premultiplied);
+        leftRight.fill(color);
+        QImage topBottom(1, s_shadowSize, QImage::Format_ARGB32_Premultiplied);
+        topBottom.fill(color);
+        buffers << QVector<Buffer::Ptr>{
+            m_shm->createBuffer(leftRight),
+            m_shm->createBuffer(corner),
+            m_shm->createBuffer(topBottom),
+            m_shm->createBuffer(corner),
+            m_shm->createBuffer(leftRight),
+            m_shm->createBuffer(corner),
+            m_shm->createBuffer(topBottom),
+            m_shm->createBuffer(corner)
+        };
+    }
+    while (surfaceCreatedSpy.count() < s_windowCount) {
+        QVERIFY(surfaceCreatedSpy.wait());
+    }
+    QSignalSpy committedSpy(surfaceCreatedSpy.last().first().value<SurfaceInterface*>(), &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    QBENCHMARK {
+        // attaching the same buffers again invalidates the tiles
+        for (int i = 0; i < s_windowCount; ++i) {
+            attachTiles(shadows[i].get(), buffers.at(i));
+            shadows[i]->commit();
+            surfaces[i]->commit(Surface::CommitFlag::None);
+        }
+        QVERIFY(committedSpy.wait());
+
+        QSet<quint64> uploads;
+        for (const auto &arguments : surfaceCreatedSpy) {
+            auto shadow = arguments.first().value<SurfaceInterface*>()->shadow();
+            QVERIFY(shadow);
+            for (auto tile : s_tiles) {
+                const quint64 key = shadow->tileKey(tile);
+                if (!uploads.contains(key)) {
+                    QVERIFY(!shadow->tileImage(tile).isNull());
+                    uploads.insert(key);
+                }
+            }
+        }
+    }
+    qDebug() << s_windowCount * 8 << "tiles," << m_shadowInterface->cachedTileCount() << "uploads,"
+             << m_shadowInterface->cachedTileBytes() << "bytes in the tile cache";
+}
+
+void ShadowBenchmark::benchmarkStartup_data()
+{
+    QTest::addColumn<bool>("tileCache");
+
+    QTest::newRow("tile cache") << true;
+    QTest::newRow("buffer per window") << false;
+}
+
+void ShadowBenchmark::benchmarkStartup()
+{
+    // an application opening many windows with the same decoration shadow, measures
+    // creating the shadows until the compositor got the last one
+    QFETCH(bool, tileCache);
+
+    QImage corner(s_shadowSize, s_shadowSize, QImage::Format_ARGB32_Premultiplied);
+    corner.fill(QColor(0, 0, 0, 128));
+    QImage leftRight(s_shadowSize, 1, QImage::Format_ARGB32_Premultiplied);
+    leftRight.fill(QColor(0, 0, 0, 128));
+    QImage topBottom(1, s_shadowSize, QImage::Format_ARGB32_Premultiplied);
+    topBottom.fill(QColor(0, 0, 0, 128));
+    const QVector<QImage> images = {leftRight, corner, topBottom, corner, leftRight, corner, topBottom, corner};
+
+    ShadowTileCache *cache = ShadowTileCache::forPool(m_shm);
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    qint64 bytes = 0;
+
+    QBENCHMARK {
+        surfaceCreatedSpy.clear();
+        std::vector<std::unique_ptr<Surface>> surfaces;
+        std::vector<std::unique_ptr<Shadow>> shadows;
+        bytes = 0;
+        for (int i = 0; i < s_windowCount; ++i) {
+            surfaces.emplace_back(m_compositor->createSurface());
+        }
+        while (surfaceCreatedSpy.count() < s_windowCount) {
+            QVERIFY(surfaceCreatedSpy.wait());
+        }
+        QSignalSpy committedSpy(surfaceCreatedSpy.last().first().value<SurfaceInterface*>(), &SurfaceInterface::committed);
+        QVERIFY(committedSpy.isValid());
+        for (int i = 0; i < s_windowCount; ++i) {
+            shadows.emplace_back(m_shadow->createShadow(surfaces[i].get()));
+            Shadow *shadow = shadows.back().get();
+            if (tileCache) {
+                shadow->setTileCache(cache);
+                shadow->attachLeft(images.at(0));
+                shadow->attachTopLeft(images.at(1));
+                shadow->attachTop(images.at(2));
+                shadow->attachTopRight(images.at(3));
+                shadow->attachRight(images.at(4));
+                shadow->attachBottomRight(images.at(5));
+                shadow->attachBottom(images.at(6));
+                shadow->attachBottomLeft(images.at(7));
+            } else {
+                QVector<Buffer::Ptr> buffers;
+                for (const QImage &image : images) {
+                    buffers << m_shm->createBuffer(image);
+                    bytes += image.sizeInBytes();
+                }
+                attachTiles(shadow, buffers);
+            }
+            shadow->commit();
+            surfaces[i]->commit(Surface::CommitFlag::None);
+        }
+        if (tileCache) {
+            bytes = cache->bytes();
+        }
+        QVERIFY(committedSpy.wait());
+    }
+    qDebug() << s_windowCount << "windows," << bytes << "bytes of shadow tiles in the pool";
+}
+
+QTEST_GUILESS_MAIN(ShadowBenchmark)
+#include "bench_shadow.moc"
@@ -0,0 +1,252 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/registry.h"
+#include "../src/client/shm_pool.h"
+#include "../src/client/subcompositor.h"
+#include "../src/client/subsurface.h"
+#include "../src/client/surface.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/subcompositor_interface.h"
+#include "../src/server/surface_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+class SurfaceBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkCommit_data();
+    void benchmarkCommit();
+    void benchmarkSubSurfaceCascade_data();
+    void benchmarkSubSurfaceCascade();
+
+private:
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Compositor *m_compositor = nullptr;
+    SubCompositor *m_subCompositor = nullptr;
+    ShmPool *m_shm = nullptr;
+    Buffer::Ptr m_buffer;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-surface-0");
+// commits sent by the client per benchmark iteration
+static const int s_commitCount = 100;
+
+void SurfaceBenchmark::initTestCase()
+{
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+    m_compositorInterface = m_display->createCompositor(this);
+    m_compositorInterface->create();
+    m_display->createSubCompositor(this)->create();
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+    m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+    const auto subCompositor = m_registry->interface(Registry::Interface::SubCompositor);
+    m_subCompositor = m_registry->createSubCompositor(subCompositor.name, subCompositor.version, this);
+    QVERIFY(m_subCompositor->isValid());
+    const auto shm = m_registry->interface(Registry::Interface::Shm);
+    m_shm = m_registry->createShmPool(shm.name, shm.version, this);
+    QVERIFY(m_shm->isValid());
+
+    QImage image(256, 256, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    m_buffer = m_shm->createBuffer(image);
+    QVERIFY(!m_buffer.isNull());
+    m_buffer.toStrongRef()->setUsed(true);
+}
+
+void SurfaceBenchmark::cleanupTestCase()
+{
+    m_buffer.clear();
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_subCompositor;
+    m_subCompositor = nullptr;
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void SurfaceBenchmark::benchmarkCommit_data()
+{
+    QTest::addColumn<bool>("attach");
+    QTest::addColumn<int>("damageRects");
+
+    QTest::newRow("commit") << false << 0;
+    QTest::newRow("damage") << false << 1;
+    QTest::newRow("attach/damage") << true << 1;
+    QTest::newRow("attach/damage 16 rects") << true << 16;
+}
+
+void SurfaceBenchmark::benchmarkCommit()
+{
+    // a client committing frames as fast as possible, measures until the compositor
+    // processed the last commit
+    QFETCH(bool, attach);
+    QFETCH(int, damageRects);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    QElapsedTimer timer;
+    int iterations = 0;
+    timer.start();
+    QBENCHMARK {
+        committedSpy.clear();
+        for (int i = 0; i < s_commitCount; ++i) {
+            if (attach) {
+                surface->attachBuffer(m_buffer);
+            }
+            for (int j = 0; j < damageRects; ++j) {
+                surface->damage(QRect(j * 16, i % 240, 16, 16));
+            }
+            surface->commit(Surface::CommitFlag::None);
+        }
+        while (committedSpy.count() < s_commitCount) {
+            QVERIFY(committedSpy.wait());
+        }
+        ++iterations;
+    }
+    qDebug() << qRound64(iterations * s_commitCount * 1e9 / qMax(timer.nsecsElapsed(), qint64(1))) << "commits per second";
+}
+
+void SurfaceBenchmark::benchmarkSubSurfaceCascade_data()
+{
+    QTest::addColumn<int>("depth");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("4") << 4;
+    QTest::newRow("16") << 16;
+}
+
+void SurfaceBenchmark::benchmarkSubSurfaceCascade()
+{
+    // a chain of synchronized sub-surfaces, each one commits a new frame which gets
+    // applied once the main surface commits
+    QFETCH(int, depth);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    std::vector<std::unique_ptr<Surface>> surfaces;
+    std::vector<std::unique_ptr<SubSurface>> subSurfaces;
+    surfaces.emplace_back(m_compositor->createSurface());
+    for (int i = 0; i < depth; ++i) {
+        surfaces.emplace_back(m_compositor->createSurface());
+        subSurfaces.emplace_back(m_subCompositor->createSubSurface(surfaces.back().get(), surfaces.at(i).get()));
+        subSurfaces.back()->setPosition(QPoint(1, 1));
+    }
+    while (surfaceCreatedSpy.count() < depth + 1) {
+        QVERIFY(surfaceCreatedSpy.wait());
+    }
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    QElapsedTimer timer;
+    int iterations = 0;
+    timer.start();
+    QBENCHMARK {
+        committedSpy.clear();
+        for (int i = 0; i < s_commitCount; ++i) {
+            for (auto it = surfaces.rbegin(); it != surfaces.rend(); ++it) {
+                (*it)->attachBuffer(m_buffer);
+                (*it)->damage(QRect(0, 0, 256, 256));
+                (*it)->commit(Surface::CommitFlag::None);
+            }
+        }
+        while (committedSpy.count() < s_commitCount) {
+            QVERIFY(committedSpy.wait());
+        }
+        ++iterations;
+    }
+    QCOMPARE(serverSurface->childSubSurfaces().count(), 1);
+    qDebug() << qRound64(iterations * s_commitCount * 1e9 / qMax(timer.nsecsElapsed(), qint64(1))) << "cascades per second";
+}
+
+QTEST_GUILESS_MAIN(SurfaceBenchmark)
+#include "bench_surface.moc"
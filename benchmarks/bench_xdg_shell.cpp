@@ -0,0 +1,256 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QtTest>
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/registry.h"
+#include "../src/client/surface.h"
+#include "../src/client/xdgshell.h"
+// server
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/xdgshell_interface.h"
+
+using namespace KWayland::Client;
+using namespace KWayland::Server;
+
+Q_DECLARE_METATYPE(KWayland::Server::XdgShellInterfaceVersion)
+Q_DECLARE_METATYPE(KWayland::Server::XdgShellSurfaceInterface::ConfigurePolicy)
+
+class XdgShellBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkConfigure_data();
+    void benchmarkConfigure();
+    void benchmarkResize_data();
+    void benchmarkResize();
+
+private:
+    void addVersionRows();
+
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+    QMap<XdgShellInterfaceVersion, XdgShellInterface*> m_shellInterfaces;
+
+    ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    Compositor *m_compositor = nullptr;
+    QMap<XdgShellInterfaceVersion, XdgShell*> m_shells;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-bench-xdg-shell-0");
+// configure events sent per frame of an interactive resize
+static const int s_resizeBurst = 16;
+
+void XdgShellBenchmark::initTestCase()
+{
+    qRegisterMetaType<XdgShellSurfaceInterface*>();
+
+    m_display = new Display(this);
+    m_display->setSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_compositorInterface = m_display->createCompositor(this);
+    m_compositorInterface->create();
+    for (auto version : {XdgShellInterfaceVersion::UnstableV5, XdgShellInterfaceVersion::UnstableV6, XdgShellInterfaceVersion::Stable}) {
+        XdgShellInterface *shell = m_display->createXdgShell(version, this);
+        shell->create();
+        m_shellInterfaces.insert(version, shell);
+    }
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+    m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+    const QMap<XdgShellInterfaceVersion, Registry::Interface> interfaces = {
+        {XdgShellInterfaceVersion::UnstableV5, Registry::Interface::XdgShellUnstableV5},
+        {XdgShellInterfaceVersion::UnstableV6, Registry::Interface::XdgShellUnstableV6},
+        {XdgShellInterfaceVersion::Stable, Registry::Interface::XdgShellStable}
+    };
+    for (auto it = interfaces.constBegin(); it != interfaces.constEnd(); ++it) {
+        const auto shell = m_registry->interface(it.value());
+        m_shells.insert(it.key(), m_registry->createXdgShell(shell.name, shell.version, this));
+        QVERIFY(m_shells.value(it.key())->isValid());
+    }
+}
+
+void XdgShellBenchmark::cleanupTestCase()
+{
+    qDeleteAll(m_shells);
+    m_shells.clear();
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void XdgShellBenchmark::addVersionRows()
+{
+    QTest::addColumn<XdgShellInterfaceVersion>("version");
+
+    QTest::newRow("v5") << XdgShellInterfaceVersion::UnstableV5;
+    QTest::newRow("v6") << XdgShellInterfaceVersion::UnstableV6;
+    QTest::newRow("stable") << XdgShellInterfaceVersion::Stable;
+}
+
+void XdgShellBenchmark::benchmarkConfigure_data()
+{
+    addVersionRows();
+}
+
+void XdgShellBenchmark::benchmarkConfigure()
+{
+    // one configure, ack and commit roundtrip of a toplevel
+    QFETCH(XdgShellInterfaceVersion, version);
+
+    QSignalSpy surfaceCreatedSpy(m_shellInterfaces.value(version), &XdgShellInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QScopedPointer<XdgShellSurface> xdgSurface(m_shells.value(version)->createSurface(surface.data()));
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<XdgShellSurfaceInterface*>();
+    QVERIFY(serverSurface);
+
+    connect(xdgSurface.data(), &XdgShellSurface::configureRequested, this,
+        [&xdgSurface, &surface] (const QSize &size, XdgShellSurface::States states, quint32 serial) {
+            Q_UNUSED(size)
+            Q_UNUSED(states)
+            xdgSurface->ackConfigure(serial);
+            surface->commit(Surface::CommitFlag::None);
+        }
+    );
+    QSignalSpy committedSpy(serverSurface, &XdgShellSurfaceInterface::configureCommitted);
+    QVERIFY(committedSpy.isValid());
+
+    QBENCHMARK {
+        serverSurface->configure(XdgShellSurfaceInterface::States(), QSize(100, 100));
+        QVERIFY(committedSpy.wait());
+    }
+}
+
+void XdgShellBenchmark::benchmarkResize_data()
+{
+    QTest::addColumn<XdgShellInterfaceVersion>("version");
+    QTest::addColumn<XdgShellSurfaceInterface::ConfigurePolicy>("policy");
+
+    const QVector<QPair<QByteArray, XdgShellInterfaceVersion>> versions = {
+        {QByteArrayLiteral("v5"), XdgShellInterfaceVersion::UnstableV5},
+        {QByteArrayLiteral("v6"), XdgShellInterfaceVersion::UnstableV6},
+        {QByteArrayLiteral("stable"), XdgShellInterfaceVersion::Stable}
+    };
+    for (const auto &version : versions) {
+        QTest::newRow((version.first + QByteArrayLiteral("/immediate")).constData()) << version.second << XdgShellSurfaceInterface::ConfigurePolicy::Immediate;
+        QTest::newRow((version.first + QByteArrayLiteral("/coalesce")).constData()) << version.second << XdgShellSurfaceInterface::ConfigurePolicy::Coalesce;
+        QTest::newRow((version.first + QByteArrayLiteral("/until commit")).constData()) << version.second << XdgShellSurfaceInterface::ConfigurePolicy::CoalesceUntilCommit;
+    }
+}
+
+void XdgShellBenchmark::benchmarkResize()
+{
+    // an interactive resize sends a burst of configures, measures until the client
+    // committed the last size
+    QFETCH(XdgShellInterfaceVersion, version);
+    QFETCH(XdgShellSurfaceInterface::ConfigurePolicy, policy);
+
+    QSignalSpy surfaceCreatedSpy(m_shellInterfaces.value(version), &XdgShellInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QScopedPointer<XdgShellSurface> xdgSurface(m_shells.value(version)->createSurface(surface.data()));
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<XdgShellSurfaceInterface*>();
+    QVERIFY(serverSurface);
+    serverSurface->setConfigurePolicy(policy);
+
+    connect(xdgSurface.data(), &XdgShellSurface::configureRequested, this,
+        [&xdgSurface, &surface] (const QSize &size, XdgShellSurface::States states, quint32 serial) {
+            Q_UNUSED(size)
+            Q_UNUSED(states)
+            xdgSurface->ackConfigure(serial);
+            surface->commit(Surface::CommitFlag::None);
+        }
+    );
+    quint32 committedSerial = 0;
+    const auto committedConnection = connect(serverSurface, &XdgShellSurfaceInterface::configureCommitted, this,
+        [&committedSerial] (quint32 serial) {
+            committedSerial = serial;
+        }
+    );
+    QSignalSpy committedSpy(serverSurface, &XdgShellSurfaceInterface::configureCommitted);
+    QVERIFY(committedSpy.isValid());
+
+    QBENCHMARK {
+        quint32 serial = 0;
+        for (int i = 0; i < s_resizeBurst; ++i) {
+            serial = serverSurface->configure(XdgShellSurfaceInterface::State::Resizing, QSize(100 + i, 100 + i));
+        }
+        while (committedSerial != serial) {
+            QVERIFY(committedSpy.wait());
+        }
+    }
+    disconnect(committedConnection);
+}
+
+QTEST_GUILESS_MAIN(XdgShellBenchmark)
+#include "bench_xdg_shell.moc"
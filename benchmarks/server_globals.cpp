@@ -0,0 +1,100 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "server_globals.h"
+// server
+#include "../src/server/display.h"
+#include "../src/server/blur_interface.h"
+#include "../src/server/compositor_interface.h"
+#include "../src/server/contrast_interface.h"
+#include "../src/server/datadevicemanager_interface.h"
+#include "../src/server/dpms_interface.h"
+#include "../src/server/fakeinput_interface.h"
+#include "../src/server/idle_interface.h"
+#include "../src/server/idleinhibit_interface.h"
+#include "../src/server/output_interface.h"
+#include "../src/server/outputdevice_interface.h"
+#include "../src/server/outputmanagement_interface.h"
+#include "../src/server/plasmashell_interface.h"
+#include "../src/server/plasmavirtualdesktop_interface.h"
+#include "../src/server/plasmawindowmanagement_interface.h"
+#include "../src/server/pointerconstraints_interface.h"
+#include "../src/server/pointergestures_interface.h"
+#include "../src/server/relativepointer_interface.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/server_decoration_interface.h"
+#include "../src/server/shadow_interface.h"
+#include "../src/server/shell_interface.h"
+#include "../src/server/slide_interface.h"
+#include "../src/server/subcompositor_interface.h"
+#include "../src/server/textinput_interface.h"
+#include "../src/server/xdgdecoration_interface.h"
+#include "../src/server/xdgforeign_interface.h"
+#include "../src/server/xdgoutput_interface.h"
+#include "../src/server/xdgshell_interface.h"
+
+using namespace KWayland::Server;
+
+ServerGlobals createServerGlobals(Display *display)
+{
+    ServerGlobals globals;
+    display->createShm();
+    globals.compositor = display->createCompositor(display);
+    globals.compositor->create();
+    globals.seat = display->createSeat(display);
+    globals.seat->setHasKeyboard(true);
+    globals.seat->setHasPointer(true);
+    globals.seat->setHasTouch(true);
+    globals.seat->create();
+    for (int i = 0; i < 2; ++i) {
+        auto output = display->createOutput(display);
+        output->setGlobalPosition(QPoint(i * 1920, 0));
+        output->addMode(QSize(1920, 1080));
+        output->create();
+    }
+    display->createShell(display)->create();
+    display->createSubCompositor(display)->create();
+    display->createDataDeviceManager(display)->create();
+    display->createPlasmaShell(display)->create();
+    display->createPlasmaWindowManagement(display)->create();
+    display->createPlasmaVirtualDesktopManagement(display)->create();
+    display->createIdle(display)->create();
+    display->createFakeInput(display)->create();
+    display->createShadowManager(display)->create();
+    display->createBlurManager(display)->create();
+    display->createContrastManager(display)->create();
+    display->createSlideManager(display)->create();
+    display->createDpmsManager(display)->create();
+    display->createOutputManagement(display)->create();
+    display->createOutputDevice(display)->create();
+    display->createServerSideDecorationManager(display)->create();
+    display->createTextInputManager(TextInputInterfaceVersion::UnstableV0, display)->create();
+    display->createTextInputManager(TextInputInterfaceVersion::UnstableV2, display)->create();
+    display->createXdgShell(XdgShellInterfaceVersion::UnstableV6, display)->create();
+    globals.xdgShell = display->createXdgShell(XdgShellInterfaceVersion::Stable, display);
+    globals.xdgShell->create();
+    display->createRelativePointerManager(RelativePointerInterfaceVersion::UnstableV1, display)->create();
+    display->createPointerGestures(PointerGesturesInterfaceVersion::UnstableV1, display)->create();
+    display->createPointerConstraints(PointerConstraintsInterfaceVersion::UnstableV1, display)->create();
+    display->createXdgForeignInterface(display)->create();
+    display->createIdleInhibitManager(IdleInhibitManagerInterfaceVersion::UnstableV1, display)->create();
+    display->createXdgOutputManager(display)->create();
+    display->createXdgDecorationManager(globals.xdgShell, display)->create();
+    return globals;
+}
@@ -1 +1,4 @@
+#cmakedefine01 HAVE_LINUX_DMA_BUF_H
 #cmakedefine01 HAVE_LINUX_INPUT_H
+#cmakedefine01 HAVE_LINUX_UDMABUF_H
+#cmakedefine01 HAVE_MEMFD
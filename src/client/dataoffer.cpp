@@ -19,12 +19,18 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "dataoffer.h"
 #include "datadevice.h"
+#include "datatransfer_p.h"
 #include "wayland_pointer_p.h"
 // Qt
+#include <QFutureWatcher>
 #include <QMimeType>
 #include <QMimeDatabase>
+#include <QtConcurrentRun>
 // Wayland
 #include <wayland-client-protocol.h>
+// system
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace KWayland
 {
@@ -41,6 +47,8 @@ public:
     DataDeviceManager::DnDActions sourceActions = DataDeviceManager::DnDAction::None;
     DataDeviceManager::DnDAction selectedAction = DataDeviceManager::DnDAction::None;
 
+    int requestPipe(const QString &mimeType);
+
 private:
     void offer(const QString &mimeType);
     void setAction(DataDeviceManager::DnDAction action);
@@ -166,6 +174,77 @@ QList< QMimeType > DataOffer::offeredMimeTypes() const
     return d->mimeTypes;
 }
 
+int DataOffer::Private::requestPipe(const QString &mimeType)
+{
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC) != 0) {
+        return -1;
+    }
+    wl_data_offer_receive(dataOffer, mimeType.toUtf8().constData(), pipeFds[1]);
+    close(pipeFds[1]);
+    return pipeFds[0];
+}
+
+void DataOffer::receiveData(const QString &mimeType)
+{
+    Q_ASSERT(isValid());
+    const int fd = d->requestPipe(mimeType);
+    if (fd == -1) {
+        emit dataReceived(mimeType, QByteArray());
+        return;
+    }
+    auto readData = [fd] () -> QByteArray {
+        QByteArray data;
+        const qint64 size = DataTransfer::read(fd, data);
+        close(fd);
+        if (size == -1) {
+            return QByteArray();
+        }
+        if (data.isNull()) {
+            // distinguish an empty transfer from a failed one
+            data = QByteArray("");
+        }
+        return data;
+    };
+    QFutureWatcher<QByteArray> *watcher = new QFutureWatcher<QByteArray>(this);
+    connect(watcher, &QFutureWatcher<QByteArray>::finished, this,
+        [this, watcher, mimeType] {
+            watcher->deleteLater();
+            emit dataReceived(mimeType, watcher->result());
+        }
+    );
+    watcher->setFuture(QtConcurrent::run(readData));
+}
+
+bool DataOffer::receiveToFile(const QString &mimeType, int fd)
+{
+    Q_ASSERT(isValid());
+    const int targetFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (targetFd == -1) {
+        return false;
+    }
+    const int pipeFd = d->requestPipe(mimeType);
+    if (pipeFd == -1) {
+        close(targetFd);
+        return false;
+    }
+    auto readToFile = [pipeFd, targetFd] () -> qint64 {
+        const qint64 size = DataTransfer::readToFile(pipeFd, targetFd);
+        close(pipeFd);
+        close(targetFd);
+        return size;
+    };
+    QFutureWatcher<qint64> *watcher = new QFutureWatcher<qint64>(this);
+    connect(watcher, &QFutureWatcher<qint64>::finished, this,
+        [this, watcher, mimeType] {
+            watcher->deleteLater();
+            emit receivedToFile(mimeType, watcher->result());
+        }
+    );
+    watcher->setFuture(QtConcurrent::run(readToFile));
+    return true;
+}
+
 void DataOffer::receive(const QMimeType &mimeType, qint32 fd)
 {
     receive(mimeType.name(), fd);
@@ -81,6 +81,30 @@ public:
     void receive(const QMimeType &mimeType, qint32 fd);
     void receive(const QString &mimeType, qint32 fd);
 
+    /**
+     * Requests the data for @p mimeType and reads it asynchronously in a worker thread.
+     *
+     * Once all data got read the signal dataReceived is emitted. The request is sent
+     * with the next flush of the connection.
+     *
+     * @see dataReceived
+     * @since 5.68
+     **/
+    void receiveData(const QString &mimeType);
+    /**
+     * Requests the data for @p mimeType and writes it asynchronously in a worker thread
+     * into the file @p fd refers to, starting at its current offset.
+     *
+     * The data is moved with splice from the transfer pipe into the file, without
+     * copying it through user space. The file descriptor gets duplicated, the caller keeps
+     * ownership of @p fd. Once the transfer finished the signal receivedToFile is emitted.
+     *
+     * @returns @c false if the transfer could not be started
+     * @see receivedToFile
+     * @since 5.68
+     **/
+    bool receiveToFile(const QString &mimeType, int fd);
+
     /**
      * Notifies the compositor that the drag destination successfully
      * finished the drag-and-drop operation.
@@ -129,6 +153,20 @@ Q_SIGNALS:
      * @since 5.42
      **/
     void selectedDragAndDropActionChanged();
+    /**
+     * Emitted when the transfer started by receiveData finished.
+     * @param mimeType The requested mime type
+     * @param data The received data, a null QByteArray if the transfer failed
+     * @since 5.68
+     **/
+    void dataReceived(const QString &mimeType, const QByteArray &data);
+    /**
+     * Emitted when the transfer started by receiveToFile finished.
+     * @param mimeType The requested mime type
+     * @param size The number of bytes written to the file or @c -1 if the transfer failed
+     * @since 5.68
+     **/
+    void receivedToFile(const QString &mimeType, qint64 size);
 
 private:
     friend class DataDevice;
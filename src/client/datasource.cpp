@@ -18,11 +18,18 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "datasource.h"
+#include "datatransfer_p.h"
 #include "wayland_pointer_p.h"
 // Qt
+#include <QFutureWatcher>
+#include <QHash>
 #include <QMimeType>
+#include <QtConcurrentRun>
 // Wayland
 #include <wayland-client-protocol.h>
+// system
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace KWayland
 {
@@ -33,12 +40,24 @@ class Q_DECL_HIDDEN DataSource::Private
 {
 public:
     explicit Private(DataSource *q);
+    ~Private();
     void setup(wl_data_source *s);
 
     WaylandPointer<wl_data_source, wl_data_source_destroy> source;
     DataDeviceManager::DnDAction selectedAction = DataDeviceManager::DnDAction::None;
 
+    /**
+     * Content served by the DataSource itself, either from memory or from a file.
+     **/
+    struct Content {
+        QByteArray data;
+        int fd = -1;
+    };
+    QHash<QString, Content> contents;
+    void setContent(const QString &mimeType, const Content &content);
+
 private:
+    void send(const QString &mimeType, int fd);
     void setAction(DataDeviceManager::DnDAction action);
     static void targetCallback(void *data, wl_data_source *dataSource, const char *mimeType);
     static void sendCallback(void *data, wl_data_source *dataSource, const char *mimeType, int32_t fd);
@@ -66,6 +85,65 @@ DataSource::Private::Private(DataSource *q)
 {
 }
 
+DataSource::Private::~Private()
+{
+    for (auto it = contents.constBegin(); it != contents.constEnd(); ++it) {
+        if (it.value().fd != -1) {
+            close(it.value().fd);
+        }
+    }
+}
+
+void DataSource::Private::setContent(const QString &mimeType, const Content &content)
+{
+    auto it = contents.find(mimeType);
+    if (it != contents.end()) {
+        if (it.value().fd != -1) {
+            close(it.value().fd);
+        }
+        it.value() = content;
+        return;
+    }
+    contents.insert(mimeType, content);
+    q->offer(mimeType);
+}
+
+void DataSource::Private::send(const QString &mimeType, int fd)
+{
+    const auto it = contents.constFind(mimeType);
+    if (it == contents.constEnd()) {
+        emit q->sendDataRequested(mimeType, fd);
+        return;
+    }
+    const QByteArray data = it.value().data;
+    const int sourceFd = it.value().fd == -1 ? -1 : fcntl(it.value().fd, F_DUPFD_CLOEXEC, 0);
+    if (it.value().fd != -1 && sourceFd == -1) {
+        close(fd);
+        emit q->dataSent(mimeType, -1);
+        return;
+    }
+    // the transfer takes as long as the receiver needs, so it must not block the event loop
+    auto sendData = [data, sourceFd, fd] () -> qint64 {
+        qint64 size;
+        if (sourceFd == -1) {
+            size = DataTransfer::write(fd, data);
+        } else {
+            size = DataTransfer::copyFile(fd, sourceFd);
+            close(sourceFd);
+        }
+        close(fd);
+        return size;
+    };
+    QFutureWatcher<qint64> *watcher = new QFutureWatcher<qint64>(q);
+    QObject::connect(watcher, &QFutureWatcher<qint64>::finished, q,
+        [this, watcher, mimeType] {
+            watcher->deleteLater();
+            emit q->dataSent(mimeType, watcher->result());
+        }
+    );
+    watcher->setFuture(QtConcurrent::run(sendData));
+}
+
 void DataSource::Private::targetCallback(void *data, wl_data_source *dataSource, const char *mimeType)
 {
     auto d = reinterpret_cast<DataSource::Private*>(data);
@@ -77,7 +155,7 @@ void DataSource::Private::sendCallback(void *data, wl_data_source *dataSource, c
 {
     auto d = reinterpret_cast<DataSource::Private*>(data);
     Q_ASSERT(d->source == dataSource);
-    emit d->q->sendDataRequested(QString::fromUtf8(mimeType), fd);
+    d->send(QString::fromUtf8(mimeType), fd);
 }
 
 void DataSource::Private::cancelledCallback(void *data, wl_data_source *dataSource)
@@ -184,6 +262,24 @@ void DataSource::offer(const QMimeType &mimeType)
     offer(mimeType.name());
 }
 
+void DataSource::setData(const QString &mimeType, const QByteArray &data)
+{
+    Private::Content content;
+    content.data = data;
+    d->setContent(mimeType, content);
+}
+
+bool DataSource::setFile(const QString &mimeType, int fd)
+{
+    Private::Content content;
+    content.fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (content.fd == -1) {
+        return false;
+    }
+    d->setContent(mimeType, content);
+    return true;
+}
+
 DataSource::operator wl_data_source*() const
 {
     return d->source;
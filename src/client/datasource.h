@@ -86,6 +86,37 @@ public:
     void offer(const QString &mimeType);
     void offer(const QMimeType &mimeType);
 
+    /**
+     * Offers @p mimeType and serves all requests for it with @p data.
+     *
+     * The data is written asynchronously in a worker thread, so a slow or large
+     * transfer does not block the event loop. For @p mimeType the signal sendDataRequested
+     * is no longer emitted, instead dataSent is emitted once a transfer is done.
+     * Calling this method again for the same @p mimeType replaces the served data.
+     *
+     * @see setFile
+     * @see dataSent
+     * @since 5.68
+     **/
+    void setData(const QString &mimeType, const QByteArray &data);
+    /**
+     * Offers @p mimeType and serves all requests for it with the content of the file
+     * @p fd refers to.
+     *
+     * The file descriptor gets duplicated, the caller keeps ownership of @p fd. Each
+     * request gets the complete file starting at offset @c 0. The content is transferred
+     * asynchronously in a worker thread with sendfile, so it is not copied through user
+     * space. This works well for memfds or large temporary files.
+     * For @p mimeType the signal sendDataRequested is no longer emitted, instead dataSent
+     * is emitted once a transfer is done.
+     *
+     * @returns @c false if @p fd could not be duplicated
+     * @see setData
+     * @see dataSent
+     * @since 5.68
+     **/
+    bool setFile(const QString &mimeType, int fd);
+
     /**
      * Sets the actions that the source side client supports for this
      * operation.
@@ -120,6 +151,13 @@ Q_SIGNALS:
      * it.
      **/
     void sendDataRequested(const QString &mimeType, qint32 fd);
+    /**
+     * Emitted when the transfer of the data set for @p mimeType through setData or setFile
+     * to a receiver finished.
+     * @param size The number of bytes sent or @c -1 if the transfer failed
+     * @since 5.68
+     **/
+    void dataSent(const QString &mimeType, qint64 size);
     /**
      * This DataSource has been replaced by another DataSource.
      * The client should clean up and destroy this DataSource.
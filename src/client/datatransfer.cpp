@@ -0,0 +1,300 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "datatransfer_p.h"
+#include "logging.h"
+// system
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+// std
+#include <limits>
+
+namespace KWayland
+{
+namespace Client
+{
+namespace DataTransfer
+{
+
+namespace
+{
+
+// large enough to keep a pipe full with few syscalls
+static const qint64 s_chunkSize = 1024 * 1024;
+
+/**
+ * Blocks SIGPIPE for the current thread while in scope, so that writes to a pipe
+ * whose reader went away fail with EPIPE instead of terminating the process.
+ * A SIGPIPE raised meanwhile gets consumed before the signal mask is restored.
+ **/
+class SigPipeBlocker
+{
+public:
+    SigPipeBlocker()
+    {
+        sigemptyset(&m_set);
+        sigaddset(&m_set, SIGPIPE);
+        sigset_t pending;
+        sigemptyset(&pending);
+        sigpending(&pending);
+        m_wasPending = sigismember(&pending, SIGPIPE);
+        if (!m_wasPending) {
+            pthread_sigmask(SIG_BLOCK, &m_set, &m_oldSet);
+        }
+    }
+    ~SigPipeBlocker()
+    {
+        if (m_wasPending) {
+            return;
+        }
+        if (m_brokenPipe) {
+            static const struct timespec zero = {0, 0};
+            while (sigtimedwait(&m_set, nullptr, &zero) == -1 && errno == EINTR) {
+            }
+        }
+        pthread_sigmask(SIG_SETMASK, &m_oldSet, nullptr);
+    }
+    void setBrokenPipe()
+    {
+        m_brokenPipe = true;
+    }
+
+private:
+    sigset_t m_set;
+    sigset_t m_oldSet;
+    bool m_wasPending = false;
+    bool m_brokenPipe = false;
+};
+
+/**
+ * Switches a file descriptor to non-blocking mode while in scope, so that a peer which
+ * stops reading or writing ends in EAGAIN and the transfer waits in poll with s_timeout
+ * instead of blocking the worker thread forever. The original flags get restored.
+ **/
+class NonBlocking
+{
+public:
+    explicit NonBlocking(int fd)
+        : m_fd(fd)
+        , m_flags(fcntl(fd, F_GETFL))
+    {
+        if (m_flags != -1 && !(m_flags & O_NONBLOCK)) {
+            fcntl(m_fd, F_SETFL, m_flags | O_NONBLOCK);
+        }
+    }
+    ~NonBlocking()
+    {
+        if (m_flags != -1 && !(m_flags & O_NONBLOCK)) {
+            fcntl(m_fd, F_SETFL, m_flags);
+        }
+    }
+
+private:
+    int m_fd;
+    int m_flags;
+};
+
+static bool waitFor(int fd, short events)
+{
+    pollfd pfd = {fd, events, 0};
+    while (true) {
+        const int ret = poll(&pfd, 1, s_timeout);
+        if (ret > 0) {
+            return true;
+        }
+        if (ret == 0) {
+            qCWarning(KWAYLAND_CLIENT) << "Data transfer timed out";
+            return false;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+// handles the result of one transfer syscall, returns whether to retry
+static bool retry(qint64 ret, int fd, short events, SigPipeBlocker *blocker = nullptr)
+{
+    if (ret >= 0) {
+        return true;
+    }
+    if (errno == EINTR) {
+        return true;
+    }
+    if (errno == EAGAIN) {
+        return waitFor(fd, events);
+    }
+    if (errno == EPIPE && blocker) {
+        blocker->setBrokenPipe();
+    }
+    return false;
+}
+
+}
+
+qint64 write(int fd, const QByteArray &data)
+{
+    SigPipeBlocker blocker;
+    NonBlocking nonBlocking(fd);
+    const char *buffer = data.constData();
+    qint64 remaining = data.size();
+    qint64 total = 0;
+    while (remaining > 0) {
+        const qint64 ret = ::write(fd, buffer + total, qMin(remaining, s_chunkSize));
+        if (ret > 0) {
+            total += ret;
+            remaining -= ret;
+            continue;
+        }
+        if (!retry(ret, fd, POLLOUT, &blocker)) {
+            return -1;
+        }
+    }
+    return total;
+}
+
+qint64 copyFile(int fd, int sourceFd)
+{
+    struct stat info;
+    if (fstat(sourceFd, &info) != 0) {
+        return -1;
+    }
+    SigPipeBlocker blocker;
+    NonBlocking nonBlocking(fd);
+    off_t offset = 0;
+    const off_t size = info.st_size;
+    bool useSendFile = true;
+    while (offset < size) {
+        if (useSendFile) {
+            // sendfile keeps the data in the page cache, it supports any target since Linux 2.6.33
+            const qint64 ret = sendfile(fd, sourceFd, &offset, qMin<qint64>(size - offset, s_chunkSize));
+            if (ret > 0) {
+                continue;
+            }
+            if (ret == 0) {
+                // file got truncated meanwhile
+                break;
+            }
+            if (errno == EINVAL || errno == ENOSYS) {
+                useSendFile = false;
+                continue;
+            }
+            if (!retry(ret, fd, POLLOUT, &blocker)) {
+                return -1;
+            }
+            continue;
+        }
+        char buffer[64 * 1024];
+        const qint64 bytesRead = pread(sourceFd, buffer, qMin<qint64>(size - offset, sizeof(buffer)), offset);
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {
+            return bytesRead == 0 ? qint64(offset) : -1;
+        }
+        if (write(fd, QByteArray::fromRawData(buffer, bytesRead)) != bytesRead) {
+            return -1;
+        }
+        offset += bytesRead;
+    }
+    return offset;
+}
+
+qint64 read(int fd, QByteArray &data)
+{
+    NonBlocking nonBlocking(fd);
+    const int start = data.size();
+    qint64 chunk = 64 * 1024;
+    while (true) {
+        if (data.size() > std::numeric_limits<int>::max() - chunk) {
+            return -1;
+        }
+        const int used = data.size();
+        data.resize(used + chunk);
+        const qint64 ret = ::read(fd, data.data() + used, chunk);
+        if (ret > 0) {
+            data.resize(used + ret);
+            // grow the chunk for large payloads to reduce the number of reallocations and syscalls
+            chunk = qMin(chunk * 2, s_chunkSize);
+            continue;
+        }
+        data.resize(used);
+        if (ret == 0) {
+            return data.size() - start;
+        }
+        if (!retry(ret, fd, POLLIN)) {
+            return -1;
+        }
+    }
+}
+
+qint64 readToFile(int fd, int targetFd)
+{
+    NonBlocking nonBlocking(fd);
+    qint64 total = 0;
+    bool useSplice = true;
+    while (true) {
+        if (useSplice) {
+            // moves the pages from the pipe into the file without a copy in user space,
+            // an empty pipe only fails with EAGAIN if asked for explicitly
+            const qint64 ret = splice(fd, nullptr, targetFd, nullptr, s_chunkSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (ret > 0) {
+                total += ret;
+                continue;
+            }
+            if (ret == 0) {
+                return total;
+            }
+            if (errno == EINVAL || errno == ENOSYS) {
+                useSplice = false;
+                continue;
+            }
+            if (!retry(ret, fd, POLLIN)) {
+                return -1;
+            }
+            continue;
+        }
+        char buffer[64 * 1024];
+        const qint64 bytesRead = ::read(fd, buffer, sizeof(buffer));
+        if (bytesRead == 0) {
+            return total;
+        }
+        if (bytesRead < 0) {
+            if (!retry(bytesRead, fd, POLLIN)) {
+                return -1;
+            }
+            continue;
+        }
+        if (write(targetFd, QByteArray::fromRawData(buffer, bytesRead)) != bytesRead) {
+            return -1;
+        }
+        total += bytesRead;
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,69 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWAYLAND_CLIENT_DATATRANSFER_P_H
+#define KWAYLAND_CLIENT_DATATRANSFER_P_H
+
+#include <QByteArray>
+
+namespace KWayland
+{
+namespace Client
+{
+
+/**
+ * Blocking helpers moving clipboard and drag and drop data through the file descriptors
+ * exchanged with wl_data_source.send and wl_data_offer.receive.
+ *
+ * They are meant to run in a worker thread. Pipes and sockets are served with
+ * sendfile/splice where the kernel supports it, so file content never gets copied into
+ * user space. The pipe or socket is switched to non-blocking mode for the duration of the
+ * transfer, so each helper gives up if the other side does not make any progress for
+ * s_timeout milliseconds. No SIGPIPE is raised if the other side goes away.
+ * All helpers return the number of transferred bytes or @c -1 on error.
+ **/
+namespace DataTransfer
+{
+
+static const int s_timeout = 5000;
+
+/**
+ * Writes @p data into @p fd.
+ **/
+qint64 write(int fd, const QByteArray &data);
+/**
+ * Writes the complete content of the file @p sourceFd into @p fd, starting at
+ * offset @c 0 without changing the file offset of @p sourceFd.
+ **/
+qint64 copyFile(int fd, int sourceFd);
+/**
+ * Reads from @p fd until end of file and appends to @p data.
+ **/
+qint64 read(int fd, QByteArray &data);
+/**
+ * Reads from the pipe @p fd until end of file and writes everything into the file @p targetFd.
+ **/
+qint64 readToFile(int fd, int targetFd);
+
+}
+
+}
+}
+
+#endif
@@ -18,11 +18,15 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "keyboard.h"
+#include "logging.h"
 #include "surface.h"
 #include "wayland_pointer_p.h"
 #include <QPointer>
 // wayland
 #include <wayland-client-protocol.h>
+// system
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace KWayland
 {
@@ -205,6 +209,32 @@ qint32 Keyboard::keyRepeatRate() const
     return d->repeatInfo.charactersPerSecond;
 }
 
+QByteArray Keyboard::readKeymap(int fd, quint32 size)
+{
+    if (fd < 0 || size == 0) {
+        return QByteArray();
+    }
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || !S_ISREG(fileInfo.st_mode)) {
+        qCWarning(KWAYLAND_CLIENT) << "Keymap is not a regular file";
+        return QByteArray();
+    }
+    if (fileInfo.st_size < off_t(size)) {
+        qCWarning(KWAYLAND_CLIENT) << "Keymap size" << size << "exceeds file size" << fileInfo.st_size;
+        return QByteArray();
+    }
+    // a private read-only mapping works for sealed and unsealed files alike
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        qCWarning(KWAYLAND_CLIENT) << "Could not map keymap";
+        return QByteArray();
+    }
+    const char *data = static_cast<const char*>(map);
+    const QByteArray keymap(data, int(qstrnlen(data, size)));
+    munmap(map, size);
+    return keymap;
+}
+
 Keyboard::operator wl_keyboard*()
 {
     return d->keyboard;
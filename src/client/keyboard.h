@@ -122,6 +122,24 @@ public:
      **/
     qint32 keyRepeatDelay() const;
 
+    /**
+     * Reads the keymap passed with keymapChanged.
+     *
+     * The file is mapped read-only, which works with keymaps the compositor sealed
+     * against modification. The @p size announced by the compositor is validated
+     * against the actual file size, a keymap exceeding the file is rejected.
+     * The terminating null byte is not part of the returned data.
+     *
+     * The file descriptor is not closed, the caller keeps ownership of @p fd.
+     *
+     * @param fd The file descriptor passed with keymapChanged
+     * @param size The size passed with keymapChanged
+     * @returns The keymap, a null QByteArray if it could not be read
+     * @see keymapChanged
+     * @since 5.68
+     **/
+    static QByteArray readKeymap(int fd, quint32 size);
+
     operator wl_keyboard*();
     operator wl_keyboard*() const;
 
@@ -145,6 +163,7 @@ Q_SIGNALS:
      * be memory-mapped to provide a keyboard mapping description.
      *
      * The signal is only emitted if the keymap format is libxkbcommon compatible.
+     * Use readKeymap to access the content.
      *
      * @param fd file descriptor of the keymap
      * @param size The size of the keymap
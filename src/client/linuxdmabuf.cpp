@@ -0,0 +1,443 @@
+/****************************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+#include "linuxdmabuf.h"
+#include "event_queue.h"
+#include "wayland_pointer_p.h"
+
+#include <wayland-linux-dmabuf-unstable-v1-client-protocol.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// version 4 adds the dmabuf feedback, only available with newer wayland-protocols
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+#define KWAYLAND_LINUX_DMABUF_FEEDBACK 1
+#else
+#define KWAYLAND_LINUX_DMABUF_FEEDBACK 0
+#endif
+
+namespace KWayland
+{
+namespace Client
+{
+
+// the value of DRM_FORMAT_MOD_INVALID, not pulling in drm_fourcc.h for a single constant
+static const quint64 s_modifierInvalid = 0x00ffffffffffffffULL;
+
+class Q_DECL_HIDDEN LinuxDmabuf::Private
+{
+public:
+    Private(LinuxDmabuf *q);
+
+    void setup(zwp_linux_dmabuf_v1 *arg);
+    void addFormat(quint32 format, quint64 modifier);
+    void reset();
+
+    WaylandPointer<zwp_linux_dmabuf_v1, zwp_linux_dmabuf_v1_destroy> linuxdmabuf;
+    EventQueue *queue = nullptr;
+    QHash<quint32, QVector<quint64>> formats;
+
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    WaylandPointer<zwp_linux_dmabuf_feedback_v1, zwp_linux_dmabuf_feedback_v1_destroy> feedback;
+    struct FormatModifier {
+        uint32_t format;
+        uint32_t padding;
+        uint64_t modifier;
+    };
+    // the format table shared by the compositor, mapped read-only
+    const FormatModifier *formatTable = nullptr;
+    size_t formatTableSize = 0;
+    // the table entries of the tranches received since the last done
+    QVector<uint16_t> pendingIndices;
+    void unmapFormatTable();
+#endif
+
+private:
+    static void formatCallback(void *data, zwp_linux_dmabuf_v1 *linuxdmabuf, uint32_t format);
+    static void modifierCallback(void *data, zwp_linux_dmabuf_v1 *linuxdmabuf, uint32_t format,
+                                 uint32_t modifierHi, uint32_t modifierLo);
+
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    static void doneCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback);
+    static void formatTableCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, int32_t fd, uint32_t size);
+    static void mainDeviceCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *device);
+    static void trancheDoneCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback);
+    static void trancheTargetDeviceCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *device);
+    static void trancheFormatsCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *indices);
+    static void trancheFlagsCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, uint32_t flags);
+    static const zwp_linux_dmabuf_feedback_v1_listener s_feedbackListener;
+#endif
+
+    LinuxDmabuf *q;
+    static const zwp_linux_dmabuf_v1_listener s_listener;
+};
+
+const zwp_linux_dmabuf_v1_listener LinuxDmabuf::Private::s_listener = {
+    formatCallback,
+    modifierCallback
+};
+
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+const zwp_linux_dmabuf_feedback_v1_listener LinuxDmabuf::Private::s_feedbackListener = {
+    doneCallback,
+    formatTableCallback,
+    mainDeviceCallback,
+    trancheDoneCallback,
+    trancheTargetDeviceCallback,
+    trancheFormatsCallback,
+    trancheFlagsCallback
+};
+#endif
+
+LinuxDmabuf::Private::Private(LinuxDmabuf *q)
+    : q(q)
+{
+}
+
+void LinuxDmabuf::Private::formatCallback(void *data, zwp_linux_dmabuf_v1 *linuxdmabuf, uint32_t format)
+{
+    auto p = reinterpret_cast<LinuxDmabuf::Private*>(data);
+    Q_ASSERT(p->linuxdmabuf == linuxdmabuf);
+    p->addFormat(format, s_modifierInvalid);
+}
+
+void LinuxDmabuf::Private::modifierCallback(void *data, zwp_linux_dmabuf_v1 *linuxdmabuf, uint32_t format,
+                                            uint32_t modifierHi, uint32_t modifierLo)
+{
+    auto p = reinterpret_cast<LinuxDmabuf::Private*>(data);
+    Q_ASSERT(p->linuxdmabuf == linuxdmabuf);
+    p->addFormat(format, (quint64(modifierHi) << 32) | modifierLo);
+}
+
+void LinuxDmabuf::Private::addFormat(quint32 format, quint64 modifier)
+{
+    // version 3 compositors may announce a linear or implicit modifier through both events
+    QVector<quint64> &modifiers = formats[format];
+    if (modifiers.contains(modifier)) {
+        return;
+    }
+    modifiers << modifier;
+    emit q->formatAnnounced(format, modifier);
+}
+
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+void LinuxDmabuf::Private::doneCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback)
+{
+    // each update of the feedback carries all tranches again
+    auto p = reinterpret_cast<LinuxDmabuf::Private*>(data);
+    Q_ASSERT(p->feedback == feedback);
+    const size_t entries = p->formatTableSize / sizeof(FormatModifier);
+    QHash<quint32, QVector<quint64>> previous;
+    previous.swap(p->formats);
+    for (uint16_t index : qAsConst(p->pendingIndices)) {
+        if (index >= entries) {
+            continue;
+        }
+        const FormatModifier &entry = p->formatTable[index];
+        QVector<quint64> &modifiers = p->formats[entry.format];
+        if (modifiers.contains(entry.modifier)) {
+            continue;
+        }
+        modifiers << entry.modifier;
+        if (!previous.value(entry.format).contains(entry.modifier)) {
+            emit p->q->formatAnnounced(entry.format, entry.modifier);
+        }
+    }
+    p->pendingIndices.clear();
+}
+
+void LinuxDmabuf::Private::formatTableCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, int32_t fd, uint32_t size)
+{
+    auto p = reinterpret_cast<LinuxDmabuf::Private*>(data);
+    Q_ASSERT(p->feedback == feedback);
+    p->unmapFormatTable();
+    if (size > 0) {
+        void *table = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (table != MAP_FAILED) {
+            p->formatTable = static_cast<const FormatModifier*>(table);
+            p->formatTableSize = size;
+        }
+    }
+    close(fd);
+}
+
+void LinuxDmabuf::Private::mainDeviceCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *device)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(feedback)
+    Q_UNUSED(device)
+}
+
+void LinuxDmabuf::Private::trancheDoneCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(feedback)
+}
+
+void LinuxDmabuf::Private::trancheTargetDeviceCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *device)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(feedback)
+    Q_UNUSED(device)
+}
+
+void LinuxDmabuf::Private::trancheFormatsCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *indices)
+{
+    auto p = reinterpret_cast<LinuxDmabuf::Private*>(data);
+    Q_ASSERT(p->feedback == feedback);
+    const uint16_t *begin = static_cast<const uint16_t*>(indices->data);
+    const uint16_t *end = begin + indices->size / sizeof(uint16_t);
+    for (const uint16_t *index = begin; index != end; ++index) {
+        p->pendingIndices << *index;
+    }
+}
+
+void LinuxDmabuf::Private::trancheFlagsCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, uint32_t flags)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(feedback)
+    Q_UNUSED(flags)
+}
+
+void LinuxDmabuf::Private::unmapFormatTable()
+{
+    if (formatTable) {
+        munmap(const_cast<FormatModifier*>(formatTable), formatTableSize);
+        formatTable = nullptr;
+        formatTableSize = 0;
+    }
+}
+#endif
+
+void LinuxDmabuf::Private::setup(zwp_linux_dmabuf_v1 *arg)
+{
+    Q_ASSERT(arg);
+    Q_ASSERT(!linuxdmabuf);
+    linuxdmabuf.setup(arg);
+    zwp_linux_dmabuf_v1_add_listener(linuxdmabuf, &s_listener, this);
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    // version 4 announces the formats only through the feedback
+    if (zwp_linux_dmabuf_v1_get_version(linuxdmabuf) >= ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION) {
+        feedback.setup(zwp_linux_dmabuf_v1_get_default_feedback(linuxdmabuf));
+        zwp_linux_dmabuf_feedback_v1_add_listener(feedback, &s_feedbackListener, this);
+    }
+#endif
+}
+
+void LinuxDmabuf::Private::reset()
+{
+    formats.clear();
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    pendingIndices.clear();
+    unmapFormatTable();
+#endif
+}
+
+LinuxDmabuf::LinuxDmabuf(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+LinuxDmabuf::~LinuxDmabuf()
+{
+    release();
+}
+
+void LinuxDmabuf::setup(zwp_linux_dmabuf_v1 *linuxdmabuf)
+{
+    d->setup(linuxdmabuf);
+}
+
+void LinuxDmabuf::release()
+{
+    d->reset();
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    d->feedback.release();
+#endif
+    d->linuxdmabuf.release();
+}
+
+void LinuxDmabuf::destroy()
+{
+    d->reset();
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    d->feedback.destroy();
+#endif
+    d->linuxdmabuf.destroy();
+}
+
+LinuxDmabuf::operator zwp_linux_dmabuf_v1*() {
+    return d->linuxdmabuf;
+}
+
+LinuxDmabuf::operator zwp_linux_dmabuf_v1*() const {
+    return d->linuxdmabuf;
+}
+
+bool LinuxDmabuf::isValid() const
+{
+    return d->linuxdmabuf.isValid();
+}
+
+void LinuxDmabuf::setEventQueue(EventQueue *queue)
+{
+    d->queue = queue;
+}
+
+EventQueue *LinuxDmabuf::eventQueue()
+{
+    return d->queue;
+}
+
+QHash<quint32, QVector<quint64>> LinuxDmabuf::supportedFormats() const
+{
+    return d->formats;
+}
+
+bool LinuxDmabuf::isFormatSupported(quint32 format, quint64 modifier) const
+{
+    auto it = d->formats.constFind(format);
+    return it != d->formats.constEnd() && it->contains(modifier);
+}
+
+LinuxDmabufParams *LinuxDmabuf::createParams(QObject *parent)
+{
+    Q_ASSERT(isValid());
+    auto p = new LinuxDmabufParams(parent);
+    auto w = zwp_linux_dmabuf_v1_create_params(d->linuxdmabuf);
+    if (d->queue) {
+        d->queue->addProxy(w);
+    }
+    p->setup(w);
+    return p;
+}
+
+class Q_DECL_HIDDEN LinuxDmabufParams::Private
+{
+public:
+    Private(LinuxDmabufParams *q);
+
+    void setup(zwp_linux_buffer_params_v1 *arg);
+
+    WaylandPointer<zwp_linux_buffer_params_v1, zwp_linux_buffer_params_v1_destroy> params;
+
+private:
+    static void createdCallback(void *data, zwp_linux_buffer_params_v1 *params, wl_buffer *buffer);
+    static void failedCallback(void *data, zwp_linux_buffer_params_v1 *params);
+
+    LinuxDmabufParams *q;
+    static const zwp_linux_buffer_params_v1_listener s_listener;
+};
+
+const zwp_linux_buffer_params_v1_listener LinuxDmabufParams::Private::s_listener = {
+    createdCallback,
+    failedCallback
+};
+
+LinuxDmabufParams::Private::Private(LinuxDmabufParams *q)
+    : q(q)
+{
+}
+
+void LinuxDmabufParams::Private::createdCallback(void *data, zwp_linux_buffer_params_v1 *params, wl_buffer *buffer)
+{
+    auto p = reinterpret_cast<LinuxDmabufParams::Private*>(data);
+    Q_ASSERT(p->params == params);
+    emit p->q->created(buffer);
+}
+
+void LinuxDmabufParams::Private::failedCallback(void *data, zwp_linux_buffer_params_v1 *params)
+{
+    auto p = reinterpret_cast<LinuxDmabufParams::Private*>(data);
+    Q_ASSERT(p->params == params);
+    emit p->q->failed();
+}
+
+void LinuxDmabufParams::Private::setup(zwp_linux_buffer_params_v1 *arg)
+{
+    Q_ASSERT(arg);
+    Q_ASSERT(!params);
+    params.setup(arg);
+    zwp_linux_buffer_params_v1_add_listener(params, &s_listener, this);
+}
+
+LinuxDmabufParams::LinuxDmabufParams(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+LinuxDmabufParams::~LinuxDmabufParams()
+{
+    release();
+}
+
+void LinuxDmabufParams::setup(zwp_linux_buffer_params_v1 *params)
+{
+    d->setup(params);
+}
+
+void LinuxDmabufParams::release()
+{
+    d->params.release();
+}
+
+void LinuxDmabufParams::destroy()
+{
+    d->params.destroy();
+}
+
+LinuxDmabufParams::operator zwp_linux_buffer_params_v1*() {
+    return d->params;
+}
+
+LinuxDmabufParams::operator zwp_linux_buffer_params_v1*() const {
+    return d->params;
+}
+
+bool LinuxDmabufParams::isValid() const
+{
+    return d->params.isValid();
+}
+
+void LinuxDmabufParams::addPlane(int fd, quint32 planeIndex, quint32 offset, quint32 stride, quint64 modifier)
+{
+    Q_ASSERT(isValid());
+    zwp_linux_buffer_params_v1_add(d->params, fd, planeIndex, offset, stride, modifier >> 32, modifier & 0xffffffff);
+}
+
+void LinuxDmabufParams::create(const QSize &size, quint32 format, Flags flags)
+{
+    Q_ASSERT(isValid());
+    zwp_linux_buffer_params_v1_create(d->params, size.width(), size.height(), format, uint32_t(flags));
+}
+
+wl_buffer *LinuxDmabufParams::createImmediate(const QSize &size, quint32 format, Flags flags)
+{
+    Q_ASSERT(isValid());
+    if (zwp_linux_buffer_params_v1_get_version(d->params) < ZWP_LINUX_BUFFER_PARAMS_V1_CREATE_IMMED_SINCE_VERSION) {
+        return nullptr;
+    }
+    return zwp_linux_buffer_params_v1_create_immed(d->params, size.width(), size.height(), format, uint32_t(flags));
+}
+
+}
+}
@@ -0,0 +1,301 @@
+/****************************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+#ifndef KWAYLAND_CLIENT_LINUXDMABUF_H
+#define KWAYLAND_CLIENT_LINUXDMABUF_H
+
+#include <QHash>
+#include <QObject>
+#include <QSize>
+#include <QVector>
+
+#include <KWayland/Client/kwaylandclient_export.h>
+
+struct wl_buffer;
+struct zwp_linux_dmabuf_v1;
+struct zwp_linux_buffer_params_v1;
+
+namespace KWayland
+{
+namespace Client
+{
+
+class EventQueue;
+class LinuxDmabufParams;
+
+/**
+ * @short Wrapper for the zwp_linux_dmabuf_v1 interface.
+ *
+ * This class provides a convenient wrapper for the zwp_linux_dmabuf_v1 interface.
+ * It allows to create wl_buffers from dmabuf file descriptors, thus sharing the
+ * buffer content with the compositor without copying it into a ShmPool.
+ *
+ * To use this class one needs to interact with the Registry. There are two
+ * possible ways to create the LinuxDmabuf interface:
+ * @code
+ * LinuxDmabuf *c = registry->createLinuxDmabuf(name, version);
+ * @endcode
+ *
+ * This creates the LinuxDmabuf and sets it up directly. As an alternative this
+ * can also be done in a more low level way:
+ * @code
+ * LinuxDmabuf *c = new LinuxDmabuf;
+ * c->setup(registry->bindLinuxDmabufUnstableV1(name, version));
+ * @endcode
+ *
+ * Directly after binding the compositor announces the supported formats and modifiers,
+ * they are available through supportedFormats once the next roundtrip finished.
+ *
+ * The LinuxDmabuf can be used as a drop-in replacement for any zwp_linux_dmabuf_v1
+ * pointer as it provides matching cast operators.
+ *
+ * @see Registry
+ * @see LinuxDmabufParams
+ * @since 5.68
+ **/
+class KWAYLANDCLIENT_EXPORT LinuxDmabuf : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Creates a new LinuxDmabuf.
+     * Note: after constructing the LinuxDmabuf it is not yet valid and one needs
+     * to call setup. In order to get a ready to use LinuxDmabuf prefer using
+     * Registry::createLinuxDmabuf.
+     **/
+    explicit LinuxDmabuf(QObject *parent = nullptr);
+    virtual ~LinuxDmabuf();
+
+    /**
+     * Setup this LinuxDmabuf to manage the @p linuxdmabuf.
+     * When using Registry::createLinuxDmabuf there is no need to call this
+     * method.
+     **/
+    void setup(zwp_linux_dmabuf_v1 *linuxdmabuf);
+    /**
+     * @returns @c true if managing a zwp_linux_dmabuf_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the zwp_linux_dmabuf_v1 interface.
+     * After the interface has been released the LinuxDmabuf instance is no
+     * longer valid and can be setup with another zwp_linux_dmabuf_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this LinuxDmabuf.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away. If the connection is not valid anymore, it's not
+     * possible to call release anymore as that calls into the Wayland
+     * connection and the call would fail. This method cleans up the data, so
+     * that the instance can be deleted or set up to a new zwp_linux_dmabuf_v1 interface
+     * once there is a new connection available.
+     *
+     * It is suggested to connect this method to ConnectionThread::connectionDied:
+     * @code
+     * connect(connection, &ConnectionThread::connectionDied, linuxdmabuf, &LinuxDmabuf::destroy);
+     * @endcode
+     *
+     * @see release
+     **/
+    void destroy();
+
+    /**
+     * Sets the @p queue to use for creating objects with this LinuxDmabuf.
+     **/
+    void setEventQueue(EventQueue *queue);
+    /**
+     * @returns The event queue to use for creating objects with this LinuxDmabuf.
+     **/
+    EventQueue *eventQueue();
+
+    /**
+     * The DRM formats announced by the compositor together with the modifiers
+     * supported for each of them.
+     *
+     * A format announced without any modifier, which is what compositors implementing
+     * version 1 or 2 of the interface do, is listed with DRM_FORMAT_MOD_INVALID.
+     * With version 4 the formats are read from the format table of the default
+     * dmabuf feedback, which the compositor shares with all clients.
+     * @see formatAnnounced
+     **/
+    QHash<quint32, QVector<quint64>> supportedFormats() const;
+    /**
+     * @returns Whether the compositor announced the DRM @p format with the @p modifier.
+     **/
+    bool isFormatSupported(quint32 format, quint64 modifier) const;
+
+    /**
+     * Creates a LinuxDmabufParams to assemble the planes of a new wl_buffer.
+     * @param parent The parent object for the LinuxDmabufParams
+     * @returns The created LinuxDmabufParams
+     **/
+    LinuxDmabufParams *createParams(QObject *parent = nullptr);
+
+    operator zwp_linux_dmabuf_v1*();
+    operator zwp_linux_dmabuf_v1*() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted for each @p format and @p modifier combination announced by the compositor.
+     **/
+    void formatAnnounced(quint32 format, quint64 modifier);
+    /**
+     * The corresponding global for this interface on the Registry got removed.
+     *
+     * This signal gets only emitted if the LinuxDmabuf got created by
+     * Registry::createLinuxDmabuf
+     **/
+    void removed();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+/**
+ * @short Wrapper for the zwp_linux_buffer_params_v1 interface.
+ *
+ * The LinuxDmabufParams collects the dmabuf planes making up a buffer. Once all planes
+ * are added either create or createImmediate turns them into a wl_buffer, which can be
+ * attached to a Surface like any other buffer. The LinuxDmabufParams can only be used
+ * for creating one wl_buffer and should be deleted afterwards, the created wl_buffer
+ * stays valid and has to be destroyed by the caller with wl_buffer_destroy.
+ *
+ * @code
+ * LinuxDmabufParams *params = linuxDmabuf->createParams();
+ * params->addPlane(fd, 0, 0, stride, modifier);
+ * connect(params, &LinuxDmabufParams::created, this, [params] (wl_buffer *buffer) {
+ *     surface->attachBuffer(buffer);
+ *     params->deleteLater();
+ * });
+ * params->create(size, DRM_FORMAT_XRGB8888);
+ * @endcode
+ *
+ * @see LinuxDmabuf
+ * @since 5.68
+ **/
+class KWAYLANDCLIENT_EXPORT LinuxDmabufParams : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Flag {
+        YInverted = 1 << 0, ///< Contents are y-inverted
+        Interlaced = 1 << 1, ///< Content is interlaced
+        BottomFieldFirst = 1 << 2 ///< Bottom field first
+    };
+    Q_DECLARE_FLAGS(Flags, Flag)
+
+    virtual ~LinuxDmabufParams();
+
+    /**
+     * Setup this LinuxDmabufParams to manage the @p params.
+     * When using LinuxDmabuf::createParams there is no need to call this
+     * method.
+     **/
+    void setup(zwp_linux_buffer_params_v1 *params);
+    /**
+     * @returns @c true if managing a zwp_linux_buffer_params_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the zwp_linux_buffer_params_v1 interface.
+     * After the interface has been released the LinuxDmabufParams instance is no
+     * longer valid and can be setup with another zwp_linux_buffer_params_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this LinuxDmabufParams.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away. If the connection is not valid anymore, it's not
+     * possible to call release anymore as that calls into the Wayland
+     * connection and the call would fail. This method cleans up the data, so
+     * that the instance can be deleted or set up to a new zwp_linux_buffer_params_v1 interface
+     * once there is a new connection available.
+     *
+     * @see release
+     **/
+    void destroy();
+
+    /**
+     * Adds the dmabuf @p fd as plane @p planeIndex of the buffer.
+     *
+     * The file descriptor is duplicated when sending the request, the caller keeps the
+     * ownership of @p fd and may close it once the request got flushed.
+     *
+     * @param fd The dmabuf file descriptor
+     * @param planeIndex The index of the plane, starting at 0
+     * @param offset The offset of the plane in bytes from the start of the dmabuf
+     * @param stride The distance from the start of a row to the next row in bytes
+     * @param modifier The layout modifier, DRM_FORMAT_MOD_INVALID for an implicit one
+     **/
+    void addPlane(int fd, quint32 planeIndex, quint32 offset, quint32 stride, quint64 modifier);
+
+    /**
+     * Asks the compositor to import the added planes as a buffer of the given
+     * @p size and DRM @p format.
+     *
+     * The result is reported asynchronously through either created or failed.
+     * @see createImmediate
+     **/
+    void create(const QSize &size, quint32 format, Flags flags = Flags());
+    /**
+     * Creates a wl_buffer from the added planes without waiting for the compositor
+     * to import it.
+     *
+     * This saves the roundtrip of create, but if the import fails the compositor
+     * disconnects the client. Thus this should only be used for buffers with a
+     * format and modifier the compositor announced and which got imported
+     * successfully before.
+     *
+     * Requires version 2 of the zwp_linux_dmabuf_v1 interface.
+     *
+     * @returns The created wl_buffer or @c null if not supported.
+     **/
+    wl_buffer *createImmediate(const QSize &size, quint32 format, Flags flags = Flags());
+
+    operator zwp_linux_buffer_params_v1*();
+    operator zwp_linux_buffer_params_v1*() const;
+
+Q_SIGNALS:
+    /**
+     * The compositor imported the planes successfully into @p buffer.
+     * The ownership of @p buffer is passed to the receiver.
+     * @see create
+     **/
+    void created(wl_buffer *buffer);
+    /**
+     * The compositor could not import the planes.
+     * @see create
+     **/
+    void failed();
+
+private:
+    friend class LinuxDmabuf;
+    explicit LinuxDmabufParams(QObject *parent = nullptr);
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWayland::Client::LinuxDmabufParams::Flags)
+
+#endif
@@ -48,6 +48,8 @@ public:
 private:
     static void appliedCallback(void *data, org_kde_kwin_outputconfiguration *config);
     static void failedCallback(void *data, org_kde_kwin_outputconfiguration *config);
+    static void testPassedCallback(void *data, org_kde_kwin_outputconfiguration *config);
+    static void testFailedCallback(void *data, org_kde_kwin_outputconfiguration *config);
 };
 
 OutputConfiguration::OutputConfiguration(QObject *parent)
@@ -206,10 +208,20 @@ void OutputConfiguration::apply()
     org_kde_kwin_outputconfiguration_apply(d->outputconfiguration);
 }
 
+void OutputConfiguration::test()
+{
+    if (wl_proxy_get_version(d->outputconfiguration) < ORG_KDE_KWIN_OUTPUTCONFIGURATION_TEST_SINCE_VERSION) {
+        return;
+    }
+    org_kde_kwin_outputconfiguration_test(d->outputconfiguration);
+}
+
 // Callbacks
 org_kde_kwin_outputconfiguration_listener OutputConfiguration::Private::s_outputconfigurationListener = {
     appliedCallback,
-    failedCallback
+    failedCallback,
+    testPassedCallback,
+    testFailedCallback
 };
 
 void OutputConfiguration::Private::appliedCallback(void* data, org_kde_kwin_outputconfiguration* config)
@@ -226,6 +238,20 @@ void OutputConfiguration::Private::failedCallback(void* data, org_kde_kwin_outpu
     emit o->q->failed();
 }
 
+void OutputConfiguration::Private::testPassedCallback(void* data, org_kde_kwin_outputconfiguration* config)
+{
+    Q_UNUSED(config);
+    auto o = reinterpret_cast<OutputConfiguration::Private*>(data);
+    emit o->q->testPassed();
+}
+
+void OutputConfiguration::Private::testFailedCallback(void* data, org_kde_kwin_outputconfiguration* config)
+{
+    Q_UNUSED(config);
+    auto o = reinterpret_cast<OutputConfiguration::Private*>(data);
+    emit o->q->testFailed();
+}
+
 
 }
 }
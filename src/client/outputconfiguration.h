@@ -242,6 +242,21 @@ public:
      */
     void apply();
 
+    /**
+     * Ask the compositor whether it would accept the changes, without applying them.
+     * The compositor checks the layout resulting from the pending changes of all
+     * outputdevices, e.g. that the modes exist and the outputs do not overlap,
+     * and reacts with the testPassed() or testFailed() signals. The pending changes
+     * are kept, so they can be adjusted and tested again or applied.
+     *
+     * Does nothing if the compositor does not support testing configurations.
+     *
+     * @see testPassed()
+     * @see testFailed()
+     * @since 5.68
+     */
+    void test();
+
     operator org_kde_kwin_outputconfiguration*();
     operator org_kde_kwin_outputconfiguration*() const;
 
@@ -258,6 +273,16 @@ Q_SIGNALS:
      * OutputDevices.
      */
     void failed();
+    /**
+     * The server would accept the changes tested through test().
+     * @since 5.68
+     */
+    void testPassed();
+    /**
+     * The server would reject the changes tested through test().
+     * @since 5.68
+     */
+    void testFailed();
 
 private:
     friend class OutputManagement;
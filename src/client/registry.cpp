@@ -29,6 +29,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "idle.h"
 #include "idleinhibit.h"
 #include "keystate.h"
+#include "linuxdmabuf.h"
 #include "remote_access.h"
 #include "logging.h"
 #include "outputconfiguration.h"
@@ -61,6 +62,10 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "xdgdecoration.h"
 // Qt
 #include <QDebug>
+#include <QPointer>
+// std
+#include <algorithm>
+#include <iterator>
 // wayland
 #include <wayland-client-protocol.h>
 #include <wayland-fullscreen-shell-client-protocol.h>
@@ -93,6 +98,14 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include <wayland-xdg-output-unstable-v1-client-protocol.h>
 #include <wayland-xdg-decoration-unstable-v1-client-protocol.h>
 #include <wayland-keystate-client-protocol.h>
+#include <wayland-linux-dmabuf-unstable-v1-client-protocol.h>
+
+// the dmabuf feedback of version 4 depends on the wayland-protocols LinuxDmabuf got built with
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+static const quint32 s_linuxDmabufVersion = 4;
+#else
+static const quint32 s_linuxDmabufVersion = 3;
+#endif
 
 /*****
  * How to add another interface:
@@ -101,7 +114,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
  * * define the create<InterfaceName> method
  * * define the <interfaceName>Announced signal
  * * define the <interfaceName>Removed signal
- * * add a block to s_interfaces
+ * * add a block to s_interfaces, including the create<InterfaceName> method
  * * add the BIND macro for the new bind<InterfaceName>
  * * add the CREATE macro for the new create<InterfaceName>
  * * extend registry unit test to verify that it works
@@ -113,287 +126,437 @@ namespace Client
 {
 
 namespace {
-struct SuppertedInterfaceData {
+template <class T, T *(Registry::*createMethod)(quint32, quint32, QObject *)>
+static QObject *createWrapper(Registry *registry, quint32 name, quint32 version, QObject *parent)
+{
+    return (registry->*createMethod)(name, version, parent);
+}
+
+struct SupportedInterfaceData {
+    Registry::Interface id;
     quint32 maxVersion;
-    QByteArray name;
+    const char *name;
     const wl_interface *interface;
     void (Registry::*announcedSignal)(quint32, quint32);
     void (Registry::*removedSignal)(quint32);
+    QObject *(*create)(Registry *, quint32, quint32, QObject *);
 };
-static const QMap<Registry::Interface, SuppertedInterfaceData> s_interfaces = {
-    {Registry::Interface::Compositor, {
+static const SupportedInterfaceData s_interfaces[] = {
+    {
+        Registry::Interface::Compositor,
         4,
-        QByteArrayLiteral("wl_compositor"),
+        "wl_compositor",
         &wl_compositor_interface,
         &Registry::compositorAnnounced,
-        &Registry::compositorRemoved
-    }},
-    {Registry::Interface::DataDeviceManager, {
+        &Registry::compositorRemoved,
+        &createWrapper<Compositor, &Registry::createCompositor>
+    },
+    {
+        Registry::Interface::DataDeviceManager,
         3,
-        QByteArrayLiteral("wl_data_device_manager"),
+        "wl_data_device_manager",
         &wl_data_device_manager_interface,
         &Registry::dataDeviceManagerAnnounced,
-        &Registry::dataDeviceManagerRemoved
-    }},
-    {Registry::Interface::Output, {
+        &Registry::dataDeviceManagerRemoved,
+        &createWrapper<DataDeviceManager, &Registry::createDataDeviceManager>
+    },
+    {
+        Registry::Interface::Output,
         3,
-        QByteArrayLiteral("wl_output"),
+        "wl_output",
         &wl_output_interface,
         &Registry::outputAnnounced,
-        &Registry::outputRemoved
-    }},
-    {Registry::Interface::Shm, {
+        &Registry::outputRemoved,
+        &createWrapper<Output, &Registry::createOutput>
+    },
+    {
+        Registry::Interface::Shm,
         1,
-        QByteArrayLiteral("wl_shm"),
+        "wl_shm",
         &wl_shm_interface,
         &Registry::shmAnnounced,
-        &Registry::shmRemoved
-    }},
-    {Registry::Interface::Seat, {
+        &Registry::shmRemoved,
+        &createWrapper<ShmPool, &Registry::createShmPool>
+    },
+    {
+        Registry::Interface::Seat,
         5,
-        QByteArrayLiteral("wl_seat"),
+        "wl_seat",
         &wl_seat_interface,
         &Registry::seatAnnounced,
-        &Registry::seatRemoved
-    }},
-    {Registry::Interface::Shell, {
+        &Registry::seatRemoved,
+        &createWrapper<Seat, &Registry::createSeat>
+    },
+    {
+        Registry::Interface::Shell,
         1,
-        QByteArrayLiteral("wl_shell"),
+        "wl_shell",
         &wl_shell_interface,
         &Registry::shellAnnounced,
-        &Registry::shellRemoved
-    }},
-    {Registry::Interface::SubCompositor, {
+        &Registry::shellRemoved,
+        &createWrapper<Shell, &Registry::createShell>
+    },
+    {
+        Registry::Interface::SubCompositor,
         1,
-        QByteArrayLiteral("wl_subcompositor"),
+        "wl_subcompositor",
         &wl_subcompositor_interface,
         &Registry::subCompositorAnnounced,
-        &Registry::subCompositorRemoved
-    }},
-    {Registry::Interface::PlasmaShell, {
+        &Registry::subCompositorRemoved,
+        &createWrapper<SubCompositor, &Registry::createSubCompositor>
+    },
+    {
+        Registry::Interface::PlasmaShell,
         6,
-        QByteArrayLiteral("org_kde_plasma_shell"),
+        "org_kde_plasma_shell",
         &org_kde_plasma_shell_interface,
         &Registry::plasmaShellAnnounced,
-        &Registry::plasmaShellRemoved
-    }},
-    {Registry::Interface::PlasmaVirtualDesktopManagement, {
+        &Registry::plasmaShellRemoved,
+        &createWrapper<PlasmaShell, &Registry::createPlasmaShell>
+    },
+    {
+        Registry::Interface::PlasmaVirtualDesktopManagement,
         2,
-        QByteArrayLiteral("org_kde_plasma_virtual_desktop_management"),
+        "org_kde_plasma_virtual_desktop_management",
         &org_kde_plasma_virtual_desktop_management_interface,
         &Registry::plasmaVirtualDesktopManagementAnnounced,
-        &Registry::plasmaVirtualDesktopManagementRemoved
-    }},
-    {Registry::Interface::PlasmaWindowManagement, {
+        &Registry::plasmaVirtualDesktopManagementRemoved,
+        &createWrapper<PlasmaVirtualDesktopManagement, &Registry::createPlasmaVirtualDesktopManagement>
+    },
+    {
+        Registry::Interface::PlasmaWindowManagement,
         9,
-        QByteArrayLiteral("org_kde_plasma_window_management"),
+        "org_kde_plasma_window_management",
         &org_kde_plasma_window_management_interface,
         &Registry::plasmaWindowManagementAnnounced,
-        &Registry::plasmaWindowManagementRemoved
-    }},
-    {Registry::Interface::Idle, {
+        &Registry::plasmaWindowManagementRemoved,
+        &createWrapper<PlasmaWindowManagement, &Registry::createPlasmaWindowManagement>
+    },
+    {
+        Registry::Interface::Idle,
         1,
-        QByteArrayLiteral("org_kde_kwin_idle"),
+        "org_kde_kwin_idle",
         &org_kde_kwin_idle_interface,
         &Registry::idleAnnounced,
-        &Registry::idleRemoved
-    }},
-    {Registry::Interface::RemoteAccessManager, {
-        1,
-        QByteArrayLiteral("org_kde_kwin_remote_access_manager"),
+        &Registry::idleRemoved,
+        &createWrapper<Idle, &Registry::createIdle>
+    },
+    {
+        Registry::Interface::RemoteAccessManager,
+        2,
+        "org_kde_kwin_remote_access_manager",
         &org_kde_kwin_remote_access_manager_interface,
         &Registry::remoteAccessManagerAnnounced,
-        &Registry::remoteAccessManagerRemoved
-    }},
-    {Registry::Interface::FakeInput, {
+        &Registry::remoteAccessManagerRemoved,
+        &createWrapper<RemoteAccessManager, &Registry::createRemoteAccessManager>
+    },
+    {
+        Registry::Interface::FakeInput,
         4,
-        QByteArrayLiteral("org_kde_kwin_fake_input"),
+        "org_kde_kwin_fake_input",
         &org_kde_kwin_fake_input_interface,
         &Registry::fakeInputAnnounced,
-        &Registry::fakeInputRemoved
-    }},
-    {Registry::Interface::OutputManagement, {
-        2,
-        QByteArrayLiteral("org_kde_kwin_outputmanagement"),
+        &Registry::fakeInputRemoved,
+        &createWrapper<FakeInput, &Registry::createFakeInput>
+    },
+    {
+        Registry::Interface::OutputManagement,
+        3,
+        "org_kde_kwin_outputmanagement",
         &org_kde_kwin_outputmanagement_interface,
         &Registry::outputManagementAnnounced,
-        &Registry::outputManagementRemoved
-    }},
-    {Registry::Interface::OutputDevice, {
+        &Registry::outputManagementRemoved,
+        &createWrapper<OutputManagement, &Registry::createOutputManagement>
+    },
+    {
+        Registry::Interface::OutputDevice,
         2,
-        QByteArrayLiteral("org_kde_kwin_outputdevice"),
+        "org_kde_kwin_outputdevice",
         &org_kde_kwin_outputdevice_interface,
         &Registry::outputDeviceAnnounced,
-        &Registry::outputDeviceRemoved
-    }},
-    {Registry::Interface::Shadow, {
+        &Registry::outputDeviceRemoved,
+        &createWrapper<OutputDevice, &Registry::createOutputDevice>
+    },
+    {
+        Registry::Interface::Shadow,
         2,
-        QByteArrayLiteral("org_kde_kwin_shadow_manager"),
+        "org_kde_kwin_shadow_manager",
         &org_kde_kwin_shadow_manager_interface,
         &Registry::shadowAnnounced,
-        &Registry::shadowRemoved
-    }},
-    {Registry::Interface::Blur, {
+        &Registry::shadowRemoved,
+        &createWrapper<ShadowManager, &Registry::createShadowManager>
+    },
+    {
+        Registry::Interface::Blur,
         1,
-        QByteArrayLiteral("org_kde_kwin_blur_manager"),
+        "org_kde_kwin_blur_manager",
         &org_kde_kwin_blur_manager_interface,
         &Registry::blurAnnounced,
-        &Registry::blurRemoved
-    }},
-    {Registry::Interface::Contrast, {
+        &Registry::blurRemoved,
+        &createWrapper<BlurManager, &Registry::createBlurManager>
+    },
+    {
+        Registry::Interface::Contrast,
         1,
-        QByteArrayLiteral("org_kde_kwin_contrast_manager"),
+        "org_kde_kwin_contrast_manager",
         &org_kde_kwin_contrast_manager_interface,
         &Registry::contrastAnnounced,
-        &Registry::contrastRemoved
-    }},
-    {Registry::Interface::Slide, {
+        &Registry::contrastRemoved,
+        &createWrapper<ContrastManager, &Registry::createContrastManager>
+    },
+    {
+        Registry::Interface::Slide,
         1,
-        QByteArrayLiteral("org_kde_kwin_slide_manager"),
+        "org_kde_kwin_slide_manager",
         &org_kde_kwin_slide_manager_interface,
         &Registry::slideAnnounced,
-        &Registry::slideRemoved
-    }},
-    {Registry::Interface::FullscreenShell, {
+        &Registry::slideRemoved,
+        &createWrapper<SlideManager, &Registry::createSlideManager>
+    },
+    {
+        Registry::Interface::FullscreenShell,
         1,
-        QByteArrayLiteral("_wl_fullscreen_shell"),
+        "_wl_fullscreen_shell",
         &_wl_fullscreen_shell_interface,
         &Registry::fullscreenShellAnnounced,
-        &Registry::fullscreenShellRemoved
-    }},
-    {Registry::Interface::Dpms, {
+        &Registry::fullscreenShellRemoved,
+        &createWrapper<FullscreenShell, &Registry::createFullscreenShell>
+    },
+    {
+        Registry::Interface::Dpms,
         1,
-        QByteArrayLiteral("org_kde_kwin_dpms_manager"),
+        "org_kde_kwin_dpms_manager",
         &org_kde_kwin_dpms_manager_interface,
         &Registry::dpmsAnnounced,
-        &Registry::dpmsRemoved
-    }},
-    {Registry::Interface::ServerSideDecorationManager, {
+        &Registry::dpmsRemoved,
+        &createWrapper<DpmsManager, &Registry::createDpmsManager>
+    },
+    {
+        Registry::Interface::ServerSideDecorationManager,
         1,
-        QByteArrayLiteral("org_kde_kwin_server_decoration_manager"),
+        "org_kde_kwin_server_decoration_manager",
         &org_kde_kwin_server_decoration_manager_interface,
         &Registry::serverSideDecorationManagerAnnounced,
-        &Registry::serverSideDecorationManagerRemoved
-    }},
-    {Registry::Interface::TextInputManagerUnstableV0, {
+        &Registry::serverSideDecorationManagerRemoved,
+        &createWrapper<ServerSideDecorationManager, &Registry::createServerSideDecorationManager>
+    },
+    {
+        Registry::Interface::TextInputManagerUnstableV0,
         1,
-        QByteArrayLiteral("wl_text_input_manager"),
+        "wl_text_input_manager",
         &wl_text_input_manager_interface,
         &Registry::textInputManagerUnstableV0Announced,
-        &Registry::textInputManagerUnstableV0Removed
-    }},
-    {Registry::Interface::TextInputManagerUnstableV2, {
+        &Registry::textInputManagerUnstableV0Removed,
+        &createWrapper<TextInputManager, &Registry::createTextInputManager>
+    },
+    {
+        Registry::Interface::TextInputManagerUnstableV2,
         1,
-        QByteArrayLiteral("zwp_text_input_manager_v2"),
+        "zwp_text_input_manager_v2",
         &zwp_text_input_manager_v2_interface,
         &Registry::textInputManagerUnstableV2Announced,
-        &Registry::textInputManagerUnstableV2Removed
-    }},
-    {Registry::Interface::XdgShellUnstableV5, {
+        &Registry::textInputManagerUnstableV2Removed,
+        &createWrapper<TextInputManager, &Registry::createTextInputManager>
+    },
+    {
+        Registry::Interface::XdgShellUnstableV5,
         1,
-        QByteArrayLiteral("xdg_shell"),
+        "xdg_shell",
         &zxdg_shell_v5_interface,
         &Registry::xdgShellUnstableV5Announced,
-        &Registry::xdgShellUnstableV5Removed
-    }},
-    {Registry::Interface::RelativePointerManagerUnstableV1, {
+        &Registry::xdgShellUnstableV5Removed,
+        &createWrapper<XdgShell, &Registry::createXdgShell>
+    },
+    {
+        Registry::Interface::RelativePointerManagerUnstableV1,
         1,
-        QByteArrayLiteral("zwp_relative_pointer_manager_v1"),
+        "zwp_relative_pointer_manager_v1",
         &zwp_relative_pointer_manager_v1_interface,
         &Registry::relativePointerManagerUnstableV1Announced,
-        &Registry::relativePointerManagerUnstableV1Removed
-    }},
-    {Registry::Interface::PointerGesturesUnstableV1, {
+        &Registry::relativePointerManagerUnstableV1Removed,
+        &createWrapper<RelativePointerManager, &Registry::createRelativePointerManager>
+    },
+    {
+        Registry::Interface::PointerGesturesUnstableV1,
         1,
-        QByteArrayLiteral("zwp_pointer_gestures_v1"),
+        "zwp_pointer_gestures_v1",
         &zwp_pointer_gestures_v1_interface,
         &Registry::pointerGesturesUnstableV1Announced,
-        &Registry::pointerGesturesUnstableV1Removed
-    }},
-    {Registry::Interface::PointerConstraintsUnstableV1, {
+        &Registry::pointerGesturesUnstableV1Removed,
+        &createWrapper<PointerGestures, &Registry::createPointerGestures>
+    },
+    {
+        Registry::Interface::PointerConstraintsUnstableV1,
         1,
-        QByteArrayLiteral("zwp_pointer_constraints_v1"),
+        "zwp_pointer_constraints_v1",
         &zwp_pointer_constraints_v1_interface,
         &Registry::pointerConstraintsUnstableV1Announced,
-        &Registry::pointerConstraintsUnstableV1Removed
-    }},
-    {Registry::Interface::XdgExporterUnstableV2, {
+        &Registry::pointerConstraintsUnstableV1Removed,
+        &createWrapper<PointerConstraints, &Registry::createPointerConstraints>
+    },
+    {
+        Registry::Interface::XdgExporterUnstableV2,
         1,
-        QByteArrayLiteral("zxdg_exporter_v2"),
+        "zxdg_exporter_v2",
         &zxdg_exporter_v2_interface,
         &Registry::exporterUnstableV2Announced,
-        &Registry::exporterUnstableV2Removed
-    }},
-    {Registry::Interface::XdgImporterUnstableV2, {
+        &Registry::exporterUnstableV2Removed,
+        &createWrapper<XdgExporter, &Registry::createXdgExporter>
+    },
+    {
+        Registry::Interface::XdgImporterUnstableV2,
         1,
-        QByteArrayLiteral("zxdg_importer_v2"),
+        "zxdg_importer_v2",
         &zxdg_importer_v2_interface,
         &Registry::importerUnstableV2Announced,
-        &Registry::importerUnstableV2Removed
-    }},
-    {Registry::Interface::XdgShellUnstableV6, {
+        &Registry::importerUnstableV2Removed,
+        &createWrapper<XdgImporter, &Registry::createXdgImporter>
+    },
+    {
+        Registry::Interface::XdgShellUnstableV6,
         1,
-        QByteArrayLiteral("zxdg_shell_v6"),
+        "zxdg_shell_v6",
         &zxdg_shell_v6_interface,
         &Registry::xdgShellUnstableV6Announced,
-        &Registry::xdgShellUnstableV6Removed
-    }},
-    {Registry::Interface::IdleInhibitManagerUnstableV1, {
+        &Registry::xdgShellUnstableV6Removed,
+        &createWrapper<XdgShell, &Registry::createXdgShell>
+    },
+    {
+        Registry::Interface::IdleInhibitManagerUnstableV1,
         1,
-        QByteArrayLiteral("zwp_idle_inhibit_manager_v1"),
+        "zwp_idle_inhibit_manager_v1",
         &zwp_idle_inhibit_manager_v1_interface,
         &Registry::idleInhibitManagerUnstableV1Announced,
-        &Registry::idleInhibitManagerUnstableV1Removed
-    }},
-    {Registry::Interface::AppMenu, {
+        &Registry::idleInhibitManagerUnstableV1Removed,
+        &createWrapper<IdleInhibitManager, &Registry::createIdleInhibitManager>
+    },
+    {
+        Registry::Interface::AppMenu,
         1,
-        QByteArrayLiteral("org_kde_kwin_appmenu_manager"),
+        "org_kde_kwin_appmenu_manager",
         &org_kde_kwin_appmenu_manager_interface,
         &Registry::appMenuAnnounced,
-        &Registry::appMenuRemoved
-    }},
-    {Registry::Interface::ServerSideDecorationPalette, {
+        &Registry::appMenuRemoved,
+        &createWrapper<AppMenuManager, &Registry::createAppMenuManager>
+    },
+    {
+        Registry::Interface::ServerSideDecorationPalette,
         1,
-        QByteArrayLiteral("org_kde_kwin_server_decoration_palette_manager"),
+        "org_kde_kwin_server_decoration_palette_manager",
         &org_kde_kwin_server_decoration_palette_manager_interface,
         &Registry::serverSideDecorationPaletteManagerAnnounced,
-        &Registry::serverSideDecorationPaletteManagerRemoved
-    }},
-    {Registry::Interface::XdgOutputUnstableV1, {
+        &Registry::serverSideDecorationPaletteManagerRemoved,
+        &createWrapper<ServerSideDecorationPaletteManager, &Registry::createServerSideDecorationPaletteManager>
+    },
+    {
+        Registry::Interface::XdgOutputUnstableV1,
         1,
-        QByteArrayLiteral("zxdg_output_manager_v1"),
+        "zxdg_output_manager_v1",
         &zxdg_output_manager_v1_interface,
         &Registry::xdgOutputAnnounced,
-        &Registry::xdgOutputRemoved
-    }},
-    {Registry::Interface::XdgShellStable, {
+        &Registry::xdgOutputRemoved,
+        &createWrapper<XdgOutputManager, &Registry::createXdgOutputManager>
+    },
+    {
+        Registry::Interface::XdgShellStable,
         1,
-        QByteArrayLiteral("xdg_wm_base"),
+        "xdg_wm_base",
         &xdg_wm_base_interface,
         &Registry::xdgShellStableAnnounced,
-        &Registry::xdgShellStableRemoved
-    }},
-    {Registry::Interface::XdgDecorationUnstableV1, {
+        &Registry::xdgShellStableRemoved,
+        &createWrapper<XdgShell, &Registry::createXdgShell>
+    },
+    {
+        Registry::Interface::XdgDecorationUnstableV1,
         1,
-        QByteArrayLiteral("zxdg_decoration_manager_v1"),
+        "zxdg_decoration_manager_v1",
         &zxdg_decoration_manager_v1_interface,
         &Registry::xdgDecorationAnnounced,
-        &Registry::xdgDecorationRemoved
-    }},
-    {Registry::Interface::Keystate, {
+        &Registry::xdgDecorationRemoved,
+        &createWrapper<XdgDecorationManager, &Registry::createXdgDecorationManager>
+    },
+    {
+        Registry::Interface::Keystate,
         1,
-        QByteArrayLiteral("org_kde_kwin_keystate"),
+        "org_kde_kwin_keystate",
         &org_kde_kwin_keystate_interface,
         &Registry::keystateAnnounced,
-        &Registry::keystateRemoved
-    }}
+        &Registry::keystateRemoved,
+        &createWrapper<Keystate, &Registry::createKeystate>
+    },
+    {
+        Registry::Interface::LinuxDmabufUnstableV1,
+        s_linuxDmabufVersion,
+        "zwp_linux_dmabuf_v1",
+        &zwp_linux_dmabuf_v1_interface,
+        &Registry::linuxDmabufAnnounced,
+        &Registry::linuxDmabufRemoved,
+        &createWrapper<LinuxDmabuf, &Registry::createLinuxDmabuf>
+    }
+};
+
+static const int s_interfaceCount = int(sizeof(s_interfaces) / sizeof(s_interfaces[0]));
+
+/**
+ * Lookup tables built once from s_interfaces: the data indexed by Registry::Interface
+ * and all names sorted for a binary search when a global gets announced.
+ **/
+class InterfaceTables
+{
+public:
+    InterfaceTables()
+    {
+        std::fill(std::begin(m_byInterface), std::end(m_byInterface), nullptr);
+        for (int i = 0; i < s_interfaceCount; ++i) {
+            const SupportedInterfaceData *data = &s_interfaces[i];
+            Q_ASSERT(int(data->id) > 0 && int(data->id) <= s_interfaceCount);
+            m_byInterface[int(data->id)] = data;
+            m_byName[i] = data;
+        }
+        std::sort(std::begin(m_byName), std::end(m_byName),
+            [] (const SupportedInterfaceData *a, const SupportedInterfaceData *b) {
+                return qstrcmp(a->name, b->name) < 0;
+            }
+        );
+    }
+
+    const SupportedInterfaceData *data(Registry::Interface interface) const
+    {
+        const int index = int(interface);
+        if (index <= 0 || index > s_interfaceCount) {
+            return nullptr;
+        }
+        return m_byInterface[index];
+    }
+
+    Registry::Interface interface(const char *name) const
+    {
+        auto it = std::lower_bound(std::begin(m_byName), std::end(m_byName), name,
+            [] (const SupportedInterfaceData *data, const char *name) {
+                return qstrcmp(data->name, name) < 0;
+            }
+        );
+        if (it != std::end(m_byName) && qstrcmp((*it)->name, name) == 0) {
+            return (*it)->id;
+        }
+        return Registry::Interface::Unknown;
+    }
+
+private:
+    const SupportedInterfaceData *m_byInterface[s_interfaceCount + 1];
+    const SupportedInterfaceData *m_byName[s_interfaceCount];
 };
 
-static quint32 maxVersion(const Registry::Interface &interface)
+static const InterfaceTables &interfaceTables()
+{
+    static const InterfaceTables s_tables;
+    return s_tables;
+}
+
+static quint32 maxVersion(Registry::Interface interface)
 {
-    auto it = s_interfaces.find(interface);
-    if (it != s_interfaces.end()) {
-        return it.value().maxVersion;
+    if (auto data = interfaceTables().data(interface)) {
+        return data->maxVersion;
     }
     return 0;
 }
@@ -413,10 +576,22 @@ public:
     template <class T, typename WL>
     T *create(quint32 name, quint32 version, QObject *parent, WL *(Registry::*bindMethod)(uint32_t, uint32_t) const);
 
+    void syncBound();
+    void resetObjects();
+
     WaylandPointer<wl_registry, wl_registry_destroy> registry;
     static const struct wl_callback_listener s_callbackListener;
     WaylandPointer<wl_callback, wl_callback_destroy> callback;
+    static const struct wl_callback_listener s_boundCallbackListener;
+    WaylandPointer<wl_callback, wl_callback_destroy> boundCallback;
+    wl_display *display = nullptr;
     EventQueue *queue = nullptr;
+    // lazily created wrappers handed out by Registry::object, indexed by Interface
+    struct SharedObject {
+        QPointer<QObject> object;
+        quint32 name = 0;
+    };
+    SharedObject objects[s_interfaceCount + 1];
 
 private:
     void handleAnnounce(uint32_t name, const char *interface, uint32_t version);
@@ -425,14 +600,12 @@ private:
     static void globalAnnounce(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
     static void globalRemove(void *data, struct wl_registry *registry, uint32_t name);
     static void globalSync(void *data, struct wl_callback *callback, uint32_t serial);
+    static void boundSync(void *data, struct wl_callback *callback, uint32_t serial);
 
     Registry *q;
-    struct InterfaceData {
-        Interface interface;
-        uint32_t name;
-        uint32_t version;
-    };
-    QList<InterfaceData> m_interfaces;
+    // announced globals in announce order, indexed by Interface
+    QVector<AnnouncedInterface> m_interfaces[s_interfaceCount + 1];
+    QHash<quint32, Interface> m_names;
     static const struct wl_registry_listener s_registryListener;
 };
 
@@ -458,23 +631,36 @@ Registry::~Registry()
     release();
 }
 
+void Registry::Private::resetObjects()
+{
+    for (auto &shared : objects) {
+        shared.object.clear();
+        shared.name = 0;
+    }
+}
+
 void Registry::release()
 {
+    d->resetObjects();
     d->registry.release();
     d->callback.release();
+    d->boundCallback.release();
 }
 
 void Registry::destroy()
 {
     emit registryDestroyed();
+    d->resetObjects();
     d->registry.destroy();
     d->callback.destroy();
+    d->boundCallback.destroy();
 }
 
 void Registry::create(wl_display *display)
 {
     Q_ASSERT(display);
     Q_ASSERT(!isValid());
+    d->display = display;
     d->registry.setup(wl_display_get_registry(display));
     d->callback.setup(wl_display_sync(display));
     if (d->queue) {
@@ -523,6 +709,10 @@ const struct wl_registry_listener Registry::Private::s_registryListener = {
 const struct wl_callback_listener Registry::Private::s_callbackListener = {
    globalSync
 };
+
+const struct wl_callback_listener Registry::Private::s_boundCallbackListener = {
+   boundSync
+};
 #endif
 
 void Registry::Private::globalAnnounce(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
@@ -548,98 +738,101 @@ void Registry::Private::globalSync(void* data, wl_callback* callback, uint32_t s
     r->callback.destroy();
 }
 
+void Registry::Private::boundSync(void *data, wl_callback *callback, uint32_t serial)
+{
+    Q_UNUSED(serial)
+    auto r = reinterpret_cast<Registry::Private*>(data);
+    Q_ASSERT(r->boundCallback == callback);
+    r->boundCallback.destroy();
+    emit r->q->interfacesBound();
+}
+
 void Registry::Private::handleGlobalSync()
 {
     emit q->interfacesAnnounced();
 }
 
-namespace {
-static Registry::Interface nameToInterface(const char *interface)
+void Registry::Private::syncBound()
 {
-    for (auto it = s_interfaces.constBegin(); it != s_interfaces.constEnd(); ++it) {
-        if (qstrcmp(interface, it.value().name) == 0) {
-            return it.key();
-        }
+    if (!display) {
+        return;
     }
-    return Registry::Interface::Unknown;
-}
+    // a newer sync supersedes a pending one, the server answers them in order anyway
+    boundCallback.destroy();
+    boundCallback.setup(wl_display_sync(display));
+    if (queue) {
+        queue->addProxy(boundCallback);
+    }
+    wl_callback_add_listener(boundCallback, &s_boundCallbackListener, this);
+    wl_display_flush(display);
 }
 
 void Registry::Private::handleAnnounce(uint32_t name, const char *interface, uint32_t version)
 {
-    Interface i = nameToInterface(interface);
+    const Interface i = interfaceTables().interface(interface);
     emit q->interfaceAnnounced(QByteArray(interface), name, version);
     if (i == Interface::Unknown) {
         qCDebug(KWAYLAND_CLIENT) << "Unknown interface announced: " << interface << "/" << name << "/" << version;
         return;
     }
     qCDebug(KWAYLAND_CLIENT) << "Wayland Interface: " << interface << "/" << name << "/" << version;
-    m_interfaces.append({i, name, version});
-    auto it = s_interfaces.constFind(i);
-    if (it != s_interfaces.end()) {
-        emit (q->*it.value().announcedSignal)(name, version);
-    }
+    m_interfaces[int(i)].append({name, version});
+    m_names.insert(name, i);
+    emit (q->*interfaceTables().data(i)->announcedSignal)(name, version);
 }
 
 void Registry::Private::handleRemove(uint32_t name)
 {
-    auto it = std::find_if(m_interfaces.begin(), m_interfaces.end(),
-        [name](const InterfaceData &data) {
-            return data.name == name;
+    auto it = m_names.find(name);
+    if (it != m_names.end()) {
+        const Interface i = it.value();
+        m_names.erase(it);
+        auto &announced = m_interfaces[int(i)];
+        auto ait = std::find_if(announced.begin(), announced.end(),
+            [name] (const AnnouncedInterface &data) {
+                return data.name == name;
+            }
+        );
+        if (ait != announced.end()) {
+            announced.erase(ait);
         }
-    );
-    if (it != m_interfaces.end()) {
-        InterfaceData data = *(it);
-        m_interfaces.erase(it);
-        auto sit = s_interfaces.find(data.interface);
-        if (sit != s_interfaces.end()) {
-            emit (q->*sit.value().removedSignal)(data.name);
+        if (objects[int(i)].name == name) {
+            // the wrapper announces the removal itself, the next lookup uses another global
+            objects[int(i)].object.clear();
+            objects[int(i)].name = 0;
         }
+        emit (q->*interfaceTables().data(i)->removedSignal)(name);
     }
     emit q->interfaceRemoved(name);
 }
 
 bool Registry::Private::hasInterface(Registry::Interface interface) const
 {
-    auto it = std::find_if(m_interfaces.constBegin(), m_interfaces.constEnd(),
-        [interface](const InterfaceData &data) {
-            return data.interface == interface;
-        }
-    );
-    return it != m_interfaces.constEnd();
+    if (!interfaceTables().data(interface)) {
+        return false;
+    }
+    return !m_interfaces[int(interface)].isEmpty();
 }
 
 QVector<Registry::AnnouncedInterface> Registry::Private::interfaces(Interface interface) const
 {
-    QVector<Registry::AnnouncedInterface> retVal;
-    for (auto it = m_interfaces.constBegin(); it != m_interfaces.constEnd(); ++it) {
-        const auto &data = *it;
-        if (data.interface == interface) {
-            retVal << AnnouncedInterface{data.name, data.version};
-        }
+    if (!interfaceTables().data(interface)) {
+        return QVector<AnnouncedInterface>();
     }
-    return retVal;
+    return m_interfaces[int(interface)];
 }
 
 Registry::AnnouncedInterface Registry::Private::interface(Interface interface) const
 {
-    const auto all = interfaces(interface);
-    if (!all.isEmpty()) {
-        return all.last();
+    if (hasInterface(interface)) {
+        return m_interfaces[int(interface)].last();
     }
     return AnnouncedInterface{0, 0};
 }
 
 Registry::Interface Registry::Private::interfaceForName(quint32 name) const
 {
-    auto it = std::find_if(m_interfaces.constBegin(), m_interfaces.constEnd(),
-        [name] (const InterfaceData &data) {
-            return data.name == name;
-        });
-    if (it == m_interfaces.constEnd()) {
-        return Interface::Unknown;
-    }
-    return (*it).interface;
+    return m_names.value(name, Interface::Unknown);
 }
 
 bool Registry::hasInterface(Registry::Interface interface) const
@@ -657,6 +850,41 @@ Registry::AnnouncedInterface Registry::interface(Interface interface) const
     return d->interface(interface);
 }
 
+QVector<QObject *> Registry::bindAll(const QVector<Interface> &interfaces, QObject *parent)
+{
+    QVector<QObject *> bound;
+    if (!isValid()) {
+        return bound;
+    }
+    for (Interface interface : interfaces) {
+        const auto data = interfaceTables().data(interface);
+        if (!data) {
+            continue;
+        }
+        const auto announced = d->interfaces(interface);
+        for (const auto &global : announced) {
+            bound << data->create(this, global.name, global.version, parent);
+        }
+    }
+    d->syncBound();
+    return bound;
+}
+
+QObject *Registry::object(Interface interface)
+{
+    const auto data = interfaceTables().data(interface);
+    if (!data || !isValid() || !d->hasInterface(interface)) {
+        return nullptr;
+    }
+    auto &shared = d->objects[int(interface)];
+    if (!shared.object) {
+        const auto global = d->interface(interface);
+        shared.object = data->create(this, global.name, global.version, this);
+        shared.name = global.name;
+    }
+    return shared.object;
+}
+
 #define BIND2(__NAME__, __INAME__, __WL__) \
 __WL__ *Registry::bind##__NAME__(uint32_t name, uint32_t version) const \
 { \
@@ -703,6 +931,7 @@ BIND2(AppMenuManager, AppMenu, org_kde_kwin_appmenu_manager)
 BIND2(ServerSideDecorationPaletteManager, ServerSideDecorationPalette, org_kde_kwin_server_decoration_palette_manager)
 BIND(XdgOutputUnstableV1, zxdg_output_manager_v1)
 BIND(XdgDecorationUnstableV1, zxdg_decoration_manager_v1)
+BIND(LinuxDmabufUnstableV1, zwp_linux_dmabuf_v1)
 
 #undef BIND
 #undef BIND2
@@ -859,28 +1088,31 @@ XdgDecorationManager *Registry::createXdgDecorationManager(quint32 name, quint32
     }
 }
 
-namespace {
-static const wl_interface *wlInterface(Registry::Interface interface)
+LinuxDmabuf *Registry::createLinuxDmabuf(quint32 name, quint32 version, QObject *parent)
 {
-    auto it = s_interfaces.find(interface);
-    if (it != s_interfaces.end()) {
-        return it.value().interface;
+    switch(d->interfaceForName(name)) {
+    case Interface::LinuxDmabufUnstableV1:
+        return d->create<LinuxDmabuf>(name, version, parent, &Registry::bindLinuxDmabufUnstableV1);
+    default:
+        return nullptr;
     }
-    return nullptr;
-}
 }
 
 template <typename T>
 T *Registry::Private::bind(Registry::Interface interface, uint32_t name, uint32_t version) const
 {
-    auto it = std::find_if(m_interfaces.constBegin(), m_interfaces.constEnd(), [=](const InterfaceData &data) {
-        return data.interface == interface && data.name == name && data.version >= version;
-    });
-    if (it == m_interfaces.constEnd()) {
+    bool found = false;
+    if (interfaceForName(name) == interface) {
+        const auto &announced = m_interfaces[int(interface)];
+        found = std::any_of(announced.constBegin(), announced.constEnd(), [=](const AnnouncedInterface &data) {
+            return data.name == name && data.version >= version;
+        });
+    }
+    if (!found) {
         qCDebug(KWAYLAND_CLIENT) << "Don't have interface " << int(interface) << "with name " << name << "and minimum version" << version;
         return nullptr;
     }
-    auto t = reinterpret_cast<T*>(wl_registry_bind(registry, name, wlInterface(interface), version));
+    auto t = reinterpret_cast<T*>(wl_registry_bind(registry, name, interfaceTables().data(interface)->interface, version));
     if (queue) {
         queue->addProxy(t);
     }
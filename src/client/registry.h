@@ -66,6 +66,7 @@ struct zxdg_importer_v2;
 struct zwp_idle_inhibit_manager_v1;
 struct zxdg_output_manager_v1;
 struct zxdg_decoration_manager_v1;
+struct zwp_linux_dmabuf_v1;
 
 namespace KWayland
 {
@@ -85,6 +86,7 @@ class OutputDevice;
 class Idle;
 class IdleInhibitManager;
 class Keystate;
+class LinuxDmabuf;
 class RemoteAccessManager;
 class Output;
 class PlasmaShell;
@@ -188,6 +190,7 @@ public:
         XdgShellStable, ///refers to xdg_wm_base @since 5.48
         XdgDecorationUnstableV1, ///refers to zxdg_decoration_manager_v1, @since 5.54
         Keystate,///<refers to org_kwin_keystate, @since 5.57
+        LinuxDmabufUnstableV1, ///< refers to zwp_linux_dmabuf_v1, @since 5.68
     };
     explicit Registry(QObject *parent = nullptr);
     virtual ~Registry();
@@ -679,6 +682,17 @@ public:
      **/
     zxdg_decoration_manager_v1 *bindXdgDecorationUnstableV1(uint32_t name, uint32_t version) const;
 
+    /**
+     * Binds the zwp_linux_dmabuf_v1 with @p name and @p version.
+     * If the @p name does not exist or is not for the linux dmabuf interface,
+     * @c null will be returned.
+     *
+     * Prefer using createLinuxDmabuf instead.
+     * @see createLinuxDmabuf
+     * @since 5.68
+     **/
+    zwp_linux_dmabuf_v1 *bindLinuxDmabufUnstableV1(uint32_t name, uint32_t version) const;
+
     ///@}
 
     /**
@@ -1251,8 +1265,84 @@ public:
      **/
     XdgDecorationManager *createXdgDecorationManager(quint32 name, quint32 version, QObject *parent = nullptr);
 
+    /**
+     * Creates a LinuxDmabuf and sets it up to manage the interface identified by
+     * @p name and @p version.
+     *
+     * Note: in case @p name is invalid or isn't for the zwp_linux_dmabuf_v1 interface,
+     * the returned LinuxDmabuf will not be valid. Therefore it's recommended to call
+     * isValid on the created instance.
+     *
+     * @param name The name of the zwp_linux_dmabuf_v1 interface to bind
+     * @param version The version or the zwp_linux_dmabuf_v1 interface to use
+     * @param parent The parent for LinuxDmabuf
+     *
+     * @returns The created LinuxDmabuf.
+     * @since 5.68
+     **/
+    LinuxDmabuf *createLinuxDmabuf(quint32 name, quint32 version, QObject *parent = nullptr);
+
     ///@}
 
+    /**
+     * Creates the wrapper objects for all announced globals of the well-known @p interfaces
+     * in one go, e.g. once interfacesAnnounced got emitted.
+     *
+     * For each interface all announced globals are bound with the highest version
+     * supported by both the server and KWayland, so multiple Outputs or Seats result in
+     * multiple objects. Interfaces which have not been announced are skipped.
+     *
+     * All bind requests are followed by a single wl_display_sync and flushed together,
+     * instead of a roundtrip per global. Once the server processed the binds
+     * the interfacesBound signal is emitted; at that point the initial events of the
+     * created objects (e.g. Output modes) have been delivered.
+     *
+     * @code
+     * const auto objects = registry->bindAll({Registry::Interface::Compositor, Registry::Interface::Shm, Registry::Interface::Seat});
+     * for (QObject *object : objects) {
+     *     if (auto compositor = qobject_cast<Compositor*>(object)) {
+     *         // ...
+     *     }
+     * }
+     * @endcode
+     *
+     * @param interfaces The well-known interfaces to bind
+     * @param parent The parent for the created objects
+     * @returns The created objects in the order of @p interfaces and announcement
+     * @see interfacesBound
+     * @since 5.68
+     **/
+    QVector<QObject *> bindAll(const QVector<Interface> &interfaces, QObject *parent = nullptr);
+
+    /**
+     * Provides a wrapper object for the well-known @p interface which is owned by this
+     * Registry.
+     *
+     * The wrapper is created lazily: the global is only bound on the first call,
+     * subsequent calls return the same object. This allows short-lived tools to skip
+     * setting up globals they might not need at all.
+     * If there @p interface has been announced multiple times, the last announced is used.
+     * If the used global gets removed, the next call creates a wrapper for the then last
+     * announced global, the old wrapper is kept until the Registry gets destroyed.
+     *
+     * @code
+     * auto seat = registry->object<Seat>(Registry::Interface::Seat);
+     * @endcode
+     *
+     * @param interface The well-known interface for which the wrapper should be returned
+     * @returns The wrapper or @c null if the @p interface is not announced
+     * @since 5.68
+     **/
+    QObject *object(Interface interface);
+    /**
+     * Convenience overload of object(Interface) casting the wrapper to @c T.
+     * @since 5.68
+     **/
+    template <class T>
+    T *object(Interface interface) {
+        return qobject_cast<T*>(object(interface));
+    }
+
 
     /**
      * cast operator to the low-level Wayland @c wl_registry
@@ -1528,6 +1618,14 @@ Q_SIGNALS:
      **/
     void xdgDecorationAnnounced(quint32 name, quint32 version);
 
+    /**
+     * Emitted whenever a zwp_linux_dmabuf_v1 interface gets announced.
+     * @param name The name for the announced interface
+     * @param version The maximum supported version of the announced interface
+     * @since 5.68
+     **/
+    void linuxDmabufAnnounced(quint32 name, quint32 version);
+
     ///@}
 
     /**
@@ -1756,6 +1854,13 @@ Q_SIGNALS:
      **/
     void xdgDecorationRemoved(quint32 name);
 
+    /**
+     * Emitted whenever a zwp_linux_dmabuf_v1 interface gets removed.
+     * @param name The name of the removed interface
+     * @since 5.68
+     **/
+    void linuxDmabufRemoved(quint32 name);
+
     void keystateAnnounced(quint32 name, quint32 version);
     void keystateRemoved(quint32 name);
 
@@ -1791,6 +1896,14 @@ Q_SIGNALS:
      * This signal is emitted from the wl_display_sync callback.
      **/
     void interfacesAnnounced();
+    /**
+     * Emitted when the server processed all bind requests issued by the last call
+     * to bindAll.
+     * This signal is emitted from the wl_display_sync callback.
+     * @see bindAll
+     * @since 5.68
+     **/
+    void interfacesBound();
 
 Q_SIGNALS:
     /*
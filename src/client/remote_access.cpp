@@ -133,6 +133,10 @@ public:
     static struct org_kde_kwin_remote_buffer_listener s_listener;
     static void paramsCallback(void *data, org_kde_kwin_remote_buffer *rbuf,
             qint32 fd, quint32 width, quint32 height, quint32 stride, quint32 format);
+    static void damageCallback(void *data, org_kde_kwin_remote_buffer *rbuf,
+            int32_t x, int32_t y, int32_t width, int32_t height);
+    static void readyCallback(void *data, org_kde_kwin_remote_buffer *rbuf);
+    static void discardedCallback(void *data, org_kde_kwin_remote_buffer *rbuf);
 
     WaylandPointer<org_kde_kwin_remote_buffer, org_kde_kwin_remote_buffer_release> remotebuffer;
     RemoteBuffer *q;
@@ -142,6 +146,8 @@ public:
     quint32 height = 0;
     quint32 stride = 0;
     quint32 format = 0;
+    QRegion damage;
+    QRegion pendingDamage;
 };
 
 RemoteBuffer::Private::Private(RemoteBuffer *q)
@@ -162,9 +168,36 @@ void RemoteBuffer::Private::paramsCallback(void *data, org_kde_kwin_remote_buffe
     emit p->q->parametersObtained();
 }
 
+void RemoteBuffer::Private::damageCallback(void *data, org_kde_kwin_remote_buffer *rbuf,
+        int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    Q_UNUSED(rbuf)
+    Private *p = reinterpret_cast<Private *>(data);
+    p->pendingDamage += QRect(x, y, width, height);
+}
+
+void RemoteBuffer::Private::readyCallback(void *data, org_kde_kwin_remote_buffer *rbuf)
+{
+    Q_UNUSED(rbuf)
+    Private *p = reinterpret_cast<Private *>(data);
+    p->damage = p->pendingDamage;
+    p->pendingDamage = QRegion();
+    emit p->q->frameReady();
+}
+
+void RemoteBuffer::Private::discardedCallback(void *data, org_kde_kwin_remote_buffer *rbuf)
+{
+    Q_UNUSED(rbuf)
+    Private *p = reinterpret_cast<Private *>(data);
+    emit p->q->discarded();
+}
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 org_kde_kwin_remote_buffer_listener RemoteBuffer::Private::s_listener = {
-    paramsCallback
+    paramsCallback,
+    damageCallback,
+    readyCallback,
+    discardedCallback
 };
 #endif
 
@@ -241,6 +274,20 @@ quint32 RemoteBuffer::format() const
     return d->format;
 }
 
+QRegion RemoteBuffer::damage() const
+{
+    return d->damage;
+}
+
+void RemoteBuffer::done()
+{
+    Q_ASSERT(isValid());
+    if (org_kde_kwin_remote_buffer_get_version(d->remotebuffer) < ORG_KDE_KWIN_REMOTE_BUFFER_DONE_SINCE_VERSION) {
+        return;
+    }
+    org_kde_kwin_remote_buffer_done(d->remotebuffer);
+}
+
 
 }
 }
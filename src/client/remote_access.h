@@ -21,6 +21,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #define KWAYLAND_CLIENT_REMOTE_ACCESS_H
 
 #include <QObject>
+#include <QRegion>
 
 #include <KWayland/Client/kwaylandclient_export.h>
 
@@ -188,10 +189,39 @@ public:
     quint32 height() const;
     quint32 stride() const;
     quint32 format() const;
+    /**
+     * The region which changed since the previous frame of the output, valid
+     * once frameReady got emitted.
+     * @since 5.68
+     **/
+    QRegion damage() const;
 
+    /**
+     * Tells the compositor that the frame announced with frameReady has been read.
+     * Unlike release the buffer stays valid and the compositor sends later frames
+     * in it, announced by frameReady again.
+     *
+     * Requires version 2 of the interface.
+     * @since 5.68
+     **/
+    void done();
 
 Q_SIGNALS:
     void parametersObtained();
+    /**
+     * Emitted when the buffer holds a new frame, the first time after parametersObtained.
+     * Call done once the frame has been read.
+     *
+     * Only emitted with version 2 of the interface.
+     * @see damage
+     * @since 5.68
+     **/
+    void frameReady();
+    /**
+     * The compositor won't send further frames in this buffer, it should be released.
+     * @since 5.68
+     **/
+    void discarded();
 
 private:
 
@@ -0,0 +1,290 @@
+/****************************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+#include "remote_frame_reader.h"
+#include "remote_access.h"
+#include "logging.h"
+// Qt
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+// Wayland
+#include <wayland-remote-access-client-protocol.h>
+
+#include <config-kwayland.h>
+// system
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if HAVE_LINUX_DMA_BUF_H
+#include <linux/dma-buf.h>
+#endif
+
+namespace KWayland
+{
+namespace Client
+{
+
+static constexpr quint32 fourccCode(char a, char b, char c, char d)
+{
+    return quint32(a) | (quint32(b) << 8) | (quint32(c) << 16) | (quint32(d) << 24);
+}
+
+static QImage::Format imageFormat(quint32 format)
+{
+    // DRM formats are little endian, matching QImage's 32 bit formats on little endian machines
+    switch (format) {
+    case fourccCode('X', 'R', '2', '4'):
+        return QImage::Format_RGB32;
+    case fourccCode('A', 'R', '2', '4'):
+        return QImage::Format_ARGB32_Premultiplied;
+    case fourccCode('X', 'B', '2', '4'):
+        return QImage::Format_RGBX8888;
+    case fourccCode('A', 'B', '2', '4'):
+        return QImage::Format_RGBA8888_Premultiplied;
+    case fourccCode('R', 'G', '1', '6'):
+        return QImage::Format_RGB16;
+    default:
+        return QImage::Format_Invalid;
+    }
+}
+
+static void syncDmabuf(int fd, bool start)
+{
+#if HAVE_LINUX_DMA_BUF_H
+    // makes the content coherent for the CPU, fails harmlessly for buffers which are no dmabuf
+    if (fd == -1) {
+        return;
+    }
+    dma_buf_sync sync = {};
+    sync.flags = DMA_BUF_SYNC_READ | (start ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END);
+    ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(start)
+#endif
+}
+
+class Q_DECL_HIDDEN RemoteFrameReader::Private
+{
+public:
+    Private(RemoteFrameReader *q, RemoteAccessManager *manager);
+    ~Private();
+
+    struct Buffer {
+        const void *output = nullptr;
+        int fd = -1;
+        uchar *data = nullptr;
+        size_t size = 0;
+        // started when the compositor announced the frame, invalid while no frame is read
+        QElapsedTimer announced;
+    };
+
+    void bufferReady(const void *output, RemoteBuffer *buffer);
+    void map(RemoteBuffer *buffer);
+    void frameReady(RemoteBuffer *buffer);
+    void read(RemoteBuffer *buffer);
+    void remove(RemoteBuffer *buffer);
+    void unmap(const Buffer &mapping);
+    bool canReuse() const;
+
+    QPointer<RemoteAccessManager> manager;
+    QHash<RemoteBuffer *, Buffer> buffers;
+
+    quint64 framesRead = 0;
+    qint64 totalLatency = 0;
+    qint64 maxLatency = 0;
+
+private:
+    RemoteFrameReader *q;
+};
+
+RemoteFrameReader::Private::Private(RemoteFrameReader *q, RemoteAccessManager *manager)
+    : manager(manager)
+    , q(q)
+{
+}
+
+RemoteFrameReader::Private::~Private()
+{
+    const auto remoteBuffers = buffers.keys();
+    for (RemoteBuffer *buffer : remoteBuffers) {
+        remove(buffer);
+    }
+}
+
+bool RemoteFrameReader::Private::canReuse() const
+{
+    return manager && manager->isValid()
+            && org_kde_kwin_remote_access_manager_get_version(*manager) >= ORG_KDE_KWIN_REMOTE_BUFFER_DONE_SINCE_VERSION;
+}
+
+void RemoteFrameReader::Private::bufferReady(const void *output, RemoteBuffer *buffer)
+{
+    Buffer &mapping = buffers[buffer];
+    mapping.output = output;
+    mapping.announced.start();
+
+    QObject::connect(buffer, &RemoteBuffer::parametersObtained, q, [this, buffer] {
+        map(buffer);
+        // before version 2 every buffer holds a single frame, which is complete with its parameters
+        if (!canReuse()) {
+            read(buffer);
+        }
+    });
+    QObject::connect(buffer, &RemoteBuffer::frameReady, q, [this, buffer] {
+        frameReady(buffer);
+    });
+    QObject::connect(buffer, &RemoteBuffer::discarded, q, [this, buffer] {
+        remove(buffer);
+    });
+    // the buffers are children of the manager, which might go away first
+    QObject::connect(buffer, &QObject::destroyed, q, [this, buffer] {
+        unmap(buffers.take(buffer));
+    });
+}
+
+void RemoteFrameReader::Private::map(RemoteBuffer *buffer)
+{
+    auto it = buffers.find(buffer);
+    if (it == buffers.end()) {
+        return;
+    }
+    Buffer &mapping = *it;
+    mapping.fd = buffer->fd();
+    mapping.size = size_t(buffer->stride()) * buffer->height();
+    if (mapping.size == 0) {
+        return;
+    }
+    void *data = mmap(nullptr, mapping.size, PROT_READ, MAP_SHARED, mapping.fd, 0);
+    if (data == MAP_FAILED) {
+        qCWarning(KWAYLAND_CLIENT) << "Could not map remote buffer" << buffer->width() << "x" << buffer->height();
+        return;
+    }
+    mapping.data = static_cast<uchar *>(data);
+}
+
+void RemoteFrameReader::Private::frameReady(RemoteBuffer *buffer)
+{
+    auto it = buffers.find(buffer);
+    if (it == buffers.end()) {
+        return;
+    }
+    // a reused buffer got announced with the frame itself
+    if (!it->announced.isValid()) {
+        it->announced.start();
+    }
+    read(buffer);
+}
+
+void RemoteFrameReader::Private::read(RemoteBuffer *buffer)
+{
+    auto it = buffers.find(buffer);
+    if (it == buffers.end()) {
+        return;
+    }
+    const Buffer mapping = *it;
+    const QImage::Format format = imageFormat(buffer->format());
+    QImage image;
+    if (mapping.data && format != QImage::Format_Invalid) {
+        // the const data makes the image read-only, it is copied when modified
+        image = QImage(static_cast<const uchar *>(mapping.data), buffer->width(), buffer->height(), buffer->stride(), format);
+    }
+    QRegion damage = buffer->damage();
+    if (damage.isEmpty()) {
+        damage = QRegion(0, 0, buffer->width(), buffer->height());
+    }
+
+    syncDmabuf(mapping.fd, true);
+    emit q->frameRead(mapping.output, image, damage);
+    syncDmabuf(mapping.fd, false);
+
+    // the image must not be used past this point
+    image = QImage();
+    if (canReuse()) {
+        it = buffers.find(buffer);
+        if (it != buffers.end()) {
+            it->announced.invalidate();
+            buffer->done();
+        }
+    } else {
+        remove(buffer);
+    }
+
+    const qint64 latency = mapping.announced.nsecsElapsed();
+    framesRead++;
+    totalLatency += latency;
+    maxLatency = qMax(maxLatency, latency);
+}
+
+void RemoteFrameReader::Private::unmap(const Buffer &mapping)
+{
+    if (mapping.data) {
+        munmap(mapping.data, mapping.size);
+    }
+    if (mapping.fd != -1) {
+        close(mapping.fd);
+    }
+}
+
+void RemoteFrameReader::Private::remove(RemoteBuffer *buffer)
+{
+    unmap(buffers.take(buffer));
+    // called from within signals of the buffer
+    buffer->deleteLater();
+}
+
+RemoteFrameReader::RemoteFrameReader(RemoteAccessManager *manager, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, manager))
+{
+    connect(manager, &RemoteAccessManager::bufferReady, this,
+        [this] (const void *output, const RemoteBuffer *buffer) {
+            // the buffers are created by the manager for its listeners to take over
+            d->bufferReady(output, const_cast<RemoteBuffer *>(buffer));
+        }
+    );
+}
+
+RemoteFrameReader::~RemoteFrameReader() = default;
+
+quint64 RemoteFrameReader::framesRead() const
+{
+    return d->framesRead;
+}
+
+qint64 RemoteFrameReader::averageLatency() const
+{
+    return d->framesRead ? d->totalLatency / qint64(d->framesRead) : 0;
+}
+
+qint64 RemoteFrameReader::maxLatency() const
+{
+    return d->maxLatency;
+}
+
+void RemoteFrameReader::resetStatistics()
+{
+    d->framesRead = 0;
+    d->totalLatency = 0;
+    d->maxLatency = 0;
+}
+
+}
+}
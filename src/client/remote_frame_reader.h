@@ -0,0 +1,114 @@
+/****************************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+****************************************************************************/
+#ifndef KWAYLAND_CLIENT_REMOTE_FRAME_READER_H
+#define KWAYLAND_CLIENT_REMOTE_FRAME_READER_H
+
+#include <QObject>
+#include <QImage>
+#include <QRegion>
+
+#include <KWayland/Client/kwaylandclient_export.h>
+
+namespace KWayland
+{
+namespace Client
+{
+
+class RemoteAccessManager;
+
+/**
+ * @short Reads the frames announced by a RemoteAccessManager.
+ *
+ * The RemoteFrameReader takes care of the RemoteBuffers the compositor announces
+ * through the RemoteAccessManager. It maps each buffer into memory, passes the frame
+ * as a QImage to frameRead and returns the buffer to the compositor once all slots
+ * connected to frameRead returned.
+ *
+ * @code
+ * auto reader = new RemoteFrameReader(remoteAccessManager);
+ * connect(reader, &RemoteFrameReader::frameRead, encoder,
+ *     [encoder] (const void *output, const QImage &image, const QRegion &damage) {
+ *         encoder->encode(image, damage);
+ *     }
+ * );
+ * @endcode
+ *
+ * Mapping only gives meaningful content for linear buffers, which is what the
+ * compositor has to provide when offering frames for CPU readback. The buffers
+ * are kept mapped as long as the compositor reuses them.
+ *
+ * The RemoteFrameReader owns the RemoteBuffers announced by the RemoteAccessManager,
+ * the RemoteAccessManager should not be used for reading frames in parallel.
+ *
+ * @see RemoteAccessManager
+ * @since 5.68
+ **/
+class KWAYLANDCLIENT_EXPORT RemoteFrameReader : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Creates a RemoteFrameReader reading the frames announced by @p manager.
+     **/
+    explicit RemoteFrameReader(RemoteAccessManager *manager, QObject *parent = nullptr);
+    virtual ~RemoteFrameReader();
+
+    /**
+     * @returns The number of frames read since creation or resetStatistics.
+     **/
+    quint64 framesRead() const;
+    /**
+     * The average time in nanoseconds from the compositor announcing a frame until
+     * the frame got returned to it.
+     **/
+    qint64 averageLatency() const;
+    /**
+     * The longest time in nanoseconds from the compositor announcing a frame until
+     * the frame got returned to it.
+     **/
+    qint64 maxLatency() const;
+    /**
+     * Resets framesRead, averageLatency and maxLatency.
+     **/
+    void resetStatistics();
+
+Q_SIGNALS:
+    /**
+     * Emitted for each frame of the @p output.
+     *
+     * The @p image directly accesses the mapped buffer and is only valid during the
+     * emission. Copy it to keep the frame. The @p image is null if the buffer could
+     * not be mapped or its format is not supported by QImage.
+     *
+     * @param output The wl_output the frame belongs to
+     * @param image The frame
+     * @param damage The region which changed since the previous frame of the output
+     **/
+    void frameRead(const void *output, const QImage &image, const QRegion &damage);
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+#endif
@@ -19,10 +19,16 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "shadow.h"
 #include "event_queue.h"
+#include "shm_pool.h"
 #include "surface.h"
 #include "wayland_pointer_p.h"
 
+#include <QHash>
+#include <QImage>
 #include <QMarginsF>
+#include <QPointer>
+
+#include <cstring>
 
 #include <wayland-shadow-client-protocol.h>
 
@@ -115,9 +121,44 @@ ShadowManager::operator org_kde_kwin_shadow_manager*() const
 class Shadow::Private
 {
 public:
+    enum Tile {
+        Left,
+        TopLeft,
+        Top,
+        TopRight,
+        Right,
+        BottomRight,
+        Bottom,
+        BottomLeft,
+        TileCount
+    };
+    void releaseTile(Tile tile);
+    void releaseTiles();
+
     WaylandPointer<org_kde_kwin_shadow, org_kde_kwin_shadow_destroy> shadow;
+    QPointer<ShadowTileCache> tileCache;
+    // Buffers acquired from the tileCache, to be released once replaced
+    Buffer::Ptr tiles[TileCount];
 };
 
+void Shadow::Private::releaseTile(Tile tile)
+{
+    if (tiles[tile].isNull()) {
+        return;
+    }
+    if (tileCache) {
+        tileCache->release(tiles[tile]);
+    }
+    tiles[tile].clear();
+}
+
+void Shadow::Private::releaseTiles()
+{
+    for (int i = 0; i < TileCount; ++i) {
+        releaseTile(Tile(i));
+    }
+}
+
 Shadow::Shadow(QObject *parent)
     : QObject(parent)
     , d(new Private)
@@ -126,6 +167,7 @@ Shadow::Shadow(QObject *parent)
 
 Shadow::~Shadow()
 {
+    d->releaseTiles();
     release();
 }
 
@@ -166,12 +208,27 @@ void Shadow::commit()
     org_kde_kwin_shadow_commit(d->shadow);
 }
 
+void Shadow::setTileCache(ShadowTileCache *cache)
+{
+    if (d->tileCache == cache) {
+        return;
+    }
+    d->releaseTiles();
+    d->tileCache = cache;
+}
+
+ShadowTileCache *Shadow::tileCache() const
+{
+    return d->tileCache;
+}
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 #define attach( __PART__, __WAYLAND_PART__ ) \
 void Shadow::attach##__PART__(wl_buffer *buffer) \
 { \
     Q_ASSERT(isValid()); \
     org_kde_kwin_shadow_attach_##__WAYLAND_PART__(d->shadow, buffer); \
+    d->releaseTile(Private::__PART__); \
 } \
 void Shadow::attach##__PART__(Buffer *buffer) \
 { \
@@ -183,6 +240,17 @@ void Shadow::attach##__PART__(Buffer *buffer) \
 void Shadow::attach##__PART__(Buffer::Ptr buffer) \
 { \
     attach##__PART__(buffer.toStrongRef().data()); \
+} \
+void Shadow::attach##__PART__(const QImage &image) \
+{ \
+    Q_ASSERT(d->tileCache); \
+    Buffer::Ptr buffer = d->tileCache->acquire(image); \
+    auto b = buffer.toStrongRef(); \
+    if (!b) { \
+        return; \
+    } \
+    attach##__PART__(b->buffer()); \
+    d->tiles[Private::__PART__] = buffer; \
 }
 
 attach(Left, left)
@@ -207,5 +275,181 @@ Shadow::operator org_kde_kwin_shadow*() const
     return d->shadow;
 }
 
+class Q_DECL_HIDDEN ShadowTileCache::Private
+{
+public:
+    Private(ShmPool *pool);
+    void remove(Buffer *buffer);
+    void prune();
+    static uint contentHash(const QImage &image);
+    static bool hasContent(Buffer *buffer, const QImage &image);
+
+    struct Entry {
+        Buffer::Ptr buffer;
+        uint hash;
+        int refCount;
+    };
+    ShmPool *pool;
+    QHash<Buffer*, Entry> entries;
+    QMultiHash<uint, Buffer*> byContent;
+};
+
+ShadowTileCache::Private::Private(ShmPool *pool)
+    : pool(pool)
+{
+}
+
+uint ShadowTileCache::Private::contentHash(const QImage &image)
+{
+    uint hash = qHash(qMakePair(image.width(), image.height()), uint(image.format()));
+    const int lineBytes = image.width() * 4;
+    for (int y = 0; y < image.height(); ++y) {
+        hash = qHashBits(image.constScanLine(y), lineBytes, hash);
+    }
+    return hash;
+}
+
+bool ShadowTileCache::Private::hasContent(Buffer *buffer, const QImage &image)
+{
+    const Buffer::Format format = image.format() == QImage::Format_RGB32 ? Buffer::Format::RGB32 : Buffer::Format::ARGB32;
+    if (buffer->size() != image.size() || buffer->stride() != image.bytesPerLine() || buffer->format() != format) {
+        return false;
+    }
+    const uchar *address = buffer->address();
+    const int lineBytes = image.width() * 4;
+    for (int y = 0; y < image.height(); ++y) {
+        if (memcmp(address + y * buffer->stride(), image.constScanLine(y), lineBytes) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShadowTileCache::Private::remove(Buffer *buffer)
+{
+    auto it = entries.find(buffer);
+    if (it == entries.end()) {
+        return;
+    }
+    byContent.remove(it->hash, buffer);
+    entries.erase(it);
+}
+
+void ShadowTileCache::Private::prune()
+{
+    // the ShmPool destroys all its Buffers when it gets released
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->buffer.isNull()) {
+            byContent.remove(it->hash, it.key());
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+ShadowTileCache::ShadowTileCache(ShmPool *pool)
+    : QObject(pool)
+    , d(new Private(pool))
+{
+}
+
+ShadowTileCache::~ShadowTileCache() = default;
+
+ShadowTileCache *ShadowTileCache::forPool(ShmPool *pool)
+{
+    Q_ASSERT(pool);
+    if (auto cache = pool->findChild<ShadowTileCache*>(QString(), Qt::FindDirectChildrenOnly)) {
+        return cache;
+    }
+    return new ShadowTileCache(pool);
+}
+
+ShmPool *ShadowTileCache::pool() const
+{
+    return d->pool;
+}
+
+Buffer::Ptr ShadowTileCache::acquire(const QImage &image)
+{
+    if (image.isNull()) {
+        return Buffer::Ptr();
+    }
+    QImage tile = image;
+    if (tile.format() != QImage::Format_ARGB32_Premultiplied && tile.format() != QImage::Format_RGB32) {
+        tile = tile.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+    const uint hash = Private::contentHash(tile);
+    bool stale = false;
+    for (auto it = d->byContent.constFind(hash); it != d->byContent.constEnd() && it.key() == hash; ++it) {
+        Private::Entry &entry = d->entries[it.value()];
+        auto buffer = entry.buffer.toStrongRef();
+        if (!buffer) {
+            stale = true;
+            continue;
+        }
+        if (Private::hasContent(buffer.data(), tile)) {
+            ++entry.refCount;
+            return entry.buffer;
+        }
+    }
+    if (stale) {
+        d->prune();
+    }
+
+    Buffer::Ptr buffer = d->pool->createBuffer(tile);
+    auto b = buffer.toStrongRef();
+    if (!b) {
+        return Buffer::Ptr();
+    }
+    // keeps the ShmPool from handing out the Buffer for other content
+    b->setUsed(true);
+    // a destroyed Buffer might have left an entry at the same address
+    d->remove(b.data());
+    d->entries.insert(b.data(), Private::Entry{buffer, hash, 1});
+    d->byContent.insert(hash, b.data());
+    return buffer;
+}
+
+void ShadowTileCache::release(Buffer::Ptr buffer)
+{
+    auto b = buffer.toStrongRef();
+    if (!b) {
+        d->prune();
+        return;
+    }
+    auto it = d->entries.find(b.data());
+    if (it == d->entries.end()) {
+        return;
+    }
+    if (--it->refCount > 0) {
+        return;
+    }
+    b->setUsed(false);
+    d->remove(b.data());
+}
+
+int ShadowTileCache::count() const
+{
+    int count = 0;
+    for (const auto &entry : qAsConst(d->entries)) {
+        if (!entry.buffer.isNull()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+qint64 ShadowTileCache::bytes() const
+{
+    qint64 bytes = 0;
+    for (const auto &entry : qAsConst(d->entries)) {
+        if (auto buffer = entry.buffer.toStrongRef()) {
+            bytes += qint64(buffer->size().height()) * buffer->stride();
+        }
+    }
+    return bytes;
+}
+
 }
 }
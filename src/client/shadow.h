@@ -32,6 +32,7 @@ struct wl_buffer;
 struct org_kde_kwin_shadow;
 struct org_kde_kwin_shadow_manager;
 
+class QImage;
 class QMarginsF;
 class QWindow;
 
@@ -42,6 +43,8 @@ namespace Client
 
 class EventQueue;
 class Shadow;
+class ShadowTileCache;
+class ShmPool;
 class Surface;
 
 /**
@@ -227,8 +230,47 @@ public:
     void attachBottomLeft(wl_buffer *buffer);
     void attachBottomLeft(Buffer *buffer);
     void attachBottomLeft(Buffer::Ptr buffer);
+    /**
+     * Attaches the tile @p image through the tileCache.
+     *
+     * All Shadows using the same ShadowTileCache share one Buffer for each distinct
+     * image, thus an application with many windows creates every tile of its shadow
+     * only once. The Shadow keeps a reference on the attached Buffer until another
+     * tile gets attached at the same position or the Shadow gets destroyed.
+     *
+     * Requires a tileCache to be set.
+     * @see setTileCache
+     * @since 5.68
+     **/
+    void attachLeft(const QImage &image);
+    /// @since 5.68
+    void attachTopLeft(const QImage &image);
+    /// @since 5.68
+    void attachTop(const QImage &image);
+    /// @since 5.68
+    void attachTopRight(const QImage &image);
+    /// @since 5.68
+    void attachRight(const QImage &image);
+    /// @since 5.68
+    void attachBottomRight(const QImage &image);
+    /// @since 5.68
+    void attachBottom(const QImage &image);
+    /// @since 5.68
+    void attachBottomLeft(const QImage &image);
     void setOffsets(const QMarginsF &margins);
 
+    /**
+     * Sets the @p cache used by the attach methods taking a QImage.
+     * @see ShadowTileCache::forPool
+     * @since 5.68
+     **/
+    void setTileCache(ShadowTileCache *cache);
+    /**
+     * @returns The ShadowTileCache used by the attach methods taking a QImage.
+     * @since 5.68
+     **/
+    ShadowTileCache *tileCache() const;
+
     operator org_kde_kwin_shadow*();
     operator org_kde_kwin_shadow*() const;
 
@@ -239,6 +281,80 @@ private:
     QScopedPointer<Private> d;
 };
 
+/**
+ * @short Shares the Buffers of identical shadow tiles.
+ *
+ * The tiles of a shadow are usually the same for all windows of an application,
+ * as they are rendered by the same decoration theme. The ShadowTileCache creates
+ * a Buffer in its ShmPool only once for each distinct image and hands out that
+ * Buffer to every Shadow attaching the same image.
+ *
+ * Each acquired Buffer is reference counted. The Buffer is marked as used as long
+ * as a reference exists, so that the ShmPool does not hand it out for other
+ * content, and becomes available to the ShmPool again once the last reference got
+ * released.
+ *
+ * There is one ShadowTileCache per ShmPool, it is created on first use and shared
+ * by the whole process:
+ * @code
+ * Shadow *shadow = shadowManager->createShadow(surface);
+ * shadow->setTileCache(ShadowTileCache::forPool(shmPool));
+ * shadow->attachTopLeft(topLeftImage);
+ * @endcode
+ *
+ * @see Shadow::setTileCache
+ * @since 5.68
+ **/
+class KWAYLANDCLIENT_EXPORT ShadowTileCache : public QObject
+{
+    Q_OBJECT
+public:
+    virtual ~ShadowTileCache();
+
+    /**
+     * @returns The ShadowTileCache creating its Buffers in @p pool, it is created
+     * on the first call and destroyed together with the @p pool.
+     **/
+    static ShadowTileCache *forPool(ShmPool *pool);
+
+    /**
+     * @returns The ShmPool the Buffers are created in.
+     **/
+    ShmPool *pool() const;
+
+    /**
+     * Provides a Buffer with the content of @p image and adds a reference to it.
+     *
+     * If a Buffer with the same content was acquired before and is still referenced,
+     * that Buffer is returned, otherwise a new Buffer is created in the pool.
+     * Each call must be balanced by a call to release.
+     *
+     * @returns The shared Buffer, a @c null Buffer::Ptr if the pool failed to provide one
+     * @see release
+     **/
+    Buffer::Ptr acquire(const QImage &image);
+    /**
+     * Drops a reference to @p buffer acquired before. Once there is no reference
+     * left the Buffer can be reused by the pool.
+     * @see acquire
+     **/
+    void release(Buffer::Ptr buffer);
+
+    /**
+     * @returns The number of distinct Buffers currently referenced.
+     **/
+    int count() const;
+    /**
+     * @returns The bytes of pool memory used by the currently referenced Buffers.
+     **/
+    qint64 bytes() const;
+
+private:
+    explicit ShadowTileCache(ShmPool *pool);
+    class Private;
+    QScopedPointer<Private> d;
+};
+
 }
 }
 
@@ -141,6 +141,8 @@ public:
 
     QRegion pendingRegion;
     QRegion currentRegion;
+    QRect currentBoundingRect;
+    int currentRectCount = 0;
 
 private:
     void commit();
@@ -171,7 +173,13 @@ void BlurInterface::Private::commitCallback(wl_client *client, wl_resource *reso
 
 void BlurInterface::Private::commit()
 {
+    if (currentRegion == pendingRegion) {
+        return;
+    }
     currentRegion = pendingRegion;
+    currentBoundingRect = currentRegion.boundingRect();
+    currentRectCount = currentRegion.rectCount();
+    emit q_func()->regionChanged();
 }
 
 void BlurInterface::Private::setRegionCallback(wl_client *client, wl_resource *resource, wl_resource *region)
@@ -206,6 +214,33 @@ QRegion BlurInterface::region()
     return d->currentRegion;
 }
 
+QRect BlurInterface::boundingRect() const
+{
+    Q_D();
+    return d->currentBoundingRect;
+}
+
+int BlurInterface::rectCount() const
+{
+    Q_D();
+    return d->currentRectCount;
+}
+
+QRegion BlurInterface::damagedRegion(const QRegion &damage) const
+{
+    Q_D();
+    if (d->currentRegion.isEmpty()) {
+        return damage;
+    }
+    if (!d->currentBoundingRect.intersects(damage.boundingRect())) {
+        return QRegion();
+    }
+    if (d->currentRectCount == 1) {
+        return damage.intersected(d->currentBoundingRect);
+    }
+    return damage.intersected(d->currentRegion);
+}
+
 BlurInterface::Private *BlurInterface::d_func() const
 {
     return reinterpret_cast<Private*>(d.data());
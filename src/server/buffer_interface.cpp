@@ -256,7 +256,9 @@ void BufferInterface::unref()
     if (d->refCount == 0) {
         if (d->buffer) {
             wl_buffer_send_release(d->buffer);
-            wl_client_flush(wl_resource_get_client(d->buffer));
+            if (ClientConnection *c = ClientConnection::get(wl_resource_get_client(d->buffer))) {
+                c->flush();
+            }
         }
         deleteLater();
     }
@@ -42,8 +42,10 @@ public:
     uid_t user = 0;
     gid_t group = 0;
     QString executablePath;
+    Limits limits;
 
 private:
+    friend class ClientConnection;
     static void destroyListenerCallback(wl_listener *listener, void *data);
     ClientConnection *q;
     wl_listener listener;
@@ -103,7 +105,24 @@ void ClientConnection::flush()
     if (!d->client) {
         return;
     }
-    wl_client_flush(d->client);
+    if (d->display) {
+        d->display->flushClient(d->client);
+    } else {
+        wl_client_flush(d->client);
+    }
+}
+
+ClientConnection *ClientConnection::get(wl_client *client)
+{
+    if (!client) {
+        return nullptr;
+    }
+    auto it = std::find_if(Private::s_allClients.constBegin(), Private::s_allClients.constEnd(),
+        [client](Private *c) {
+            return c->client == client;
+        }
+    );
+    return it != Private::s_allClients.constEnd() ? (*it)->q : nullptr;
 }
 
 void ClientConnection::destroy()
@@ -114,6 +133,19 @@ void ClientConnection::destroy()
     wl_client_destroy(d->client);
 }
 
+void ClientConnection::setLimits(const Limits &limits)
+{
+    d->limits = limits;
+    if (d->display) {
+        d->display->clientLimitsChanged();
+    }
+}
+
+ClientConnection::Limits ClientConnection::limits() const
+{
+    return d->limits;
+}
+
 wl_resource *ClientConnection::createResource(const wl_interface *interface, quint32 version, quint32 id)
 {
     if (!d->client) {
@@ -54,6 +54,9 @@ public:
 
     /**
      * Flushes the connection to this client. Ensures that all events are pushed to the client.
+     *
+     * With a Display::flushPolicy other than Display::FlushPolicy::Immediate the events are
+     * pushed with the next flush of all clients instead.
      **/
     void flush();
     /**
@@ -141,11 +144,86 @@ public:
      **/
     void destroy();
 
+    /**
+     * @returns The ClientConnection for the native @p client, @c nullptr if none got created.
+     * @see Display::getConnection
+     * @since 5.68
+     **/
+    static ClientConnection *get(wl_client *client);
+
+    /**
+     * The budgets a client can exceed.
+     * @see limitExceeded
+     * @since 5.68
+     **/
+    enum class Limit {
+        /**
+         * The client sent more requests than Limits::requestsPerDispatch in one dispatch
+         * of the event loop.
+         **/
+        Requests,
+        /**
+         * The client does not read its events and more than Limits::queuedBytes are
+         * pending in its socket.
+         **/
+        QueuedBytes
+    };
+    Q_ENUM(Limit)
+    /**
+     * Budgets protecting the server and the other clients from a client flooding the
+     * server with requests or not reading its events. @c 0 disables a budget.
+     * @see setLimits
+     * @since 5.68
+     **/
+    struct Limits {
+        /**
+         * The requests the client may send in one dispatch of the event loop.
+         **/
+        int requestsPerDispatch = 0;
+        /**
+         * The bytes of events which may be pending in the socket of the client. While
+         * more are pending the client is no longer flushed, so the events queue up in
+         * the server instead of repeatedly hitting the full socket.
+         **/
+        qint64 queuedBytes = 0;
+        /**
+         * Milliseconds a client may keep exceeding one of its budgets before it gets
+         * disconnected. @c 0 only emits limitExceeded.
+         **/
+        int disconnectTimeout = 0;
+    };
+    /**
+     * Sets the budgets of this client, by default the ones of Display::clientLimits.
+     *
+     * libwayland reads all requests available on the socket of a client, so the
+     * requests budget cannot hold back a client, it only detects one flooding the
+     * server. Once the client exceeds a budget limitExceeded is emitted and if it
+     * keeps exceeding it for the disconnectTimeout it gets disconnected.
+     *
+     * @see limits
+     * @see Display::setClientLimits
+     * @since 5.68
+     **/
+    void setLimits(const Limits &limits);
+    /**
+     * @see setLimits
+     * @since 5.68
+     **/
+    Limits limits() const;
+
 Q_SIGNALS:
     /**
      * Signal emitted when the ClientConnection got disconnected from the server.
      **/
     void disconnected(KWayland::Server::ClientConnection*);
+    /**
+     * Emitted when the client starts exceeding the budget for @p limit.
+     * The signal and a disconnect are delivered from the event loop of the Display,
+     * never from within a request handler.
+     * @see setLimits
+     * @since 5.68
+     **/
+    void limitExceeded(KWayland::Server::ClientConnection::Limit limit);
 
 private:
     friend class Display;
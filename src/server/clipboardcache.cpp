@@ -0,0 +1,378 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "clipboardcache_p.h"
+#include "datasource_interface.h"
+#include "logging.h"
+// Qt
+#include <QSocketNotifier>
+#include <QTimer>
+// system
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <functional>
+
+namespace KWayland
+{
+namespace Server
+{
+
+namespace
+{
+
+static const int s_chunkSize = 64 * 1024;
+// how long a receiver may stall before the cached data is no longer written to it
+static const int s_writeTimeout = 5000;
+
+/**
+ * Writes to a pipe without raising SIGPIPE if the reader went away.
+ **/
+static ssize_t writeNoSigPipe(int fd, const char *data, size_t size)
+{
+    sigset_t sigPipeMask;
+    sigset_t oldMask;
+    sigemptyset(&sigPipeMask);
+    sigaddset(&sigPipeMask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigPipeMask, &oldMask);
+    const ssize_t written = write(fd, data, size);
+    const int writeError = errno;
+    if (written == -1 && writeError == EPIPE && !sigismember(&oldMask, SIGPIPE)) {
+        // consume the pending SIGPIPE before unblocking it
+        const timespec timeout = {0, 0};
+        while (sigtimedwait(&sigPipeMask, nullptr, &timeout) == -1 && errno == EINTR) {
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+    errno = writeError;
+    return written;
+}
+
+/**
+ * Reads everything the source client sends into a pipe, without blocking the event loop.
+ **/
+class ClipboardFetch : public QObject
+{
+public:
+    ClipboardFetch(int fd, qint64 maximumSize, std::function<void (const QByteArray&, bool)> callback, QObject *parent)
+        : QObject(parent)
+        , m_fd(fd)
+        , m_maximumSize(maximumSize)
+        , m_callback(callback)
+        , m_notifier(new QSocketNotifier(fd, QSocketNotifier::Read, this))
+    {
+        connect(m_notifier, &QSocketNotifier::activated, this, [this] { readData(); });
+    }
+    ~ClipboardFetch() override {
+        close(m_fd);
+    }
+
+private:
+    void readData() {
+        while (true) {
+            const int oldSize = m_data.size();
+            m_data.resize(oldSize + s_chunkSize);
+            const ssize_t bytesRead = read(m_fd, m_data.data() + oldSize, s_chunkSize);
+            m_data.resize(oldSize + qMax(bytesRead, ssize_t(0)));
+            if (bytesRead > 0) {
+                if (m_data.size() > m_maximumSize) {
+                    finish(false);
+                    return;
+                }
+                continue;
+            }
+            if (bytesRead == 0) {
+                finish(true);
+                return;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                finish(false);
+            }
+            return;
+        }
+    }
+    void finish(bool success) {
+        m_notifier->setEnabled(false);
+        m_callback(m_data, success);
+    }
+
+    int m_fd;
+    qint64 m_maximumSize;
+    std::function<void (const QByteArray&, bool)> m_callback;
+    QSocketNotifier *m_notifier;
+    QByteArray m_data;
+};
+
+/**
+ * Writes cached data into the pipe of a receiving client, without blocking the event loop.
+ * Gives up and closes the pipe if the receiver does not read for s_writeTimeout milliseconds.
+ **/
+class ClipboardWriter : public QObject
+{
+public:
+    ClipboardWriter(int fd, const QByteArray &data, QObject *parent)
+        : QObject(parent)
+        , m_fd(fd)
+        , m_data(data)
+    {
+        fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+        if (writeData()) {
+            return;
+        }
+        m_notifier = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+        connect(m_notifier, &QSocketNotifier::activated, this,
+            [this] {
+                if (writeData()) {
+                    m_notifier->setEnabled(false);
+                    m_timer->stop();
+                } else {
+                    m_timer->start();
+                }
+            }
+        );
+        m_timer = new QTimer(this);
+        m_timer->setSingleShot(true);
+        m_timer->setInterval(s_writeTimeout);
+        connect(m_timer, &QTimer::timeout, this,
+            [this] {
+                qCWarning(KWAYLAND_SERVER) << "Receiver stopped reading cached clipboard data, closing the pipe";
+                m_notifier->setEnabled(false);
+                deleteLater();
+            }
+        );
+        m_timer->start();
+    }
+    ~ClipboardWriter() override {
+        close(m_fd);
+    }
+
+private:
+    /**
+     * @returns @c true if the writer is done and got scheduled for deletion
+     **/
+    bool writeData() {
+        while (m_offset < m_data.size()) {
+            const ssize_t written = writeNoSigPipe(m_fd, m_data.constData() + m_offset, m_data.size() - m_offset);
+            if (written >= 0) {
+                m_offset += written;
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        deleteLater();
+        return true;
+    }
+
+    int m_fd;
+    QByteArray m_data;
+    int m_offset = 0;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer *m_timer = nullptr;
+};
+
+}
+
+ClipboardCache::ClipboardCache(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ClipboardCache::~ClipboardCache() = default;
+
+void ClipboardCache::setMode(SeatInterface::ClipboardCacheMode mode)
+{
+    m_mode = mode;
+    clear();
+}
+
+void ClipboardCache::setMimeTypes(const QStringList &mimeTypes)
+{
+    m_mimeTypes = mimeTypes;
+    clear();
+}
+
+void ClipboardCache::setLimits(qint64 maximumEntrySize, qint64 maximumTotalSize)
+{
+    m_maximumEntrySize = maximumEntrySize;
+    m_maximumTotalSize = maximumTotalSize;
+    clear();
+}
+
+void ClipboardCache::resetStatistics()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
+bool ClipboardCache::isCacheable(const QString &mimeType) const
+{
+    if (m_mimeTypes.isEmpty()) {
+        return true;
+    }
+    for (const QString &pattern : m_mimeTypes) {
+        if (pattern.endsWith(QLatin1Char('*'))) {
+            if (mimeType.startsWith(pattern.leftRef(pattern.size() - 1))) {
+                return true;
+            }
+        } else if (mimeType == pattern) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ClipboardCache::clear()
+{
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        delete it.value().fetch;
+        for (qint32 fd : it.value().pendingRequests) {
+            // the receivers see an empty transfer
+            close(fd);
+        }
+    }
+    m_entries.clear();
+    m_totalSize = 0;
+    disconnect(m_mimeTypeOfferedConnection);
+    disconnect(m_sourceDestroyedConnection);
+    m_source.clear();
+}
+
+void ClipboardCache::setSource(DataSourceInterface *source)
+{
+    if (m_source == source && source) {
+        return;
+    }
+    clear();
+    if (!source || m_mode == SeatInterface::ClipboardCacheMode::Disabled) {
+        return;
+    }
+    m_source = source;
+    m_sourceDestroyedConnection = connect(source, &QObject::destroyed, this, [this] { clear(); });
+    if (m_mode != SeatInterface::ClipboardCacheMode::Eager) {
+        return;
+    }
+    const QStringList mimeTypes = source->mimeTypes();
+    for (const QString &mimeType : mimeTypes) {
+        if (isCacheable(mimeType) && !m_entries.contains(mimeType)) {
+            fetch(mimeType);
+        }
+    }
+    m_mimeTypeOfferedConnection = connect(source, &DataSourceInterface::mimeTypeOffered, this,
+        [this] (const QString &mimeType) {
+            if (isCacheable(mimeType) && !m_entries.contains(mimeType)) {
+                fetch(mimeType);
+            }
+        }
+    );
+}
+
+bool ClipboardCache::serve(DataSourceInterface *source, const QString &mimeType, qint32 fd)
+{
+    // only the current selection is cached, offers of older selections go to their source
+    if (!m_source || m_source != source || !isCacheable(mimeType)) {
+        return false;
+    }
+    if (!source->mimeTypes().contains(mimeType)) {
+        return false;
+    }
+    auto it = m_entries.find(mimeType);
+    if (it != m_entries.end() && it.value().state == Entry::State::Complete) {
+        m_hits++;
+        new ClipboardWriter(fd, it.value().data, this);
+        return true;
+    }
+    if (it != m_entries.end() && it.value().state == Entry::State::Uncacheable) {
+        m_misses++;
+        return false;
+    }
+    if (it == m_entries.end()) {
+        if (!fetch(mimeType)) {
+            return false;
+        }
+        it = m_entries.find(mimeType);
+    }
+    // the source sends its data only once, the request gets served from the fetch
+    m_misses++;
+    it.value().pendingRequests << fd;
+    return true;
+}
+
+bool ClipboardCache::fetch(const QString &mimeType)
+{
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        qCWarning(KWAYLAND_SERVER) << "Could not create pipe for clipboard cache";
+        return false;
+    }
+    Entry entry;
+    entry.fetch = new ClipboardFetch(pipeFds[0], qMin(m_maximumEntrySize, m_maximumTotalSize - m_totalSize),
+        [this, mimeType] (const QByteArray &data, bool success) {
+            fetchFinished(mimeType, data, success);
+        }, this
+    );
+    m_entries.insert(mimeType, entry);
+    // takes ownership of the write end
+    m_source->requestData(mimeType, pipeFds[1]);
+    return true;
+}
+
+void ClipboardCache::fetchFinished(const QString &mimeType, const QByteArray &data, bool success)
+{
+    auto it = m_entries.find(mimeType);
+    if (it == m_entries.end()) {
+        return;
+    }
+    it.value().fetch->deleteLater();
+    it.value().fetch = nullptr;
+    const QVector<qint32> pendingRequests = it.value().pendingRequests;
+    it.value().pendingRequests.clear();
+    if (!success || m_totalSize + data.size() > m_maximumTotalSize) {
+        it.value().state = Entry::State::Uncacheable;
+        // the fetch stopped at the size limit, only the source can serve the waiting requests
+        for (qint32 fd : pendingRequests) {
+            if (m_source) {
+                m_source->requestData(mimeType, fd);
+            } else {
+                close(fd);
+            }
+        }
+        return;
+    }
+    it.value().state = Entry::State::Complete;
+    it.value().data = data;
+    m_totalSize += data.size();
+    for (qint32 fd : pendingRequests) {
+        new ClipboardWriter(fd, data, this);
+    }
+}
+
+}
+}
@@ -0,0 +1,131 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef WAYLAND_SERVER_CLIPBOARDCACHE_P_H
+#define WAYLAND_SERVER_CLIPBOARDCACHE_P_H
+
+#include "seat_interface.h"
+// Qt
+#include <QByteArray>
+#include <QHash>
+#include <QMetaObject>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+
+namespace KWayland
+{
+namespace Server
+{
+
+class DataSourceInterface;
+
+/**
+ * Keeps the content of the current clipboard selection of a SeatInterface in memory.
+ *
+ * The data for a mime type gets pulled from the source client once, either when the
+ * selection is set (ClipboardCacheMode::Eager) or on the first request for the mime type
+ * (ClipboardCacheMode::OnRequest). Requests arriving meanwhile wait for that transfer,
+ * all following requests are answered by the compositor without involving the source client.
+ **/
+class Q_DECL_HIDDEN ClipboardCache : public QObject
+{
+public:
+    explicit ClipboardCache(QObject *parent = nullptr);
+    ~ClipboardCache() override;
+
+    void setMode(SeatInterface::ClipboardCacheMode mode);
+    SeatInterface::ClipboardCacheMode mode() const {
+        return m_mode;
+    }
+    void setMimeTypes(const QStringList &mimeTypes);
+    QStringList mimeTypes() const {
+        return m_mimeTypes;
+    }
+    void setLimits(qint64 maximumEntrySize, qint64 maximumTotalSize);
+    qint64 maximumEntrySize() const {
+        return m_maximumEntrySize;
+    }
+    qint64 maximumTotalSize() const {
+        return m_maximumTotalSize;
+    }
+
+    /**
+     * Sets the DataSourceInterface of the current selection, discarding all cached data.
+     * Changing the mode, mime types or limits discards the cached data as well, the source
+     * has to be set again afterwards.
+     **/
+    void setSource(DataSourceInterface *source);
+
+    /**
+     * Tries to answer the request for @p mimeType of @p source from the cache.
+     * A request for data still being fetched gets served once the fetch finished.
+     * @returns @c true if the request got served or queued and @p fd is taken over by the
+     * cache, @c false if the request has to be forwarded to the source.
+     **/
+    bool serve(DataSourceInterface *source, const QString &mimeType, qint32 fd);
+
+    quint64 hits() const {
+        return m_hits;
+    }
+    quint64 misses() const {
+        return m_misses;
+    }
+    qint64 size() const {
+        return m_totalSize;
+    }
+    void resetStatistics();
+
+private:
+    struct Entry {
+        enum class State {
+            Fetching,
+            Complete,
+            // too large or failed, requests are forwarded to the source
+            Uncacheable
+        };
+        State state = State::Fetching;
+        QByteArray data;
+        QObject *fetch = nullptr;
+        // pipes of the requests waiting for the fetch
+        QVector<qint32> pendingRequests;
+    };
+    bool isCacheable(const QString &mimeType) const;
+    bool fetch(const QString &mimeType);
+    void fetchFinished(const QString &mimeType, const QByteArray &data, bool success);
+    void clear();
+
+    SeatInterface::ClipboardCacheMode m_mode = SeatInterface::ClipboardCacheMode::Disabled;
+    QStringList m_mimeTypes;
+    qint64 m_maximumEntrySize = 4 * 1024 * 1024;
+    qint64 m_maximumTotalSize = 16 * 1024 * 1024;
+    QPointer<DataSourceInterface> m_source;
+    QMetaObject::Connection m_mimeTypeOfferedConnection;
+    QMetaObject::Connection m_sourceDestroyedConnection;
+    QHash<QString, Entry> m_entries;
+    qint64 m_totalSize = 0;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
+
+}
+}
+
+#endif
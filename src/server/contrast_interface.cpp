@@ -142,12 +142,14 @@ public:
 
     QRegion pendingRegion;
     QRegion currentRegion;
-    qreal pendingContrast;
-    qreal currentContrast;
-    qreal pendingIntensity;
-    qreal currentIntensity;
-    qreal pendingSaturation;
-    qreal currentSaturation;
+    QRect currentBoundingRect;
+    int currentRectCount = 0;
+    qreal pendingContrast = 0;
+    qreal currentContrast = 0;
+    qreal pendingIntensity = 0;
+    qreal currentIntensity = 0;
+    qreal pendingSaturation = 0;
+    qreal currentSaturation = 0;
 
 private:
     void commit();
@@ -184,10 +186,19 @@ void ContrastInterface::Private::commitCallback(wl_client *client, wl_resource *
 
 void ContrastInterface::Private::commit()
 {
-    currentRegion = pendingRegion;
+    const bool regionChanged = currentRegion != pendingRegion;
+    if (!regionChanged && currentContrast == pendingContrast && currentIntensity == pendingIntensity && currentSaturation == pendingSaturation) {
+        return;
+    }
+    if (regionChanged) {
+        currentRegion = pendingRegion;
+        currentBoundingRect = currentRegion.boundingRect();
+        currentRectCount = currentRegion.rectCount();
+    }
     currentContrast = pendingContrast;
     currentIntensity = pendingIntensity;
     currentSaturation = pendingSaturation;
+    emit q_func()->changed();
 }
 
 void ContrastInterface::Private::setRegionCallback(wl_client *client, wl_resource *resource, wl_resource *region)
@@ -243,6 +254,33 @@ QRegion ContrastInterface::region() const
     return d->currentRegion;
 }
 
+QRect ContrastInterface::boundingRect() const
+{
+    Q_D();
+    return d->currentBoundingRect;
+}
+
+int ContrastInterface::rectCount() const
+{
+    Q_D();
+    return d->currentRectCount;
+}
+
+QRegion ContrastInterface::damagedRegion(const QRegion &damage) const
+{
+    Q_D();
+    if (d->currentRegion.isEmpty()) {
+        return damage;
+    }
+    if (!d->currentBoundingRect.intersects(damage.boundingRect())) {
+        return QRegion();
+    }
+    if (d->currentRectCount == 1) {
+        return damage.intersected(d->currentBoundingRect);
+    }
+    return damage.intersected(d->currentRegion);
+}
+
 qreal ContrastInterface::contrast() const
 {
     Q_D();
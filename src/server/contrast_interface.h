@@ -25,6 +25,8 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "resource.h"
 
 #include <QObject>
+#include <QRect>
+#include <QRegion>
 
 #include <KWayland/Server/kwaylandserver_export.h>
 
@@ -79,6 +81,37 @@ public:
     qreal contrast() const;
     qreal intensity() const;
     qreal saturation() const;
+    /**
+     * @returns The bounding rect of the region, computed when the region got committed.
+     * An empty rect for a null region.
+     * @see region
+     * @since 5.68
+     **/
+    QRect boundingRect() const;
+    /**
+     * @returns The number of rectangles in the region, computed when the region got committed.
+     * @see region
+     * @since 5.68
+     **/
+    int rectCount() const;
+    /**
+     * @returns The part of @p damage for which the contrast effect has to be rendered
+     * again. For a null region, which covers the complete surface, this is @p damage itself.
+     *
+     * Damage outside the bounding rect is rejected without intersecting the region.
+     * @param damage The damage of the SurfaceInterface in surface local coordinates
+     * @see SurfaceInterface::damage
+     * @since 5.68
+     **/
+    QRegion damagedRegion(const QRegion &damage) const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when a commit changed the region, contrast, intensity or saturation.
+     * Committing the same values again does not emit this signal.
+     * @since 5.68
+     **/
+    void changed();
 
 private:
     explicit ContrastInterface(ContrastManagerInterface *parent, wl_resource *parentResource);
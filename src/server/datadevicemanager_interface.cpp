@@ -22,6 +22,8 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "global_p.h"
 #include "display.h"
 #include "seat_interface_p.h"
+// Qt
+#include <QHash>
 // Wayland
 #include <wayland-server.h>
 
@@ -35,6 +37,14 @@ class DataDeviceManagerInterface::Private : public Global::Private
 public:
     Private(DataDeviceManagerInterface *q, Display *d);
 
+    /**
+     * Mime types offered by data sources, most clients offer the same handful.
+     * Counts the offers, an entry goes away with the last data source offering it.
+     **/
+    QHash<QByteArray, int> mimeTypes;
+    // bounds the memory clients offering random mime types can pin at a time
+    static const int s_maxInternedMimeTypes = 1024;
+
 private:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
     void createDataSource(wl_client *client, wl_resource *resource, uint32_t id);
@@ -131,5 +141,36 @@ DataDeviceManagerInterface::DataDeviceManagerInterface(Display *display, QObject
 
 DataDeviceManagerInterface::~DataDeviceManagerInterface() = default;
 
+DataDeviceManagerInterface::Private *DataDeviceManagerInterface::d_func() const
+{
+    return reinterpret_cast<Private*>(d.data());
+}
+
+QByteArray DataDeviceManagerInterface::internMimeType(const char *mimeType)
+{
+    Q_D();
+    const QByteArray key = QByteArray::fromRawData(mimeType, qstrlen(mimeType));
+    auto it = d->mimeTypes.find(key);
+    if (it != d->mimeTypes.end()) {
+        it.value()++;
+        return it.key();
+    }
+    // deep copy, key does not own its data
+    const QByteArray encoded(key.constData(), key.size());
+    if (d->mimeTypes.size() < Private::s_maxInternedMimeTypes) {
+        d->mimeTypes.insert(encoded, 1);
+    }
+    return encoded;
+}
+
+void DataDeviceManagerInterface::releaseMimeType(const QByteArray &mimeType)
+{
+    Q_D();
+    auto it = d->mimeTypes.find(mimeType);
+    if (it != d->mimeTypes.end() && --it.value() == 0) {
+        d->mimeTypes.erase(it);
+    }
+}
+
 }
 }
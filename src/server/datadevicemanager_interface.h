@@ -63,7 +63,18 @@ Q_SIGNALS:
 private:
     explicit DataDeviceManagerInterface(Display *display, QObject *parent = nullptr);
     friend class Display;
+    friend class DataSourceInterface;
+    /**
+     * @returns An UTF-8 encoded, null terminated copy of @p mimeType, shared between
+     * all DataSourceInterfaces offering the same mime type.
+     **/
+    QByteArray internMimeType(const char *mimeType);
+    /**
+     * Releases a mime type returned by internMimeType once its DataSourceInterface goes away.
+     **/
+    void releaseMimeType(const QByteArray &mimeType);
     class Private;
+    Private *d_func() const;
 };
 
 }
@@ -18,8 +18,11 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "dataoffer_interface_p.h"
+#include "clipboardcache_p.h"
 #include "datadevice_interface.h"
 #include "datasource_interface.h"
+#include "datasource_interface_p.h"
+#include "seat_interface_p.h"
 // Qt
 #include <QStringList>
 // Wayland
@@ -75,6 +78,9 @@ void DataOfferInterface::Private::receive(const QString &mimeType, qint32 fd)
         close(fd);
         return;
     }
+    if (dataDevice && dataDevice->seat()->d_func()->clipboardCache->serve(source, mimeType, fd)) {
+        return;
+    }
     source->requestData(mimeType, fd);
 }
 
@@ -158,12 +164,16 @@ DataOfferInterface::DataOfferInterface(DataSourceInterface *source, DataDeviceIn
 {
     Q_ASSERT(source);
     connect(source, &DataSourceInterface::mimeTypeOffered, this,
-        [this](const QString &mimeType) {
+        [this] (const QString &mimeType) {
             Q_D();
-            if (!d->resource) {
+            if (!d->resource || !d->source) {
                 return;
             }
-            wl_data_offer_send_offer(d->resource, mimeType.toUtf8().constData());
+            const auto sourcePrivate = d->source->d_func();
+            const int index = sourcePrivate->mimeTypes.lastIndexOf(mimeType);
+            if (index != -1) {
+                wl_data_offer_send_offer(d->resource, sourcePrivate->encodedMimeTypes.at(index).constData());
+            }
         }
     );
     QObject::connect(source, &QObject::destroyed, this,
@@ -179,8 +189,9 @@ DataOfferInterface::~DataOfferInterface() = default;
 void DataOfferInterface::sendAllOffers()
 {
     Q_D();
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        wl_data_offer_send_offer(d->resource, mimeType.toUtf8().constData());
+    const auto &mimeTypes = d->source->d_func()->encodedMimeTypes;
+    for (const QByteArray &mimeType : mimeTypes) {
+        wl_data_offer_send_offer(d->resource, mimeType.constData());
     }
 }
 
@@ -20,8 +20,10 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef KWAYLAND_SERVER_DATAOFFERINTERFACE_P_H
 #define KWAYLAND_SERVER_DATAOFFERINTERFACE_P_H
 #include "dataoffer_interface.h"
+#include "datadevice_interface.h"
 #include "datasource_interface.h"
 #include "resource_p.h"
+#include <QPointer>
 #include <wayland-server.h>
 
 namespace KWayland
@@ -35,7 +37,7 @@ public:
     Private(DataSourceInterface *source, DataDeviceInterface *parentInterface, DataOfferInterface *q, wl_resource *parentResource);
     ~Private();
     DataSourceInterface *source;
-    DataDeviceInterface *dataDevice;
+    QPointer<DataDeviceInterface> dataDevice;
     // defaults are set to sensible values for < version 3 interfaces
     DataDeviceManagerInterface::DnDActions supportedDnDActions = DataDeviceManagerInterface::DnDAction::Copy | DataDeviceManagerInterface::DnDAction::Move;
     DataDeviceManagerInterface::DnDAction preferredDnDAction = DataDeviceManagerInterface::DnDAction::Copy;
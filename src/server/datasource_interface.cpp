@@ -18,9 +18,9 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "datasource_interface.h"
+#include "datasource_interface_p.h"
 #include "datadevicemanager_interface.h"
 #include "clientconnection.h"
-#include "resource_p.h"
 // Qt
 #include <QStringList>
 // Wayland
@@ -33,27 +33,6 @@ namespace KWayland
 namespace Server
 {
 
-class DataSourceInterface::Private : public Resource::Private
-{
-public:
-    Private(DataSourceInterface *q, DataDeviceManagerInterface *parent, wl_resource *parentResource);
-    ~Private();
-
-    QStringList mimeTypes;
-    DataDeviceManagerInterface::DnDActions supportedDnDActions = DataDeviceManagerInterface::DnDAction::None;
-
-private:
-    DataSourceInterface *q_func() {
-        return reinterpret_cast<DataSourceInterface *>(q);
-    }
-    void offer(const QString &mimeType);
-
-    static void offerCallback(wl_client *client, wl_resource *resource, const char *mimeType);
-    static void setActionsCallback(wl_client *client, wl_resource *resource, uint32_t dnd_actions);
-
-    const static struct wl_data_source_interface s_interface;
-};
-
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 const struct wl_data_source_interface DataSourceInterface::Private::s_interface = {
     offerCallback,
@@ -64,22 +43,36 @@ const struct wl_data_source_interface DataSourceInterface::Private::s_interface
 
 DataSourceInterface::Private::Private(DataSourceInterface *q, DataDeviceManagerInterface *parent, wl_resource *parentResource)
     : Resource::Private(q, parent, parentResource, &wl_data_source_interface, &s_interface)
+    , manager(parent)
 {
 }
 
-DataSourceInterface::Private::~Private() = default;
+DataSourceInterface::Private::~Private()
+{
+    if (manager) {
+        for (const QByteArray &mimeType : qAsConst(encodedMimeTypes)) {
+            manager->releaseMimeType(mimeType);
+        }
+    }
+}
 
 void DataSourceInterface::Private::offerCallback(wl_client *client, wl_resource *resource, const char *mimeType)
 {
     Q_UNUSED(client)
-    cast<Private>(resource)->offer(QString::fromUtf8(mimeType));
+    cast<Private>(resource)->offer(mimeType);
 }
 
-void DataSourceInterface::Private::offer(const QString &mimeType)
+void DataSourceInterface::Private::offer(const char *mimeType)
 {
-    mimeTypes << mimeType;
+    if (manager) {
+        encodedMimeTypes << manager->internMimeType(mimeType);
+    } else {
+        encodedMimeTypes << QByteArray(mimeType);
+    }
+    const QString decoded = QString::fromUtf8(encodedMimeTypes.last());
+    mimeTypes << decoded;
     Q_Q(DataSourceInterface);
-    emit q->mimeTypeOffered(mimeType);
+    emit q->mimeTypeOffered(decoded);
 }
 
 void DataSourceInterface::Private::setActionsCallback(wl_client *client, wl_resource *resource, uint32_t dnd_actions)
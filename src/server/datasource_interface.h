@@ -82,6 +82,7 @@ Q_SIGNALS:
 
 private:
     friend class DataDeviceManagerInterface;
+    friend class DataOfferInterface;
     explicit DataSourceInterface(DataDeviceManagerInterface *parent, wl_resource *parentResource);
 
     class Private;
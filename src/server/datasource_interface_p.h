@@ -0,0 +1,66 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef WAYLAND_SERVER_DATASOURCE_INTERFACE_P_H
+#define WAYLAND_SERVER_DATASOURCE_INTERFACE_P_H
+
+#include "datasource_interface.h"
+#include "resource_p.h"
+// Qt
+#include <QByteArray>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+
+namespace KWayland
+{
+namespace Server
+{
+
+class DataSourceInterface::Private : public Resource::Private
+{
+public:
+    Private(DataSourceInterface *q, DataDeviceManagerInterface *parent, wl_resource *parentResource);
+    ~Private();
+
+    QStringList mimeTypes;
+    /**
+     * The offered mime types, UTF-8 encoded and null terminated, ready to be sent.
+     **/
+    QVector<QByteArray> encodedMimeTypes;
+    // interns the mime types, may go away before the data source
+    QPointer<DataDeviceManagerInterface> manager;
+    DataDeviceManagerInterface::DnDActions supportedDnDActions = DataDeviceManagerInterface::DnDAction::None;
+
+private:
+    DataSourceInterface *q_func() {
+        return reinterpret_cast<DataSourceInterface *>(q);
+    }
+    void offer(const char *mimeType);
+
+    static void offerCallback(wl_client *client, wl_resource *resource, const char *mimeType);
+    static void setActionsCallback(wl_client *client, wl_resource *resource, uint32_t dnd_actions);
+
+    const static struct wl_data_source_interface s_interface;
+};
+
+}
+}
+
+#endif
@@ -62,13 +62,25 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include <QCoreApplication>
 #include <QDebug>
 #include <QAbstractEventDispatcher>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
 #include <QSocketNotifier>
 #include <QThread>
+#include <QTimer>
 
 #include <wayland-server.h>
 
 #include <EGL/egl.h>
 
+#include <algorithm>
+#include <cstring>
+#include <sys/ioctl.h>
+#if defined(Q_OS_LINUX)
+#include <linux/sockios.h>
+#endif
+
 namespace KWayland
 {
 namespace Server
@@ -82,6 +94,54 @@ public:
     void dispatch();
     void setRunning(bool running);
     void installSocketNotifier();
+    void startDispatchThread();
+    void terminate();
+
+    struct MessageCounter {
+        const char *interface = nullptr;
+        quint32 opcode = 0;
+        bool event = false;
+        quint64 count = 0;
+        quint64 bytes = 0;
+        qint64 handlerTime = 0;
+    };
+    struct ClientCounters {
+        wl_client *client = nullptr;
+        wl_listener destroyListener;
+        quint64 requests = 0;
+        quint64 requestBytes = 0;
+        quint64 events = 0;
+        quint64 eventBytes = 0;
+        quint64 flushes = 0;
+        qint64 handlerTime = 0;
+        // requests of the current dispatch, only counted while a client has a request budget
+        int dispatchRequests = 0;
+        // a wl_message is unique for the interface, opcode and direction
+        QHash<const wl_message*, MessageCounter> messages;
+    };
+    // when a client started to exceed its budgets, in msec of limitsTimer
+    struct LimitState {
+        wl_client *client = nullptr;
+        qint64 requestsExceededSince = -1;
+        qint64 requestsLastExceeded = -1;
+        qint64 queueExceededSince = -1;
+    };
+    void updateProtocolLogger();
+    void destroyProtocolLogger();
+    void resetStatistics();
+    void updateStatisticsDumpTimer();
+    void dumpStatistics();
+    void logMessage(wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+    void finishRequest(qint64 now);
+    ClientCounters *clientCounters(wl_client *client);
+    void removeClientCounters(wl_client *client);
+    void flushClient(wl_client *client);
+    void updateLimits();
+    void checkRequestBudgets();
+    void checkQueuedBytes();
+    void handleExceededLimits(const QVector<ClientConnection*> &exceeding, const QVector<ClientConnection*> &abusive,
+                              ClientConnection::Limit limit);
+    void disconnectClients(const QVector<QPointer<ClientConnection>> &connections, ClientConnection::Limit limit);
 
     wl_display *display = nullptr;
     wl_event_loop *loop = nullptr;
@@ -93,14 +153,118 @@ public:
     QVector<SeatInterface*> seats;
     QVector<ClientConnection*> clients;
     EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    QSocketNotifier *socketNotifier = nullptr;
+    QMetaObject::Connection aboutToBlockConnection;
+
+    DispatchMode dispatchMode = DispatchMode::EventLoop;
+    QThread *dispatchThread = nullptr;
+    // the thread the Display gets moved back to once terminated
+    QThread *originThread = nullptr;
+    FlushPolicy flushPolicy = FlushPolicy::Immediate;
+
+    bool statisticsEnabled = false;
+    int statisticsDumpInterval = 0;
+    wl_protocol_logger *protocolLogger = nullptr;
+    QHash<wl_client*, ClientCounters*> clientStatistics;
+    QElapsedTimer statisticsTimer;
+    QTimer *statisticsDumpTimer = nullptr;
+    quint64 flushes = 0;
+    qint64 dispatchTime = 0;
+    // the request whose handler is currently running
+    wl_client *requestClient = nullptr;
+    const wl_message *requestMessage = nullptr;
+    qint64 requestStart = 0;
+
+    ClientConnection::Limits clientLimits;
+    // whether any client has a request or queued bytes budget
+    bool requestLimits = false;
+    bool queueLimits = false;
+    QHash<ClientConnection*, LimitState> limitStates;
+    // clients exceeding their queued bytes, they are not flushed until they read their socket
+    QSet<wl_client*> throttledClients;
+    QElapsedTimer limitsTimer;
+    wl_listener clientCreatedListener;
 
 private:
+    static void protocolLoggerCallback(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+    static void clientCreatedCallback(wl_listener *listener, void *data);
+    static void clientDestroyedCallback(wl_listener *listener, void *data);
+    static Private *fromClient(wl_client *client);
+    static QVector<Private*> s_displays;
     Display *q;
 };
 
+QVector<Display::Private*> Display::Private::s_displays;
+
+// the size of the message on the wire, see wl_closure_marshal
+static quint32 messageSize(const wl_protocol_logger_message *message)
+{
+    // object id, opcode and size
+    quint32 size = 8;
+    int argument = 0;
+    for (const char *signature = message->message->signature; *signature && argument < message->arguments_count; ++signature) {
+        switch (*signature) {
+        case 'i':
+        case 'u':
+        case 'f':
+        case 'o':
+        case 'n':
+            size += 4;
+            argument++;
+            break;
+        case 's': {
+            const char *string = message->arguments[argument++].s;
+            size += 4;
+            if (string) {
+                size += (std::strlen(string) + 1 + 3) & ~3u;
+            }
+            break;
+        }
+        case 'a': {
+            const wl_array *array = message->arguments[argument++].a;
+            size += 4;
+            if (array) {
+                size += (array->size + 3) & ~3u;
+            }
+            break;
+        }
+        case 'h':
+            // file descriptors are passed out of band
+            argument++;
+            break;
+        default:
+            // version and nullable markers
+            break;
+        }
+    }
+    return size;
+}
+
+// the bytes sent to the client which it did not read yet, -1 if unknown
+static int queuedBytes(wl_client *client)
+{
+    int queued = 0;
+#if defined(SIOCOUTQ)
+    if (ioctl(wl_client_get_fd(client), SIOCOUTQ, &queued) != 0) {
+        return -1;
+    }
+#elif defined(FIONWRITE)
+    if (ioctl(wl_client_get_fd(client), FIONWRITE, &queued) != 0) {
+        return -1;
+    }
+#else
+    Q_UNUSED(client)
+    return -1;
+#endif
+    return queued;
+}
+
 Display::Private::Private(Display *q)
     : q(q)
 {
+    s_displays << this;
+    clientCreatedListener.notify = clientCreatedCallback;
+    limitsTimer.start();
 }
 
 void Display::Private::installSocketNotifier()
@@ -113,12 +277,48 @@ void Display::Private::installSocketNotifier()
         qCWarning(KWAYLAND_SERVER) << "Did not get the file descriptor for the event loop";
         return;
     }
-    QSocketNotifier *m_notifier = new QSocketNotifier(fd, QSocketNotifier::Read, q);
-    QObject::connect(m_notifier, &QSocketNotifier::activated, q, [this] { dispatch(); } );
-    QObject::connect(QThread::currentThread()->eventDispatcher(), &QAbstractEventDispatcher::aboutToBlock, q, [this] { flush(); });
+    socketNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, q);
+    QObject::connect(socketNotifier, &QSocketNotifier::activated, q, [this] { dispatch(); } );
+    aboutToBlockConnection = QObject::connect(QThread::currentThread()->eventDispatcher(), &QAbstractEventDispatcher::aboutToBlock, q,
+        [this] {
+            if (flushPolicy != FlushPolicy::Explicit) {
+                flush();
+            }
+        }
+    );
     setRunning(true);
 }
 
+void Display::Private::startDispatchThread()
+{
+    if (q->parent()) {
+        qCWarning(KWAYLAND_SERVER) << "A Display with a parent cannot be moved to a dispatch thread, dispatching through the event loop";
+        installSocketNotifier();
+        return;
+    }
+    originThread = q->thread();
+    dispatchThread = new QThread;
+    dispatchThread->setObjectName(QStringLiteral("WaylandDispatch"));
+    q->moveToThread(dispatchThread);
+    dispatchThread->start();
+    // the socket notifier and the flush on aboutToBlock have to be installed from within the thread
+    QMetaObject::invokeMethod(q, [this] { installSocketNotifier(); }, Qt::BlockingQueuedConnection);
+}
+
+void Display::Private::terminate()
+{
+    emit q->aboutToTerminate();
+    delete socketNotifier;
+    socketNotifier = nullptr;
+    QObject::disconnect(aboutToBlockConnection);
+    wl_display_terminate(display);
+    destroyProtocolLogger();
+    wl_display_destroy(display);
+    display = nullptr;
+    loop = nullptr;
+    setRunning(false);
+}
+
 Display::Display(QObject *parent)
     : QObject(parent)
     , d(new Private(this))
@@ -129,8 +329,10 @@ Display::~Display()
 {
     terminate();
     if (d->display) {
+        d->destroyProtocolLogger();
         wl_display_destroy(d->display);
     }
+    Private::s_displays.removeOne(d.data());
 }
 
 void Display::Private::flush()
@@ -138,7 +340,22 @@ void Display::Private::flush()
     if (!display || !loop) {
         return;
     }
-    wl_display_flush_clients(display);
+    if (throttledClients.isEmpty()) {
+        wl_display_flush_clients(display);
+    } else {
+        // flushing a client which does not read its socket only hits the full socket buffer again
+        wl_client *client;
+        wl_list *list = wl_display_get_client_list(display);
+        wl_client_for_each(client, list) {
+            if (!throttledClients.contains(client)) {
+                wl_client_flush(client);
+            }
+        }
+    }
+    if (statisticsEnabled && protocolLogger) {
+        flushes++;
+    }
+    checkQueuedBytes();
 }
 
 void Display::Private::dispatch()
@@ -146,9 +363,387 @@ void Display::Private::dispatch()
     if (!display || !loop) {
         return;
     }
+    const bool measure = statisticsEnabled && protocolLogger;
+    const qint64 start = measure ? statisticsTimer.nsecsElapsed() : 0;
     if (wl_event_loop_dispatch(loop, 0) != 0) {
         qCWarning(KWAYLAND_SERVER) << "Error on dispatching Wayland event loop";
     }
+    if (measure && statisticsEnabled && protocolLogger) {
+        const qint64 now = statisticsTimer.nsecsElapsed();
+        finishRequest(now);
+        dispatchTime += now - start;
+    }
+    checkRequestBudgets();
+}
+
+void Display::Private::protocolLoggerCallback(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    reinterpret_cast<Private*>(data)->logMessage(type, message);
+}
+
+Display::Private *Display::Private::fromClient(wl_client *client)
+{
+    wl_display *display = wl_client_get_display(client);
+    auto it = std::find_if(s_displays.constBegin(), s_displays.constEnd(),
+        [display] (Private *p) {
+            return p->display == display;
+        }
+    );
+    return it != s_displays.constEnd() ? *it : nullptr;
+}
+
+void Display::Private::clientCreatedCallback(wl_listener *listener, void *data)
+{
+    Q_UNUSED(listener)
+    wl_client *client = reinterpret_cast<wl_client*>(data);
+    Private *p = fromClient(client);
+    // the budgets are enforced through the ClientConnection, so also clients which
+    // never bind a global must get one
+    if (p && (p->requestLimits || p->queueLimits)) {
+        p->q->getConnection(client);
+    }
+}
+
+void Display::Private::clientDestroyedCallback(wl_listener *listener, void *data)
+{
+    Q_UNUSED(listener)
+    wl_client *client = reinterpret_cast<wl_client*>(data);
+    if (Private *p = fromClient(client)) {
+        p->removeClientCounters(client);
+    }
+}
+
+void Display::Private::updateProtocolLogger()
+{
+    const bool needed = display && (statisticsEnabled || requestLimits);
+    if (needed == (protocolLogger != nullptr)) {
+        return;
+    }
+    if (needed) {
+        protocolLogger = wl_display_add_protocol_logger(display, protocolLoggerCallback, this);
+        statisticsTimer.start();
+    } else {
+        destroyProtocolLogger();
+    }
+    updateStatisticsDumpTimer();
+}
+
+void Display::Private::destroyProtocolLogger()
+{
+    if (!protocolLogger) {
+        return;
+    }
+    wl_protocol_logger_destroy(protocolLogger);
+    protocolLogger = nullptr;
+    for (ClientCounters *counters : qAsConst(clientStatistics)) {
+        wl_list_remove(&counters->destroyListener.link);
+        delete counters;
+    }
+    clientStatistics.clear();
+    requestClient = nullptr;
+    requestMessage = nullptr;
+    flushes = 0;
+    dispatchTime = 0;
+}
+
+void Display::Private::resetStatistics()
+{
+    flushes = 0;
+    dispatchTime = 0;
+    for (auto counters : qAsConst(clientStatistics)) {
+        counters->requests = 0;
+        counters->requestBytes = 0;
+        counters->events = 0;
+        counters->eventBytes = 0;
+        counters->flushes = 0;
+        counters->handlerTime = 0;
+        counters->messages.clear();
+    }
+}
+
+void Display::Private::updateStatisticsDumpTimer()
+{
+    if (statisticsDumpInterval <= 0 || !statisticsEnabled || !protocolLogger) {
+        if (statisticsDumpTimer) {
+            statisticsDumpTimer->stop();
+        }
+        return;
+    }
+    if (!statisticsDumpTimer) {
+        statisticsDumpTimer = new QTimer(q);
+        QObject::connect(statisticsDumpTimer, &QTimer::timeout, q, [this] { dumpStatistics(); });
+    }
+    statisticsDumpTimer->start(statisticsDumpInterval);
+}
+
+void Display::Private::dumpStatistics()
+{
+    auto statistics = q->statistics();
+    std::sort(statistics.clients.begin(), statistics.clients.end(),
+        [] (const ClientStatistics &a, const ClientStatistics &b) {
+            return a.requests > b.requests;
+        }
+    );
+    qCInfo(KWAYLAND_SERVER).noquote() << QStringLiteral("Protocol statistics: %1 clients, %2 flushes, %3 ms dispatching")
+                                         .arg(statistics.clients.count()).arg(statistics.flushes)
+                                         .arg(statistics.dispatchTime / 1000000.0, 0, 'f', 2);
+    for (auto &client : statistics.clients) {
+        qCInfo(KWAYLAND_SERVER).noquote() << QStringLiteral("  pid %1 %2: %3 requests (%4 bytes), %5 events (%6 bytes), %7 flushes, %8 ms in handlers")
+                                             .arg(client.processId)
+                                             .arg(client.connection ? client.connection->executablePath() : QString())
+                                             .arg(client.requests).arg(client.requestBytes)
+                                             .arg(client.events).arg(client.eventBytes)
+                                             .arg(client.flushes)
+                                             .arg(client.handlerTime / 1000000.0, 0, 'f', 2);
+        std::sort(client.messages.begin(), client.messages.end(),
+            [] (const MessageStatistics &a, const MessageStatistics &b) {
+                return a.count > b.count;
+            }
+        );
+        // the most frequent messages are usually enough to tell what the client is doing
+        for (int i = 0; i < qMin(5, client.messages.count()); ++i) {
+            const auto &message = client.messages.at(i);
+            qCInfo(KWAYLAND_SERVER).noquote() << QStringLiteral("    %1.%2 %3: %4 times, %5 bytes, %6 ms")
+                                                 .arg(QString::fromLatin1(message.interface))
+                                                 .arg(QString::fromLatin1(message.message))
+                                                 .arg(message.event ? QStringLiteral("event") : QStringLiteral("request"))
+                                                 .arg(message.count).arg(message.bytes)
+                                                 .arg(message.handlerTime / 1000000.0, 0, 'f', 2);
+        }
+    }
+}
+
+void Display::Private::logMessage(wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    const bool event = type == WL_PROTOCOL_LOGGER_EVENT;
+    wl_client *client = wl_resource_get_client(message->resource);
+    if (!statisticsEnabled) {
+        // only installed for the request budgets
+        if (!event) {
+            clientCounters(client)->dispatchRequests++;
+        }
+        return;
+    }
+    const qint64 now = statisticsTimer.nsecsElapsed();
+    if (!event) {
+        // the previous handler returned once libwayland dispatches the next request
+        finishRequest(now);
+    }
+    ClientCounters *counters = clientCounters(client);
+    if (!event && requestLimits) {
+        counters->dispatchRequests++;
+    }
+    MessageCounter &counter = counters->messages[message->message];
+    if (!counter.interface) {
+        counter.interface = wl_resource_get_class(message->resource);
+        counter.opcode = message->message_opcode;
+        counter.event = event;
+    }
+    const quint32 size = messageSize(message);
+    counter.count++;
+    counter.bytes += size;
+    if (event) {
+        counters->events++;
+        counters->eventBytes += size;
+    } else {
+        counters->requests++;
+        counters->requestBytes += size;
+        requestClient = client;
+        requestMessage = message->message;
+        requestStart = now;
+    }
+}
+
+void Display::Private::finishRequest(qint64 now)
+{
+    if (!requestClient) {
+        return;
+    }
+    if (ClientCounters *counters = clientStatistics.value(requestClient)) {
+        auto it = counters->messages.find(requestMessage);
+        if (it != counters->messages.end()) {
+            const qint64 time = now - requestStart;
+            it->handlerTime += time;
+            counters->handlerTime += time;
+        }
+    }
+    requestClient = nullptr;
+    requestMessage = nullptr;
+}
+
+Display::Private::ClientCounters *Display::Private::clientCounters(wl_client *client)
+{
+    auto it = clientStatistics.constFind(client);
+    if (it != clientStatistics.constEnd()) {
+        return it.value();
+    }
+    ClientCounters *counters = new ClientCounters;
+    counters->client = client;
+    counters->destroyListener.notify = clientDestroyedCallback;
+    wl_client_add_destroy_listener(client, &counters->destroyListener);
+    clientStatistics.insert(client, counters);
+    return counters;
+}
+
+void Display::Private::removeClientCounters(wl_client *client)
+{
+    ClientCounters *counters = clientStatistics.take(client);
+    if (!counters) {
+        return;
+    }
+    wl_list_remove(&counters->destroyListener.link);
+    delete counters;
+    if (requestClient == client) {
+        requestClient = nullptr;
+        requestMessage = nullptr;
+    }
+}
+
+void Display::Private::flushClient(wl_client *client)
+{
+    if (flushPolicy != FlushPolicy::Immediate || throttledClients.contains(client)) {
+        // sent with the next flush of all clients
+        return;
+    }
+    wl_client_flush(client);
+    if (statisticsEnabled && protocolLogger) {
+        clientCounters(client)->flushes++;
+    }
+}
+
+void Display::Private::updateLimits()
+{
+    requestLimits = clientLimits.requestsPerDispatch > 0;
+    queueLimits = clientLimits.queuedBytes > 0;
+    for (ClientConnection *c : qAsConst(clients)) {
+        const auto limits = c->limits();
+        requestLimits = requestLimits || limits.requestsPerDispatch > 0;
+        queueLimits = queueLimits || limits.queuedBytes > 0;
+    }
+    updateProtocolLogger();
+}
+
+void Display::Private::checkRequestBudgets()
+{
+    if (!requestLimits || !protocolLogger) {
+        return;
+    }
+    // getting the ClientConnection and the signals can trigger new messages, so collect first
+    QVector<QPair<wl_client*, int>> dispatched;
+    for (ClientCounters *counters : qAsConst(clientStatistics)) {
+        if (counters->dispatchRequests > 0) {
+            dispatched << qMakePair(counters->client, counters->dispatchRequests);
+            counters->dispatchRequests = 0;
+        }
+    }
+    const qint64 now = limitsTimer.elapsed();
+    QVector<ClientConnection*> abusive;
+    QVector<ClientConnection*> exceeding;
+    for (const auto &requests : qAsConst(dispatched)) {
+        if (!clientStatistics.contains(requests.first)) {
+            // destroyed in the meantime
+            continue;
+        }
+        ClientConnection *connection = q->getConnection(requests.first);
+        const auto limits = connection->limits();
+        if (limits.requestsPerDispatch <= 0 || requests.second <= limits.requestsPerDispatch) {
+            continue;
+        }
+        LimitState &state = limitStates[connection];
+        state.client = requests.first;
+        // floods arrive in bursts, only once the client did not exceed the budget for
+        // a timeout it starts over
+        const qint64 timeout = limits.disconnectTimeout > 0 ? limits.disconnectTimeout : 1000;
+        if (state.requestsExceededSince < 0 || now - state.requestsLastExceeded > timeout) {
+            state.requestsExceededSince = now;
+            exceeding << connection;
+        }
+        state.requestsLastExceeded = now;
+        if (limits.disconnectTimeout > 0 && now - state.requestsExceededSince >= limits.disconnectTimeout) {
+            abusive << connection;
+        }
+    }
+    handleExceededLimits(exceeding, abusive, ClientConnection::Limit::Requests);
+}
+
+void Display::Private::checkQueuedBytes()
+{
+    if (!queueLimits && throttledClients.isEmpty()) {
+        return;
+    }
+    const qint64 now = limitsTimer.elapsed();
+    QVector<ClientConnection*> abusive;
+    QVector<ClientConnection*> exceeding;
+    for (ClientConnection *connection : qAsConst(clients)) {
+        wl_client *client = connection->client();
+        if (!client) {
+            continue;
+        }
+        const auto limits = connection->limits();
+        const int queued = limits.queuedBytes > 0 ? queuedBytes(client) : -1;
+        if (queued < 0 || queued <= limits.queuedBytes) {
+            if (throttledClients.remove(client)) {
+                // the client caught up, send what got queued in the meantime
+                wl_client_flush(client);
+            }
+            auto it = limitStates.find(connection);
+            if (it != limitStates.end()) {
+                it->queueExceededSince = -1;
+            }
+            continue;
+        }
+        LimitState &state = limitStates[connection];
+        state.client = client;
+        throttledClients.insert(client);
+        if (state.queueExceededSince < 0) {
+            state.queueExceededSince = now;
+            exceeding << connection;
+        }
+        if (limits.disconnectTimeout > 0 && now - state.queueExceededSince >= limits.disconnectTimeout) {
+            abusive << connection;
+        }
+    }
+    handleExceededLimits(exceeding, abusive, ClientConnection::Limit::QueuedBytes);
+}
+
+void Display::Private::handleExceededLimits(const QVector<ClientConnection*> &exceeding, const QVector<ClientConnection*> &abusive,
+                                            ClientConnection::Limit limit)
+{
+    if (exceeding.isEmpty() && abusive.isEmpty()) {
+        return;
+    }
+    // the checks run from flushes, which can happen within a request handler of the very client,
+    // so neither the signal nor the disconnect may run before libwayland is done with it
+    QVector<QPointer<ClientConnection>> exceedingConnections;
+    for (ClientConnection *connection : exceeding) {
+        exceedingConnections << connection;
+    }
+    QVector<QPointer<ClientConnection>> abusiveConnections;
+    for (ClientConnection *connection : abusive) {
+        abusiveConnections << connection;
+    }
+    QMetaObject::invokeMethod(q,
+        [this, exceedingConnections, abusiveConnections, limit] {
+            for (const QPointer<ClientConnection> &connection : exceedingConnections) {
+                if (connection && connection->client()) {
+                    emit connection->limitExceeded(limit);
+                }
+            }
+            disconnectClients(abusiveConnections, limit);
+        }, Qt::QueuedConnection
+    );
+}
+
+void Display::Private::disconnectClients(const QVector<QPointer<ClientConnection>> &connections, ClientConnection::Limit limit)
+{
+    for (const QPointer<ClientConnection> &connection : connections) {
+        if (!connection || !connection->client()) {
+            continue;
+        }
+        qCWarning(KWAYLAND_SERVER) << "Disconnecting client" << connection->processId() << connection->executablePath()
+                                   << "which exceeded its budget" << limit;
+        connection->destroy();
+    }
 }
 
 void Display::setSocketName(const QString &name)
@@ -184,6 +779,8 @@ void Display::start(StartMode mode)
     Q_ASSERT(!d->running);
     Q_ASSERT(!d->display);
     d->display = wl_display_create();
+    wl_display_add_client_created_listener(d->display, &d->clientCreatedListener);
+    d->updateProtocolLogger();
     if (mode == StartMode::ConnectToSocket) {
         if (d->automaticSocketNaming) {
             const char *socket = wl_display_add_socket_auto(d->display);
@@ -204,7 +801,11 @@ void Display::start(StartMode mode)
     }
 
     d->loop = wl_display_get_event_loop(d->display);
-    d->installSocketNotifier();
+    if (d->dispatchMode == DispatchMode::DedicatedThread) {
+        d->startDispatchThread();
+    } else {
+        d->installSocketNotifier();
+    }
 }
 
 void Display::startLoop()
@@ -221,7 +822,11 @@ void Display::dispatchEvents(int msecTimeout)
         d->dispatch();
     } else if (d->loop) {
         wl_event_loop_dispatch(d->loop, msecTimeout);
-        wl_display_flush_clients(d->display);
+        if (d->statisticsEnabled && d->protocolLogger) {
+            d->finishRequest(d->statisticsTimer.nsecsElapsed());
+        }
+        d->checkRequestBudgets();
+        d->flush();
     }
 }
 
@@ -230,12 +835,39 @@ void Display::terminate()
     if (!d->running) {
         return;
     }
-    emit aboutToTerminate();
-    wl_display_terminate(d->display);
-    wl_display_destroy(d->display);
-    d->display = nullptr;
-    d->loop = nullptr;
-    d->setRunning(false);
+    if (!d->dispatchThread) {
+        d->terminate();
+        return;
+    }
+    Q_ASSERT(QThread::currentThread() != d->dispatchThread);
+    // the interfaces living in the dispatch thread get destroyed in there on aboutToTerminate
+    QMetaObject::invokeMethod(this,
+        [this] {
+            d->terminate();
+            moveToThread(d->originThread);
+        }, Qt::BlockingQueuedConnection
+    );
+    d->dispatchThread->quit();
+    d->dispatchThread->wait();
+    delete d->dispatchThread;
+    d->dispatchThread = nullptr;
+    d->originThread = nullptr;
+}
+
+void Display::setDispatchMode(DispatchMode mode)
+{
+    Q_ASSERT(!d->running);
+    d->dispatchMode = mode;
+}
+
+Display::DispatchMode Display::dispatchMode() const
+{
+    return d->dispatchMode;
+}
+
+QThread *Display::dispatchThread() const
+{
+    return d->dispatchThread;
 }
 
 void Display::Private::setRunning(bool r)
@@ -247,6 +879,7 @@ void Display::Private::setRunning(bool r)
 
 OutputInterface *Display::createOutput(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     OutputInterface *output = new OutputInterface(this, parent);
     connect(output, &QObject::destroyed, this, [this,output] { d->outputs.removeAll(output); });
     connect(this, &Display::aboutToTerminate, output, [this,output] { removeOutput(output); });
@@ -256,6 +889,7 @@ OutputInterface *Display::createOutput(QObject *parent)
 
 CompositorInterface *Display::createCompositor(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     CompositorInterface *compositor = new CompositorInterface(this, parent);
     connect(this, &Display::aboutToTerminate, compositor, [this,compositor] { delete compositor; });
     return compositor;
@@ -263,6 +897,7 @@ CompositorInterface *Display::createCompositor(QObject *parent)
 
 ShellInterface *Display::createShell(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     ShellInterface *shell = new ShellInterface(this, parent);
     connect(this, &Display::aboutToTerminate, shell, [this,shell] { delete shell; });
     return shell;
@@ -270,6 +905,7 @@ ShellInterface *Display::createShell(QObject *parent)
 
 OutputDeviceInterface *Display::createOutputDevice(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     OutputDeviceInterface *output = new OutputDeviceInterface(this, parent);
     connect(output, &QObject::destroyed, this, [this,output] { d->outputdevices.removeAll(output); });
     connect(this, &Display::aboutToTerminate, output, [this,output] { removeOutputDevice(output); });
@@ -279,6 +915,7 @@ OutputDeviceInterface *Display::createOutputDevice(QObject *parent)
 
 OutputManagementInterface *Display::createOutputManagement(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     OutputManagementInterface *om = new OutputManagementInterface(this, parent);
     connect(this, &Display::aboutToTerminate, om, [this,om] { delete om; });
     return om;
@@ -286,6 +923,7 @@ OutputManagementInterface *Display::createOutputManagement(QObject *parent)
 
 SeatInterface *Display::createSeat(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     SeatInterface *seat = new SeatInterface(this, parent);
     connect(seat, &QObject::destroyed, this, [this, seat] { d->seats.removeAll(seat); });
     connect(this, &Display::aboutToTerminate, seat, [this,seat] { delete seat; });
@@ -295,6 +933,7 @@ SeatInterface *Display::createSeat(QObject *parent)
 
 SubCompositorInterface *Display::createSubCompositor(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto c = new SubCompositorInterface(this, parent);
     connect(this, &Display::aboutToTerminate, c, [this,c] { delete c; });
     return c;
@@ -302,6 +941,7 @@ SubCompositorInterface *Display::createSubCompositor(QObject *parent)
 
 DataDeviceManagerInterface *Display::createDataDeviceManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto m = new DataDeviceManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, m, [this,m] { delete m; });
     return m;
@@ -309,6 +949,7 @@ DataDeviceManagerInterface *Display::createDataDeviceManager(QObject *parent)
 
 PlasmaShellInterface *Display::createPlasmaShell(QObject* parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto s = new PlasmaShellInterface(this, parent);
     connect(this, &Display::aboutToTerminate, s, [this, s] { delete s; });
     return s;
@@ -316,6 +957,7 @@ PlasmaShellInterface *Display::createPlasmaShell(QObject* parent)
 
 PlasmaWindowManagementInterface *Display::createPlasmaWindowManagement(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto wm = new PlasmaWindowManagementInterface(this, parent);
     connect(this, &Display::aboutToTerminate, wm, [this, wm] { delete wm; });
     return wm;
@@ -323,6 +965,7 @@ PlasmaWindowManagementInterface *Display::createPlasmaWindowManagement(QObject *
 
 QtSurfaceExtensionInterface *Display::createQtSurfaceExtension(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto s = new QtSurfaceExtensionInterface(this, parent);
     connect(this, &Display::aboutToTerminate, s, [this, s] { delete s; });
     return s;
@@ -330,6 +973,7 @@ QtSurfaceExtensionInterface *Display::createQtSurfaceExtension(QObject *parent)
 
 RemoteAccessManagerInterface *Display::createRemoteAccessManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto i = new RemoteAccessManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, i, [this, i] { delete i; });
     return i;
@@ -337,6 +981,7 @@ RemoteAccessManagerInterface *Display::createRemoteAccessManager(QObject *parent
 
 IdleInterface *Display::createIdle(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto i = new IdleInterface(this, parent);
     connect(this, &Display::aboutToTerminate, i, [this, i] { delete i; });
     return i;
@@ -344,6 +989,7 @@ IdleInterface *Display::createIdle(QObject *parent)
 
 FakeInputInterface *Display::createFakeInput(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto i = new FakeInputInterface(this, parent);
     connect(this, &Display::aboutToTerminate, i, [this, i] { delete i; });
     return i;
@@ -351,6 +997,7 @@ FakeInputInterface *Display::createFakeInput(QObject *parent)
 
 ShadowManagerInterface *Display::createShadowManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto s = new ShadowManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, s, [this, s] { delete s; });
     return s;
@@ -358,6 +1005,7 @@ ShadowManagerInterface *Display::createShadowManager(QObject *parent)
 
 BlurManagerInterface *Display::createBlurManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto b = new BlurManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, b, [this, b] { delete b; });
     return b;
@@ -365,6 +1013,7 @@ BlurManagerInterface *Display::createBlurManager(QObject *parent)
 
 ContrastManagerInterface *Display::createContrastManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto b = new ContrastManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, b, [this, b] { delete b; });
     return b;
@@ -372,6 +1021,7 @@ ContrastManagerInterface *Display::createContrastManager(QObject *parent)
 
 SlideManagerInterface *Display::createSlideManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto b = new SlideManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, b, [this, b] { delete b; });
     return b;
@@ -379,6 +1029,7 @@ SlideManagerInterface *Display::createSlideManager(QObject *parent)
 
 DpmsManagerInterface *Display::createDpmsManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto d = new DpmsManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, d, [this, d] { delete d; });
     return d;
@@ -386,6 +1037,7 @@ DpmsManagerInterface *Display::createDpmsManager(QObject *parent)
 
 ServerSideDecorationManagerInterface *Display::createServerSideDecorationManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto d = new ServerSideDecorationManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, d, [d] { delete d; });
     return d;
@@ -393,6 +1045,7 @@ ServerSideDecorationManagerInterface *Display::createServerSideDecorationManager
 
 TextInputManagerInterface *Display::createTextInputManager(const TextInputInterfaceVersion &version, QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     TextInputManagerInterface *t = nullptr;
     switch (version) {
     case TextInputInterfaceVersion::UnstableV0:
@@ -410,6 +1063,7 @@ TextInputManagerInterface *Display::createTextInputManager(const TextInputInterf
 
 XdgShellInterface *Display::createXdgShell(const XdgShellInterfaceVersion &version, QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     XdgShellInterface *x = nullptr;
     switch (version) {
     case XdgShellInterfaceVersion::UnstableV5:
@@ -428,6 +1082,7 @@ XdgShellInterface *Display::createXdgShell(const XdgShellInterfaceVersion &versi
 
 RelativePointerManagerInterface *Display::createRelativePointerManager(const RelativePointerInterfaceVersion &version, QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     RelativePointerManagerInterface *r = nullptr;
     switch (version) {
     case RelativePointerInterfaceVersion::UnstableV1:
@@ -440,6 +1095,7 @@ RelativePointerManagerInterface *Display::createRelativePointerManager(const Rel
 
 PointerGesturesInterface *Display::createPointerGestures(const PointerGesturesInterfaceVersion &version, QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     PointerGesturesInterface *p = nullptr;
     switch (version) {
     case PointerGesturesInterfaceVersion::UnstableV1:
@@ -452,6 +1108,7 @@ PointerGesturesInterface *Display::createPointerGestures(const PointerGesturesIn
 
 PointerConstraintsInterface *Display::createPointerConstraints(const PointerConstraintsInterfaceVersion &version, QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     PointerConstraintsInterface *p = nullptr;
     switch (version) {
     case PointerConstraintsInterfaceVersion::UnstableV1:
@@ -464,6 +1121,7 @@ PointerConstraintsInterface *Display::createPointerConstraints(const PointerCons
 
 XdgForeignInterface *Display::createXdgForeignInterface(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     XdgForeignInterface *foreign = new XdgForeignInterface(this, parent);
     connect(this, &Display::aboutToTerminate, foreign, [this,foreign] { delete foreign; });
     return foreign;
@@ -471,6 +1129,7 @@ XdgForeignInterface *Display::createXdgForeignInterface(QObject *parent)
 
 IdleInhibitManagerInterface *Display::createIdleInhibitManager(const IdleInhibitManagerInterfaceVersion &version, QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     IdleInhibitManagerInterface *i = nullptr;
     switch (version) {
     case IdleInhibitManagerInterfaceVersion::UnstableV1:
@@ -483,6 +1142,7 @@ IdleInhibitManagerInterface *Display::createIdleInhibitManager(const IdleInhibit
 
 AppMenuManagerInterface *Display::createAppMenuManagerInterface(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto b = new AppMenuManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, b, [this, b] { delete b; });
     return b;
@@ -490,6 +1150,7 @@ AppMenuManagerInterface *Display::createAppMenuManagerInterface(QObject *parent)
 
 ServerSideDecorationPaletteManagerInterface *Display::createServerSideDecorationPaletteManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto b = new ServerSideDecorationPaletteManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, b, [this, b] { delete b; });
     return b;
@@ -497,6 +1158,7 @@ ServerSideDecorationPaletteManagerInterface *Display::createServerSideDecoration
 
 LinuxDmabufUnstableV1Interface *Display::createLinuxDmabufInterface(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto b = new LinuxDmabufUnstableV1Interface(this, parent);
     connect(this, &Display::aboutToTerminate, b, [this, b] { delete b; });
     return b;
@@ -504,6 +1166,7 @@ LinuxDmabufUnstableV1Interface *Display::createLinuxDmabufInterface(QObject *par
 
 PlasmaVirtualDesktopManagementInterface *Display::createPlasmaVirtualDesktopManagement(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto b = new PlasmaVirtualDesktopManagementInterface(this, parent);
     connect(this, &Display::aboutToTerminate, b, [this, b] { delete b; });
     return b;
@@ -511,6 +1174,7 @@ PlasmaVirtualDesktopManagementInterface *Display::createPlasmaVirtualDesktopMana
 
 XdgOutputManagerInterface *Display::createXdgOutputManager(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto b = new XdgOutputManagerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, b, [this, b] { delete b; });
     return b;
@@ -518,6 +1182,7 @@ XdgOutputManagerInterface *Display::createXdgOutputManager(QObject *parent)
 
 XdgDecorationManagerInterface *Display::createXdgDecorationManager(XdgShellInterface *shellInterface, QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto d = new XdgDecorationManagerInterface(this, shellInterface, parent);
     connect(this, &Display::aboutToTerminate, d, [d] { delete d; });
     return d;
@@ -525,6 +1190,7 @@ XdgDecorationManagerInterface *Display::createXdgDecorationManager(XdgShellInter
 
 EglStreamControllerInterface *Display::createEglStreamControllerInterface(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     EglStreamControllerInterface *e = new EglStreamControllerInterface(this, parent);
     connect(this, &Display::aboutToTerminate, e, [e] { delete e; });
     return e;
@@ -532,6 +1198,7 @@ EglStreamControllerInterface *Display::createEglStreamControllerInterface(QObjec
 
 KeyStateInterface *Display::createKeyStateInterface(QObject *parent)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     auto d = new KeyStateInterface(this, parent);
     connect(this, &Display::aboutToTerminate, d, [d] { delete d; });
     return d;
@@ -539,6 +1206,7 @@ KeyStateInterface *Display::createKeyStateInterface(QObject *parent)
 
 void Display::createShm()
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     Q_ASSERT(d->display);
     wl_display_init_shm(d->display);
 }
@@ -609,12 +1277,18 @@ ClientConnection *Display::getConnection(wl_client *client)
     // no ConnectionData yet, create it
     auto c = new ClientConnection(client, this);
     d->clients << c;
+    c->setLimits(d->clientLimits);
     connect(c, &ClientConnection::disconnected, this,
         [this] (ClientConnection *c) {
             const int index = d->clients.indexOf(c);
             Q_ASSERT(index != -1);
             d->clients.remove(index);
             Q_ASSERT(d->clients.indexOf(c) == -1);
+            auto it = d->limitStates.find(c);
+            if (it != d->limitStates.end()) {
+                d->throttledClients.remove(it->client);
+                d->limitStates.erase(it);
+            }
             emit clientDisconnected(c);
         }
     );
@@ -627,8 +1301,122 @@ QVector< ClientConnection* > Display::connections() const
     return d->clients;
 }
 
+void Display::setStatisticsEnabled(bool enabled)
+{
+    if (d->statisticsEnabled == enabled) {
+        return;
+    }
+    d->statisticsEnabled = enabled;
+    d->resetStatistics();
+    d->updateProtocolLogger();
+    d->updateStatisticsDumpTimer();
+}
+
+bool Display::isStatisticsEnabled() const
+{
+    return d->statisticsEnabled;
+}
+
+Display::Statistics Display::statistics() const
+{
+    Statistics statistics;
+    if (!d->statisticsEnabled) {
+        return statistics;
+    }
+    statistics.flushes = d->flushes;
+    statistics.dispatchTime = d->dispatchTime;
+    for (auto counters : qAsConst(d->clientStatistics)) {
+        ClientStatistics client;
+        auto it = std::find_if(d->clients.constBegin(), d->clients.constEnd(),
+            [counters] (ClientConnection *c) {
+                return c->client() == counters->client;
+            }
+        );
+        if (it != d->clients.constEnd()) {
+            client.connection = *it;
+        }
+        wl_client_get_credentials(counters->client, &client.processId, nullptr, nullptr);
+        client.requests = counters->requests;
+        client.requestBytes = counters->requestBytes;
+        client.events = counters->events;
+        client.eventBytes = counters->eventBytes;
+        client.flushes = counters->flushes;
+        client.handlerTime = counters->handlerTime;
+        for (auto message = counters->messages.constBegin(); message != counters->messages.constEnd(); ++message) {
+            const Private::MessageCounter &counter = message.value();
+            MessageStatistics m;
+            m.interface = QByteArray(counter.interface);
+            m.message = QByteArray(message.key()->name);
+            m.opcode = counter.opcode;
+            m.event = counter.event;
+            m.count = counter.count;
+            m.bytes = counter.bytes;
+            m.handlerTime = counter.handlerTime;
+            client.messages << m;
+        }
+        statistics.clients << client;
+    }
+    return statistics;
+}
+
+void Display::resetStatistics()
+{
+    d->resetStatistics();
+}
+
+void Display::flushClient(wl_client *client)
+{
+    d->flushClient(client);
+}
+
+void Display::setFlushPolicy(FlushPolicy policy)
+{
+    d->flushPolicy = policy;
+}
+
+Display::FlushPolicy Display::flushPolicy() const
+{
+    return d->flushPolicy;
+}
+
+void Display::flushClients()
+{
+    d->flush();
+}
+
+void Display::clientLimitsChanged()
+{
+    d->updateLimits();
+}
+
+void Display::setClientLimits(const ClientConnection::Limits &limits)
+{
+    d->clientLimits = limits;
+    for (ClientConnection *c : qAsConst(d->clients)) {
+        c->setLimits(limits);
+    }
+    d->updateLimits();
+}
+
+ClientConnection::Limits Display::clientLimits() const
+{
+    return d->clientLimits;
+}
+
+void Display::setStatisticsDumpInterval(int msec)
+{
+    d->statisticsDumpInterval = qMax(0, msec);
+    d->updateStatisticsDumpTimer();
+}
+
+int Display::statisticsDumpInterval() const
+{
+    return d->statisticsDumpInterval;
+}
+
 ClientConnection *Display::createClient(int fd)
 {
+    Q_ASSERT(QThread::currentThread() == thread());
     Q_ASSERT(fd != -1);
     Q_ASSERT(d->display);
     wl_client *c = wl_client_create(d->display, fd);
@@ -23,11 +23,14 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QList>
 #include <QObject>
+#include <QVector>
 
 #include <KWayland/Server/kwaylandserver_export.h>
 
 #include "clientconnection.h"
 
+class QThread;
+
 struct wl_client;
 struct wl_display;
 struct wl_event_loop;
@@ -139,6 +142,93 @@ public:
     };
     void start(StartMode mode = StartMode::ConnectToSocket);
     void terminate();
+    /**
+     * Where the Wayland event loop gets dispatched and the clients get flushed.
+     * @li EventLoop: through the Qt event loop of the thread the Display got started in
+     * @li DedicatedThread: in dispatchThread, a thread owned by the Display
+     * @see setDispatchMode
+     * @since 5.68
+     **/
+    enum class DispatchMode {
+        EventLoop,
+        DedicatedThread
+    };
+    /**
+     * Sets how the Display dispatches the Wayland event loop, has to be called before start.
+     * The default is DispatchMode::EventLoop.
+     *
+     * With DispatchMode::DedicatedThread start moves the Display to dispatchThread, so
+     * a long paint or another blocking operation in the compositor's thread does not
+     * delay dispatching the requests and flushing the events. All requests are handled
+     * and all signals of the Display, the ClientConnections and the interfaces are
+     * emitted in dispatchThread. Thus the Display, except for terminate, and the interfaces
+     * may only be used from that thread and the interfaces have to be created in there.
+     * The compositor exchanges state with them through queued connections, e.g. for
+     * committed surface states and input events.
+     *
+     * The Display needs to be started and terminated from the thread it got created
+     * in and may not have a parent in this mode. Once terminated it is moved back to
+     * the thread it got started from.
+     *
+     * @see dispatchMode
+     * @see dispatchThread
+     * @since 5.68
+     **/
+    void setDispatchMode(DispatchMode mode);
+    /**
+     * @see setDispatchMode
+     * @since 5.68
+     **/
+    DispatchMode dispatchMode() const;
+    /**
+     * @returns The thread dispatching the Wayland event loop while the Display is running
+     * with DispatchMode::DedicatedThread, otherwise @c nullptr.
+     * @see setDispatchMode
+     * @since 5.68
+     **/
+    QThread *dispatchThread() const;
+
+    /**
+     * When the events queued for the clients get written to their sockets.
+     * @li Immediate: whenever an interface flushes a client, e.g. after an input event, and
+     * once per event loop iteration
+     * @li EventLoop: once per event loop iteration, before the event loop blocks
+     * @li Explicit: only in flushClients, e.g. called by the compositor after each repaint
+     * @see setFlushPolicy
+     * @since 5.68
+     **/
+    enum class FlushPolicy {
+        Immediate,
+        EventLoop,
+        Explicit
+    };
+    /**
+     * Sets when the events get written to the clients, the default is FlushPolicy::Immediate.
+     *
+     * Flushing a client costs a syscall, with FlushPolicy::Immediate a burst of input events
+     * or buffer releases results in many small writes. The other policies batch them, at the
+     * cost of delaying the events until the end of the event loop iteration or the next
+     * flushClients. Independent of the policy libwayland writes the events of a client once
+     * its buffer is full.
+     *
+     * @see flushPolicy
+     * @see flushClients
+     * @see ClientConnection::flush
+     * @since 5.68
+     **/
+    void setFlushPolicy(FlushPolicy policy);
+    /**
+     * @see setFlushPolicy
+     * @since 5.68
+     **/
+    FlushPolicy flushPolicy() const;
+    /**
+     * Writes the events queued for all clients to their sockets. With FlushPolicy::Explicit
+     * this has to be called regularly, e.g. after each repaint.
+     * @see setFlushPolicy
+     * @since 5.68
+     **/
+    void flushClients();
     /**
      * Starts the event loop for the server socket.
      * This method should only be used if start() is used before creating the
@@ -333,6 +423,144 @@ public:
     ClientConnection *getConnection(wl_client *client);
     QVector<ClientConnection*> connections() const;
 
+    /**
+     * Counters of one request or event of an interface.
+     * @see ClientStatistics
+     * @since 5.68
+     **/
+    struct MessageStatistics {
+        /**
+         * The name of the interface, e.g. wl_surface
+         **/
+        QByteArray interface;
+        /**
+         * The name of the request or event, e.g. commit
+         **/
+        QByteArray message;
+        quint32 opcode = 0;
+        /**
+         * @c true for events sent to the client, @c false for requests of the client
+         **/
+        bool event = false;
+        quint64 count = 0;
+        /**
+         * The size of the messages on the wire, file descriptors are not included
+         **/
+        quint64 bytes = 0;
+        /**
+         * Nanoseconds spent in the handlers of the requests, @c 0 for events
+         **/
+        qint64 handlerTime = 0;
+    };
+    /**
+     * Counters of all messages exchanged with one client.
+     * @see Statistics
+     * @since 5.68
+     **/
+    struct ClientStatistics {
+        /**
+         * The ClientConnection of the client, @c null if none got created yet
+         **/
+        ClientConnection *connection = nullptr;
+        pid_t processId = 0;
+        quint64 requests = 0;
+        quint64 requestBytes = 0;
+        quint64 events = 0;
+        quint64 eventBytes = 0;
+        /**
+         * How often the connection got flushed through ClientConnection::flush
+         **/
+        quint64 flushes = 0;
+        /**
+         * Nanoseconds spent in the handlers of all requests
+         **/
+        qint64 handlerTime = 0;
+        QVector<MessageStatistics> messages;
+    };
+    /**
+     * @see statistics
+     * @since 5.68
+     **/
+    struct Statistics {
+        /**
+         * How often the connections to all clients got flushed
+         **/
+        quint64 flushes = 0;
+        /**
+         * Nanoseconds spent dispatching the Wayland event loop
+         **/
+        qint64 dispatchTime = 0;
+        /**
+         * The connected clients which sent or received a message
+         **/
+        QVector<ClientStatistics> clients;
+    };
+
+    /**
+     * Enables counting the requests and events exchanged with the clients, disabled by default.
+     *
+     * The messages are counted through a protocol logger, thus only use it when needed
+     * for finding out which client or interface causes load on the server. Disabling
+     * discards all counters.
+     *
+     * The time of a request is taken until the next request is dispatched or the
+     * event loop dispatch ends. It includes the events sent by the handler, but also
+     * reading the next request from the client, so it is an approximation.
+     *
+     * @see statistics
+     * @see setStatisticsDumpInterval
+     * @since 5.68
+     **/
+    void setStatisticsEnabled(bool enabled);
+    /**
+     * @see setStatisticsEnabled
+     * @since 5.68
+     **/
+    bool isStatisticsEnabled() const;
+    /**
+     * @returns The counters collected since statistics got enabled or resetStatistics got called.
+     * The counters of a client are discarded once it disconnects.
+     * @see setStatisticsEnabled
+     * @since 5.68
+     **/
+    Statistics statistics() const;
+    /**
+     * Sets all counters of statistics to @c 0.
+     * @since 5.68
+     **/
+    void resetStatistics();
+    /**
+     * Logs the statistics every @p msec milliseconds to the kwayland-server logging category
+     * with info severity, listing the clients with the most requests first. @c 0, the default,
+     * disables logging. Has no effect while statistics are not enabled.
+     * @see setStatisticsEnabled
+     * @since 5.68
+     **/
+    void setStatisticsDumpInterval(int msec);
+    /**
+     * @see setStatisticsDumpInterval
+     * @since 5.68
+     **/
+    int statisticsDumpInterval() const;
+
+    /**
+     * Sets the budgets of all connected clients and the default for clients connecting later.
+     *
+     * The requests budget is checked after each dispatch of the event loop, the queued
+     * bytes budget on each flush. A client exceeding its queued bytes is not flushed
+     * until it read its socket, so it cannot stall flushing the other clients.
+     *
+     * @see ClientConnection::setLimits
+     * @see clientLimits
+     * @since 5.68
+     **/
+    void setClientLimits(const ClientConnection::Limits &limits);
+    /**
+     * @see setClientLimits
+     * @since 5.68
+     **/
+    ClientConnection::Limits clientLimits() const;
+
     /**
      * Set the EGL @p display for this Wayland display.
      * The EGLDisplay can only be set once and must be alive as long as the Wayland display
@@ -359,6 +587,9 @@ Q_SIGNALS:
     void clientDisconnected(KWayland::Server::ClientConnection*);
 
 private:
+    friend class ClientConnection;
+    void flushClient(wl_client *client);
+    void clientLimitsChanged();
     class Private;
     QScopedPointer<Private> d;
 };
@@ -20,6 +20,8 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "global.h"
 #include "global_p.h"
 #include "display.h"
+// Qt
+#include <QThread>
 // wayland
 #include <wayland-server.h>
 
@@ -46,6 +48,8 @@ void Global::Private::bind(wl_client *client, void *data, uint32_t version, uint
 void Global::Private::create()
 {
     Q_ASSERT(!global);
+    // with a dispatch thread the globals have to be created in there
+    Q_ASSERT(QThread::currentThread() == display->thread());
     global = wl_global_create(*display, m_interface, m_version, this, bind);
 }
 
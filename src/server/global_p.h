@@ -47,7 +47,8 @@ protected:
     static void bind(wl_client *client, void *data, uint32_t version, uint32_t id);
 
     const wl_interface *const m_interface;
-    const quint32 m_version;
+    // the version announced by create()
+    quint32 m_version;
 };
 
 }
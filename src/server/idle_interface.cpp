@@ -23,9 +23,13 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "resource_p.h"
 #include "seat_interface.h"
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
 #include <QTimer>
 
 #include <functional>
+#include <map>
 #include <wayland-server.h>
 #include <wayland-idle-server-protocol.h>
 
@@ -42,6 +46,34 @@ public:
     int inhibitCount = 0;
     QVector<IdleTimeoutInterface*> idleTimeouts;
 
+    /**
+     * The idle engine.
+     *
+     * Instead of a timer per IdleTimeoutInterface, which would have to be restarted on each
+     * input event, only the time of the last activity is recorded. A single timer fires for
+     * the earliest deadline in a sorted set. Deadlines are updated lazily: when one expires
+     * the real deadline is computed from the recorded activity, and only if it passed the
+     * IdleTimeoutInterface becomes idle. Thus an input event costs the same, no matter how
+     * many idle timeouts exist.
+     **/
+    void addTimeout(IdleTimeoutInterface *timeout);
+    void removeTimeout(IdleTimeoutInterface *timeout);
+    void timeoutActivity(IdleTimeoutInterface *timeout);
+    void seatActivity(SeatInterface *seat);
+    void globalActivity();
+    void inhibitedChanged();
+
+    QElapsedTimer clock;
+    QTimer *timer = nullptr;
+    qint64 lastGlobalActivity = 0;
+    struct Seat {
+        qint64 lastActivity = 0;
+        // the idle timeouts for this seat which sent idle and wait for the user to resume
+        QVector<IdleTimeoutInterface*> idle;
+    };
+    QHash<SeatInterface*, Seat> seats;
+    std::multimap<qint64, IdleTimeoutInterface*> deadlines;
+
 private:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
     static void getIdleTimeoutCallback(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *seat, uint32_t timeout);
@@ -51,6 +83,13 @@ private:
         return reinterpret_cast<Private*>(wl_resource_get_user_data(r));
     }
 
+    qint64 activity(IdleTimeoutInterface *timeout) const;
+    void schedule(IdleTimeoutInterface *timeout, qint64 deadline);
+    void unschedule(IdleTimeoutInterface *timeout);
+    void resume(IdleTimeoutInterface *timeout);
+    void processDeadlines();
+    void startTimer();
+
     IdleInterface *q;
     static const struct org_kde_kwin_idle_interface s_interface;
     static const quint32 s_version;
@@ -63,10 +102,14 @@ public:
     ~Private();
     void setup(quint32 timeout);
 
-    void simulateUserActivity();
-
     SeatInterface *seat;
-    QTimer *timer = nullptr;
+    QPointer<IdleInterface> manager;
+    bool configured = false;
+    qint64 timeout = 0;
+    qint64 lastActivity = 0;
+    bool idle = false;
+    bool scheduled = false;
+    std::multimap<qint64, IdleTimeoutInterface*>::iterator deadline;
 
 private:
     static void simulateUserActivityCallback(wl_client *client, wl_resource *resource);
@@ -104,9 +147,207 @@ void IdleInterface::Private::getIdleTimeoutCallback(wl_client *client, wl_resour
     }
     p->idleTimeouts << idleTimeout;
     QObject::connect(idleTimeout, &IdleTimeoutInterface::aboutToBeUnbound, p->q, [p, idleTimeout]() {
-        p->idleTimeouts.removeOne(idleTimeout);
+        p->removeTimeout(idleTimeout);
     });
     idleTimeout->d_func()->setup(timeout);
+    p->addTimeout(idleTimeout);
+}
+
+qint64 IdleInterface::Private::activity(IdleTimeoutInterface *timeout) const
+{
+    auto t = timeout->d_func();
+    return qMax(qMax(t->lastActivity, lastGlobalActivity), seats.value(t->seat).lastActivity);
+}
+
+void IdleInterface::Private::schedule(IdleTimeoutInterface *timeout, qint64 deadline)
+{
+    auto t = timeout->d_func();
+    unschedule(timeout);
+    t->deadline = deadlines.emplace(deadline, timeout);
+    t->scheduled = true;
+    if (t->deadline == deadlines.begin()) {
+        startTimer();
+    }
+}
+
+void IdleInterface::Private::unschedule(IdleTimeoutInterface *timeout)
+{
+    auto t = timeout->d_func();
+    if (!t->scheduled) {
+        return;
+    }
+    deadlines.erase(t->deadline);
+    t->scheduled = false;
+}
+
+void IdleInterface::Private::startTimer()
+{
+    if (deadlines.empty()) {
+        timer->stop();
+        return;
+    }
+    timer->start(int(qMax(deadlines.begin()->first - clock.elapsed(), qint64(0))));
+}
+
+void IdleInterface::Private::addTimeout(IdleTimeoutInterface *timeout)
+{
+    auto t = timeout->d_func();
+    SeatInterface *seat = t->seat;
+    if (!seats.contains(seat)) {
+        seats.insert(seat, Seat());
+        QObject::connect(seat, &SeatInterface::timestampChanged, q,
+            [this, seat] {
+                seatActivity(seat);
+            }
+        );
+        QObject::connect(seat, &QObject::destroyed, q,
+            [this, seat] {
+                seats.remove(seat);
+            }
+        );
+    }
+    t->lastActivity = clock.elapsed();
+    if (q->isInhibited()) {
+        // don't start if inhibited
+        return;
+    }
+    schedule(timeout, t->lastActivity + t->timeout);
+}
+
+void IdleInterface::Private::removeTimeout(IdleTimeoutInterface *timeout)
+{
+    idleTimeouts.removeOne(timeout);
+    auto t = timeout->d_func();
+    unschedule(timeout);
+    if (t->idle) {
+        auto it = seats.find(t->seat);
+        if (it != seats.end()) {
+            it.value().idle.removeOne(timeout);
+        }
+    }
+    t->manager.clear();
+}
+
+void IdleInterface::Private::resume(IdleTimeoutInterface *timeout)
+{
+    auto t = timeout->d_func();
+    t->idle = false;
+    if (t->resource) {
+        org_kde_kwin_idle_timeout_send_resumed(t->resource);
+    }
+    schedule(timeout, activity(timeout) + t->timeout);
+}
+
+void IdleInterface::Private::timeoutActivity(IdleTimeoutInterface *timeout)
+{
+    if (q->isInhibited()) {
+        // ignored while inhibited
+        return;
+    }
+    auto t = timeout->d_func();
+    t->lastActivity = clock.elapsed();
+    if (t->idle) {
+        auto it = seats.find(t->seat);
+        if (it != seats.end()) {
+            it.value().idle.removeOne(timeout);
+        }
+        resume(timeout);
+    }
+}
+
+void IdleInterface::Private::seatActivity(SeatInterface *seat)
+{
+    if (q->isInhibited()) {
+        // ignored while inhibited
+        return;
+    }
+    auto it = seats.find(seat);
+    if (it == seats.end()) {
+        return;
+    }
+    it.value().lastActivity = clock.elapsed();
+    if (it.value().idle.isEmpty()) {
+        // the common case: nothing is idle, the deadlines get updated once they expire
+        return;
+    }
+    const auto idle = std::move(it.value().idle);
+    it.value().idle.clear();
+    for (auto timeout : idle) {
+        resume(timeout);
+    }
+}
+
+void IdleInterface::Private::globalActivity()
+{
+    if (q->isInhibited()) {
+        return;
+    }
+    lastGlobalActivity = clock.elapsed();
+    for (auto it = seats.begin(); it != seats.end(); ++it) {
+        const auto idle = std::move(it.value().idle);
+        it.value().idle.clear();
+        for (auto timeout : idle) {
+            resume(timeout);
+        }
+    }
+}
+
+void IdleInterface::Private::inhibitedChanged()
+{
+    if (q->isInhibited()) {
+        // idle timeouts are resumed and don't expire while inhibited
+        for (auto it = seats.begin(); it != seats.end(); ++it) {
+            for (auto timeout : qAsConst(it.value().idle)) {
+                auto t = timeout->d_func();
+                t->idle = false;
+                if (t->resource) {
+                    org_kde_kwin_idle_timeout_send_resumed(t->resource);
+                }
+            }
+            it.value().idle.clear();
+        }
+        for (auto timeout : qAsConst(idleTimeouts)) {
+            unschedule(timeout);
+        }
+        timer->stop();
+        return;
+    }
+    // restart all idle timeouts
+    lastGlobalActivity = clock.elapsed();
+    for (auto timeout : qAsConst(idleTimeouts)) {
+        auto t = timeout->d_func();
+        if (!t->configured) {
+            continue;
+        }
+        schedule(timeout, lastGlobalActivity + t->timeout);
+    }
+}
+
+void IdleInterface::Private::processDeadlines()
+{
+    const qint64 now = clock.elapsed();
+    while (!deadlines.empty() && deadlines.begin()->first <= now) {
+        IdleTimeoutInterface *timeout = deadlines.begin()->second;
+        auto t = timeout->d_func();
+        deadlines.erase(deadlines.begin());
+        t->scheduled = false;
+        const qint64 deadline = activity(timeout) + t->timeout;
+        if (deadline > now) {
+            // there was activity since the deadline got scheduled
+            t->deadline = deadlines.emplace(deadline, timeout);
+            t->scheduled = true;
+            continue;
+        }
+        t->idle = true;
+        auto it = seats.find(t->seat);
+        if (it != seats.end()) {
+            it.value().idle << timeout;
+        }
+        if (t->resource) {
+            org_kde_kwin_idle_timeout_send_idle(t->resource);
+        }
+    }
+    startTimer();
 }
 
 void IdleInterface::Private::bind(wl_client *client, uint32_t version, uint32_t id)
@@ -129,9 +370,21 @@ void IdleInterface::Private::unbind(wl_resource *resource)
 IdleInterface::IdleInterface(Display *display, QObject *parent)
     : Global(new Private(this, display), parent)
 {
+    Q_D();
+    d->clock.start();
+    d->timer = new QTimer(this);
+    d->timer->setSingleShot(true);
+    connect(d->timer, &QTimer::timeout, this, [d] { d->processDeadlines(); });
+    connect(this, &IdleInterface::inhibitedChanged, this, [d] { d->inhibitedChanged(); });
 }
 
-IdleInterface::~IdleInterface() = default;
+IdleInterface::~IdleInterface()
+{
+    Q_D();
+    for (auto timeout : qAsConst(d->idleTimeouts)) {
+        timeout->d_func()->manager.clear();
+    }
+}
 
 void IdleInterface::inhibit()
 {
@@ -160,9 +413,7 @@ bool IdleInterface::isInhibited() const
 void IdleInterface::simulateUserActivity()
 {
     Q_D();
-    for (auto i : qAsConst(d->idleTimeouts)) {
-        i->d_func()->simulateUserActivity();
-    }
+    d->globalActivity();
 }
 
 IdleInterface::Private *IdleInterface::d_func() const
@@ -180,6 +431,7 @@ const struct org_kde_kwin_idle_timeout_interface IdleTimeoutInterface::Private::
 IdleTimeoutInterface::Private::Private(SeatInterface *seat, IdleTimeoutInterface *q, IdleInterface *manager, wl_resource *parentResource)
     : Resource::Private(q, manager, parentResource, &org_kde_kwin_idle_timeout_interface, &s_interface)
     , seat(seat)
+    , manager(manager)
 {
 }
 
@@ -189,77 +441,34 @@ void IdleTimeoutInterface::Private::simulateUserActivityCallback(wl_client *clie
 {
     Q_UNUSED(client);
     Private *p = reinterpret_cast<Private*>(wl_resource_get_user_data(resource));
-    p->simulateUserActivity();
-}
-
-void IdleTimeoutInterface::Private::simulateUserActivity()
-{
-    if (!timer) {
-        // not yet configured
+    if (!p->configured || !p->manager) {
         return;
     }
-    if (qobject_cast<IdleInterface*>(global)->isInhibited()) {
-        // ignored while inhibited
-        return;
-    }
-    if (!timer->isActive() && resource) {
-        org_kde_kwin_idle_timeout_send_resumed(resource);
-    }
-    timer->start();
+    p->manager->d_func()->timeoutActivity(p->q_func());
 }
 
 void IdleTimeoutInterface::Private::setup(quint32 timeout)
 {
-    if (timer) {
+    if (configured) {
         return;
     }
-    timer = new QTimer(q);
-    timer->setSingleShot(true);
+    configured = true;
     // less than 5 sec is not idle by definition
-    timer->setInterval(qMax(timeout, 5000u));
-    QObject::connect(timer, &QTimer::timeout, q,
-        [this] {
-            if (resource) {
-                org_kde_kwin_idle_timeout_send_idle(resource);
-            }
-        }
-    );
-    if (qobject_cast<IdleInterface*>(global)->isInhibited()) {
-        // don't start if inhibited
-        return;
-    }
-    timer->start();
+    this->timeout = qMax(timeout, 5000u);
 }
 
 IdleTimeoutInterface::IdleTimeoutInterface(SeatInterface *seat, IdleInterface *parent, wl_resource *parentResource)
     : Resource(new Private(seat, this, parent, parentResource))
 {
-    connect(seat, &SeatInterface::timestampChanged, this,
-        [this] {
-            Q_D();
-            d->simulateUserActivity();
-        }
-    );
-    connect(parent, &IdleInterface::inhibitedChanged, this,
-        [this] {
-            Q_D();
-            if (!d->timer) {
-                // not yet configured
-                return;
-            }
-            if (qobject_cast<IdleInterface*>(d->global)->isInhibited()) {
-                if (!d->timer->isActive() && d->resource) {
-                    org_kde_kwin_idle_timeout_send_resumed(d->resource);
-                }
-                d->timer->stop();
-            } else {
-                d->timer->start();
-            }
-        }
-    );
 }
 
-IdleTimeoutInterface::~IdleTimeoutInterface() = default;
+IdleTimeoutInterface::~IdleTimeoutInterface()
+{
+    Q_D();
+    if (d->manager) {
+        d->manager->d_func()->removeTimeout(this);
+    }
+}
 
 IdleTimeoutInterface::Private *IdleTimeoutInterface::d_func() const
 {
@@ -116,6 +116,7 @@ Q_SIGNALS:
 private:
     explicit IdleInterface(Display *display, QObject *parent = nullptr);
     friend class Display;
+    friend class IdleTimeoutInterface;
     class Private;
     Private *d_func() const;
 };
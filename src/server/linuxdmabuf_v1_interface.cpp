@@ -25,6 +25,8 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "drm_fourcc.h"
 #include "global_p.h"
+#include "logging.h"
+#include "sealedfile_p.h"
 #include "wayland-linux-dmabuf-unstable-v1-server-protocol.h"
 #include "wayland-server-protocol.h"
 
@@ -32,10 +34,18 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QVector>
 
+#include <algorithm>
 #include <array>
 #include <assert.h>
 #include <unistd.h>
 
+// version 4 adds the dmabuf feedback, only available with newer wayland-protocols
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+#define KWAYLAND_LINUX_DMABUF_FEEDBACK 1
+#else
+#define KWAYLAND_LINUX_DMABUF_FEEDBACK 0
+#endif
+
 namespace KWayland
 {
 namespace Server
@@ -109,17 +119,49 @@ public:
     ~Private();
 
     static const struct wl_buffer_interface *bufferImplementation() { return &s_bufferImplementation; }
-    V1Iface::Impl *impl;
-    QHash<uint32_t, QSet<uint64_t> > supportedFormatsWithModifiers;
+    V1Iface::Impl *impl = nullptr;
     V1Iface * const q;
     static const uint32_t s_version;
 
+    /**
+     * An entry of the format table, laid out as the zwp_linux_dmabuf_feedback_v1
+     * format table so the table can be shared with clients as is.
+     **/
+    struct FormatModifier {
+        uint32_t format;
+        uint32_t padding;
+        uint64_t modifier;
+    };
+    static_assert(sizeof(FormatModifier) == 16, "format table entries are 16 bytes");
+    void setFormats(const QHash<uint32_t, QSet<uint64_t>> &formats);
+
+    // sorted by format and modifier
+    QVector<FormatModifier> formatTable;
+    // the formats for version 1 and 2, which only know implicit modifiers
+    QVector<uint32_t> implicitFormats;
+
     void bind(wl_client *client, uint32_t version, uint32_t id) override final;
     void createParams(wl_client *client, wl_resource *resource, uint32_t id);
 
     static void unbind(wl_client *client, wl_resource *resource);
     static void createParamsCallback(wl_client *client, wl_resource *resource, uint32_t id);
 
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    void setMainDevice(dev_t device);
+    void createFeedback(wl_client *client, wl_resource *resource, uint32_t id);
+    void sendFeedback(wl_resource *feedback);
+
+    static void getDefaultFeedbackCallback(wl_client *client, wl_resource *resource, uint32_t id);
+    static void getSurfaceFeedbackCallback(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *surface);
+
+    // the format table as sealed file, created when first needed
+    int formatTableFd = -1;
+    // version 4 is only announced with a main device, the feedback cannot do without
+    dev_t mainDevice = 0;
+    QVector<wl_resource *> feedbacks;
+    static const struct zwp_linux_dmabuf_feedback_v1_interface s_feedbackImplementation;
+#endif
+
 private:
     class Params
     {
@@ -177,9 +219,19 @@ void V1Iface::Private::Params::createImmed(wl_client *client, wl_resource *resou
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 const struct zwp_linux_dmabuf_v1_interface V1Iface::Private::s_implementation = {
     [](wl_client *, wl_resource *resource) { wl_resource_destroy(resource); }, // unbind
-    createParamsCallback
+    createParamsCallback,
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    getDefaultFeedbackCallback,
+    getSurfaceFeedbackCallback
+#endif
 };
 
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+const struct zwp_linux_dmabuf_feedback_v1_interface V1Iface::Private::s_feedbackImplementation = {
+    [](wl_client *, wl_resource *resource) { wl_resource_destroy(resource); } // destroy
+};
+#endif
+
 const struct wl_buffer_interface V1Iface::Private::s_bufferImplementation = {
     [](wl_client *, wl_resource *resource) { wl_resource_destroy(resource); } // destroy
 };
@@ -419,20 +471,73 @@ void V1Iface::Private::Params::add(wl_client *client, wl_resource *resource,
     params->add(fd, plane_idx, offset, stride, (uint64_t(modifier_hi) << 32) | modifier_lo);
 }
 
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+const uint32_t V1Iface::Private::s_version = 4;
+#else
 const uint32_t V1Iface::Private::s_version = 3;
 #endif
+#endif
 
 V1Iface::Private::Private(V1Iface *q, Display *display)
-    : Global::Private(display, &zwp_linux_dmabuf_v1_interface, s_version),
+    : Global::Private(display, &zwp_linux_dmabuf_v1_interface, std::min(s_version, 3u)),
       q(q)
 {
 }
 
-V1Iface::Private::~Private() = default;
+V1Iface::Private::~Private()
+{
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    // feedbacks may outlive the global, they are not updated anymore
+    for (wl_resource *feedback : qAsConst(feedbacks)) {
+        wl_resource_set_user_data(feedback, nullptr);
+    }
+    if (formatTableFd != -1) {
+        close(formatTableFd);
+    }
+#endif
+}
+
+void V1Iface::Private::setFormats(const QHash<uint32_t, QSet<uint64_t>> &formats)
+{
+    formatTable.clear();
+    implicitFormats.clear();
+    for (auto it = formats.constBegin(); it != formats.constEnd(); ++it) {
+        if (it.value().isEmpty()) {
+            formatTable.append({it.key(), 0, DRM_FORMAT_MOD_INVALID});
+        }
+        for (uint64_t modifier : it.value()) {
+            formatTable.append({it.key(), 0, modifier});
+        }
+    }
+    std::sort(formatTable.begin(), formatTable.end(), [] (const FormatModifier &a, const FormatModifier &b) {
+        return a.format < b.format || (a.format == b.format && a.modifier < b.modifier);
+    });
+    for (const FormatModifier &entry : qAsConst(formatTable)) {
+        if ((entry.modifier == DRM_FORMAT_MOD_LINEAR || entry.modifier == DRM_FORMAT_MOD_INVALID)
+                && (implicitFormats.isEmpty() || implicitFormats.last() != entry.format)) {
+            implicitFormats.append(entry.format);
+        }
+    }
+
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    // tranches reference the table with 16 bit indices
+    if (formatTable.count() > 0xFFFF) {
+        qCWarning(KWAYLAND_SERVER) << "Too many dmabuf formats and modifiers, dropping" << formatTable.count() - 0xFFFF;
+        formatTable.resize(0xFFFF);
+    }
+    if (formatTableFd != -1) {
+        close(formatTableFd);
+        formatTableFd = -1;
+    }
+    for (wl_resource *feedback : qAsConst(feedbacks)) {
+        sendFeedback(feedback);
+    }
+#endif
+}
 
 void V1Iface::Private::bind(wl_client *client, uint32_t version, uint32_t id)
 {
-    wl_resource *resource = wl_resource_create(client, &zwp_linux_dmabuf_v1_interface, std::min(s_version, version), id);
+    wl_resource *resource = wl_resource_create(client, &zwp_linux_dmabuf_v1_interface, std::min(m_version, version), id);
     if (!resource) {
         wl_client_post_no_memory(client);
         return;
@@ -443,26 +548,112 @@ void V1Iface::Private::bind(wl_client *client, uint32_t version, uint32_t id)
     // Send formats & modifiers
     // ------------------------
 
-    QHash<uint32_t, QSet<uint64_t>>::const_iterator it = supportedFormatsWithModifiers.constBegin();
-    while (it != supportedFormatsWithModifiers.constEnd()) {
-        QSet<uint64_t> modifiers = it.value();
-        if (modifiers.isEmpty()) {
-            modifiers << DRM_FORMAT_MOD_INVALID;
+    const uint32_t resourceVersion = wl_resource_get_version(resource);
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    if (resourceVersion >= ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION) {
+        // the format table gets sent with the feedback
+        return;
+    }
+#endif
+    if (resourceVersion >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
+        for (const FormatModifier &entry : qAsConst(formatTable)) {
+            zwp_linux_dmabuf_v1_send_modifier(resource, entry.format, entry.modifier >> 32, entry.modifier & 0xFFFFFFFF);
         }
+    } else {
+        for (uint32_t format : qAsConst(implicitFormats)) {
+            zwp_linux_dmabuf_v1_send_format(resource, format);
+        }
+    }
+}
+
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+void V1Iface::Private::setMainDevice(dev_t device)
+{
+    if (mainDevice == device) {
+        return;
+    }
+    if (global && (m_version < s_version || device == 0)) {
+        // bound clients already know which version got announced
+        qCWarning(KWAYLAND_SERVER) << "The dmabuf main device has to be set before creating the global";
+        return;
+    }
+    mainDevice = device;
+    if (!global) {
+        m_version = device == 0 ? 3 : s_version;
+        return;
+    }
+    for (wl_resource *feedback : qAsConst(feedbacks)) {
+        sendFeedback(feedback);
+    }
+}
 
-        for (uint64_t modifier : qAsConst(modifiers)) {
-            if (version >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
-                const uint32_t modifier_lo = modifier & 0xFFFFFFFF;
-                const uint32_t modifier_hi = modifier >> 32;
-                zwp_linux_dmabuf_v1_send_modifier(resource, it.key(), modifier_hi, modifier_lo);
-            } else if (modifier == DRM_FORMAT_MOD_LINEAR || modifier == DRM_FORMAT_MOD_INVALID) {
-                zwp_linux_dmabuf_v1_send_format(resource, it.key());
+void V1Iface::Private::createFeedback(wl_client *client, wl_resource *resource, uint32_t id)
+{
+    wl_resource *feedback = wl_resource_create(client, &zwp_linux_dmabuf_feedback_v1_interface, wl_resource_get_version(resource), id);
+    if (!feedback) {
+        wl_resource_post_no_memory(resource);
+        return;
+    }
+    wl_resource_set_implementation(feedback, &s_feedbackImplementation, this,
+        [] (wl_resource *feedback) {
+            if (auto p = static_cast<V1Iface::Private *>(wl_resource_get_user_data(feedback))) {
+                p->feedbacks.removeOne(feedback);
             }
         }
-        it++;
+    );
+    feedbacks.append(feedback);
+    sendFeedback(feedback);
+}
+
+void V1Iface::Private::sendFeedback(wl_resource *feedback)
+{
+    if (formatTableFd == -1) {
+        const QByteArray table(reinterpret_cast<const char *>(formatTable.constData()), formatTable.count() * sizeof(FormatModifier));
+        formatTableFd = createSealedFile("kwayland-dmabuf-formats", table);
+        if (formatTableFd == -1) {
+            wl_resource_post_no_memory(feedback);
+            return;
+        }
+    }
+    zwp_linux_dmabuf_feedback_v1_send_format_table(feedback, formatTableFd, formatTable.count() * sizeof(FormatModifier));
+
+    wl_array device;
+    wl_array_init(&device);
+    *static_cast<dev_t *>(wl_array_add(&device, sizeof(dev_t))) = mainDevice;
+    zwp_linux_dmabuf_feedback_v1_send_main_device(feedback, &device);
+
+    // a single tranche with the whole table for the main device
+    wl_array indices;
+    wl_array_init(&indices);
+    uint16_t *index = static_cast<uint16_t *>(wl_array_add(&indices, formatTable.count() * sizeof(uint16_t)));
+    for (int i = 0; i < formatTable.count(); ++i) {
+        index[i] = i;
     }
+    zwp_linux_dmabuf_feedback_v1_send_tranche_target_device(feedback, &device);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_formats(feedback, &indices);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_flags(feedback, 0);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_done(feedback);
+    zwp_linux_dmabuf_feedback_v1_send_done(feedback);
+
+    wl_array_release(&indices);
+    wl_array_release(&device);
+}
+
+void V1Iface::Private::getDefaultFeedbackCallback(wl_client *client, wl_resource *resource, uint32_t id)
+{
+    V1Iface::Private *global = static_cast<V1Iface::Private *>(wl_resource_get_user_data(resource));
+    global->createFeedback(client, resource, id);
 }
 
+void V1Iface::Private::getSurfaceFeedbackCallback(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *surface)
+{
+    // there are no per surface preferences, every surface gets the default feedback
+    Q_UNUSED(surface)
+    V1Iface::Private *global = static_cast<V1Iface::Private *>(wl_resource_get_user_data(resource));
+    global->createFeedback(client, resource, id);
+}
+#endif
+
 void V1Iface::Private::createParams(wl_client *client, wl_resource *resource, uint32_t id)
 {
     Params *params = new Params(this, client, wl_resource_get_version(resource), id);
@@ -493,7 +684,16 @@ void V1Iface::setImpl(V1Iface::Impl *impl)
 
 void V1Iface::setSupportedFormatsWithModifiers(QHash<uint32_t, QSet<uint64_t> > set)
 {
-    d_func()->supportedFormatsWithModifiers = set;
+    d_func()->setFormats(set);
+}
+
+void V1Iface::setMainDevice(dev_t device)
+{
+#if KWAYLAND_LINUX_DMABUF_FEEDBACK
+    d_func()->setMainDevice(device);
+#else
+    Q_UNUSED(device)
+#endif
 }
 
 const struct wl_buffer_interface *V1Iface::bufferImplementation()
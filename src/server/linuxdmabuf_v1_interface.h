@@ -30,6 +30,8 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSet>
 #include <QSize>
 
+#include <sys/types.h>
+
 struct wl_buffer_interface;
 
 namespace KWayland
@@ -151,8 +153,29 @@ public:
      */
     void setImpl(Impl *impl);
 
+    /**
+     * Sets the DRM formats and for each of them the modifiers the compositor can import.
+     * A format without modifiers is announced with DRM_FORMAT_MOD_INVALID.
+     *
+     * The formats are turned into a sorted format table once, which all binding clients
+     * share. Clients using the dmabuf feedback get the table through one sealed file
+     * instead of an event per format and modifier, and are sent the new table when the
+     * formats change.
+     */
     void setSupportedFormatsWithModifiers(QHash<uint32_t, QSet<uint64_t> > set);
 
+    /**
+     * Sets the DRM @p device the compositor uses for compositing.
+     *
+     * It is announced as the main device and the target device of the format table to
+     * clients using the dmabuf feedback, which was added in version 4 of the interface.
+     * Version 4 is only announced if a main device got set before calling create(),
+     * otherwise the interface is capped at version 3. Afterwards the device can only be
+     * replaced by another one.
+     * @since 5.68
+     */
+    void setMainDevice(dev_t device);
+
     /**
      * Returns the LinuxDmabufInterface for the given resource.
      **/
@@ -41,13 +41,25 @@ public:
     ~Private();
     void sendMode(wl_resource *resource, const Mode &mode);
     void sendDone(const ResourceData &data);
+    void flushResources();
     void updateGeometry();
     void updateScale();
+    void updateCurrentMode();
+    void sendUpdate(uint changes);
+
+    enum Change {
+        GeometryChange = 1 << 0,
+        ScaleChange = 1 << 1,
+        ModeChange = 1 << 2
+    };
 
     QSize physicalSize;
     QPoint globalPosition;
     QString manufacturer = QStringLiteral("org.kde.kwin");
     QString model = QStringLiteral("none");
+    // UTF-8 encoded copies of manufacturer and model, sent with every geometry event
+    QByteArray encodedManufacturer = manufacturer.toUtf8();
+    QByteArray encodedModel = model.toUtf8();
     int scale = 1;
     SubPixel subPixel = SubPixel::Unknown;
     Transform transform = Transform::Normal;
@@ -57,6 +69,10 @@ public:
         DpmsMode mode = DpmsMode::On;
         bool supported = false;
     } dpms;
+    struct {
+        int depth = 0;
+        uint pending = 0;
+    } change;
 
     static OutputInterface *get(wl_resource *native);
 
@@ -127,24 +143,22 @@ OutputInterface::OutputInterface(Display *display, QObject *parent)
     : Global(new Private(this, display), parent)
 {
     Q_D();
-    connect(this, &OutputInterface::currentModeChanged, this,
-        [this, d] {
-            auto currentModeIt = std::find_if(d->modes.constBegin(), d->modes.constEnd(), [](const Mode &mode) { return mode.flags.testFlag(ModeFlag::Current); });
-            if (currentModeIt == d->modes.constEnd()) {
-                return;
-            }
-            for (auto it = d->resources.constBegin(); it != d->resources.constEnd(); ++it) {
-                d->sendMode((*it).resource, *currentModeIt);
-                d->sendDone(*it);
-            }
-            wl_display_flush_clients(*(d->display));
-        }
-    );
+    connect(this, &OutputInterface::currentModeChanged,    this, [this, d] { d->updateCurrentMode(); });
     connect(this, &OutputInterface::subPixelChanged,       this, [this, d] { d->updateGeometry(); });
     connect(this, &OutputInterface::transformChanged,      this, [this, d] { d->updateGeometry(); });
     connect(this, &OutputInterface::globalPositionChanged, this, [this, d] { d->updateGeometry(); });
-    connect(this, &OutputInterface::modelChanged,          this, [this, d] { d->updateGeometry(); });
-    connect(this, &OutputInterface::manufacturerChanged,   this, [this, d] { d->updateGeometry(); });
+    connect(this, &OutputInterface::modelChanged,          this,
+        [this, d] {
+            d->encodedModel = d->model.toUtf8();
+            d->updateGeometry();
+        }
+    );
+    connect(this, &OutputInterface::manufacturerChanged,   this,
+        [this, d] {
+            d->encodedManufacturer = d->manufacturer.toUtf8();
+            d->updateGeometry();
+        }
+    );
     connect(this, &OutputInterface::scaleChanged,          this, [this, d] { d->updateScale(); });
 }
 
@@ -382,8 +396,8 @@ void OutputInterface::Private::sendGeometry(wl_resource *resource)
                             physicalSize.width(),
                             physicalSize.height(),
                             toSubPixel(),
-                            qPrintable(manufacturer),
-                            qPrintable(model),
+                            encodedManufacturer.constData(),
+                            encodedModel.constData(),
                             toTransform());
 }
 
@@ -403,20 +417,70 @@ void OutputInterface::Private::sendDone(const ResourceData &data)
     wl_output_send_done(data.resource);
 }
 
-void OutputInterface::Private::updateGeometry()
+void OutputInterface::Private::flushResources()
 {
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
-        sendGeometry((*it).resource);
-        sendDone(*it);
+        display->getConnection(wl_resource_get_client((*it).resource))->flush();
     }
 }
 
+void OutputInterface::Private::updateGeometry()
+{
+    if (change.depth > 0) {
+        change.pending |= GeometryChange;
+        return;
+    }
+    sendUpdate(GeometryChange);
+}
+
 void OutputInterface::Private::updateScale()
 {
+    if (change.depth > 0) {
+        change.pending |= ScaleChange;
+        return;
+    }
+    sendUpdate(ScaleChange);
+}
+
+void OutputInterface::Private::updateCurrentMode()
+{
+    if (change.depth > 0) {
+        change.pending |= ModeChange;
+        return;
+    }
+    sendUpdate(ModeChange);
+}
+
+void OutputInterface::Private::sendUpdate(uint changes)
+{
+    if (changes == 0) {
+        return;
+    }
+    auto currentModeIt = modes.constEnd();
+    if (changes & ModeChange) {
+        currentModeIt = std::find_if(modes.constBegin(), modes.constEnd(), [](const Mode &mode) { return mode.flags.testFlag(ModeFlag::Current); });
+        if (currentModeIt == modes.constEnd()) {
+            changes &= ~uint(ModeChange);
+            if (changes == 0) {
+                return;
+            }
+        }
+    }
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
-        sendScale(*it);
+        if (changes & GeometryChange) {
+            sendGeometry((*it).resource);
+        }
+        if (changes & ScaleChange) {
+            sendScale(*it);
+        }
+        if (changes & ModeChange) {
+            sendMode((*it).resource, *currentModeIt);
+        }
         sendDone(*it);
     }
+    if (changes & ModeChange) {
+        flushResources();
+    }
 }
 
 #define SETTER(setterName, type, argumentName) \
@@ -520,6 +584,24 @@ bool OutputInterface::isDpmsSupported() const
     return d->dpms.supported;
 }
 
+void OutputInterface::beginChange()
+{
+    Q_D();
+    d->change.depth++;
+}
+
+void OutputInterface::commitChange()
+{
+    Q_D();
+    Q_ASSERT(d->change.depth > 0);
+    if (d->change.depth == 0 || --d->change.depth > 0) {
+        return;
+    }
+    const uint changes = d->change.pending;
+    d->change.pending = 0;
+    d->sendUpdate(changes);
+}
+
 QVector<wl_resource *> OutputInterface::clientResources(ClientConnection *client) const
 {
     Q_D();
@@ -132,6 +132,29 @@ public:
      **/
     QVector<wl_resource *> clientResources(ClientConnection *client) const;
 
+    /**
+     * Starts a batch of changes to this output.
+     *
+     * Until the matching commitChange the setters only update the state of the
+     * OutputInterface and emit their change signals, the bound clients are not
+     * notified. Calls may be nested, only the outermost commitChange sends the
+     * changes.
+     *
+     * @see commitChange
+     * @since 5.68
+     **/
+    void beginChange();
+    /**
+     * Ends a batch of changes started with beginChange.
+     *
+     * Each bound client receives the changed geometry, scale and current mode
+     * in one update terminated by a single done event.
+     *
+     * @see beginChange
+     * @since 5.68
+     **/
+    void commitChange();
+
     static OutputInterface *get(wl_resource *native);
 
 Q_SIGNALS:
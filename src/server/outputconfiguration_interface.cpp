@@ -30,6 +30,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "wayland-org_kde_kwin_outputdevice-server-protocol.h"
 
 #include <QDebug>
+#include <QRect>
 #include <QSize>
 
 namespace KWayland
@@ -46,6 +47,7 @@ public:
 
     void sendApplied();
     void sendFailed();
+    void sendTestResult(bool passed);
     void emitConfigurationChangeRequested() const;
     void clearPendingChanges();
 
@@ -54,8 +56,14 @@ public:
 
     OutputManagementInterface *outputManagement;
     QHash<OutputDeviceInterface*, OutputChangeSet*> changes;
+    // requests which got dropped, they make the configuration invalid
+    struct {
+        bool mode = false;
+        bool scale = false;
+        bool colorCurves = false;
+    } invalid;
 
-    static const quint32 s_version = 2;
+    static const quint32 s_version = 3;
 
 private:
     static void enableCallback(wl_client *client, wl_resource *resource,
@@ -74,6 +82,7 @@ private:
     static void colorcurvesCallback(wl_client *client, wl_resource *resource,
                                     wl_resource * outputdevice,
                                     wl_array *red, wl_array *green, wl_array *blue);
+    static void testCallback(wl_client *client, wl_resource *resource);
 
     OutputConfigurationInterface *q_func() {
         return reinterpret_cast<OutputConfigurationInterface *>(q);
@@ -91,7 +100,8 @@ const struct org_kde_kwin_outputconfiguration_interface OutputConfigurationInter
     applyCallback,
     scaleFCallback,
     colorcurvesCallback,
-    resourceDestroyedCallback
+    resourceDestroyedCallback,
+    testCallback
 };
 
 OutputConfigurationInterface::OutputConfigurationInterface(OutputManagementInterface* parent, wl_resource* parentResource): Resource(new Private(this, parent, parentResource))
@@ -130,12 +140,13 @@ void OutputConfigurationInterface::Private::modeCallback(wl_client *client, wl_r
             break;
         }
     }
+    auto s = cast<Private>(resource);
+    Q_ASSERT(s);
     if (!modeValid) {
         qCWarning(KWAYLAND_SERVER) << "Set invalid mode id:" << mode_id;
+        s->invalid.mode = true;
         return;
     }
-    auto s = cast<Private>(resource);
-    Q_ASSERT(s);
     s->pendingChanges(o)->d_func()->modeId = mode_id;
 }
 
@@ -183,13 +194,14 @@ void OutputConfigurationInterface::Private::positionCallback(wl_client *client,
 void OutputConfigurationInterface::Private::scaleCallback(wl_client *client, wl_resource *resource, wl_resource * outputdevice, int32_t scale)
 {
     Q_UNUSED(client);
+    auto s = cast<Private>(resource);
+    Q_ASSERT(s);
     if (scale <= 0) {
         qCWarning(KWAYLAND_SERVER) << "Requested to scale output device to" << scale << ", but I can't do that.";
+        s->invalid.scale = true;
         return;
     }
     OutputDeviceInterface *o = OutputDeviceInterface::get(outputdevice);
-    auto s = cast<Private>(resource);
-    Q_ASSERT(s);
     s->pendingChanges(o)->d_func()->scale = scale;
 }
 
@@ -197,14 +209,15 @@ void OutputConfigurationInterface::Private::scaleFCallback(wl_client *client, wl
 {
     Q_UNUSED(client);
     const qreal scale = wl_fixed_to_double(scale_fixed);
+    auto s = cast<Private>(resource);
+    Q_ASSERT(s);
 
     if (scale <= 0) {
         qCWarning(KWAYLAND_SERVER) << "Requested to scale output device to" << scale << ", but I can't do that.";
+        s->invalid.scale = true;
         return;
     }
     OutputDeviceInterface *o = OutputDeviceInterface::get(outputdevice);
-    auto s = cast<Private>(resource);
-    Q_ASSERT(s);
 
     s->pendingChanges(o)->d_func()->scale = scale;
 }
@@ -214,9 +227,25 @@ void OutputConfigurationInterface::Private::applyCallback(wl_client *client, wl_
     Q_UNUSED(client);
     auto s = cast<Private>(resource);
     Q_ASSERT(s);
+    if (s->outputManagement->isValidationEnabled()) {
+        const auto result = s->q_func()->validate();
+        if (result != ValidationResult::Valid) {
+            qCWarning(KWAYLAND_SERVER) << "Rejecting invalid output configuration:" << int(result);
+            s->q_func()->setFailed();
+            return;
+        }
+    }
     s->emitConfigurationChangeRequested();
 }
 
+void OutputConfigurationInterface::Private::testCallback(wl_client *client, wl_resource *resource)
+{
+    Q_UNUSED(client);
+    auto s = cast<Private>(resource);
+    Q_ASSERT(s);
+    s->sendTestResult(s->q_func()->validate() == ValidationResult::Valid);
+}
+
 void OutputConfigurationInterface::Private::colorcurvesCallback(wl_client *client, wl_resource *resource,
                                                                 wl_resource * outputdevice,
                                                                 wl_array *red, wl_array *green, wl_array *blue)
@@ -229,13 +258,13 @@ void OutputConfigurationInterface::Private::colorcurvesCallback(wl_client *clien
         return (newColor->size % sizeof(uint16_t) == 0) &&
                 (newColor->size / sizeof(uint16_t) == static_cast<size_t>(oldColor.size()));
     };
+    auto s = cast<Private>(resource);
+    Q_ASSERT(s);
     if (!checkArg(red, oldCc.red) || !checkArg(green, oldCc.green) || !checkArg(blue, oldCc.blue)) {
         qCWarning(KWAYLAND_SERVER) << "Requested to change color curves, but have wrong size.";
+        s->invalid.colorCurves = true;
         return;
     }
-
-    auto s = cast<Private>(resource);
-    Q_ASSERT(s);
     OutputDeviceInterface::ColorCurves cc;
 
     auto fillVector = [](const wl_array *array, QVector<quint16> *v) {
@@ -278,6 +307,138 @@ QHash<OutputDeviceInterface*, OutputChangeSet*> OutputConfigurationInterface::ch
     return d->changes;
 }
 
+OutputConfigurationInterface::ValidationResult OutputConfigurationInterface::validate() const
+{
+    Q_D();
+    if (d->invalid.mode) {
+        return ValidationResult::InvalidMode;
+    }
+    if (d->invalid.scale) {
+        return ValidationResult::InvalidScale;
+    }
+    if (d->invalid.colorCurves) {
+        return ValidationResult::InvalidColorCurves;
+    }
+    const qreal minimumScale = d->outputManagement->minimumScale();
+    const qreal maximumScale = d->outputManagement->maximumScale();
+
+    // logical geometries of the enabled output devices after applying the changes
+    const auto outputDevices = d->outputManagement->display()->outputDevices();
+    QVector<QRect> geometries;
+    geometries.reserve(outputDevices.count());
+    for (OutputDeviceInterface *outputDevice : outputDevices) {
+        const OutputChangeSet *c = d->changes.value(outputDevice);
+        const auto enabled = c && c->enabledChanged() ? c->enabled() : outputDevice->enabled();
+        QSize size = outputDevice->pixelSize();
+        if (c && c->modeChanged()) {
+            const auto modes = outputDevice->modes();
+            auto it = std::find_if(modes.constBegin(), modes.constEnd(), [c] (const OutputDeviceInterface::Mode &mode) { return mode.id == c->mode(); });
+            if (it == modes.constEnd()) {
+                return ValidationResult::InvalidMode;
+            }
+            size = (*it).size;
+        }
+        qreal scale = outputDevice->scaleF();
+        if (c && c->scaleChanged()) {
+            scale = c->scaleF();
+            if (scale < minimumScale || scale > maximumScale) {
+                return ValidationResult::InvalidScale;
+            }
+        }
+        if (enabled == OutputDeviceInterface::Enablement::Disabled) {
+            continue;
+        }
+        switch (c && c->transformChanged() ? c->transform() : outputDevice->transform()) {
+        case OutputDeviceInterface::Transform::Rotated90:
+        case OutputDeviceInterface::Transform::Rotated270:
+        case OutputDeviceInterface::Transform::Flipped90:
+        case OutputDeviceInterface::Transform::Flipped270:
+            size.transpose();
+            break;
+        default:
+            break;
+        }
+        const QPoint position = c && c->positionChanged() ? c->position() : outputDevice->globalPosition();
+        // rounded like the compositor does, clients may round fractional sizes differently
+        geometries << QRect(position, size / scale);
+    }
+    if (geometries.isEmpty()) {
+        return outputDevices.isEmpty() ? ValidationResult::Valid : ValidationResult::NoEnabledOutput;
+    }
+
+    // the sizes of outputs with fractional scales are off by up to a pixel, so overlaps and
+    // gaps of a pixel are tolerated
+    static const int tolerance = 1;
+    for (int i = 0; i < geometries.count(); ++i) {
+        for (int j = i + 1; j < geometries.count(); ++j) {
+            const QRect &a = geometries.at(i);
+            const QRect &b = geometries.at(j);
+            // cloned outputs share the same logical geometry
+            if (a.topLeft() == b.topLeft() && qAbs(a.width() - b.width()) <= tolerance
+                    && qAbs(a.height() - b.height()) <= tolerance) {
+                continue;
+            }
+            const QRect overlap = a.intersected(b);
+            if (overlap.width() > tolerance && overlap.height() > tolerance) {
+                return ValidationResult::OverlappingOutputs;
+            }
+        }
+    }
+
+    // flood fill over outputs sharing an edge or a corner
+    QVector<bool> reached(geometries.count(), false);
+    QVector<int> pending = {0};
+    reached[0] = true;
+    int reachedCount = 1;
+    while (!pending.isEmpty()) {
+        const QRect grown = geometries.at(pending.takeLast()).adjusted(-1 - tolerance, -1 - tolerance, 1 + tolerance, 1 + tolerance);
+        for (int i = 0; i < geometries.count(); ++i) {
+            if (!reached.at(i) && grown.intersects(geometries.at(i))) {
+                reached[i] = true;
+                reachedCount++;
+                pending << i;
+            }
+        }
+    }
+    if (reachedCount != geometries.count()) {
+        return ValidationResult::DisconnectedOutputs;
+    }
+    return ValidationResult::Valid;
+}
+
+void OutputConfigurationInterface::applyChanges()
+{
+    Q_D();
+    for (auto it = d->changes.constBegin(); it != d->changes.constEnd(); ++it) {
+        it.key()->beginChange();
+    }
+    for (auto it = d->changes.constBegin(); it != d->changes.constEnd(); ++it) {
+        OutputDeviceInterface *outputDevice = it.key();
+        const OutputChangeSet *c = it.value();
+        if (c->enabledChanged()) {
+            outputDevice->setEnabled(c->enabled());
+        }
+        if (c->modeChanged()) {
+            outputDevice->setCurrentMode(c->mode());
+        }
+        if (c->transformChanged()) {
+            outputDevice->setTransform(c->transform());
+        }
+        if (c->positionChanged()) {
+            outputDevice->setGlobalPosition(c->position());
+        }
+        if (c->scaleChanged()) {
+            outputDevice->setScaleF(c->scaleF());
+        }
+        if (c->colorCurvesChanged()) {
+            outputDevice->setColorCurves(c->colorCurves());
+        }
+    }
+    for (auto it = d->changes.constBegin(); it != d->changes.constEnd(); ++it) {
+        it.key()->commitChange();
+    }
+}
+
 void OutputConfigurationInterface::setApplied()
 {
     Q_D();
@@ -308,20 +469,33 @@ void OutputConfigurationInterface::Private::sendFailed()
     org_kde_kwin_outputconfiguration_send_failed(resource);
 }
 
+void OutputConfigurationInterface::Private::sendTestResult(bool passed)
+{
+    if (!resource) {
+        return;
+    }
+    if (passed) {
+        org_kde_kwin_outputconfiguration_send_test_passed(resource);
+    } else {
+        org_kde_kwin_outputconfiguration_send_test_failed(resource);
+    }
+}
+
 OutputChangeSet* OutputConfigurationInterface::Private::pendingChanges(OutputDeviceInterface *outputdevice)
 {
-    if (!changes.keys().contains(outputdevice)) {
-        changes[outputdevice] = new OutputChangeSet(outputdevice, q);
+    auto it = changes.find(outputdevice);
+    if (it == changes.end()) {
+        it = changes.insert(outputdevice, new OutputChangeSet(outputdevice, q));
     }
-    return changes[outputdevice];
+    return *it;
 }
 
 bool OutputConfigurationInterface::Private::hasPendingChanges(OutputDeviceInterface *outputdevice) const
 {
-    if (!changes.keys().contains(outputdevice)) {
+    auto c = changes.value(outputdevice);
+    if (!c) {
         return false;
     }
-    auto c = changes[outputdevice];
     return c->enabledChanged() ||
     c->modeChanged() ||
     c->transformChanged() ||
@@ -333,6 +507,9 @@ void OutputConfigurationInterface::Private::clearPendingChanges()
 {
     qDeleteAll(changes.begin(), changes.end());
     changes.clear();
+    invalid.mode = false;
+    invalid.scale = false;
+    invalid.colorCurves = false;
 }
 
 
@@ -62,6 +62,61 @@ class KWAYLANDSERVER_EXPORT OutputConfigurationInterface : public Resource
 public:
     virtual ~OutputConfigurationInterface();
 
+    /**
+     * Result of validating the changes of a configuration.
+     * @see validate
+     * @since 5.68
+     **/
+    enum class ValidationResult {
+        /**
+         * The configuration can be applied
+         **/
+        Valid,
+        /**
+         * A mode the client requested does not exist on the output device
+         **/
+        InvalidMode,
+        /**
+         * A requested scaling factor is outside of the range set on the OutputManagementInterface
+         **/
+        InvalidScale,
+        /**
+         * Requested color curves do not match the size of the output device's color curves
+         **/
+        InvalidColorCurves,
+        /**
+         * The configuration would disable all output devices
+         **/
+        NoEnabledOutput,
+        /**
+         * Enabled output devices would overlap each other. Cloned output devices sharing
+         * the same position and size do not overlap.
+         **/
+        OverlappingOutputs,
+        /**
+         * Enabled output devices would not form one contiguous area
+         **/
+        DisconnectedOutputs
+    };
+
+    /**
+     * Checks whether the changes can be applied to the OutputDeviceInterfaces.
+     *
+     * The resulting layout of all enabled output devices of the Display is computed from
+     * the changes and the current state of the output devices. The layout is valid if
+     * every requested mode exists and every requested scale is within the range set
+     * through OutputManagementInterface::setScaleRange, at least one output device stays
+     * enabled, and the logical geometries of the enabled output devices neither overlap
+     * nor leave gaps between them.
+     *
+     * This is what the client's dry run through OutputConfiguration::test is answered with.
+     * The compositor may use it to reject a configuration before touching the hardware.
+     *
+     * @see OutputManagementInterface::setValidationEnabled
+     * @since 5.68
+     **/
+    ValidationResult validate() const;
+
     /**
      * Accessor for the changes made to OutputDevices. The data returned from this call
      * will be deleted by the OutputConfigurationInterface when
@@ -92,6 +147,19 @@ public Q_SLOTS:
      * @see OutputConfiguration::failed
      */
     void setFailed();
+    /**
+     * Applies the changes to the OutputDeviceInterfaces.
+     *
+     * The changes of all output devices are applied as one batch, each bound client
+     * receives a single update per output device terminated by one done event. The
+     * compositor calls this once it applied the changes to its outputs and before
+     * calling setApplied.
+     *
+     * @see OutputDeviceInterface::beginChange
+     * @see setApplied
+     * @since 5.68
+     **/
+    void applyChanges();
 
 private:
     explicit OutputConfigurationInterface(OutputManagementInterface *parent, wl_resource *parentResource);
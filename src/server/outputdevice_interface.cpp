@@ -50,10 +50,25 @@ public:
     void updateColorCurves();
     void updateEisaId();
     void updateSerialNumber();
+    void updateCurrentMode();
+    void sendUpdate(uint changes);
+
+    enum Change {
+        GeometryChange = 1 << 0,
+        ScaleChange = 1 << 1,
+        ColorCurvesChange = 1 << 2,
+        EisaIdChange = 1 << 3,
+        ModeChange = 1 << 4,
+        UuidChange = 1 << 5,
+        EdidChange = 1 << 6,
+        EnabledChange = 1 << 7
+    };
+    bool deferChange(Change change);
 
     void sendGeometry(wl_resource *resource);
     void sendMode(wl_resource *resource, const Mode &mode);
     void sendDone(const ResourceData &data);
+    void flushResources();
     void sendUuid(const ResourceData &data);
     void sendEdid(const ResourceData &data);
     void sendEnabled(const ResourceData &data);
@@ -76,10 +91,24 @@ public:
     Mode currentMode;
     QList<ResourceData> resources;
 
+    // encoded copies of the string properties and the edid, sent on every bind
+    struct {
+        QByteArray manufacturer = QByteArrayLiteral("org.kde.kwin");
+        QByteArray model = QByteArrayLiteral("none");
+        QByteArray serialNumber;
+        QByteArray eisaId;
+        QByteArray edid;
+    } encoded;
+
     QByteArray edid;
     Enablement enabled = Enablement::Enabled;
     QByteArray uuid;
 
+    struct {
+        int depth = 0;
+        uint pending = 0;
+    } change;
+
     static OutputDeviceInterface *get(wl_resource *native);
 
 private:
@@ -134,21 +163,24 @@ OutputDeviceInterface::OutputDeviceInterface(Display *display, QObject *parent)
     : Global(new Private(this, display), parent)
 {
     Q_D();
-    connect(this, &OutputDeviceInterface::currentModeChanged, this,
-        [d] {
-            Q_ASSERT(d->currentMode.id >= 0);
-            for (auto it = d->resources.constBegin(); it != d->resources.constEnd(); ++it) {
-                d->sendMode((*it).resource, d->currentMode);
-                d->sendDone(*it);
-            }
-            wl_display_flush_clients(*(d->display));
-        }
-    );
+    connect(this, &OutputDeviceInterface::currentModeChanged,    this, [d] { d->updateCurrentMode(); });
     connect(this, &OutputDeviceInterface::subPixelChanged,       this, [d] { d->updateGeometry(); });
     connect(this, &OutputDeviceInterface::transformChanged,      this, [d] { d->updateGeometry(); });
     connect(this, &OutputDeviceInterface::globalPositionChanged, this, [d] { d->updateGeometry(); });
-    connect(this, &OutputDeviceInterface::modelChanged,          this, [d] { d->updateGeometry(); });
-    connect(this, &OutputDeviceInterface::manufacturerChanged,   this, [d] { d->updateGeometry(); });
+    connect(this, &OutputDeviceInterface::modelChanged,          this,
+        [d] {
+            d->encoded.model = d->model.toUtf8();
+            d->updateGeometry();
+        }
+    );
+    connect(this, &OutputDeviceInterface::manufacturerChanged,   this,
+        [d] {
+            d->encoded.manufacturer = d->manufacturer.toUtf8();
+            d->updateGeometry();
+        }
+    );
+    connect(this, &OutputDeviceInterface::serialNumberChanged,   this, [d] { d->encoded.serialNumber = d->serialNumber.toUtf8(); });
+    connect(this, &OutputDeviceInterface::eisaIdChanged,         this, [d] { d->encoded.eisaId = d->eisaId.toUtf8(); });
     connect(this, &OutputDeviceInterface::scaleFChanged,          this, [d] { d->updateScale(); });
     connect(this, &OutputDeviceInterface::scaleChanged,          this, [d] { d->updateScale(); });
     connect(this, &OutputDeviceInterface::colorCurvesChanged,    this, [d] { d->updateColorCurves(); });
@@ -406,8 +438,8 @@ void OutputDeviceInterface::Private::sendGeometry(wl_resource *resource)
                             physicalSize.width(),
                             physicalSize.height(),
                             toSubPixel(),
-                            qPrintable(manufacturer),
-                            qPrintable(model),
+                            encoded.manufacturer.constData(),
+                            encoded.model.constData(),
                             toTransform());
 }
 
@@ -449,7 +481,7 @@ void KWayland::Server::OutputDeviceInterface::Private::sendSerialNumber(const Re
 {
     if (wl_resource_get_version(data.resource) >= ORG_KDE_KWIN_OUTPUTDEVICE_SERIAL_NUMBER_SINCE_VERSION) {
         org_kde_kwin_outputdevice_send_serial_number(data.resource,
-                                            qPrintable(serialNumber));
+                                            encoded.serialNumber.constData());
     }
 }
 
@@ -457,7 +489,7 @@ void KWayland::Server::OutputDeviceInterface::Private::sendEisaId(const Resource
 {
     if (wl_resource_get_version(data.resource) >= ORG_KDE_KWIN_OUTPUTDEVICE_EISA_ID_SINCE_VERSION) {
         org_kde_kwin_outputdevice_send_eisa_id(data.resource,
-                                            qPrintable(eisaId));
+                                            encoded.eisaId.constData());
     }
 }
 
@@ -467,8 +499,78 @@ void OutputDeviceInterface::Private::sendDone(const ResourceData &data)
     org_kde_kwin_outputdevice_send_done(data.resource);
 }
 
+void OutputDeviceInterface::Private::flushResources()
+{
+    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
+        display->getConnection(wl_resource_get_client((*it).resource))->flush();
+    }
+}
+
+bool OutputDeviceInterface::Private::deferChange(Change c)
+{
+    if (change.depth == 0) {
+        return false;
+    }
+    change.pending |= c;
+    return true;
+}
+
+void OutputDeviceInterface::Private::updateCurrentMode()
+{
+    Q_ASSERT(currentMode.id >= 0);
+    if (deferChange(ModeChange)) {
+        return;
+    }
+    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
+        sendMode((*it).resource, currentMode);
+        sendDone(*it);
+    }
+    flushResources();
+}
+
+void OutputDeviceInterface::Private::sendUpdate(uint changes)
+{
+    if (changes == 0) {
+        return;
+    }
+    // same order as on bind
+    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
+        if (changes & GeometryChange) {
+            sendGeometry((*it).resource);
+        }
+        if (changes & ScaleChange) {
+            sendScale(*it);
+        }
+        if (changes & ColorCurvesChange) {
+            sendColorCurves(*it);
+        }
+        if (changes & EisaIdChange) {
+            sendEisaId(*it);
+        }
+        if (changes & ModeChange) {
+            sendMode((*it).resource, currentMode);
+        }
+        if (changes & UuidChange) {
+            sendUuid(*it);
+        }
+        if (changes & EdidChange) {
+            sendEdid(*it);
+        }
+        if (changes & EnabledChange) {
+            sendEnabled(*it);
+        }
+        sendDone(*it);
+    }
+    if (changes & ModeChange) {
+        flushResources();
+    }
+}
+
 void OutputDeviceInterface::Private::updateGeometry()
 {
+    if (deferChange(GeometryChange)) {
+        return;
+    }
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
         sendGeometry((*it).resource);
         sendDone(*it);
@@ -477,6 +579,9 @@ void OutputDeviceInterface::Private::updateGeometry()
 
 void OutputDeviceInterface::Private::updateScale()
 {
+    if (deferChange(ScaleChange)) {
+        return;
+    }
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
         sendScale(*it);
         sendDone(*it);
@@ -485,6 +590,9 @@ void OutputDeviceInterface::Private::updateScale()
 
 void OutputDeviceInterface::Private::updateColorCurves()
 {
+    if (deferChange(ColorCurvesChange)) {
+        return;
+    }
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
         sendColorCurves(*it);
         sendDone(*it);
@@ -647,6 +755,7 @@ void OutputDeviceInterface::setEdid(const QByteArray &edid)
 {
     Q_D();
     d->edid = edid;
+    d->encoded.edid = edid.toBase64();
     d->updateEdid();
     emit edidChanged();
 }
@@ -689,10 +798,28 @@ QByteArray OutputDeviceInterface::uuid() const
     return d->uuid;
 }
 
+void OutputDeviceInterface::beginChange()
+{
+    Q_D();
+    d->change.depth++;
+}
+
+void OutputDeviceInterface::commitChange()
+{
+    Q_D();
+    Q_ASSERT(d->change.depth > 0);
+    if (d->change.depth == 0 || --d->change.depth > 0) {
+        return;
+    }
+    const uint changes = d->change.pending;
+    d->change.pending = 0;
+    d->sendUpdate(changes);
+}
+
 void KWayland::Server::OutputDeviceInterface::Private::sendEdid(const ResourceData &data)
 {
     org_kde_kwin_outputdevice_send_edid(data.resource,
-                                        edid.toBase64().constData());
+                                        encoded.edid.constData());
 }
 
 void KWayland::Server::OutputDeviceInterface::Private::sendEnabled(const ResourceData &data)
@@ -711,6 +838,9 @@ void OutputDeviceInterface::Private::sendUuid(const ResourceData &data)
 
 void KWayland::Server::OutputDeviceInterface::Private::updateEnabled()
 {
+    if (deferChange(EnabledChange)) {
+        return;
+    }
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
         sendEnabled(*it);
     }
@@ -718,6 +848,9 @@ void KWayland::Server::OutputDeviceInterface::Private::updateEnabled()
 
 void KWayland::Server::OutputDeviceInterface::Private::updateEdid()
 {
+    if (deferChange(EdidChange)) {
+        return;
+    }
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
         sendEdid(*it);
     }
@@ -725,6 +858,9 @@ void KWayland::Server::OutputDeviceInterface::Private::updateEdid()
 
 void KWayland::Server::OutputDeviceInterface::Private::updateUuid()
 {
+    if (deferChange(UuidChange)) {
+        return;
+    }
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
         sendUuid(*it);
     }
@@ -732,6 +868,9 @@ void KWayland::Server::OutputDeviceInterface::Private::updateUuid()
 
 void KWayland::Server::OutputDeviceInterface::Private::updateEisaId()
 {
+    if (deferChange(EisaIdChange)) {
+        return;
+    }
     for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
         sendEisaId(*it);
     }
@@ -156,6 +156,29 @@ public:
     void setEnabled(OutputDeviceInterface::Enablement enabled);
     void setUuid(const QByteArray &uuid);
 
+    /**
+     * Starts a batch of changes to this output device.
+     *
+     * Until the matching commitChange the setters only update the state of the
+     * OutputDeviceInterface and emit their change signals, the bound clients are
+     * not notified. Calls may be nested, only the outermost commitChange sends the
+     * changes.
+     *
+     * @see commitChange
+     * @since 5.68
+     **/
+    void beginChange();
+    /**
+     * Ends a batch of changes started with beginChange.
+     *
+     * Each bound client receives all changed properties in one update terminated
+     * by a single done event.
+     *
+     * @see beginChange
+     * @since 5.68
+     **/
+    void commitChange();
+
     static OutputDeviceInterface *get(wl_resource *native);
     static QList<OutputDeviceInterface *>list();
 
@@ -38,6 +38,10 @@ class OutputManagementInterface::Private : public Global::Private
 public:
     Private(OutputManagementInterface *q, Display *d);
 
+    qreal minimumScale = 0.5;
+    qreal maximumScale = 4.0;
+    bool validationEnabled = false;
+
 private:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
 
@@ -56,7 +60,7 @@ private:
     QHash<wl_resource*, OutputConfigurationInterface*> configurationInterfaces;
 };
 
-const quint32 OutputManagementInterface::Private::s_version = 2;
+const quint32 OutputManagementInterface::Private::s_version = 3;
 
 const struct org_kde_kwin_outputmanagement_interface OutputManagementInterface::Private::s_interface = {
     createConfigurationCallback
@@ -71,6 +75,37 @@ OutputManagementInterface::~OutputManagementInterface()
 {
 }
 
+void OutputManagementInterface::setScaleRange(qreal minimum, qreal maximum)
+{
+    Q_D();
+    d->minimumScale = minimum;
+    d->maximumScale = maximum;
+}
+
+qreal OutputManagementInterface::minimumScale() const
+{
+    Q_D();
+    return d->minimumScale;
+}
+
+qreal OutputManagementInterface::maximumScale() const
+{
+    Q_D();
+    return d->maximumScale;
+}
+
+void OutputManagementInterface::setValidationEnabled(bool enabled)
+{
+    Q_D();
+    d->validationEnabled = enabled;
+}
+
+bool OutputManagementInterface::isValidationEnabled() const
+{
+    Q_D();
+    return d->validationEnabled;
+}
+
 void OutputManagementInterface::Private::createConfigurationCallback(wl_client *client, wl_resource *resource, uint32_t id)
 {
     cast(resource)->createConfiguration(client, resource, id);
@@ -116,5 +151,10 @@ void OutputManagementInterface::Private::unbind(wl_resource *resource)
     // TODO: implement?
 }
 
+OutputManagementInterface::Private *OutputManagementInterface::d_func() const
+{
+    return reinterpret_cast<Private*>(d.data());
+}
+
 }
 }
@@ -50,6 +50,46 @@ class KWAYLANDSERVER_EXPORT OutputManagementInterface : public Global
 public:
     virtual ~OutputManagementInterface();
 
+    /**
+     * Sets the range of scaling factors OutputConfigurationInterface::validate accepts
+     * for the outputs.
+     * Default is @c 0.5 to @c 4.
+     * @see minimumScale
+     * @see maximumScale
+     * @since 5.68
+     **/
+    void setScaleRange(qreal minimum, qreal maximum);
+    /**
+     * @returns The smallest scaling factor accepted for an output
+     * @see setScaleRange
+     * @since 5.68
+     **/
+    qreal minimumScale() const;
+    /**
+     * @returns The largest scaling factor accepted for an output
+     * @see setScaleRange
+     * @since 5.68
+     **/
+    qreal maximumScale() const;
+
+    /**
+     * Sets whether configurations get validated before they are passed to the compositor.
+     *
+     * If enabled, a configuration the client asks to apply which does not pass
+     * OutputConfigurationInterface::validate is rejected right away and
+     * configurationChangeRequested is not emitted for it.
+     * Default is @c false.
+     * @see isValidationEnabled
+     * @since 5.68
+     **/
+    void setValidationEnabled(bool enabled);
+    /**
+     * @returns Whether configurations get validated before they are passed to the compositor
+     * @see setValidationEnabled
+     * @since 5.68
+     **/
+    bool isValidationEnabled() const;
+
 Q_SIGNALS:
     /**
      * Emitted after the client has requested an OutputConfiguration to be applied.
@@ -70,6 +110,7 @@ private:
     explicit OutputManagementInterface(Display *display, QObject *parent = nullptr);
     friend class Display;
     class Private;
+    Private *d_func() const;
 };
 
 }
@@ -316,7 +316,9 @@ PlasmaVirtualDesktopInterface::Private::~Private()
         auto client = wl_resource_get_client(r);
         org_kde_plasma_virtual_desktop_send_removed(r);
         wl_resource_destroy(r);
-        wl_client_flush(client);
+        if (ClientConnection *c = ClientConnection::get(client)) {
+            c->flush();
+        }
     }
 }
 
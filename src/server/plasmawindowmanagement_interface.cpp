@@ -324,7 +324,9 @@ PlasmaWindowInterface::Private::~Private()
         auto client = wl_resource_get_client(r);
         org_kde_plasma_window_send_unmapped(r);
         wl_resource_destroy(r);
-        wl_client_flush(client);
+        if (ClientConnection *c = ClientConnection::get(client)) {
+            c->flush();
+        }
     }
 }
 
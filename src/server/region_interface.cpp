@@ -20,8 +20,13 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "region_interface.h"
 #include "resource_p.h"
 #include "compositor_interface.h"
+// Qt
+#include <QMetaMethod>
+#include <QVector>
 // Wayland
 #include <wayland-server.h>
+// std
+#include <algorithm>
 
 namespace KWayland
 {
@@ -33,6 +38,8 @@ class RegionInterface::Private : public Resource::Private
 public:
     Private(CompositorInterface *compositor, RegionInterface *q, wl_resource *parentResource);
     ~Private();
+    // applies the logged operations to qtRegion
+    void materialize();
     QRegion qtRegion;
 
 private:
@@ -41,6 +48,15 @@ private:
     }
     void add(const QRect &rect);
     void subtract(const QRect &rect);
+    void log(const QRect &rect, bool subtract);
+    void emitRegionChanged();
+
+    struct Operation {
+        QRect rect;
+        bool subtract;
+    };
+    // add and subtract requests not yet applied to qtRegion
+    QVector<Operation> operations;
 
     static void addCallback(wl_client *client, wl_resource *r, int32_t x, int32_t y, int32_t width, int32_t height);
     static void subtractCallback(wl_client *client, wl_resource *r, int32_t x, int32_t y, int32_t width, int32_t height);
@@ -63,21 +79,139 @@ RegionInterface::Private::Private(CompositorInterface *compositor, RegionInterfa
 
 RegionInterface::Private::~Private() = default;
 
-void RegionInterface::Private::add(const QRect &rect)
+namespace {
+struct Band {
+    int top;
+    int bottom;
+    // pairs of left and exclusive right coordinates
+    QVector<QPair<int, int>> spans;
+};
+
+/**
+ * Builds the union of @p rects with a sweep over the horizontal bands delimited by
+ * their top and bottom edges. The rects are produced in the banded y-x order
+ * QRegion uses internally, thus the region gets set without any further merging.
+ **/
+static QRegion unite(QVector<QRect> rects)
+{
+    if (rects.count() == 1) {
+        return QRegion(rects.first());
+    }
+    std::sort(rects.begin(), rects.end(), [] (const QRect &a, const QRect &b) {
+        return a.top() < b.top();
+    });
+    QVector<int> edges;
+    edges.reserve(rects.count() * 2);
+    for (const QRect &rect : qAsConst(rects)) {
+        edges << rect.top() << rect.top() + rect.height();
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    QVector<Band> bands;
+    QVector<QRect> active;
+    QVector<QPair<int, int>> spans;
+    int next = 0;
+    for (int i = 0; i + 1 < edges.count(); ++i) {
+        const int top = edges.at(i);
+        const int bottom = edges.at(i + 1);
+        while (next < rects.count() && rects.at(next).top() == top) {
+            active << rects.at(next++);
+        }
+        active.erase(std::remove_if(active.begin(), active.end(), [top] (const QRect &rect) {
+            return rect.top() + rect.height() <= top;
+        }), active.end());
+        if (active.isEmpty()) {
+            continue;
+        }
+        spans.clear();
+        for (const QRect &rect : qAsConst(active)) {
+            spans << qMakePair(rect.left(), rect.left() + rect.width());
+        }
+        std::sort(spans.begin(), spans.end());
+        int merged = 0;
+        for (int j = 1; j < spans.count(); ++j) {
+            if (spans.at(j).first <= spans.at(merged).second) {
+                spans[merged].second = std::max(spans.at(merged).second, spans.at(j).second);
+            } else {
+                spans[++merged] = spans.at(j);
+            }
+        }
+        spans.resize(merged + 1);
+        if (!bands.isEmpty() && bands.last().bottom == top && bands.last().spans == spans) {
+            bands.last().bottom = bottom;
+        } else {
+            bands << Band{top, bottom, spans};
+        }
+    }
+
+    QVector<QRect> banded;
+    for (const Band &band : qAsConst(bands)) {
+        for (const auto &span : band.spans) {
+            banded << QRect(span.first, band.top, span.second - span.first, band.bottom - band.top);
+        }
+    }
+    QRegion region;
+    region.setRects(banded.constData(), banded.count());
+    return region;
+}
+}
+
+void RegionInterface::Private::materialize()
+{
+    QVector<QRect> batch;
+    for (int i = 0; i < operations.count(); ++i) {
+        const Operation &operation = operations.at(i);
+        batch << operation.rect;
+        if (i + 1 < operations.count() && operations.at(i + 1).subtract == operation.subtract) {
+            continue;
+        }
+        // apply each run of operations of the same kind at once
+        if (operation.subtract) {
+            qtRegion = qtRegion.subtracted(unite(batch));
+        } else if (qtRegion.isEmpty()) {
+            qtRegion = unite(batch);
+        } else {
+            qtRegion = qtRegion.united(unite(batch));
+        }
+        batch.clear();
+    }
+    operations.clear();
+}
+
+void RegionInterface::Private::log(const QRect &rect, bool subtract)
+{
+    if (rect.isEmpty()) {
+        return;
+    }
+    operations << Operation{rect, subtract};
+}
+
+void RegionInterface::Private::emitRegionChanged()
 {
-    qtRegion = qtRegion.united(rect);
     Q_Q(RegionInterface);
+    // the region only gets computed for the signal if there is a receiver
+    static const QMetaMethod regionChangedSignal = QMetaMethod::fromSignal(&RegionInterface::regionChanged);
+    if (!q->isSignalConnected(regionChangedSignal)) {
+        return;
+    }
+    materialize();
     emit q->regionChanged(qtRegion);
 }
 
+void RegionInterface::Private::add(const QRect &rect)
+{
+    log(rect, false);
+    emitRegionChanged();
+}
+
 void RegionInterface::Private::subtract(const QRect &rect)
 {
-    if (qtRegion.isEmpty()) {
+    if (qtRegion.isEmpty() && operations.isEmpty()) {
         return;
     }
-    qtRegion = qtRegion.subtracted(rect);
-    Q_Q(RegionInterface);
-    emit q->regionChanged(qtRegion);
+    log(rect, true);
+    emitRegionChanged();
 }
 
 void RegionInterface::Private::addCallback(wl_client *client, wl_resource *r, int32_t x, int32_t y, int32_t width, int32_t height)
@@ -102,6 +236,7 @@ RegionInterface::~RegionInterface() = default;
 QRegion RegionInterface::region() const
 {
     Q_D();
+    d->materialize();
     return d->qtRegion;
 }
 
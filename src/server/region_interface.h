@@ -60,6 +60,9 @@ public:
 Q_SIGNALS:
     /**
      * Emitted whenever the region changes.
+     *
+     * The add and subtract requests are only applied once the region gets read,
+     * having a receiver for this signal forces applying each request on arrival.
      **/
     void regionChanged(const QRegion&);
 
@@ -30,6 +30,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include <QHash>
 #include <QMutableHashIterator>
 
+#include <algorithm>
 #include <functional>
 
 namespace KWayland
@@ -48,6 +49,14 @@ public:
     quint32 height = 0;
     quint32 stride = 0;
     quint32 format = 0;
+    QRegion damage;
+    // identifies the buffer for reuse, changes with the buffer parameters
+    quint64 serial = nextSerial();
+
+    static quint64 nextSerial() {
+        static quint64 s_serial = 0;
+        return ++s_serial;
+    }
 };
 
 BufferHandle::BufferHandle()
@@ -62,6 +71,7 @@ BufferHandle::~BufferHandle()
 void BufferHandle::setFd(qint32 fd)
 {
     d->fd = fd;
+    d->serial = Private::nextSerial();
 }
 
 qint32 BufferHandle::fd() const
@@ -73,6 +83,7 @@ void BufferHandle::setSize(quint32 width, quint32 height)
 {
     d->width = width;
     d->height = height;
+    d->serial = Private::nextSerial();
 }
 
 quint32 BufferHandle::width() const
@@ -88,6 +99,7 @@ quint32 BufferHandle::height() const
 void BufferHandle::setStride(quint32 stride)
 {
     d->stride = stride;
+    d->serial = Private::nextSerial();
 }
 
 
@@ -99,6 +111,7 @@ quint32 BufferHandle::stride() const
 void BufferHandle::setFormat(quint32 format)
 {
     d->format = format;
+    d->serial = Private::nextSerial();
 }
 
 quint32 BufferHandle::format() const
@@ -106,6 +119,16 @@ quint32 BufferHandle::format() const
     return d->format;
 }
 
+void BufferHandle::setDamage(const QRegion &damage)
+{
+    d->damage = damage;
+}
+
+QRegion BufferHandle::damage() const
+{
+    return d->damage;
+}
+
 /**
  * @brief helper struct for manual reference counting.
  * automatic counting via QSharedPointer is no-go here as we hold strong reference in sentBuffers.
@@ -115,7 +138,7 @@ struct BufferHolder
     const BufferHandle *buf;
     quint64 counter;
 };
-    
+
 class RemoteAccessManagerInterface::Private : public Global::Private
 {
 public:
@@ -134,12 +157,50 @@ public:
      */
     void release(wl_resource *resource);
 
+    /**
+     * A buffer kept by a client of version 2 for later frames.
+     */
+    struct RingEntry
+    {
+        RemoteBufferInterface *buffer;
+        const OutputInterface *output;
+        quint64 serial;
+        qint32 frame; ///< fd of the frame the client is reading, -1 if idle
+    };
+
+    struct PendingFrame
+    {
+        const OutputInterface *output;
+        QRegion damage;
+    };
+
+    struct ClientData
+    {
+        /**
+         * Frames sent and not yet returned, keyed by fd
+         */
+        QHash<qint32, PendingFrame> pendingFrames;
+        /**
+         * Damage since the last frame sent to the client, per output.
+         * Only outputs the client received a frame for are present.
+         */
+        QHash<const OutputInterface *, QRegion> damage;
+        /**
+         * Reusable buffers, least recently used first
+         */
+        QVector<RingEntry> ring;
+    };
+
     /**
      * Clients of this interface.
      * This may be screenshot app, video capture app,
      * remote control app etc.
      */
-    QList<wl_resource *> clientResources;
+    QHash<wl_resource *, ClientData> clients;
+
+    int maxBuffersInFlight = 0;
+    quint64 deliveredFrames = 0;
+    quint64 droppedFrames = 0;
 private:
     // methods
     static void unbind(wl_resource *resource);
@@ -152,14 +213,23 @@ private:
 
     /**
      * @brief Unreferences counter and frees buffer when it reaches zero
-     * @param buf holder to decrease reference counter on
-     * @return true if buffer was released, false otherwise
+     * @param fd id of the buffer to decrease reference counter on
+     */
+    void unref(qint32 fd);
+    /**
+     * @brief Marks the frame the client reads from @p buffer as returned
      */
-    bool unref(BufferHolder &buf);
+    void frameDone(wl_resource *resource, RemoteBufferInterface *buffer);
+    /**
+     * @brief Discards the idle buffers for @p output exceeding the ring size
+     */
+    void trimRing(ClientData &data, const OutputInterface *output);
 
     // fields
     static const struct org_kde_kwin_remote_access_manager_interface s_interface;
     static const quint32 s_version;
+    // buffers of one output kept per client, covers double and triple buffering
+    static const int s_ringSize = 4;
 
     RemoteAccessManagerInterface *q;
 
@@ -170,7 +240,7 @@ private:
     QHash<qint32, BufferHolder> sentBuffers;
 };
 
-const quint32 RemoteAccessManagerInterface::Private::s_version = 1;
+const quint32 RemoteAccessManagerInterface::Private::s_version = 2;
 
 RemoteAccessManagerInterface::Private::Private(RemoteAccessManagerInterface *q, Display *d)
     : Global::Private(d, &org_kde_kwin_remote_access_manager_interface, s_version)
@@ -190,15 +260,18 @@ void RemoteAccessManagerInterface::Private::bind(wl_client *client, uint32_t ver
     wl_resource_set_implementation(resource, &s_interface, this, unbind);
 
     // add newly created client resource to the list
-    clientResources << resource;
+    clients.insert(resource, ClientData());
 }
 
 void RemoteAccessManagerInterface::Private::sendBufferReady(const OutputInterface *output, const BufferHandle *buf)
 {
     BufferHolder holder {buf, 0};
+    const QRegion frameDamage = buf->damage().isEmpty() ? QRegion(0, 0, buf->width(), buf->height()) : buf->damage();
     // notify clients
     qCDebug(KWAYLAND_SERVER) << "Server buffer sent: fd" << buf->fd();
-    for (auto res : clientResources) {
+    for (auto it = clients.begin(); it != clients.end(); ++it) {
+        wl_resource *res = it.key();
+        ClientData &data = it.value();
         auto client = wl_resource_get_client(res);
         auto boundScreens = output->clientResources(display->getConnection(client));
 
@@ -207,9 +280,42 @@ void RemoteAccessManagerInterface::Private::sendBufferReady(const OutputInterfac
             continue;
         }
 
+        // a client without a previous frame of the output needs all of it
+        auto damage = data.damage.find(output);
+        if (damage == data.damage.end()) {
+            damage = data.damage.insert(output, QRegion(0, 0, buf->width(), buf->height()));
+        } else {
+            *damage += frameDamage;
+        }
+
+        // slow clients skip frames instead of piling them up, the damage carries over,
+        // clients of version 1 only return frames when destroying the buffer, so they keep all of them
+        const bool limited = maxBuffersInFlight > 0
+                             && wl_resource_get_version(res) >= ORG_KDE_KWIN_REMOTE_BUFFER_DONE_SINCE_VERSION;
+        if (limited && data.pendingFrames.count() >= maxBuffersInFlight) {
+            droppedFrames++;
+            continue;
+        }
+        deliveredFrames++;
+        holder.counter++;
+        data.pendingFrames.insert(buf->fd(), {output, *damage});
+        *damage = QRegion();
+
+        // reuse a buffer the client already has instead of creating a new one per frame
+        auto entry = std::find_if(data.ring.begin(), data.ring.end(), [buf] (const RingEntry &entry) {
+            return entry.serial == buf->d->serial && entry.frame == -1;
+        });
+        if (entry != data.ring.end()) {
+            RingEntry recycled = *entry;
+            data.ring.erase(entry);
+            recycled.frame = buf->fd();
+            data.ring.append(recycled);
+            recycled.buffer->sendFrame(data.pendingFrames.value(buf->fd()).damage);
+            continue;
+        }
+
         // no reason for client to bind wl_output multiple times, send only to first one
         org_kde_kwin_remote_access_manager_send_buffer_ready(res, buf->fd(), boundScreens[0]);
-        holder.counter++;
     }
     if (holder.counter == 0) {
         // buffer was not requested by any client
@@ -232,13 +338,16 @@ void RemoteAccessManagerInterface::Private::getBufferCallback(wl_client *client,
     Private *p = cast(resource);
 
     // client asks for buffer we earlier announced, we must have it
-    if (Q_UNLIKELY(!p->sentBuffers.contains(internalBufId))) { // no such buffer (?)
+    auto data = p->clients.find(resource);
+    if (Q_UNLIKELY(!p->sentBuffers.contains(internalBufId) || data == p->clients.end()
+                   || !data->pendingFrames.contains(internalBufId))) { // no such buffer (?)
         wl_resource_post_no_memory(resource);
         return;
     }
 
-    BufferHolder &bh = p->sentBuffers[internalBufId];
-    auto rbuf = new RemoteBufferInterface(p->q, resource, bh.buf);
+    const BufferHandle *buf = p->sentBuffers.value(internalBufId).buf;
+    const PendingFrame frame = data->pendingFrames.value(internalBufId);
+    auto rbuf = new RemoteBufferInterface(p->q, resource, buf);
     rbuf->create(p->display->getConnection(client), wl_resource_get_version(resource), buffer);
     if (!rbuf->resource()) {
         wl_resource_post_no_memory(resource);
@@ -246,22 +355,46 @@ void RemoteAccessManagerInterface::Private::getBufferCallback(wl_client *client,
         return;
     }
 
-    QObject::connect(rbuf, &Resource::aboutToBeUnbound, p->q, [p, rbuf, resource, &bh] {
-        if (!p->clientResources.contains(resource)) {
+    const bool recyclable = wl_resource_get_version(resource) >= ORG_KDE_KWIN_REMOTE_BUFFER_DONE_SINCE_VERSION;
+    if (recyclable) {
+        data->ring.append({rbuf, frame.output, buf->d->serial, internalBufId});
+        p->trimRing(*data, frame.output);
+        QObject::connect(rbuf, &RemoteBufferInterface::frameDone, p->q, [p, rbuf, resource] {
+            p->frameDone(resource, rbuf);
+        });
+    }
+
+    QObject::connect(rbuf, &Resource::aboutToBeUnbound, p->q, [p, rbuf, resource, recyclable, internalBufId] {
+        auto data = p->clients.find(resource);
+        if (data == p->clients.end()) {
             // remote buffer destroy confirmed after client is already gone
             // all relevant buffers are already unreferenced
             return;
         }
         qCDebug(KWAYLAND_SERVER) << "Remote buffer returned, client" << wl_resource_get_id(resource)
-                                                     << ", id" << rbuf->id()
-                                                     << ", fd" << bh.buf->fd();
-        if (p->unref(bh)) {
-            p->sentBuffers.remove(bh.buf->fd());
+                                                     << ", id" << rbuf->id();
+        if (recyclable) {
+            // releasing a buffer returns the frame it holds
+            p->frameDone(resource, rbuf);
+            data = p->clients.find(resource);
+            if (data != p->clients.end()) {
+                auto entry = std::find_if(data->ring.begin(), data->ring.end(), [rbuf] (const RingEntry &entry) {
+                    return entry.buffer == rbuf;
+                });
+                if (entry != data->ring.end()) {
+                    data->ring.erase(entry);
+                }
+            }
+        } else if (data->pendingFrames.remove(internalBufId)) {
+            p->unref(internalBufId);
         }
     });
 
     // send buffer params
     rbuf->passFd();
+    if (recyclable) {
+        rbuf->sendFrame(frame.damage);
+    }
 }
 
 void RemoteAccessManagerInterface::Private::releaseCallback(wl_client *client, wl_resource *resource)
@@ -270,17 +403,55 @@ void RemoteAccessManagerInterface::Private::releaseCallback(wl_client *client, w
     unbind(resource);
 }
 
-bool RemoteAccessManagerInterface::Private::unref(BufferHolder &bh)
+void RemoteAccessManagerInterface::Private::frameDone(wl_resource *resource, RemoteBufferInterface *buffer)
 {
-    bh.counter--;
-    if (!bh.counter) {
-        // no more clients using this buffer
-        qCDebug(KWAYLAND_SERVER) << "Buffer released, fd" << bh.buf->fd();
-        emit q->bufferReleased(bh.buf);
-        return true;
+    auto data = clients.find(resource);
+    if (data == clients.end()) {
+        return;
+    }
+    auto entry = std::find_if(data->ring.begin(), data->ring.end(), [buffer] (const RingEntry &entry) {
+        return entry.buffer == buffer;
+    });
+    if (entry == data->ring.end() || entry->frame == -1) {
+        return;
+    }
+    const qint32 fd = entry->frame;
+    entry->frame = -1;
+    data->pendingFrames.remove(fd);
+    unref(fd);
+}
+
+void RemoteAccessManagerInterface::Private::trimRing(ClientData &data, const OutputInterface *output)
+{
+    // buffers of a compositor swapchain which got replaced are never sent again
+    int count = std::count_if(data.ring.constBegin(), data.ring.constEnd(), [output] (const RingEntry &entry) {
+        return entry.output == output;
+    });
+    for (auto it = data.ring.begin(); it != data.ring.end() && count > s_ringSize;) {
+        if (it->output == output && it->frame == -1) {
+            it->buffer->discard();
+            it = data.ring.erase(it);
+            count--;
+        } else {
+            ++it;
+        }
     }
+}
 
-    return false;
+void RemoteAccessManagerInterface::Private::unref(qint32 fd)
+{
+    auto it = sentBuffers.find(fd);
+    if (it == sentBuffers.end()) {
+        return;
+    }
+    it->counter--;
+    if (!it->counter) {
+        // no more clients using this buffer
+        const BufferHandle *buf = it->buf;
+        sentBuffers.erase(it);
+        qCDebug(KWAYLAND_SERVER) << "Buffer released, fd" << buf->fd();
+        emit q->bufferReleased(buf);
+    }
 }
 
 void RemoteAccessManagerInterface::Private::unbind(wl_resource *resource)
@@ -292,22 +463,17 @@ void RemoteAccessManagerInterface::Private::unbind(wl_resource *resource)
 
 void RemoteAccessManagerInterface::Private::release(wl_resource *resource)
 {
-    // all holders should decrement their counter as one client is gone
-    QMutableHashIterator<qint32, BufferHolder> itr(sentBuffers);
-    while (itr.hasNext()) {
-        BufferHolder &bh = itr.next().value();
-        if (unref(bh)) {
-            itr.remove();
-        }
+    // the frames held by the gone client are returned
+    const ClientData data = clients.take(resource);
+    for (auto it = data.pendingFrames.constBegin(); it != data.pendingFrames.constEnd(); ++it) {
+        unref(it.key());
     }
-
-    clientResources.removeAll(resource);
 }
 
 RemoteAccessManagerInterface::Private::~Private()
 {
     // server deletes created interfaces, release all held buffers
-    auto c = clientResources; // shadow copy
+    const auto c = clients.keys(); // shadow copy
     for (auto res : c) {
         release(res);
     }
@@ -327,7 +493,31 @@ void RemoteAccessManagerInterface::sendBufferReady(const OutputInterface *output
 bool RemoteAccessManagerInterface::isBound() const
 {
     Private *priv = reinterpret_cast<Private *>(d.data());
-    return !priv->clientResources.isEmpty();
+    return !priv->clients.isEmpty();
+}
+
+void RemoteAccessManagerInterface::setMaxBuffersInFlight(int count)
+{
+    Private *priv = reinterpret_cast<Private *>(d.data());
+    priv->maxBuffersInFlight = qMax(0, count);
+}
+
+int RemoteAccessManagerInterface::maxBuffersInFlight() const
+{
+    Private *priv = reinterpret_cast<Private *>(d.data());
+    return priv->maxBuffersInFlight;
+}
+
+quint64 RemoteAccessManagerInterface::deliveredFrames() const
+{
+    Private *priv = reinterpret_cast<Private *>(d.data());
+    return priv->deliveredFrames;
+}
+
+quint64 RemoteAccessManagerInterface::droppedFrames() const
+{
+    Private *priv = reinterpret_cast<Private *>(d.data());
+    return priv->droppedFrames;
 }
 
 class RemoteBufferInterface::Private : public Resource::Private
@@ -337,8 +527,13 @@ public:
     ~Private();
 
     void passFd();
+    void sendFrame(const QRegion &damage);
 
 private:
+    RemoteBufferInterface *q_func() {
+        return reinterpret_cast<RemoteBufferInterface *>(q);
+    }
+    static void doneCallback(wl_client *client, wl_resource *resource);
     static const struct org_kde_kwin_remote_buffer_interface s_interface;
 
     const BufferHandle *wrapped;
@@ -346,7 +541,8 @@ private:
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 const struct org_kde_kwin_remote_buffer_interface RemoteBufferInterface::Private::s_interface = {
-    resourceDestroyedCallback
+    resourceDestroyedCallback,
+    doneCallback
 };
 #endif
 
@@ -365,6 +561,27 @@ void RemoteBufferInterface::Private::passFd()
             wrapped->width(), wrapped->height(), wrapped->stride(), wrapped->format());
 }
 
+void RemoteBufferInterface::Private::sendFrame(const QRegion &damage)
+{
+    // an encoder gains nothing from many small rectangles, keep the event count bounded
+    static const int s_maxDamageRects = 16;
+    if (damage.rectCount() > s_maxDamageRects) {
+        const QRect bounds = damage.boundingRect();
+        org_kde_kwin_remote_buffer_send_damage(resource, bounds.x(), bounds.y(), bounds.width(), bounds.height());
+    } else {
+        for (const QRect &rect : damage) {
+            org_kde_kwin_remote_buffer_send_damage(resource, rect.x(), rect.y(), rect.width(), rect.height());
+        }
+    }
+    org_kde_kwin_remote_buffer_send_ready(resource);
+}
+
+void RemoteBufferInterface::Private::doneCallback(wl_client *client, wl_resource *resource)
+{
+    Q_UNUSED(client)
+    emit cast<Private>(resource)->q_func()->frameDone();
+}
+
 RemoteBufferInterface::RemoteBufferInterface(RemoteAccessManagerInterface *ram, wl_resource *pResource, const BufferHandle *buf)
     : Resource(new Private(ram, this, pResource, buf), ram)
 {
@@ -381,5 +598,15 @@ void RemoteBufferInterface::passFd()
     d_func()->passFd();
 }
 
+void RemoteBufferInterface::sendFrame(const QRegion &damage)
+{
+    d_func()->sendFrame(damage);
+}
+
+void RemoteBufferInterface::discard()
+{
+    org_kde_kwin_remote_buffer_send_discarded(resource());
+}
+
 }
 }
@@ -22,6 +22,8 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "global.h"
 
+#include <QRegion>
+
 namespace KWayland
 {
 namespace Server
@@ -42,6 +44,12 @@ class OutputInterface;
  * 
  *     It's the responsibility of your process to delete this BufferHandle
  *     and release its' fd afterwards.
+ *
+ * Clients of version 2 keep their buffers and only return the frames. For a client to
+ * reuse its buffer, the compositor has to pass the same BufferHandle again once it got
+ * released, e.g. one BufferHandle per buffer of its swapchain. Only the damage may change
+ * in between, setting the fd, size, stride or format makes it a new buffer. A new
+ * BufferHandle per frame makes clients create a new buffer for each frame.
  **/
 class KWAYLANDSERVER_EXPORT BufferHandle
 {
@@ -52,12 +60,24 @@ public:
     void setSize(quint32 width, quint32 height);
     void setStride(quint32 stride);
     void setFormat(quint32 format);
+    /**
+     * Sets the region of the buffer which changed since the previous frame of the output.
+     * An empty @p damage, the default, marks the whole buffer as changed.
+     *
+     * Clients use the damage to skip unchanged areas, e.g. when encoding the frame.
+     * @since 5.68
+     **/
+    void setDamage(const QRegion &damage);
   
     qint32 fd() const;
     quint32 height() const;
     quint32 width() const;
     quint32 stride() const;
     quint32 format() const;
+    /**
+     * @since 5.68
+     **/
+    QRegion damage() const;
 private:
 
     friend class RemoteAccessManagerInterface;
@@ -73,7 +93,9 @@ public:
     virtual ~RemoteAccessManagerInterface() = default;
 
     /**
-     * Store buffer in sent list and notify client that we have a buffer for it
+     * Store buffer in sent list and notify client that we have a buffer for it.
+     * Clients which still have a buffer for @p buf from a previous frame get the new
+     * frame in there, see BufferHandle for reusing buffers.
      **/
     void sendBufferReady(const OutputInterface *output, const BufferHandle *buf);
     /**
@@ -81,6 +103,34 @@ public:
      **/
     bool isBound() const;
 
+    /**
+     * Sets the maximum number of frames a client may hold at a time to @p count.
+     * Further frames are not sent to the client until it returned a frame, their
+     * damage is added to the next frame sent. A @p count of @c 0 disables the limit.
+     * The limit does not apply to clients of version 1, which cannot return frames
+     * without destroying their buffers.
+     *
+     * The default is @c 0.
+     * @since 5.68
+     **/
+    void setMaxBuffersInFlight(int count);
+    /**
+     * @since 5.68
+     **/
+    int maxBuffersInFlight() const;
+
+    /**
+     * @returns The number of frames sent to clients so far.
+     * @since 5.68
+     **/
+    quint64 deliveredFrames() const;
+    /**
+     * @returns The number of frames not sent to clients as they still held
+     * maxBuffersInFlight frames.
+     * @since 5.68
+     **/
+    quint64 droppedFrames() const;
+
 Q_SIGNALS:
     /**
      * Previously sent buffer has been released by client
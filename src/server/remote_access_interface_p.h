@@ -43,6 +43,22 @@ public:
      * Note that server still has to close mirror fd from its side.
      **/
     void passFd();
+    /**
+     * Announces a new frame in the buffer, changed in @p damage.
+     * Requires version 2.
+     **/
+    void sendFrame(const QRegion &damage);
+    /**
+     * Tells the client that the buffer won't be reused.
+     * Requires version 2.
+     **/
+    void discard();
+
+Q_SIGNALS:
+    /**
+     * The client finished reading the frame last sent.
+     **/
+    void frameDone();
 
 private:
     explicit RemoteBufferInterface(RemoteAccessManagerInterface *ram, wl_resource *pResource, const BufferHandle *buf);
@@ -0,0 +1,111 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "sealedfile_p.h"
+#include "logging.h"
+// Qt
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+
+#include <config-kwayland.h>
+// system
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace KWayland
+{
+namespace Server
+{
+
+static bool writeAll(int fd, const QByteArray &data)
+{
+    qint64 offset = 0;
+    while (offset < data.size()) {
+        const ssize_t written = write(fd, data.constData() + offset, data.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        offset += written;
+    }
+    return true;
+}
+
+#if HAVE_MEMFD
+static int createMemfd(const char *name, const QByteArray &data)
+{
+    const int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1) {
+        return -1;
+    }
+    if (!writeAll(fd, data) ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+static int createTemporaryFile(const char *name, const QByteArray &data)
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (dir.isEmpty()) {
+        dir = QDir::tempPath();
+    }
+    QByteArray path = QFile::encodeName(dir + QLatin1Char('/') + QString::fromUtf8(name)) + "-XXXXXX";
+    const int fd = mkostemp(path.data(), O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    unlink(path.constData());
+    if (!writeAll(fd, data)) {
+        close(fd);
+        return -1;
+    }
+    // a read-only description of the same file, so clients cannot modify it
+    const int readOnlyFd = open(QByteArrayLiteral("/proc/self/fd/").append(QByteArray::number(fd)).constData(),
+                                O_RDONLY | O_CLOEXEC);
+    close(fd);
+    return readOnlyFd;
+}
+
+int createSealedFile(const char *name, const QByteArray &data)
+{
+#if HAVE_MEMFD
+    const int fd = createMemfd(name, data);
+    if (fd != -1) {
+        return fd;
+    }
+#endif
+    const int fallbackFd = createTemporaryFile(name, data);
+    if (fallbackFd == -1) {
+        qCWarning(KWAYLAND_SERVER) << "Could not create file for" << name;
+    }
+    return fallbackFd;
+}
+
+}
+}
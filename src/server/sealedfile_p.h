@@ -0,0 +1,44 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef WAYLAND_SERVER_SEALEDFILE_P_H
+#define WAYLAND_SERVER_SEALEDFILE_P_H
+
+#include <QByteArray>
+
+namespace KWayland
+{
+namespace Server
+{
+
+/**
+ * Creates an anonymous file holding @p data which clients can only read.
+ *
+ * If memfd is available the file is a memfd sealed against writing, growing and
+ * shrinking, otherwise an unlinked temporary file reopened read-only. The returned
+ * file descriptor can be sent to any number of clients, the caller owns it.
+ *
+ * @returns the file descriptor or @c -1 on failure
+ **/
+int createSealedFile(const char *name, const QByteArray &data);
+
+}
+}
+
+#endif
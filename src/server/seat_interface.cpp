@@ -19,6 +19,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "seat_interface.h"
 #include "seat_interface_p.h"
+#include "clipboardcache_p.h"
 #include "display.h"
 #include "datadevice_interface.h"
 #include "datasource_interface.h"
@@ -26,6 +27,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "keyboard_interface_p.h"
 #include "pointer_interface.h"
 #include "pointer_interface_p.h"
+#include "sealedfile_p.h"
 #include "surface_interface.h"
 #include "textinput_interface_p.h"
 // Wayland
@@ -37,7 +39,9 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #if HAVE_LINUX_INPUT_H
 #include <linux/input.h>
 #endif
+#include <unistd.h>
 
+#include <algorithm>
 #include <functional>
 
 namespace KWayland
@@ -70,6 +74,7 @@ SeatInterface::SeatInterface(Display *display, QObject *parent)
     : Global(new Private(this, display), parent)
 {
     Q_D();
+    d->clipboardCache = new ClipboardCache(this);
     connect(this, &SeatInterface::nameChanged, this,
         [d] {
             for (auto it = d->resources.constBegin(); it != d->resources.constEnd(); ++it) {
@@ -93,6 +98,9 @@ SeatInterface::~SeatInterface()
     while (!d->resources.isEmpty()) {
         wl_resource_destroy(d->resources.takeLast());
     }
+    for (const auto &keymap : qAsConst(d->keys.keymapCache)) {
+        close(keymap.fd);
+    }
 }
 
 void SeatInterface::Private::bind(wl_client *client, uint32_t version, uint32_t id)
@@ -433,11 +441,18 @@ void SeatInterface::Private::updateSelection(DataDeviceInterface *dataDevice, bo
             }
         }
     }
+    // the device may have a new source even if the selection did not change
+    updateClipboardCache();
     if (selChanged) {
         emit q->selectionChanged(currentSelection);
     }
 }
 
+void SeatInterface::Private::updateClipboardCache()
+{
+    clipboardCache->setSource(currentSelection ? currentSelection->selection() : nullptr);
+}
+
 void SeatInterface::setHasKeyboard(bool has)
 {
     Q_D();
@@ -1172,6 +1187,46 @@ void SeatInterface::setKeymap(int fd, quint32 size)
     }
 }
 
+bool SeatInterface::setKeymap(const QByteArray &content)
+{
+    Q_D();
+    const int fd = d->cachedKeymap(content);
+    if (fd == -1) {
+        return false;
+    }
+    // the keymap is sent including the terminating null byte
+    setKeymap(fd, content.size() + 1);
+    return true;
+}
+
+int SeatInterface::Private::cachedKeymap(const QByteArray &content)
+{
+    auto &cache = keys.keymapCache;
+    auto it = std::find_if(cache.begin(), cache.end(),
+        [&content] (const Keyboard::CachedKeymap &keymap) {
+            return keymap.content == content;
+        }
+    );
+    if (it != cache.end()) {
+        if (it != cache.begin()) {
+            std::rotate(cache.begin(), it, it + 1);
+        }
+        return cache.first().fd;
+    }
+    Keyboard::CachedKeymap keymap;
+    keymap.content = content;
+    keymap.fd = createSealedFile("kwayland-keymap", content + '\0');
+    if (keymap.fd == -1) {
+        return -1;
+    }
+    if (cache.size() >= s_keymapCacheSize) {
+        // the active keymap is always in front, the last one is not in use
+        close(cache.takeLast().fd);
+    }
+    cache.prepend(keymap);
+    return keymap.fd;
+}
+
 void SeatInterface::updateKeyboardModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group)
 {
     Q_D();
@@ -1608,8 +1663,88 @@ void SeatInterface::setSelection(DataDeviceInterface *dataDevice)
             d->keys.focus.selection->sendClearSelection();
         }
     }
+    d->updateClipboardCache();
     emit selectionChanged(dataDevice);
 }
 
+void SeatInterface::setClipboardCacheMode(ClipboardCacheMode mode)
+{
+    Q_D();
+    if (d->clipboardCache->mode() == mode) {
+        return;
+    }
+    d->clipboardCache->setMode(mode);
+    d->updateClipboardCache();
+}
+
+SeatInterface::ClipboardCacheMode SeatInterface::clipboardCacheMode() const
+{
+    Q_D();
+    return d->clipboardCache->mode();
+}
+
+void SeatInterface::setClipboardCacheMimeTypes(const QStringList &mimeTypes)
+{
+    Q_D();
+    if (d->clipboardCache->mimeTypes() == mimeTypes) {
+        return;
+    }
+    d->clipboardCache->setMimeTypes(mimeTypes);
+    d->updateClipboardCache();
+}
+
+QStringList SeatInterface::clipboardCacheMimeTypes() const
+{
+    Q_D();
+    return d->clipboardCache->mimeTypes();
+}
+
+void SeatInterface::setClipboardCacheLimits(qint64 maximumEntrySize, qint64 maximumTotalSize)
+{
+    Q_D();
+    if (d->clipboardCache->maximumEntrySize() == maximumEntrySize &&
+        d->clipboardCache->maximumTotalSize() == maximumTotalSize) {
+        return;
+    }
+    d->clipboardCache->setLimits(maximumEntrySize, maximumTotalSize);
+    d->updateClipboardCache();
+}
+
+qint64 SeatInterface::clipboardCacheMaximumEntrySize() const
+{
+    Q_D();
+    return d->clipboardCache->maximumEntrySize();
+}
+
+qint64 SeatInterface::clipboardCacheMaximumTotalSize() const
+{
+    Q_D();
+    return d->clipboardCache->maximumTotalSize();
+}
+
+qint64 SeatInterface::clipboardCacheSize() const
+{
+    Q_D();
+    return d->clipboardCache->size();
+}
+
+quint64 SeatInterface::clipboardCacheHits() const
+{
+    Q_D();
+    return d->clipboardCache->hits();
+}
+
+quint64 SeatInterface::clipboardCacheMisses() const
+{
+    Q_D();
+    return d->clipboardCache->misses();
+}
+
+void SeatInterface::resetClipboardCacheStatistics()
+{
+    Q_D();
+    d->clipboardCache->resetStatistics();
+}
+
 }
 }
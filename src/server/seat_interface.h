@@ -22,6 +22,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QPoint>
+#include <QStringList>
 #include <QMatrix4x4>
 
 #include <KWayland/Server/kwaylandserver_export.h>
@@ -150,6 +151,28 @@ class KWAYLANDSERVER_EXPORT SeatInterface : public Global
 public:
     virtual ~SeatInterface();
 
+    /**
+     * How the compositor caches the clipboard selection.
+     * @see setClipboardCacheMode
+     * @since 5.68
+     **/
+    enum class ClipboardCacheMode {
+        /**
+         * Every request for the selection is forwarded to the source client.
+         **/
+        Disabled,
+        /**
+         * The data for a mime type is pulled from the source client on the first request,
+         * following requests are served from the cache.
+         **/
+        OnRequest,
+        /**
+         * The data for all cacheable mime types is pulled from the source client as soon
+         * as the selection is set.
+         **/
+        Eager
+    };
+
     QString name() const;
     bool hasPointer() const;
     bool hasKeyboard() const;
@@ -561,6 +584,20 @@ public:
      **/
     ///@{
     void setKeymap(int fd, quint32 size);
+    /**
+     * Sets the keymap from its textual xkb @p content.
+     *
+     * The keymap is stored in an anonymous file which is sealed read-only, so that
+     * all clients can share it without being able to modify it. The files of the last
+     * used keymaps are kept, so switching between keyboard layouts reuses the existing
+     * file instead of writing a new one.
+     *
+     * The SeatInterface owns the created file descriptor, keymapFileDescriptor returns it.
+     *
+     * @returns @c false if the file could not be created
+     * @since 5.68
+     **/
+    bool setKeymap(const QByteArray &content);
     void keyPressed(quint32 key);
     void keyReleased(quint32 key);
     void updateKeyboardModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group);
@@ -705,6 +742,85 @@ public:
      **/
     void setSelection(DataDeviceInterface *dataDevice);
 
+    /**
+     * Sets how the clipboard selection is cached by the compositor. Default is
+     * ClipboardCacheMode::Disabled.
+     *
+     * With the cache enabled a paste does not require a roundtrip to the client owning
+     * the selection, which matters if that client is busy. Only mime types matching
+     * clipboardCacheMimeTypes and payloads within the configured limits are cached,
+     * all other requests are forwarded to the source client.
+     *
+     * Changing the mode discards the cached data.
+     * @see setClipboardCacheMimeTypes
+     * @see setClipboardCacheLimits
+     * @since 5.68
+     **/
+    void setClipboardCacheMode(ClipboardCacheMode mode);
+    /**
+     * @returns How the clipboard selection is cached.
+     * @see setClipboardCacheMode
+     * @since 5.68
+     **/
+    ClipboardCacheMode clipboardCacheMode() const;
+    /**
+     * Restricts the clipboard cache to @p mimeTypes. A mime type ending with @c * matches
+     * all mime types starting with it, e.g. @c text/* matches all text mime types.
+     * An empty list, which is the default, allows caching all mime types.
+     * @see setClipboardCacheMode
+     * @since 5.68
+     **/
+    void setClipboardCacheMimeTypes(const QStringList &mimeTypes);
+    /**
+     * @see setClipboardCacheMimeTypes
+     * @since 5.68
+     **/
+    QStringList clipboardCacheMimeTypes() const;
+    /**
+     * Sets the maximum size in bytes of the data cached for a single mime type and of all
+     * data cached for the selection. Larger payloads are not cached. The defaults are 4 MiB
+     * per mime type and 16 MiB in total.
+     * @see setClipboardCacheMode
+     * @since 5.68
+     **/
+    void setClipboardCacheLimits(qint64 maximumEntrySize, qint64 maximumTotalSize);
+    /**
+     * @see setClipboardCacheLimits
+     * @since 5.68
+     **/
+    qint64 clipboardCacheMaximumEntrySize() const;
+    /**
+     * @see setClipboardCacheLimits
+     * @since 5.68
+     **/
+    qint64 clipboardCacheMaximumTotalSize() const;
+    /**
+     * @returns The number of bytes currently held in the clipboard cache
+     * @since 5.68
+     **/
+    qint64 clipboardCacheSize() const;
+    /**
+     * @returns The number of requests for a cacheable mime type which were served from
+     * the clipboard cache.
+     * @see clipboardCacheMisses
+     * @see resetClipboardCacheStatistics
+     * @since 5.68
+     **/
+    quint64 clipboardCacheHits() const;
+    /**
+     * @returns The number of requests for a cacheable mime type which had to be forwarded
+     * to the source client.
+     * @see clipboardCacheHits
+     * @see resetClipboardCacheStatistics
+     * @since 5.68
+     **/
+    quint64 clipboardCacheMisses() const;
+    /**
+     * Resets clipboardCacheHits and clipboardCacheMisses to @c 0.
+     * @since 5.68
+     **/
+    void resetClipboardCacheStatistics();
+
     static SeatInterface *get(wl_resource *native);
 
 Q_SIGNALS:
@@ -762,6 +878,7 @@ Q_SIGNALS:
 private:
     friend class Display;
     friend class DataDeviceManagerInterface;
+    friend class DataOfferInterface;
     friend class TextInputManagerUnstableV0Interface;
     friend class TextInputManagerUnstableV2Interface;
     explicit SeatInterface(Display *display, QObject *parent);
@@ -35,6 +35,7 @@ namespace KWayland
 namespace Server
 {
 
+class ClipboardCache;
 class DataDeviceInterface;
 class TextInputInterface;
 
@@ -54,6 +55,9 @@ public:
     void registerTextInput(TextInputInterface *textInput);
     void endDrag(quint32 serial);
     void cancelPreviousSelection(DataDeviceInterface *newlySelectedDataDevice);
+    void updateClipboardCache();
+    int cachedKeymap(const QByteArray &content);
+    static const int s_keymapCacheSize = 8;
 
     QString name;
     bool pointer = false;
@@ -67,6 +71,7 @@ public:
     QVector<DataDeviceInterface*> dataDevices;
     QVector<TextInputInterface*> textInputs;
     DataDeviceInterface *currentSelection = nullptr;
+    ClipboardCache *clipboardCache = nullptr;
 
     // Pointer related members
     struct Pointer {
@@ -105,6 +110,15 @@ public:
             bool xkbcommonCompatible = false;
         };
         Keymap keymap;
+        /**
+         * Keymaps set through their content, most recently used first. Switching back
+         * to a layout reuses its file.
+         **/
+        struct CachedKeymap {
+            QByteArray content;
+            int fd = -1;
+        };
+        QVector<CachedKeymap> keymapCache;
         struct Modifiers {
             quint32 depressed = 0;
             quint32 latched = 0;
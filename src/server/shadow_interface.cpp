@@ -24,6 +24,10 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "resource_p.h"
 #include "surface_interface_p.h"
 
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+
 #include <wayland-server.h>
 #include <wayland-shadow-server-protocol.h>
 
@@ -32,11 +36,100 @@ namespace KWayland
 namespace Server
 {
 
+/**
+ * Holds one copy of each distinct shadow tile, shared by all shadows
+ * attaching byte-identical tiles.
+ */
+class ShadowTileCache
+{
+public:
+    /**
+     * Finds the entry with the content of @p image or adds a copy of it.
+     * @returns the key of the entry, its reference count got increased
+     */
+    quint64 acquire(const QImage &image);
+    void release(quint64 key);
+
+    QImage image(quint64 key) const {
+        return m_entries.value(key).image;
+    }
+    int count() const {
+        return m_entries.count();
+    }
+    qint64 bytes() const {
+        return m_bytes;
+    }
+
+private:
+    static uint contentHash(const QImage &image);
+
+    struct Entry {
+        QImage image;
+        uint hash = 0;
+        int refCount = 0;
+    };
+    QHash<quint64, Entry> m_entries;
+    QMultiHash<uint, quint64> m_keys;
+    quint64 m_nextKey = 1;
+    qint64 m_bytes = 0;
+};
+
+uint ShadowTileCache::contentHash(const QImage &image)
+{
+    // only the pixels of each line count, the padding up to the stride is undefined.
+    // qHashBits uses the CRC32 instructions of the CPU where available
+    const int lineBytes = image.width() * image.depth() / 8;
+    uint hash = qHash((quint64(image.width()) << 32) | quint64(image.height()), uint(image.format()));
+    for (int y = 0; y < image.height(); ++y) {
+        hash = qHashBits(image.constScanLine(y), lineBytes, hash);
+    }
+    return hash;
+}
+
+quint64 ShadowTileCache::acquire(const QImage &image)
+{
+    const uint hash = contentHash(image);
+    for (auto it = m_keys.constFind(hash); it != m_keys.constEnd() && it.key() == hash; ++it) {
+        Entry &entry = m_entries[it.value()];
+        if (entry.image == image) {
+            entry.refCount++;
+            return it.value();
+        }
+    }
+    Entry entry;
+    // deep copy, the image only wraps the shm pool of the client
+    entry.image = image.copy();
+    entry.hash = hash;
+    entry.refCount = 1;
+    m_bytes += entry.image.sizeInBytes();
+
+    const quint64 key = m_nextKey++;
+    m_entries.insert(key, entry);
+    m_keys.insert(hash, key);
+    return key;
+}
+
+void ShadowTileCache::release(quint64 key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return;
+    }
+    if (--it->refCount > 0) {
+        return;
+    }
+    m_bytes -= it->image.sizeInBytes();
+    m_keys.remove(it->hash, key);
+    m_entries.erase(it);
+}
+
 class ShadowManagerInterface::Private : public Global::Private
 {
 public:
     Private(ShadowManagerInterface *q, Display *d);
 
+    QSharedPointer<ShadowTileCache> tileCache;
+
 private:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
     void createShadow(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *surface);
@@ -66,6 +159,7 @@ const struct org_kde_kwin_shadow_manager_interface ShadowManagerInterface::Priva
 
 ShadowManagerInterface::Private::Private(ShadowManagerInterface *q, Display *d)
     : Global::Private(d, &org_kde_kwin_shadow_manager_interface, s_version)
+    , tileCache(new ShadowTileCache)
     , q(q)
 {
 }
@@ -113,6 +207,8 @@ void ShadowManagerInterface::Private::createShadow(wl_client *client, wl_resourc
         delete shadow;
         return;
     }
+    // the cache outlives the manager as long as shadows use it
+    shadow->d_func()->tileCache = tileCache;
     s->d_func()->setShadow(QPointer<ShadowInterface>(shadow));
 }
 
@@ -134,6 +230,23 @@ ShadowManagerInterface::ShadowManagerInterface(Display *display, QObject *parent
 
 ShadowManagerInterface::~ShadowManagerInterface() = default;
 
+int ShadowManagerInterface::cachedTileCount() const
+{
+    Q_D();
+    return d->tileCache->count();
+}
+
+qint64 ShadowManagerInterface::cachedTileBytes() const
+{
+    Q_D();
+    return d->tileCache->bytes();
+}
+
+ShadowManagerInterface::Private *ShadowManagerInterface::d_func() const
+{
+    return reinterpret_cast<Private*>(d.data());
+}
+
 class ShadowInterface::Private : public Resource::Private
 {
 public:
@@ -167,8 +280,14 @@ public:
     State current;
     State pending;
 
+    QSharedPointer<ShadowTileCache> tileCache;
+
+    BufferInterface *currentBuffer(Tile tile) const;
+    quint64 tileKey(Tile tile);
+
 private:
     void commit();
+    void releaseTile(Tile tile);
     void attach(State::Flags flag, wl_resource *buffer);
     ShadowInterface *q_func() {
         return reinterpret_cast<ShadowInterface *>(q);
@@ -189,6 +308,11 @@ private:
     static void offsetBottomCallback(wl_client *client, wl_resource *resource, wl_fixed_t offset);
 
     static const struct org_kde_kwin_shadow_interface s_interface;
+
+    // tile cache keys of the current buffers, resolved on first use
+    quint64 m_tileKeys[8] = {};
+    quint32 m_resolvedTiles = 0;
+    QSet<BufferInterface*> m_trackedBuffers;
 };
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -216,10 +340,67 @@ void ShadowInterface::Private::commitCallback(wl_client *client, wl_resource *re
     cast<Private>(resource)->commit();
 }
 
+BufferInterface *ShadowInterface::Private::currentBuffer(Tile tile) const
+{
+    switch (tile) {
+    case Tile::Left:
+        return current.left;
+    case Tile::TopLeft:
+        return current.topLeft;
+    case Tile::Top:
+        return current.top;
+    case Tile::TopRight:
+        return current.topRight;
+    case Tile::Right:
+        return current.right;
+    case Tile::BottomRight:
+        return current.bottomRight;
+    case Tile::Bottom:
+        return current.bottom;
+    case Tile::BottomLeft:
+        return current.bottomLeft;
+    default:
+        Q_UNREACHABLE();
+        return nullptr;
+    }
+}
+
+quint64 ShadowInterface::Private::tileKey(Tile tile)
+{
+    const int index = int(tile);
+    if (m_resolvedTiles & (1 << index)) {
+        return m_tileKeys[index];
+    }
+    BufferInterface *buffer = currentBuffer(tile);
+    if (!buffer || !buffer->shmBuffer() || !tileCache) {
+        m_resolvedTiles |= 1 << index;
+        return 0;
+    }
+    const QImage image = buffer->data();
+    if (image.isNull()) {
+        // another shm buffer is being accessed, try again next time
+        return 0;
+    }
+    m_tileKeys[index] = tileCache->acquire(image);
+    m_resolvedTiles |= 1 << index;
+    return m_tileKeys[index];
+}
+
+void ShadowInterface::Private::releaseTile(Tile tile)
+{
+    const int index = int(tile);
+    if (m_tileKeys[index] != 0) {
+        tileCache->release(m_tileKeys[index]);
+        m_tileKeys[index] = 0;
+    }
+    m_resolvedTiles &= ~(1 << index);
+}
+
 void ShadowInterface::Private::commit()
 {
 #define BUFFER( __FLAG__, __PART__ ) \
     if (pending.flags & State::Flags::__FLAG__##Buffer) { \
+        releaseTile(Tile::__FLAG__); \
         if (current.__PART__) { \
             current.__PART__->unref(); \
         } \
@@ -247,9 +428,12 @@ void ShadowInterface::Private::commit()
 void ShadowInterface::Private::attach(ShadowInterface::Private::State::Flags flag, wl_resource *buffer)
 {
     BufferInterface *b = BufferInterface::get(buffer);
-    if (b) {
+    // the same buffers usually get attached again, only connect once per buffer
+    if (b && !m_trackedBuffers.contains(b)) {
+        m_trackedBuffers.insert(b);
         QObject::connect(b, &BufferInterface::aboutToBeDestroyed, q,
             [this](BufferInterface *buffer) {
+                m_trackedBuffers.remove(buffer);
     #define PENDING( __PART__ ) \
                 if (pending.__PART__ == buffer) { \
                     pending.__PART__ = nullptr; \
@@ -264,19 +448,20 @@ void ShadowInterface::Private::attach(ShadowInterface::Private::State::Flags fla
                 PENDING(bottomLeft)
     #undef PENDING
 
-    #define CURRENT( __PART__ ) \
+    #define CURRENT( __FLAG__, __PART__ ) \
                 if (current.__PART__ == buffer) { \
+                    releaseTile(Tile::__FLAG__); \
                     current.__PART__->unref(); \
                     current.__PART__ = nullptr; \
                 }
-                CURRENT(left)
-                CURRENT(topLeft)
-                CURRENT(top)
-                CURRENT(topRight)
-                CURRENT(right)
-                CURRENT(bottomRight)
-                CURRENT(bottom)
-                CURRENT(bottomLeft)
+                CURRENT(Left, left)
+                CURRENT(TopLeft, topLeft)
+                CURRENT(Top, top)
+                CURRENT(TopRight, topRight)
+                CURRENT(Right, right)
+                CURRENT(BottomRight, bottomRight)
+                CURRENT(Bottom, bottom)
+                CURRENT(BottomLeft, bottomLeft)
     #undef CURRENT
             }
         );
@@ -356,6 +541,13 @@ ShadowInterface::Private::Private(ShadowInterface *q, ShadowManagerInterface *c,
 
 ShadowInterface::Private::~Private()
 {
+    if (tileCache) {
+        for (quint64 key : m_tileKeys) {
+            if (key != 0) {
+                tileCache->release(key);
+            }
+        }
+    }
 #define CURRENT( __PART__ ) \
     if (current.__PART__) { \
         current.__PART__->unref(); \
@@ -400,6 +592,24 @@ BUFFER(bottomRight)
 BUFFER(bottom)
 BUFFER(bottomLeft)
 
+#undef BUFFER
+
+quint64 ShadowInterface::tileKey(Tile tile) const
+{
+    Q_D();
+    return d->tileKey(tile);
+}
+
+QImage ShadowInterface::tileImage(Tile tile) const
+{
+    Q_D();
+    const quint64 key = d->tileKey(tile);
+    if (key == 0) {
+        return QImage();
+    }
+    return d->tileCache->image(key);
+}
+
 ShadowInterface::Private *ShadowInterface::d_func() const
 {
     return reinterpret_cast<Private*>(d.data());
@@ -23,6 +23,7 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "global.h"
 #include "resource.h"
 
+#include <QImage>
 #include <QObject>
 #include <QMarginsF>
 
@@ -45,10 +46,25 @@ class KWAYLANDSERVER_EXPORT ShadowManagerInterface : public Global
 public:
     virtual ~ShadowManagerInterface();
 
+    /**
+     * The number of distinct tiles in the tile cache shared by all shadows.
+     * Tiles with byte-identical content are only held once, no matter how many
+     * shadows attached them.
+     * @see ShadowInterface::tileKey
+     * @since 5.68
+     **/
+    int cachedTileCount() const;
+    /**
+     * The memory in bytes used by the images in the tile cache.
+     * @since 5.68
+     **/
+    qint64 cachedTileBytes() const;
+
 private:
     explicit ShadowManagerInterface(Display *display, QObject *parent = nullptr);
     friend class Display;
     class Private;
+    Private *d_func() const;
 };
 
 /**
@@ -60,6 +76,21 @@ class KWAYLANDSERVER_EXPORT ShadowInterface : public Resource
 public:
     virtual ~ShadowInterface();
 
+    /**
+     * The tiles making up the shadow.
+     * @since 5.68
+     **/
+    enum class Tile {
+        Left,
+        TopLeft,
+        Top,
+        TopRight,
+        Right,
+        BottomRight,
+        Bottom,
+        BottomLeft
+    };
+
     BufferInterface *left() const;
     BufferInterface *topLeft() const;
     BufferInterface *top() const;
@@ -71,6 +102,32 @@ public:
 
     QMarginsF offset() const;
 
+    /**
+     * A key for the content of the shm buffer attached as @p tile.
+     *
+     * Decorations usually attach byte-identical tiles to all their windows. Such
+     * tiles share the key across all shadows, thus a compositor can use it to
+     * upload the tile only once, e.g. as key of its texture cache.
+     *
+     * The content gets hashed the first time the key is requested after the
+     * tile changed.
+     *
+     * @returns @c 0 if no shm buffer is attached as @p tile
+     * @see tileImage
+     * @since 5.68
+     **/
+    quint64 tileKey(Tile tile) const;
+    /**
+     * The content of @p tile from the tile cache. The image is shared with all
+     * shadows having the same tileKey and stays valid after the buffer got
+     * destroyed.
+     *
+     * @returns A null image if no shm buffer is attached as @p tile
+     * @see tileKey
+     * @since 5.68
+     **/
+    QImage tileImage(Tile tile) const;
+
 private:
     explicit ShadowInterface(ShadowManagerInterface *parent, wl_resource *parentResource);
     friend class ShadowManagerInterface;
@@ -19,9 +19,11 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "surface_interface.h"
 #include "surface_interface_p.h"
+#include "blur_interface.h"
 #include "buffer_interface.h"
 #include "clientconnection.h"
 #include "compositor_interface.h"
+#include "contrast_interface.h"
 #include "idleinhibit_interface_p.h"
 #include "pointerconstraints_interface_p.h"
 #include "region_interface.h"
@@ -329,6 +331,33 @@ void SurfaceInterface::Private::destroy()
     }
 }
 
+namespace {
+// clients replace the blur and contrast objects instead of updating them, only a
+// different object with different state needs the compositor to update the effect
+static bool isSameBlur(BlurInterface *current, BlurInterface *replacement)
+{
+    if (!current || !replacement || current == replacement) {
+        return false;
+    }
+    return current->rectCount() == replacement->rectCount()
+        && current->boundingRect() == replacement->boundingRect()
+        && current->region() == replacement->region();
+}
+
+static bool isSameContrast(ContrastInterface *current, ContrastInterface *replacement)
+{
+    if (!current || !replacement || current == replacement) {
+        return false;
+    }
+    return current->contrast() == replacement->contrast()
+        && current->intensity() == replacement->intensity()
+        && current->saturation() == replacement->saturation()
+        && current->rectCount() == replacement->rectCount()
+        && current->boundingRect() == replacement->boundingRect()
+        && current->region() == replacement->region();
+}
+}
+
 void SurfaceInterface::Private::swapStates(State *source, State *target, bool emitChanged)
 {
     Q_Q(SurfaceInterface);
@@ -338,8 +367,8 @@ void SurfaceInterface::Private::swapStates(State *source, State *target, bool em
     const bool scaleFactorChanged = source->scaleIsSet && (target->scale != source->scale);
     const bool transformChanged = source->transformIsSet && (target->transform != source->transform);
     const bool shadowChanged = source->shadowIsSet;
-    const bool blurChanged = source->blurIsSet;
-    const bool contrastChanged = source->contrastIsSet;
+    const bool blurChanged = source->blurIsSet && !isSameBlur(target->blur, source->blur);
+    const bool contrastChanged = source->contrastIsSet && !isSameContrast(target->contrast, source->contrast);
     const bool slideChanged = source->slideIsSet;
     const bool childrenChanged = source->childrenChanged;
     bool sizeChanged = false;
@@ -388,11 +417,11 @@ void SurfaceInterface::Private::swapStates(State *source, State *target, bool em
         target->shadow = source->shadow;
         target->shadowIsSet = true;
     }
-    if (blurChanged) {
+    if (source->blurIsSet) {
         target->blur = source->blur;
         target->blurIsSet = true;
     }
-    if (contrastChanged) {
+    if (source->contrastIsSet) {
         target->contrast = source->contrast;
         target->contrastIsSet = true;
     }
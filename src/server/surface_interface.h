@@ -320,6 +320,9 @@ Q_SIGNALS:
      **/
     void shadowChanged();
     /**
+     * Emitted when a different BlurInterface got committed. Replacing the BlurInterface
+     * with one for the same region does not emit this signal since 5.68.
+     * @see BlurInterface::regionChanged
      * @since 5.5
      **/
     void blurChanged();
@@ -328,6 +331,10 @@ Q_SIGNALS:
      **/
     void slideOnShowHideChanged();
     /**
+     * Emitted when a different ContrastInterface got committed. Replacing the
+     * ContrastInterface with one for the same region and values does not emit this
+     * signal since 5.68.
+     * @see ContrastInterface::changed
      * @since 5.5
      **/
     void contrastChanged();
@@ -18,12 +18,56 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 ****************************************************************************/
 #include "xdgshell_interface_p.h"
+#include "display.h"
+
+#include <QElapsedTimer>
 
 namespace KWayland
 {
 namespace Server
 {
 
+static qint64 monotonicTime()
+{
+    static QElapsedTimer s_clock;
+    if (!s_clock.isValid()) {
+        s_clock.start();
+    }
+    return s_clock.nsecsElapsed();
+}
+
+void ConfigureSerials::append(quint32 serial, qint64 sent)
+{
+    if (m_count == m_ring.count()) {
+        // full, unroll the ring into a larger one
+        QVector<Entry> ring(qMax(4, m_ring.count() * 2));
+        for (int i = 0; i < m_count; ++i) {
+            ring[i] = m_ring.at((m_head + i) % m_ring.count());
+        }
+        m_ring = ring;
+        m_head = 0;
+    }
+    m_ring[(m_head + m_count) % m_ring.count()] = Entry{serial, sent};
+    m_count++;
+}
+
+bool ConfigureSerials::acknowledge(quint32 serial, Entries &acknowledged)
+{
+    int index = 0;
+    while (index < m_count && m_ring.at((m_head + index) % m_ring.count()).serial != serial) {
+        index++;
+    }
+    if (index == m_count) {
+        return false;
+    }
+    for (int i = 0; i <= index; ++i) {
+        acknowledged.append(m_ring.at((m_head + i) % m_ring.count()));
+    }
+    m_head = (m_head + index + 1) % m_ring.count();
+    m_count -= index + 1;
+    return true;
+}
+
 XdgShellInterface::Private::Private(XdgShellInterfaceVersion interfaceVersion, XdgShellInterface *q, Display *d, const wl_interface *interface, quint32 version)
     : Global::Private(d, interface, version)
     , interfaceVersion(interfaceVersion)
@@ -93,6 +137,137 @@ XdgShellSurfaceInterface::Private::Private(XdgShellInterfaceVersion interfaceVer
 
 XdgShellSurfaceInterface::Private::~Private() = default;
 
+bool XdgShellSurfaceInterface::Private::mustDeferConfigure() const
+{
+    switch (configurePolicy) {
+    case ConfigurePolicy::Coalesce:
+        return !configureSerials.isEmpty();
+    case ConfigurePolicy::CoalesceUntilCommit:
+        return !configureSerials.isEmpty() || m_ackedConfigure.isSet;
+    case ConfigurePolicy::Immediate:
+    default:
+        return false;
+    }
+}
+
+void XdgShellSurfaceInterface::Private::sendConfigureNow(quint32 serial, States states, const QSize &size)
+{
+    configureSerials.append(serial, monotonicTime());
+    sendConfigure(serial, states, size);
+}
+
+quint32 XdgShellSurfaceInterface::Private::configure(States states, const QSize &size)
+{
+    if (!resource) {
+        return 0;
+    }
+    // the latest state wins, the client only gets to see it once
+    if (m_pendingConfigure.isSet) {
+        m_pendingConfigure.states = states;
+        m_pendingConfigure.size = size;
+        return m_pendingConfigure.serial;
+    }
+    const quint32 serial = global->display()->nextSerial();
+    if (mustDeferConfigure()) {
+        m_pendingConfigure = PendingConfigure{true, serial, states, size};
+        return serial;
+    }
+    sendConfigureNow(serial, states, size);
+    return serial;
+}
+
+void XdgShellSurfaceInterface::Private::flushPendingConfigure()
+{
+    if (!m_pendingConfigure.isSet || mustDeferConfigure() || !resource) {
+        return;
+    }
+    const PendingConfigure pending = m_pendingConfigure;
+    m_pendingConfigure = PendingConfigure();
+    sendConfigureNow(pending.serial, pending.states, pending.size);
+}
+
+void XdgShellSurfaceInterface::Private::ackConfigure(quint32 serial)
+{
+    ConfigureSerials::Entries acknowledged;
+    if (!configureSerials.acknowledge(serial, acknowledged)) {
+        // TODO: send error?
+        return;
+    }
+    m_ackedConfigure = AckedConfigure{true, serial, acknowledged.last().sent, monotonicTime()};
+    for (const ConfigureSerials::Entry &entry : qAsConst(acknowledged)) {
+        emit q_func()->configureAcknowledged(entry.serial);
+    }
+    flushPendingConfigure();
+}
+
+void XdgShellSurfaceInterface::Private::commitConfigure()
+{
+    if (!m_ackedConfigure.isSet) {
+        return;
+    }
+    const AckedConfigure acked = m_ackedConfigure;
+    m_ackedConfigure = AckedConfigure();
+    emit q_func()->configureCommitted(acked.serial, acked.acknowledged - acked.sent, monotonicTime() - acked.sent);
+    flushPendingConfigure();
+}
+
+void XdgShellSurfaceInterface::Private::setPendingWindowGeometry(const QRect &rect)
+{
+    m_pendingState.windowGeometry = rect;
+    m_pendingState.windowGeometryIsSet = true;
+}
+
+bool XdgShellSurfaceInterface::Private::setPendingMinimumSize(int32_t width, int32_t height)
+{
+    if (width < 0 || height < 0) {
+        return false;
+    }
+    m_pendingState.minimumSize = QSize(width, height);
+    m_pendingState.minimumSizeIsSet = true;
+    return true;
+}
+
+bool XdgShellSurfaceInterface::Private::setPendingMaximumSize(int32_t width, int32_t height)
+{
+    if (width < 0 || height < 0) {
+        return false;
+    }
+    m_pendingState.maximumSize = QSize(width == 0 ? INT32_MAX : width, height == 0 ? INT32_MAX : height);
+    m_pendingState.maximumSizeIsSet = true;
+    return true;
+}
+
+void XdgShellSurfaceInterface::Private::commit()
+{
+    const bool windowGeometryChanged = m_pendingState.windowGeometryIsSet;
+    const bool minimumSizeChanged = m_pendingState.minimumSizeIsSet;
+    const bool maximumSizeChanged = m_pendingState.maximumSizeIsSet;
+
+    if (windowGeometryChanged) {
+        m_currentState.windowGeometry = m_pendingState.windowGeometry;
+    }
+    if (minimumSizeChanged) {
+        m_currentState.minimumSize = m_pendingState.minimumSize;
+    }
+    if (maximumSizeChanged) {
+        m_currentState.maximumSize = m_pendingState.maximumSize;
+    }
+
+    m_pendingState = ShellSurfaceState{};
+
+    if (windowGeometryChanged) {
+        emit q_func()->windowGeometryChanged(m_currentState.windowGeometry);
+    }
+    if (minimumSizeChanged) {
+        emit q_func()->minSizeChanged(m_currentState.minimumSize);
+    }
+    if (maximumSizeChanged) {
+        emit q_func()->maxSizeChanged(m_currentState.maximumSize);
+    }
+
+    commitConfigure();
+}
+
 XdgShellSurfaceInterface::XdgShellSurfaceInterface(Private *p)
     : Resource(p)
 {
@@ -115,7 +290,20 @@ quint32 XdgShellSurfaceInterface::configure(States states, const QSize &size)
 bool XdgShellSurfaceInterface::isConfigurePending() const
 {
     Q_D();
-    return !d->configureSerials.isEmpty();
+    return !d->configureSerials.isEmpty() || d->hasPendingConfigure();
+}
+
+void XdgShellSurfaceInterface::setConfigurePolicy(ConfigurePolicy policy)
+{
+    Q_D();
+    d->configurePolicy = policy;
+    d->flushPendingConfigure();
+}
+
+XdgShellSurfaceInterface::ConfigurePolicy XdgShellSurfaceInterface::configurePolicy() const
+{
+    Q_D();
+    return d->configurePolicy;
 }
 
 SurfaceInterface *XdgShellSurfaceInterface::surface() const
@@ -186,6 +374,38 @@ XdgShellPopupInterface::Private::Private(XdgShellInterfaceVersion interfaceVersi
 
 XdgShellPopupInterface::Private::~Private() = default;
 
+void XdgShellPopupInterface::Private::setPendingWindowGeometry(const QRect &rect)
+{
+    m_pendingState.windowGeometry = rect;
+    m_pendingState.windowGeometryIsSet = true;
+}
+
+void XdgShellPopupInterface::Private::commit()
+{
+    const bool windowGeometryChanged = m_pendingState.windowGeometryIsSet;
+
+    if (windowGeometryChanged) {
+        m_currentState.windowGeometry = m_pendingState.windowGeometry;
+    }
+
+    m_pendingState = ShellSurfaceState{};
+
+    if (windowGeometryChanged) {
+        emit q_func()->windowGeometryChanged(m_currentState.windowGeometry);
+    }
+}
+
+void XdgShellPopupInterface::Private::ackConfigure(quint32 serial)
+{
+    ConfigureSerials::Entries acknowledged;
+    if (!configureSerials.acknowledge(serial, acknowledged)) {
+        return;
+    }
+    for (const ConfigureSerials::Entry &entry : qAsConst(acknowledged)) {
+        emit q_func()->configureAcknowledged(entry.serial);
+    }
+}
+
 XdgShellPopupInterface::XdgShellPopupInterface(Private *p)
     : Resource(p)
 {
@@ -235,6 +235,10 @@ public:
      *
      * The Surface acknowledges the configure event with {@link configureAcknowledged}.
      *
+     * Depending on the configurePolicy the configure event is not sent right away but
+     * merged with later calls into one configure event. All merged calls return the
+     * serial of that event.
+     *
      * @param states The states the surface is in
      * @param size The requested size
      * @returns The serial of the configure event
@@ -250,6 +254,38 @@ public:
      **/
     bool isConfigurePending() const;
 
+    /**
+     * How configure events get sent to the Surface.
+     * @since 5.68
+     **/
+    enum class ConfigurePolicy {
+        /**
+         * Every configure is sent right away.
+         **/
+        Immediate,
+        /**
+         * While a configure event is not acknowledged, further configures are merged
+         * into one configure event sent once the client acknowledged.
+         **/
+        Coalesce,
+        /**
+         * Like Coalesce, but the merged configure event is only sent after the client
+         * committed the acknowledged state. This paces configure events to the frame
+         * rate of the client, e.g. during an interactive resize.
+         **/
+        CoalesceUntilCommit
+    };
+    /**
+     * Sets the @p policy for sending configure events, by default Immediate.
+     * A configure deferred by the previous policy is sent if the new one allows it.
+     * @since 5.68
+     **/
+    void setConfigurePolicy(ConfigurePolicy policy);
+    /**
+     * @since 5.68
+     **/
+    ConfigurePolicy configurePolicy() const;
+
     /**
      * @return The SurfaceInterface this XdgSurfaceV5Interface got created for.
      **/
@@ -348,6 +384,16 @@ Q_SIGNALS:
      * @see configure
      **/
     void configureAcknowledged(quint32 serial);
+    /**
+     * The surface committed the state of the configure event with @p serial.
+     *
+     * @param serial The serial of the last acknowledged configure event
+     * @param ackLatency Nanoseconds from sending the configure event until it got acknowledged
+     * @param commitLatency Nanoseconds from sending the configure event until the commit
+     * @see configure
+     * @since 5.68
+     **/
+    void configureCommitted(quint32 serial, qint64 ackLatency, qint64 commitLatency);
     /**
      * Emitted whenever the parent surface changes.
      * @see isTransient
@@ -25,12 +25,48 @@ License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 #include "resource_p.h"
 
 #include <QTimer>
+#include <QVarLengthArray>
+#include <QVector>
 
 namespace KWayland
 {
 namespace Server
 {
 
+/**
+ * The serials of the configure events not yet acknowledged, oldest first.
+ *
+ * Clients acknowledge configure events in order, thus the serials are kept in a
+ * ring buffer, which only grows while a client falls behind.
+ */
+class ConfigureSerials
+{
+public:
+    struct Entry {
+        quint32 serial;
+        qint64 sent; ///< monotonic time in nanoseconds
+    };
+    typedef QVarLengthArray<Entry, 4> Entries;
+
+    bool isEmpty() const {
+        return m_count == 0;
+    }
+    int count() const {
+        return m_count;
+    }
+    void append(quint32 serial, qint64 sent = 0);
+    /**
+     * Removes the serials up to and including @p serial and adds them to @p acknowledged.
+     * @returns @c false and removes nothing if @p serial is unknown
+     */
+    bool acknowledge(quint32 serial, Entries &acknowledged);
+
+private:
+    QVector<Entry> m_ring;
+    int m_head = 0;
+    int m_count = 0;
+};
+
 class XdgShellInterface::Private : public Global::Private
 {
 public:
@@ -52,21 +88,90 @@ public:
     virtual ~Private();
 
     virtual void close() = 0;
-    virtual quint32 configure(States states, const QSize &size) = 0;
-    virtual QRect windowGeometry() const = 0;
-    virtual QSize minimumSize() const = 0;
-    virtual QSize maximumSize() const = 0;
+    /**
+     * Applies the pending state, shared by all versions.
+     */
+    void commit() override;
+
+    QRect windowGeometry() const {
+        return m_currentState.windowGeometry;
+    }
+    QSize minimumSize() const {
+        return m_currentState.minimumSize;
+    }
+    QSize maximumSize() const {
+        return m_currentState.maximumSize;
+    }
+    void setPendingWindowGeometry(const QRect &rect);
+    /**
+     * @returns @c false for a negative size, the caller posts the protocol error
+     */
+    bool setPendingMinimumSize(int32_t width, int32_t height);
+    /**
+     * A @p width or @p height of @c 0 means unlimited.
+     * @returns @c false for a negative size, the caller posts the protocol error
+     */
+    bool setPendingMaximumSize(int32_t width, int32_t height);
 
     XdgShellSurfaceInterface *q_func() {
         return reinterpret_cast<XdgShellSurfaceInterface *>(q);
     }
 
-    QVector<quint32> configureSerials;
+    /**
+     * Sends or, depending on the configurePolicy, defers a configure event.
+     * @returns the serial the configure event gets sent with
+     */
+    quint32 configure(States states, const QSize &size);
+    void ackConfigure(quint32 serial);
+    void flushPendingConfigure();
+    bool hasPendingConfigure() const {
+        return m_pendingConfigure.isSet;
+    }
+
+    ConfigureSerials configureSerials;
+    ConfigurePolicy configurePolicy = ConfigurePolicy::Immediate;
     QPointer<XdgShellSurfaceInterface> parent;
     XdgShellInterfaceVersion interfaceVersion;
 
 protected:
+    virtual void sendConfigure(quint32 serial, States states, const QSize &size) = 0;
+
     Private(XdgShellInterfaceVersion interfaceVersion, XdgShellSurfaceInterface *q, Global *c, SurfaceInterface *surface, wl_resource *parentResource, const wl_interface *interface, const void *implementation);
+
+private:
+    bool mustDeferConfigure() const;
+    void commitConfigure();
+
+    struct ShellSurfaceState {
+        QRect windowGeometry;
+        QSize minimumSize = QSize(0, 0);
+        QSize maximumSize = QSize(INT32_MAX, INT32_MAX);
+
+        bool windowGeometryIsSet = false;
+        bool minimumSizeIsSet = false;
+        bool maximumSizeIsSet = false;
+    };
+    ShellSurfaceState m_currentState;
+    ShellSurfaceState m_pendingState;
+
+    void sendConfigureNow(quint32 serial, States states, const QSize &size);
+
+    // merged configure waiting for the outstanding one
+    struct PendingConfigure {
+        bool isSet = false;
+        quint32 serial = 0;
+        States states;
+        QSize size;
+    };
+    PendingConfigure m_pendingConfigure;
+    // acknowledged configure not yet committed by the client
+    struct AckedConfigure {
+        bool isSet = false;
+        quint32 serial = 0;
+        qint64 sent = 0;
+        qint64 acknowledged = 0;
+    };
+    AckedConfigure m_ackedConfigure;
 };
 
 class XdgShellPopupInterface::Private : public Resource::Private, public GenericShellSurface<XdgShellPopupInterface>
@@ -74,7 +179,16 @@ class XdgShellPopupInterface::Private : public Resource::Private, public Generic
 public:
     virtual ~Private();
     virtual void popupDone() = 0;
-    virtual QRect windowGeometry() const = 0;
+    /**
+     * Applies the pending state, shared by all versions.
+     */
+    void commit() override;
+
+    QRect windowGeometry() const {
+        return m_currentState.windowGeometry;
+    }
+    void setPendingWindowGeometry(const QRect &rect);
+    void ackConfigure(quint32 serial);
 
     XdgShellPopupInterface *q_func() {
         return reinterpret_cast<XdgShellPopupInterface *>(q);
@@ -85,7 +199,7 @@ public:
         return 0;
     };
 
-    QVector<quint32> configureSerials;
+    ConfigureSerials configureSerials;
     QPointer<SurfaceInterface> parent;
     QSize initialSize;
 
@@ -103,6 +217,14 @@ public:
 protected:
     Private(XdgShellInterfaceVersion interfaceVersion, XdgShellPopupInterface *q, XdgShellInterface *c, SurfaceInterface *surface, wl_resource *parentResource, const wl_interface *interface, const void *implementation);
 
+private:
+    struct ShellSurfaceState {
+        QRect windowGeometry;
+
+        bool windowGeometryIsSet = false;
+    };
+    ShellSurfaceState m_currentState;
+    ShellSurfaceState m_pendingState;
 };
 
 }
@@ -75,22 +75,6 @@ public:
     Private(XdgPopupStableInterface *q, XdgShellStableInterface *c, SurfaceInterface *surface, wl_resource *parentResource);
     ~Private() override;
 
-    QRect windowGeometry() const override;
-    void commit() override;
-
-    void ackConfigure(quint32 serial) {
-        if (!configureSerials.contains(serial)) {
-            return;
-        }
-        while (!configureSerials.isEmpty()) {
-            quint32 i = configureSerials.takeFirst();
-            emit q_func()->configureAcknowledged(i);
-            if (i == serial) {
-                break;
-            }
-        }
-    }
-
     void popupDone() override;
     quint32 configure(const QRect &rect) override;
 
@@ -98,22 +82,10 @@ public:
         return static_cast<XdgPopupStableInterface *>(q);
     }
 private:
-    void setWindowGeometryCallback(const QRect &rect);
-
     static void grabCallback(wl_client *client, wl_resource *resource, wl_resource *seat, uint32_t serial);
 
     static const struct xdg_popup_interface s_interface;
 
-    struct ShellSurfaceState
-    {
-        QRect windowGeometry;
-
-        bool windowGeometryIsSet = false;
-    };
-
-    ShellSurfaceState m_currentState;
-    ShellSurfaceState m_pendingState;
-
     friend class XdgSurfaceStableInterface;
 };
 
@@ -153,30 +125,9 @@ public:
     Private(XdgTopLevelStableInterface* q, XdgShellStableInterface* c, SurfaceInterface* surface, wl_resource* parentResource);
     ~Private() override;
 
-    QRect windowGeometry() const override;
-    QSize minimumSize() const override;
-    QSize maximumSize() const override;
     void close() override;
-    void commit() override;
 
-    void ackConfigure(quint32 serial) {
-        if (!configureSerials.contains(serial)) {
-            return;
-        }
-        while (!configureSerials.isEmpty()) {
-            quint32 i = configureSerials.takeFirst();
-            emit q_func()->configureAcknowledged(i);
-            if (i == serial) {
-                break;
-            }
-        }
-    }
-
-    quint32 configure(States states, const QSize &size) override {
-        if (!resource) {
-            return 0;
-        }
-        const quint32 serial = global->display()->nextSerial();
+    void sendConfigure(quint32 serial, States states, const QSize &size) override {
         wl_array configureStates;
         wl_array_init(&configureStates);
         if (states.testFlag(State::Maximized)) {
@@ -195,23 +146,19 @@ public:
             uint32_t *s = static_cast<uint32_t*>(wl_array_add(&configureStates, sizeof(uint32_t)));
             *s = XDG_TOPLEVEL_STATE_ACTIVATED;
         }
-        configureSerials << serial;
         xdg_toplevel_send_configure(resource, size.width(), size.height(), &configureStates);
 
         xdg_surface_send_configure(parentResource, serial);
 
         client->flush();
         wl_array_release(&configureStates);
-        return serial;
-    };
+    }
 
     XdgTopLevelStableInterface *q_func() {
         return static_cast<XdgTopLevelStableInterface*>(q);
     }
 
 private:
-    void setWindowGeometryCallback(const QRect &rect);
-
     static void destroyCallback(wl_client *client, wl_resource *resource);
     static void setParentCallback(struct wl_client *client, struct wl_resource *resource, wl_resource *parent);
     static void showWindowMenuCallback(wl_client *client, wl_resource *resource, wl_resource *seat, uint32_t serial, int32_t x, int32_t y);
@@ -225,20 +172,6 @@ private:
 
     static const struct xdg_toplevel_interface s_interface;
 
-    struct ShellSurfaceState
-    {
-        QRect windowGeometry;
-        QSize minimumSize = QSize(0, 0);
-        QSize maximiumSize = QSize(INT32_MAX, INT32_MAX);
-
-        bool windowGeometryIsSet = false;
-        bool minimumSizeIsSet = false;
-        bool maximumSizeIsSet = false;
-    };
-
-    ShellSurfaceState m_currentState;
-    ShellSurfaceState m_pendingState;
-
     friend class XdgSurfaceStableInterface;
 };
 
@@ -567,9 +500,9 @@ void XdgSurfaceStableInterface::Private::setWindowGeometryCallback(wl_client *cl
     }
 
     if (s->m_topLevel) {
-        s->m_topLevel->d_func()->setWindowGeometryCallback(QRect(x, y, width, height));
+        s->m_topLevel->d_func()->setPendingWindowGeometry(QRect(x, y, width, height));
     } else if (s->m_popup) {
-        s->m_popup->d_func()->setWindowGeometryCallback(QRect(x, y, width, height));
+        s->m_popup->d_func()->setPendingWindowGeometry(QRect(x, y, width, height));
     }
 }
 
@@ -750,90 +683,28 @@ void XdgPositionerStableInterface::Private::setOffsetCallback(wl_client *client,
     s->anchorOffset = QPoint(x,y);
 }
 
-QRect XdgTopLevelStableInterface::Private::windowGeometry() const
-{
-    return m_currentState.windowGeometry;
-}
-
-QSize XdgTopLevelStableInterface::Private::minimumSize() const
-{
-    return m_currentState.minimumSize;
-}
-
-QSize XdgTopLevelStableInterface::Private::maximumSize() const
-{
-    return m_currentState.maximiumSize;
-}
-
 void XdgTopLevelStableInterface::Private::close()
 {
     xdg_toplevel_send_close(resource);
     client->flush();
 }
 
-void XdgTopLevelStableInterface::Private::commit()
-{
-    const bool windowGeometryChanged = m_pendingState.windowGeometryIsSet;
-    const bool minimumSizeChanged = m_pendingState.minimumSizeIsSet;
-    const bool maximumSizeChanged = m_pendingState.maximumSizeIsSet;
-
-    if (windowGeometryChanged) {
-        m_currentState.windowGeometry = m_pendingState.windowGeometry;
-    }
-    if (minimumSizeChanged) {
-        m_currentState.minimumSize = m_pendingState.minimumSize;
-    }
-    if (maximumSizeChanged) {
-        m_currentState.maximiumSize = m_pendingState.maximiumSize;
-    }
-
-    m_pendingState = ShellSurfaceState{};
-
-    if (windowGeometryChanged) {
-        emit q_func()->windowGeometryChanged(m_currentState.windowGeometry);
-    }
-    if (minimumSizeChanged) {
-        emit q_func()->minSizeChanged(m_currentState.minimumSize);
-    }
-    if (maximumSizeChanged) {
-        emit q_func()->maxSizeChanged(m_currentState.maximiumSize);
-    }
-}
-
 void XdgTopLevelStableInterface::Private::setMaxSizeCallback(wl_client *client, wl_resource *resource, int32_t width, int32_t height)
 {
-    if (width < 0 || height < 0) {
-        wl_resource_post_error(resource, XDG_WM_BASE_ERROR_INVALID_SURFACE_STATE, "Tried to set invalid xdg-toplevel maximum size");
-        return;
-    }
-    if (width == 0) {
-        width = INT32_MAX;
-    }
-    if (height == 0) {
-        height = INT32_MAX;
-    }
     auto s = cast<Private>(resource);
     Q_ASSERT(client == *s->client);
-    s->m_pendingState.maximiumSize = QSize(width, height);
-    s->m_pendingState.maximumSizeIsSet = true;
+    if (!s->setPendingMaximumSize(width, height)) {
+        wl_resource_post_error(resource, XDG_WM_BASE_ERROR_INVALID_SURFACE_STATE, "Tried to set invalid xdg-toplevel maximum size");
+    }
 }
 
 void XdgTopLevelStableInterface::Private::setMinSizeCallback(wl_client *client, wl_resource *resource, int32_t width, int32_t height)
 {
-    if (width < 0 || height < 0) {
-        wl_resource_post_error(resource, XDG_WM_BASE_ERROR_INVALID_SURFACE_STATE, "Tried to set invalid xdg-toplevel minimum size");
-        return;
-    }
     auto s = cast<Private>(resource);
     Q_ASSERT(client == *s->client);
-    s->m_pendingState.minimumSize = QSize(width, height);
-    s->m_pendingState.minimumSizeIsSet = true;
-}
-
-void XdgTopLevelStableInterface::Private::setWindowGeometryCallback(const QRect &rect)
-{
-    m_pendingState.windowGeometry = rect;
-    m_pendingState.windowGeometryIsSet = true;
+    if (!s->setPendingMinimumSize(width, height)) {
+        wl_resource_post_error(resource, XDG_WM_BASE_ERROR_INVALID_SURFACE_STATE, "Tried to set invalid xdg-toplevel minimum size");
+    }
 }
 
 const struct xdg_toplevel_interface XdgTopLevelStableInterface::Private::s_interface = {
@@ -941,32 +812,6 @@ XdgPopupStableInterface::Private::Private(XdgPopupStableInterface *q, XdgShellSt
 {
 }
 
-QRect XdgPopupStableInterface::Private::windowGeometry() const
-{
-    return m_currentState.windowGeometry;
-}
-
-void XdgPopupStableInterface::Private::commit()
-{
-    const bool windowGeometryChanged = m_pendingState.windowGeometryIsSet;
-
-    if (windowGeometryChanged) {
-        m_currentState.windowGeometry = m_pendingState.windowGeometry;
-    }
-
-    m_pendingState = ShellSurfaceState{};
-
-    if (windowGeometryChanged) {
-        emit q_func()->windowGeometryChanged(m_currentState.windowGeometry);
-    }
-}
-
-void XdgPopupStableInterface::Private::setWindowGeometryCallback(const QRect &rect)
-{
-    m_pendingState.windowGeometry = rect;
-    m_pendingState.windowGeometryIsSet = true;
-}
-
 void XdgPopupStableInterface::Private::grabCallback(wl_client *client, wl_resource *resource, wl_resource *seat, uint32_t serial)
 {
     Q_UNUSED(client)
@@ -983,7 +828,7 @@ quint32 XdgPopupStableInterface::Private::configure(const QRect &rect)
         return 0;
     }
     const quint32 serial = global->display()->nextSerial();
-    configureSerials << serial;
+    configureSerials.append(serial);
     xdg_popup_send_configure(resource, rect.x(), rect.y(), rect.width(), rect.height());
     xdg_surface_send_configure(parentResource, serial);
     client->flush();
@@ -72,8 +72,6 @@ public:
     Private(XdgPopupV5Interface *q, XdgShellV5Interface *c, SurfaceInterface *surface, wl_resource *parentResource);
     ~Private();
 
-    QRect windowGeometry() const override;
-    void commit() override;
     void popupDone() override;
 
     XdgPopupV5Interface *q_func() {
@@ -246,12 +244,8 @@ public:
     Private(XdgSurfaceV5Interface *q, XdgShellV5Interface *c, SurfaceInterface *surface, wl_resource *parentResource);
     ~Private();
 
-    QRect windowGeometry() const override;
-    QSize minimumSize() const override;
-    QSize maximumSize() const override;
     void close() override;
-    void commit() override;
-    quint32 configure(States states, const QSize &size) override;
+    void sendConfigure(quint32 serial, States states, const QSize &size) override;
 
     XdgSurfaceV5Interface *q_func() {
         return reinterpret_cast<XdgSurfaceV5Interface *>(q);
@@ -269,16 +263,6 @@ private:
     static void setMinimizedCallback(wl_client *client, wl_resource *resource);
 
     static const struct zxdg_surface_v5_interface s_interface;
-
-    struct ShellSurfaceState
-    {
-        QRect windowGeometry;
-
-        bool windowGeometryIsSet = false;
-    };
-
-    ShellSurfaceState m_currentState;
-    ShellSurfaceState m_pendingState;
 };
 
 namespace {
@@ -362,17 +346,7 @@ void XdgSurfaceV5Interface::Private::ackConfigureCallback(wl_client *client, wl_
 {
     auto s = cast<Private>(resource);
     Q_ASSERT(client == *s->client);
-    if (!s->configureSerials.contains(serial)) {
-        // TODO: send error?
-        return;
-    }
-    while (!s->configureSerials.isEmpty()) {
-        quint32 i = s->configureSerials.takeFirst();
-        emit s->q_func()->configureAcknowledged(i);
-        if (i == serial) {
-            break;
-        }
-    }
+    s->ackConfigure(serial);
 }
 
 void XdgSurfaceV5Interface::Private::setWindowGeometryCallback(wl_client *client, wl_resource *resource, int32_t x, int32_t y, int32_t width, int32_t height)
@@ -383,8 +357,7 @@ void XdgSurfaceV5Interface::Private::setWindowGeometryCallback(wl_client *client
     }
     auto s = cast<Private>(resource);
     Q_ASSERT(client == *s->client);
-    s->m_pendingState.windowGeometry = QRect(x, y, width, height);
-    s->m_pendingState.windowGeometryIsSet = true;
+    s->setPendingWindowGeometry(QRect(x, y, width, height));
 }
 
 void XdgSurfaceV5Interface::Private::setMaximizedCallback(wl_client *client, wl_resource *resource)
@@ -433,48 +406,14 @@ XdgSurfaceV5Interface::Private::Private(XdgSurfaceV5Interface *q, XdgShellV5Inte
 
 XdgSurfaceV5Interface::Private::~Private() = default;
 
-QRect XdgSurfaceV5Interface::Private::windowGeometry() const
-{
-    return m_currentState.windowGeometry;
-}
-
-QSize XdgSurfaceV5Interface::Private::minimumSize() const
-{
-    return QSize(0, 0);
-}
-
-QSize XdgSurfaceV5Interface::Private::maximumSize() const
-{
-    return QSize(INT_MAX, INT_MAX);
-}
-
 void XdgSurfaceV5Interface::Private::close()
 {
     zxdg_surface_v5_send_close(resource);
     client->flush();
 }
 
-void XdgSurfaceV5Interface::Private::commit()
-{
-    const bool windowGeometryChanged = m_pendingState.windowGeometryIsSet;
-
-    if (windowGeometryChanged) {
-        m_currentState.windowGeometry = m_pendingState.windowGeometry;
-    }
-
-    m_pendingState = ShellSurfaceState{};
-
-    if (windowGeometryChanged) {
-        emit q_func()->windowGeometryChanged(m_currentState.windowGeometry);
-    }
-}
-
-quint32 XdgSurfaceV5Interface::Private::configure(States states, const QSize &size)
+void XdgSurfaceV5Interface::Private::sendConfigure(quint32 serial, States states, const QSize &size)
 {
-    if (!resource) {
-        return 0;
-    }
-    const quint32 serial = global->display()->nextSerial();
     wl_array state;
     wl_array_init(&state);
     if (states.testFlag(State::Maximized)) {
@@ -493,12 +432,9 @@ quint32 XdgSurfaceV5Interface::Private::configure(States states, const QSize &si
         uint32_t *s = reinterpret_cast<uint32_t*>(wl_array_add(&state, sizeof(uint32_t)));
         *s = ZXDG_SURFACE_V5_STATE_ACTIVATED;
     }
-    configureSerials << serial;
     zxdg_surface_v5_send_configure(resource, size.width(), size.height(), &state, serial);
     client->flush();
     wl_array_release(&state);
-
-    return serial;
 }
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -514,15 +450,6 @@ XdgPopupV5Interface::Private::Private(XdgPopupV5Interface *q, XdgShellV5Interfac
 
 XdgPopupV5Interface::Private::~Private() = default;
 
-QRect XdgPopupV5Interface::Private::windowGeometry() const
-{
-    return QRect();
-}
-
-void XdgPopupV5Interface::Private::commit()
-{
-}
-
 void XdgPopupV5Interface::Private::popupDone()
 {
     if (!resource) {
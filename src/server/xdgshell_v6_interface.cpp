@@ -75,23 +75,6 @@ public:
     Private(XdgPopupV6Interface *q, XdgShellV6Interface *c, SurfaceInterface *surface, wl_resource *parentResource);
     ~Private();
 
-    QRect windowGeometry() const override;
-    void commit() override;
-
-    void ackConfigure(quint32 serial) {
-        if (!configureSerials.contains(serial)) {
-            // TODO: send error?
-            return;
-        }
-        while (!configureSerials.isEmpty()) {
-            quint32 i = configureSerials.takeFirst();
-            emit q_func()->configureAcknowledged(i);
-            if (i == serial) {
-                break;
-            }
-        }
-    }
-
     void popupDone() override;
     quint32 configure(const QRect &rect) override;
 
@@ -99,22 +82,10 @@ public:
         return reinterpret_cast<XdgPopupV6Interface *>(q);
     }
 private:
-    void setWindowGeometryCallback(const QRect &rect);
-
     static void grabCallback(wl_client *client, wl_resource *resource, wl_resource *seat, uint32_t serial);
 
     static const struct zxdg_popup_v6_interface s_interface;
 
-    struct ShellSurfaceState
-    {
-        QRect windowGeometry;
-
-        bool windowGeometryIsSet = false;
-    };
-
-    ShellSurfaceState m_currentState;
-    ShellSurfaceState m_pendingState;
-
     friend class XdgSurfaceV6Interface;
 };
 
@@ -154,31 +125,9 @@ public:
     Private(XdgTopLevelV6Interface* q, XdgShellV6Interface* c, SurfaceInterface* surface, wl_resource* parentResource);
     ~Private();
 
-    QRect windowGeometry() const override;
-    QSize minimumSize() const override;
-    QSize maximumSize() const override;
     void close() override;
-    void commit() override;
 
-    void ackConfigure(quint32 serial) {
-        if (!configureSerials.contains(serial)) {
-            // TODO: send error?
-            return;
-        }
-        while (!configureSerials.isEmpty()) {
-            quint32 i = configureSerials.takeFirst();
-            emit q_func()->configureAcknowledged(i);
-            if (i == serial) {
-                break;
-            }
-        }
-    }
-
-    quint32 configure(States states, const QSize &size) override {
-        if (!resource) {
-            return 0;
-        }
-        const quint32 serial = global->display()->nextSerial();
+    void sendConfigure(quint32 serial, States states, const QSize &size) override {
         wl_array state;
         wl_array_init(&state);
         if (states.testFlag(State::Maximized)) {
@@ -197,23 +146,19 @@ public:
             uint32_t *s = reinterpret_cast<uint32_t*>(wl_array_add(&state, sizeof(uint32_t)));
             *s = ZXDG_TOPLEVEL_V6_STATE_ACTIVATED;
         }
-        configureSerials << serial;
         zxdg_toplevel_v6_send_configure(resource, size.width(), size.height(), &state);
 
         zxdg_surface_v6_send_configure(parentResource, serial);
 
         client->flush();
         wl_array_release(&state);
-        return serial;
-    };
+    }
 
     XdgTopLevelV6Interface *q_func() {
         return reinterpret_cast<XdgTopLevelV6Interface*>(q);
     }
 
 private:
-    void setWindowGeometryCallback(const QRect &rect);
-
     static void destroyCallback(wl_client *client, wl_resource *resource);
     static void setParentCallback(struct wl_client *client, struct wl_resource *resource, wl_resource *parent);
     static void showWindowMenuCallback(wl_client *client, wl_resource *resource, wl_resource *seat, uint32_t serial, int32_t x, int32_t y);
@@ -227,20 +172,6 @@ private:
 
     static const struct zxdg_toplevel_v6_interface s_interface;
 
-    struct ShellSurfaceState
-    {
-        QRect windowGeometry;
-        QSize minimumSize = QSize(0, 0);
-        QSize maximiumSize = QSize(INT32_MAX, INT32_MAX);
-
-        bool windowGeometryIsSet = false;
-        bool minimumSizeIsSet = false;
-        bool maximumSizeIsSet = false;
-    };
-
-    ShellSurfaceState m_currentState;
-    ShellSurfaceState m_pendingState;
-
     friend class XdgSurfaceV6Interface;
 };
 
@@ -569,9 +500,9 @@ void XdgSurfaceV6Interface::Private::setWindowGeometryCallback(wl_client *client
     }
 
     if (s->m_topLevel) {
-        s->m_topLevel->d_func()->setWindowGeometryCallback(QRect(x, y, width, height));
+        s->m_topLevel->d_func()->setPendingWindowGeometry(QRect(x, y, width, height));
     } else if (s->m_popup) {
-        s->m_popup->d_func()->setWindowGeometryCallback(QRect(x, y, width, height));
+        s->m_popup->d_func()->setPendingWindowGeometry(QRect(x, y, width, height));
     }
 }
 
@@ -735,21 +666,6 @@ void XdgPositionerV6Interface::Private::setOffsetCallback(wl_client *client, wl_
     s->anchorOffset = QPoint(x,y);
 }
 
-QRect XdgTopLevelV6Interface::Private::windowGeometry() const
-{
-    return m_currentState.windowGeometry;
-}
-
-QSize XdgTopLevelV6Interface::Private::minimumSize() const
-{
-    return m_currentState.minimumSize;
-}
-
-QSize XdgTopLevelV6Interface::Private::maximumSize() const
-{
-    return m_currentState.maximiumSize;
-}
-
 void XdgTopLevelV6Interface::Private::close()
 {
     zxdg_toplevel_v6_send_close(resource);
@@ -758,38 +674,20 @@ void XdgTopLevelV6Interface::Private::close()
 
 void XdgTopLevelV6Interface::Private::setMaxSizeCallback(wl_client *client, wl_resource *resource, int32_t width, int32_t height)
 {
-    if (width < 0 || height < 0) {
-        wl_resource_post_error(resource, ZXDG_SHELL_V6_ERROR_INVALID_SURFACE_STATE, "Tried to set invalid xdg-toplevel maximum size");
-        return;
-    }
-    if (width == 0) {
-        width = INT32_MAX;
-    }
-    if (height == 0) {
-        height = INT32_MAX;
-    }
     auto s = cast<Private>(resource);
     Q_ASSERT(client == *s->client);
-    s->m_pendingState.maximiumSize = QSize(width, height);
-    s->m_pendingState.maximumSizeIsSet = true;
+    if (!s->setPendingMaximumSize(width, height)) {
+        wl_resource_post_error(resource, ZXDG_SHELL_V6_ERROR_INVALID_SURFACE_STATE, "Tried to set invalid xdg-toplevel maximum size");
+    }
 }
 
 void XdgTopLevelV6Interface::Private::setMinSizeCallback(wl_client *client, wl_resource *resource, int32_t width, int32_t height)
 {
-    if (width < 0 || height < 0) {
-        wl_resource_post_error(resource, ZXDG_SHELL_V6_ERROR_INVALID_SURFACE_STATE, "Tried to set invalid xdg-toplevel minimum size");
-        return;
-    }
     auto s = cast<Private>(resource);
     Q_ASSERT(client == *s->client);
-    s->m_pendingState.minimumSize = QSize(width, height);
-    s->m_pendingState.minimumSizeIsSet = true;
-}
-
-void XdgTopLevelV6Interface::Private::setWindowGeometryCallback(const QRect &rect)
-{
-    m_pendingState.windowGeometry = rect;
-    m_pendingState.windowGeometryIsSet = true;
+    if (!s->setPendingMinimumSize(width, height)) {
+        wl_resource_post_error(resource, ZXDG_SHELL_V6_ERROR_INVALID_SURFACE_STATE, "Tried to set invalid xdg-toplevel minimum size");
+    }
 }
 
 const struct zxdg_toplevel_v6_interface XdgTopLevelV6Interface::Private::s_interface = {
@@ -844,35 +742,6 @@ XdgTopLevelV6Interface::Private::Private(XdgTopLevelV6Interface *q, XdgShellV6In
 {
 }
 
-void XdgTopLevelV6Interface::Private::commit()
-{
-    const bool windowGeometryChanged = m_pendingState.windowGeometryIsSet;
-    const bool minimumSizeChanged = m_pendingState.minimumSizeIsSet;
-    const bool maximumSizeChanged = m_pendingState.maximumSizeIsSet;
-
-    if (windowGeometryChanged) {
-        m_currentState.windowGeometry = m_pendingState.windowGeometry;
-    }
-    if (minimumSizeChanged) {
-        m_currentState.minimumSize = m_pendingState.minimumSize;
-    }
-    if (maximumSizeChanged) {
-        m_currentState.maximiumSize = m_pendingState.maximiumSize;
-    }
-
-    m_pendingState = ShellSurfaceState{};
-
-    if (windowGeometryChanged) {
-        emit q_func()->windowGeometryChanged(m_currentState.windowGeometry);
-    }
-    if (minimumSizeChanged) {
-        emit q_func()->minSizeChanged(m_currentState.minimumSize);
-    }
-    if (maximumSizeChanged) {
-        emit q_func()->maxSizeChanged(m_currentState.maximiumSize);
-    }
-}
-
 void XdgTopLevelV6Interface::Private::setMaximizedCallback(wl_client *client, wl_resource *resource)
 {
     auto s = cast<Private>(resource);
@@ -936,39 +805,13 @@ void XdgPopupV6Interface::Private::grabCallback(wl_client *client, wl_resource *
 
 XdgPopupV6Interface::Private::~Private() = default;
 
-QRect XdgPopupV6Interface::Private::windowGeometry() const
-{
-    return m_currentState.windowGeometry;
-}
-
-void XdgPopupV6Interface::Private::commit()
-{
-    const bool windowGeometryChanged = m_pendingState.windowGeometryIsSet;
-
-    if (windowGeometryChanged) {
-        m_currentState.windowGeometry = m_pendingState.windowGeometry;
-    }
-
-    m_pendingState = ShellSurfaceState{};
-
-    if (windowGeometryChanged) {
-        emit q_func()->windowGeometryChanged(m_currentState.windowGeometry);
-    }
-}
-
-void XdgPopupV6Interface::Private::setWindowGeometryCallback(const QRect &rect)
-{
-    m_pendingState.windowGeometry = rect;
-    m_pendingState.windowGeometryIsSet = true;
-}
-
 quint32 XdgPopupV6Interface::Private::configure(const QRect &rect)
 {
     if (!resource) {
         return 0;
     }
     const quint32 serial = global->display()->nextSerial();
-    configureSerials << serial;
+    configureSerials.append(serial);
     zxdg_popup_v6_send_configure(resource, rect.x(), rect.y(), rect.width(), rect.height());
     zxdg_surface_v6_send_configure(parentResource, serial);
     client->flush();
@@ -0,0 +1,1067 @@
+/********************************************************************
+Copyright 2020  agent <agent@local>
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) version 3, or any
+later version accepted by the membership of KDE e.V. (or its
+successor approved by the membership of KDE e.V.), which shall
+act as a proxy defined in Section 6 of version 3 of the license.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// client
+#include "../src/client/compositor.h"
+#include "../src/client/connection_thread.h"
+#include "../src/client/datadevice.h"
+#include "../src/client/datadevicemanager.h"
+#include "../src/client/datasource.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/fakeinput.h"
+#include "../src/client/keyboard.h"
+#include "../src/client/registry.h"
+#include "../src/client/seat.h"
+#include "../src/client/shm_pool.h"
+#include "../src/client/surface.h"
+#include "../src/client/xdgshell.h"
+// server
+#include "../src/server/buffer_interface.h"
+#include "../src/server/clientconnection.h"
+#include "../src/server/compositor_interface.h"
+#include "../src/server/datadevice_interface.h"
+#include "../src/server/datadevicemanager_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/fakeinput_interface.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/surface_interface.h"
+#include "../src/server/xdgshell_interface.h"
+// Qt
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QTimer>
+// system
+#include <algorithm>
+#include <cstring>
+#include <linux/input.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-server.h>
+
+/*
+ * Synthetic load for a compositor built on KWayland::Server.
+ *
+ * The server part hosts a minimal compositor: it sends frame callbacks at 60 Hz,
+ * rotates keyboard and pointer focus through all windows and forwards fake input
+ * to the seat. The clients commit shm frames at a fixed rate, send fake input,
+ * replace the clipboard selection and recreate their window at configurable
+ * intervals. Each frame carries the CLOCK_MONOTONIC time it was committed at in its
+ * first pixels, which gives the server the latency until it handled the commit.
+ *
+ * The clients either run in a thread of the server process or in forked processes
+ * of this executable (--processes), which allows attributing the CPU time to them.
+ */
+
+using namespace KWayland;
+
+namespace
+{
+
+struct Options
+{
+    int clients = 100;
+    int processes = 0;
+    int firstIndex = 0;
+    qreal fps = 60;
+    QSize size = QSize(64, 64);
+    int inputRate = 100;
+    int clipboardInterval = 1000;
+    int churnInterval = 5000;
+    int duration = 10;
+    QString socketName = QStringLiteral("kwayland-load-0");
+};
+
+// a client only commits a new frame if it has less frames waiting for a frame callback
+static const int s_maxFramesInFlight = 3;
+static const int s_repaintInterval = 16;
+static const int s_focusInterval = 50;
+static const int s_lagInterval = 10;
+static const int s_reportInterval = 1000;
+static const int s_shutdownTimeout = 5000;
+
+static qint64 monotonicTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static qint64 cpuTime(int who)
+{
+    rusage usage;
+    if (getrusage(who, &usage) != 0) {
+        return 0;
+    }
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// user and system time of another process in microseconds
+static qint64 processCpuTime(qint64 pid)
+{
+    QFile file(QStringLiteral("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QByteArray stat = file.readAll();
+    // the command name may contain spaces, the fields following it start with the state
+    const QList<QByteArray> fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 13) {
+        return 0;
+    }
+    const qint64 ticks = fields.at(11).toLongLong() + fields.at(12).toLongLong();
+    return ticks * 1000000 / sysconf(_SC_CLK_TCK);
+}
+
+static qint64 percentile(QVector<qint64> values, qreal p)
+{
+    if (values.isEmpty()) {
+        return 0;
+    }
+    const int index = qMin(values.size() - 1, int(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values.at(index);
+}
+
+static QString milliseconds(qint64 nsecs)
+{
+    return QString::number(nsecs / 1000000.0, 'f', 2);
+}
+
+}
+
+class LoadClient : public QObject
+{
+    Q_OBJECT
+public:
+    struct Summary {
+        quint64 frames = 0;
+        quint64 throttledFrames = 0;
+        int maxFramesInFlight = 0;
+        quint64 inputEvents = 0;
+        quint64 selections = 0;
+        quint64 windows = 0;
+    };
+
+    explicit LoadClient(const Options &options, int index, QThread *connectionThread, QObject *parent = nullptr);
+    virtual ~LoadClient();
+
+    void init();
+    Summary summary() const {
+        return m_summary;
+    }
+
+Q_SIGNALS:
+    void finished();
+
+private:
+    void setupRegistry();
+    void createWindow();
+    void destroyWindow();
+    void render();
+    void sendInput();
+    void setSelection();
+    void teardown();
+
+    const Options m_options;
+    const int m_index;
+    Client::ConnectionThread *m_connection;
+    Client::EventQueue *m_queue = nullptr;
+    Client::Registry *m_registry = nullptr;
+    Client::Compositor *m_compositor = nullptr;
+    Client::ShmPool *m_shm = nullptr;
+    Client::Seat *m_seat = nullptr;
+    Client::Keyboard *m_keyboard = nullptr;
+    Client::XdgShell *m_xdgShell = nullptr;
+    Client::FakeInput *m_fakeInput = nullptr;
+    Client::DataDeviceManager *m_dataDeviceManager = nullptr;
+    Client::DataDevice *m_dataDevice = nullptr;
+    Client::DataSource *m_dataSource = nullptr;
+    Client::Surface *m_surface = nullptr;
+    Client::XdgShellSurface *m_xdgSurface = nullptr;
+    QTimer *m_frameTimer;
+    QTimer *m_inputTimer;
+    QTimer *m_clipboardTimer;
+    QTimer *m_churnTimer;
+    bool m_configured = false;
+    bool m_finished = false;
+    int m_framesInFlight = 0;
+    quint32 m_keyboardSerial = 0;
+    Summary m_summary;
+};
+
+LoadClient::LoadClient(const Options &options, int index, QThread *connectionThread, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_index(index)
+    , m_connection(new Client::ConnectionThread)
+    , m_frameTimer(new QTimer(this))
+    , m_inputTimer(new QTimer(this))
+    , m_clipboardTimer(new QTimer(this))
+    , m_churnTimer(new QTimer(this))
+{
+    m_connection->setSocketName(options.socketName);
+    m_connection->moveToThread(connectionThread);
+
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    m_frameTimer->setInterval(qMax(1, qRound(1000 / options.fps)));
+    connect(m_frameTimer, &QTimer::timeout, this, &LoadClient::render);
+    if (options.inputRate > 0) {
+        m_inputTimer->setInterval(qMax(1, 1000 / options.inputRate));
+    }
+    connect(m_inputTimer, &QTimer::timeout, this, &LoadClient::sendInput);
+    m_clipboardTimer->setInterval(options.clipboardInterval);
+    connect(m_clipboardTimer, &QTimer::timeout, this, &LoadClient::setSelection);
+    m_churnTimer->setInterval(options.churnInterval);
+    connect(m_churnTimer, &QTimer::timeout, this,
+        [this] {
+            destroyWindow();
+            createWindow();
+        }
+    );
+}
+
+LoadClient::~LoadClient()
+{
+    m_connection->deleteLater();
+}
+
+void LoadClient::init()
+{
+    connect(m_connection, &Client::ConnectionThread::connected, this,
+        [this] {
+            m_queue = new Client::EventQueue(this);
+            m_queue->setup(m_connection);
+            setupRegistry();
+        },
+        Qt::QueuedConnection
+    );
+    connect(m_connection, &Client::ConnectionThread::connectionDied, this, &LoadClient::teardown, Qt::QueuedConnection);
+    connect(m_connection, &Client::ConnectionThread::failed, this, &LoadClient::teardown, Qt::QueuedConnection);
+    m_connection->initConnection();
+}
+
+void LoadClient::setupRegistry()
+{
+    using namespace Client;
+    m_registry = new Registry(this);
+    connect(m_registry, &Registry::interfacesAnnounced, this,
+        [this] {
+            const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+            m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+            const auto shm = m_registry->interface(Registry::Interface::Shm);
+            m_shm = m_registry->createShmPool(shm.name, shm.version, this);
+            const auto seat = m_registry->interface(Registry::Interface::Seat);
+            m_seat = m_registry->createSeat(seat.name, seat.version, this);
+            const auto xdgShell = m_registry->interface(Registry::Interface::XdgShellStable);
+            m_xdgShell = m_registry->createXdgShell(xdgShell.name, xdgShell.version, this);
+            const auto fakeInput = m_registry->interface(Registry::Interface::FakeInput);
+            m_fakeInput = m_registry->createFakeInput(fakeInput.name, fakeInput.version, this);
+            const auto dataDeviceManager = m_registry->interface(Registry::Interface::DataDeviceManager);
+            m_dataDeviceManager = m_registry->createDataDeviceManager(dataDeviceManager.name, dataDeviceManager.version, this);
+            Q_ASSERT(m_compositor->isValid());
+            Q_ASSERT(m_shm->isValid());
+            Q_ASSERT(m_seat->isValid());
+            Q_ASSERT(m_xdgShell->isValid());
+            Q_ASSERT(m_fakeInput->isValid());
+            Q_ASSERT(m_dataDeviceManager->isValid());
+
+            connect(m_seat, &Seat::hasKeyboardChanged, this,
+                [this] (bool hasKeyboard) {
+                    if (!hasKeyboard || m_keyboard) {
+                        return;
+                    }
+                    m_keyboard = m_seat->createKeyboard(this);
+                    connect(m_keyboard, &Keyboard::entered, this,
+                        [this] (quint32 serial) {
+                            m_keyboardSerial = serial;
+                        }
+                    );
+                }
+            );
+            m_dataDevice = m_dataDeviceManager->getDataDevice(m_seat, this);
+            m_fakeInput->authenticate(QStringLiteral("loadGenerator"), QStringLiteral("Synthetic input load"));
+            createWindow();
+
+            m_frameTimer->start();
+            if (m_options.inputRate > 0) {
+                m_inputTimer->start();
+            }
+            // spread the periodic work of the clients instead of doing it all at once
+            auto *random = QRandomGenerator::global();
+            if (m_options.clipboardInterval > 0) {
+                QTimer::singleShot(random->bounded(m_options.clipboardInterval), m_clipboardTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+            }
+            if (m_options.churnInterval > 0) {
+                QTimer::singleShot(random->bounded(m_options.churnInterval), m_churnTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+            }
+        }
+    );
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+}
+
+void LoadClient::createWindow()
+{
+    using namespace Client;
+    m_surface = m_compositor->createSurface(this);
+    m_xdgSurface = m_xdgShell->createSurface(m_surface, this);
+    m_xdgSurface->setTitle(QStringLiteral("Load client %1").arg(m_index));
+    m_configured = false;
+    m_framesInFlight = 0;
+    connect(m_xdgSurface, &XdgShellSurface::configureRequested, this,
+        [this] (const QSize &size, XdgShellSurface::States states, quint32 serial) {
+            Q_UNUSED(size)
+            Q_UNUSED(states)
+            m_xdgSurface->ackConfigure(serial);
+            m_configured = true;
+        }
+    );
+    connect(m_surface, &Surface::frameRendered, this,
+        [this] {
+            m_framesInFlight--;
+        }
+    );
+    m_surface->commit(Surface::CommitFlag::None);
+    m_summary.windows++;
+}
+
+void LoadClient::destroyWindow()
+{
+    delete m_xdgSurface;
+    m_xdgSurface = nullptr;
+    delete m_surface;
+    m_surface = nullptr;
+}
+
+void LoadClient::render()
+{
+    if (!m_configured) {
+        return;
+    }
+    if (m_framesInFlight >= s_maxFramesInFlight) {
+        m_summary.throttledFrames++;
+        return;
+    }
+    const QSize &size = m_options.size;
+    auto buffer = m_shm->getBuffer(size, size.width() * 4).toStrongRef();
+    if (!buffer) {
+        m_summary.throttledFrames++;
+        return;
+    }
+    buffer->setUsed(true);
+    QImage image(buffer->address(), size.width(), size.height(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(QColor::fromHsv((m_summary.frames * 5 + m_index * 37) % 360, 255, 255));
+    // the server computes the latency from the time stamp in the first pixels
+    const qint64 timestamp = monotonicTime();
+    std::memcpy(buffer->address(), &timestamp, sizeof(timestamp));
+
+    m_surface->attachBuffer(*buffer);
+    m_surface->damage(QRect(QPoint(0, 0), size));
+    m_surface->commit(Client::Surface::CommitFlag::FrameCallback);
+    buffer->setUsed(false);
+
+    m_framesInFlight++;
+    m_summary.maxFramesInFlight = qMax(m_summary.maxFramesInFlight, m_framesInFlight);
+    m_summary.frames++;
+}
+
+void LoadClient::sendInput()
+{
+    // alternate the direction so that the pointer stays where it is
+    const qreal delta = m_summary.inputEvents % 2 ? -1 : 1;
+    m_fakeInput->requestPointerMove(QSizeF(delta, 0));
+    if (m_summary.inputEvents % 10 == 0) {
+        m_fakeInput->requestKeyboardKeyPress(KEY_A);
+        m_fakeInput->requestKeyboardKeyRelease(KEY_A);
+    }
+    m_summary.inputEvents++;
+}
+
+void LoadClient::setSelection()
+{
+    // the server only accepts the selection while this client has keyboard focus,
+    // the others are still sent to load the data device
+    delete m_dataSource;
+    m_dataSource = m_dataDeviceManager->createDataSource(this);
+    m_dataSource->setData(QStringLiteral("text/plain"), QByteArrayLiteral("load client ") + QByteArray::number(m_index)
+                                                        + QByteArrayLiteral(" selection ") + QByteArray::number(m_summary.selections));
+    m_dataDevice->setSelection(m_keyboardSerial, m_dataSource);
+    m_summary.selections++;
+}
+
+void LoadClient::teardown()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_frameTimer->stop();
+    m_inputTimer->stop();
+    m_clipboardTimer->stop();
+    m_churnTimer->stop();
+    // the connection is gone, only clean up the client side data
+    if (m_xdgSurface) {
+        m_xdgSurface->destroy();
+    }
+    if (m_surface) {
+        m_surface->destroy();
+    }
+    if (m_dataSource) {
+        m_dataSource->destroy();
+    }
+    if (m_dataDevice) {
+        m_dataDevice->destroy();
+    }
+    if (m_keyboard) {
+        m_keyboard->destroy();
+    }
+    if (m_dataDeviceManager) {
+        m_dataDeviceManager->destroy();
+    }
+    if (m_fakeInput) {
+        m_fakeInput->destroy();
+    }
+    if (m_xdgShell) {
+        m_xdgShell->destroy();
+    }
+    if (m_seat) {
+        m_seat->destroy();
+    }
+    if (m_shm) {
+        m_shm->destroy();
+    }
+    if (m_compositor) {
+        m_compositor->destroy();
+    }
+    if (m_registry) {
+        m_registry->destroy();
+    }
+    if (m_queue) {
+        m_queue->destroy();
+    }
+    emit finished();
+}
+
+class ClientPool : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ClientPool(const Options &options, QObject *parent = nullptr);
+    virtual ~ClientPool();
+
+    void start();
+
+Q_SIGNALS:
+    /**
+     * All clients lost their connection, emitted after the summary got printed.
+     **/
+    void finished();
+
+private:
+    void printSummary() const;
+
+    const Options m_options;
+    QThread *m_connectionThread = nullptr;
+    QVector<LoadClient*> m_clients;
+    int m_running = 0;
+};
+
+ClientPool::ClientPool(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+}
+
+ClientPool::~ClientPool()
+{
+    qDeleteAll(m_clients);
+    m_clients.clear();
+    if (m_connectionThread) {
+        m_connectionThread->quit();
+        m_connectionThread->wait();
+    }
+}
+
+void ClientPool::start()
+{
+    // all connections of the pool share one thread reading from the sockets
+    m_connectionThread = new QThread(this);
+    m_connectionThread->start();
+    for (int i = 0; i < m_options.clients; ++i) {
+        LoadClient *client = new LoadClient(m_options, m_options.firstIndex + i, m_connectionThread, this);
+        connect(client, &LoadClient::finished, this,
+            [this] {
+                if (--m_running == 0) {
+                    printSummary();
+                    emit finished();
+                }
+            }
+        );
+        m_clients << client;
+        m_running++;
+        client->init();
+    }
+}
+
+void ClientPool::printSummary() const
+{
+    LoadClient::Summary total;
+    for (LoadClient *client : m_clients) {
+        const auto summary = client->summary();
+        total.frames += summary.frames;
+        total.throttledFrames += summary.throttledFrames;
+        total.maxFramesInFlight = qMax(total.maxFramesInFlight, summary.maxFramesInFlight);
+        total.inputEvents += summary.inputEvents;
+        total.selections += summary.selections;
+        total.windows += summary.windows;
+    }
+    qInfo().noquote() << QStringLiteral("pid %1: %2 clients committed %3 frames, throttled %4 frames (at most %5 in flight), "
+                                        "sent %6 input events, %7 selections and created %8 windows")
+                         .arg(getpid()).arg(m_clients.size()).arg(total.frames).arg(total.throttledFrames)
+                         .arg(total.maxFramesInFlight).arg(total.inputEvents).arg(total.selections).arg(total.windows);
+}
+
+class LoadServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoadServer(const Options &options, QObject *parent = nullptr);
+    virtual ~LoadServer();
+
+    bool init();
+
+private:
+    struct ClientStats {
+        qint64 pid = 0;
+        QVector<qint64> latencies;
+        quint64 frames = 0;
+        quint64 inputEvents = 0;
+        quint64 selections = 0;
+        quint64 windows = 0;
+        int maxQueueDepth = 0;
+    };
+    struct Window {
+        qint64 lastTimestamp = 0;
+        // frames committed since the last frame callbacks were sent
+        int pendingFrames = 0;
+    };
+
+    void startClients();
+    void addWindow(Server::XdgShellSurfaceInterface *toplevel);
+    void frameCommitted(Server::XdgShellSurfaceInterface *toplevel);
+    void repaint();
+    void rotateFocus();
+    void measureLag();
+    void report();
+    void printFinalReport();
+    void stop();
+    void clientsFinished();
+    ClientStats &stats(Server::ClientConnection *client);
+
+    const Options m_options;
+    Server::Display *m_display = nullptr;
+    Server::SeatInterface *m_seat = nullptr;
+    QHash<Server::ClientConnection*, ClientStats> m_clients;
+    QVector<ClientStats> m_disconnectedClients;
+    QVector<Server::XdgShellSurfaceInterface*> m_toplevels;
+    QHash<Server::XdgShellSurfaceInterface*, Window> m_windows;
+    int m_focusIndex = 0;
+
+    QThread *m_clientThread = nullptr;
+    QVector<QProcess*> m_processes;
+    int m_runningProcesses = 0;
+
+    QElapsedTimer m_time;
+    QTimer *m_repaintTimer;
+    QTimer *m_focusTimer;
+    QTimer *m_lagTimer;
+    QTimer *m_reportTimer;
+    qint64 m_lastLagCheck = 0;
+    QVector<qint64> m_loopLag;
+
+    // statistics since the last report
+    QVector<qint64> m_intervalLatencies;
+    quint64 m_intervalFrames = 0;
+    quint64 m_intervalInputEvents = 0;
+    quint64 m_intervalSelections = 0;
+    int m_intervalQueueDepth = 0;
+    qint64 m_lastReport = 0;
+    qint64 m_lastServerCpu = 0;
+    qint64 m_lastClientCpu = 0;
+};
+
+LoadServer::LoadServer(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_repaintTimer(new QTimer(this))
+    , m_focusTimer(new QTimer(this))
+    , m_lagTimer(new QTimer(this))
+    , m_reportTimer(new QTimer(this))
+{
+    m_repaintTimer->setTimerType(Qt::PreciseTimer);
+    m_repaintTimer->setInterval(s_repaintInterval);
+    connect(m_repaintTimer, &QTimer::timeout, this, &LoadServer::repaint);
+    m_focusTimer->setInterval(s_focusInterval);
+    connect(m_focusTimer, &QTimer::timeout, this, &LoadServer::rotateFocus);
+    m_lagTimer->setTimerType(Qt::PreciseTimer);
+    m_lagTimer->setInterval(s_lagInterval);
+    connect(m_lagTimer, &QTimer::timeout, this, &LoadServer::measureLag);
+    m_reportTimer->setInterval(s_reportInterval);
+    connect(m_reportTimer, &QTimer::timeout, this, &LoadServer::report);
+}
+
+LoadServer::~LoadServer() = default;
+
+bool LoadServer::init()
+{
+    using namespace Server;
+    Q_ASSERT(!m_display);
+    m_display = new Display(this);
+    m_display->setSocketName(m_options.socketName);
+    m_display->start();
+    if (!m_display->isRunning()) {
+        qCritical() << "Could not create the socket" << m_options.socketName;
+        return false;
+    }
+    m_display->createShm();
+    m_display->createCompositor(m_display)->create();
+
+    m_seat = m_display->createSeat(m_display);
+    m_seat->setHasKeyboard(true);
+    m_seat->setHasPointer(true);
+    m_seat->setClipboardCacheMode(SeatInterface::ClipboardCacheMode::Eager);
+    m_seat->setClipboardCacheMimeTypes({QStringLiteral("text/plain")});
+    m_seat->create();
+    connect(m_seat, &SeatInterface::selectionChanged, this,
+        [this] (DataDeviceInterface *device) {
+            if (!device) {
+                return;
+            }
+            stats(device->client()).selections++;
+            m_intervalSelections++;
+        }
+    );
+    m_display->createDataDeviceManager(m_display)->create();
+
+    XdgShellInterface *xdgShell = m_display->createXdgShell(XdgShellInterfaceVersion::Stable, m_display);
+    xdgShell->create();
+    connect(xdgShell, &XdgShellInterface::surfaceCreated, this, &LoadServer::addWindow);
+
+    FakeInputInterface *fakeInput = m_display->createFakeInput(m_display);
+    fakeInput->create();
+    connect(fakeInput, &FakeInputInterface::deviceCreated, this,
+        [this] (FakeInputDevice *device) {
+            // all clients are trusted, there is nobody to ask
+            device->setAuthentication(true);
+            ClientConnection *client = m_display->getConnection(wl_resource_get_client(device->resource()));
+            connect(device, &FakeInputDevice::pointerMotionRequested, device,
+                [this, client] (const QSizeF &delta) {
+                    m_seat->setTimestamp(m_time.elapsed());
+                    m_seat->setPointerPos(m_seat->pointerPos() + QPointF(delta.width(), delta.height()));
+                    stats(client).inputEvents++;
+                    m_intervalInputEvents++;
+                }
+            );
+            connect(device, &FakeInputDevice::keyboardKeyPressRequested, device,
+                [this, client] (quint32 key) {
+                    m_seat->setTimestamp(m_time.elapsed());
+                    m_seat->keyPressed(key);
+                    stats(client).inputEvents++;
+                    m_intervalInputEvents++;
+                }
+            );
+            connect(device, &FakeInputDevice::keyboardKeyReleaseRequested, device,
+                [this, client] (quint32 key) {
+                    m_seat->setTimestamp(m_time.elapsed());
+                    m_seat->keyReleased(key);
+                    stats(client).inputEvents++;
+                    m_intervalInputEvents++;
+                }
+            );
+        }
+    );
+
+    connect(m_display, &Display::clientConnected, this,
+        [this] (ClientConnection *client) {
+            stats(client);
+        }
+    );
+    connect(m_display, &Display::clientDisconnected, this,
+        [this] (ClientConnection *client) {
+            auto it = m_clients.find(client);
+            if (it != m_clients.end()) {
+                m_disconnectedClients << it.value();
+                m_clients.erase(it);
+            }
+        }
+    );
+
+    m_time.start();
+    m_lastServerCpu = cpuTime(RUSAGE_THREAD);
+    m_lastClientCpu = cpuTime(RUSAGE_SELF) - m_lastServerCpu;
+    m_repaintTimer->start();
+    m_focusTimer->start();
+    m_lagTimer->start();
+    m_reportTimer->start();
+    QTimer::singleShot(m_options.duration * 1000, this, &LoadServer::stop);
+
+    startClients();
+    return true;
+}
+
+void LoadServer::startClients()
+{
+    if (m_options.processes <= 0) {
+        m_clientThread = new QThread(this);
+        ClientPool *pool = new ClientPool(m_options);
+        pool->moveToThread(m_clientThread);
+        connect(m_clientThread, &QThread::started, pool, &ClientPool::start);
+        connect(m_clientThread, &QThread::finished, pool, &QObject::deleteLater);
+        connect(pool, &ClientPool::finished, this, &LoadServer::clientsFinished);
+        m_clientThread->start();
+        return;
+    }
+    const int perProcess = (m_options.clients + m_options.processes - 1) / m_options.processes;
+    for (int first = 0; first < m_options.clients; first += perProcess) {
+        const QStringList arguments = {
+            QStringLiteral("--client-mode"),
+            QStringLiteral("--socket"), m_options.socketName,
+            QStringLiteral("--clients"), QString::number(qMin(perProcess, m_options.clients - first)),
+            QStringLiteral("--first-index"), QString::number(first),
+            QStringLiteral("--fps"), QString::number(m_options.fps),
+            QStringLiteral("--size"), QStringLiteral("%1x%2").arg(m_options.size.width()).arg(m_options.size.height()),
+            QStringLiteral("--input-rate"), QString::number(m_options.inputRate),
+            QStringLiteral("--clipboard-interval"), QString::number(m_options.clipboardInterval),
+            QStringLiteral("--churn-interval"), QString::number(m_options.churnInterval)
+        };
+        QProcess *process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this,
+            [this] {
+                if (--m_runningProcesses == 0) {
+                    clientsFinished();
+                }
+            }
+        );
+        process->start(QCoreApplication::applicationFilePath(), arguments);
+        m_processes << process;
+        m_runningProcesses++;
+    }
+}
+
+LoadServer::ClientStats &LoadServer::stats(Server::ClientConnection *client)
+{
+    auto it = m_clients.find(client);
+    if (it == m_clients.end()) {
+        it = m_clients.insert(client, ClientStats());
+        it->pid = client->processId();
+    }
+    return it.value();
+}
+
+void LoadServer::addWindow(Server::XdgShellSurfaceInterface *toplevel)
+{
+    using namespace Server;
+    m_toplevels << toplevel;
+    m_windows.insert(toplevel, Window());
+    stats(toplevel->surface()->client()).windows++;
+    connect(toplevel->surface(), &SurfaceInterface::committed, this,
+        [this, toplevel] {
+            frameCommitted(toplevel);
+        }
+    );
+    connect(toplevel, &QObject::destroyed, this,
+        [this, toplevel] {
+            m_toplevels.removeOne(toplevel);
+            m_windows.remove(toplevel);
+        }
+    );
+    toplevel->configure(XdgShellSurfaceInterface::States(), m_options.size);
+}
+
+void LoadServer::frameCommitted(Server::XdgShellSurfaceInterface *toplevel)
+{
+    auto it = m_windows.find(toplevel);
+    if (it == m_windows.end()) {
+        return;
+    }
+    Server::SurfaceInterface *surface = toplevel->surface();
+    Server::BufferInterface *buffer = surface ? surface->buffer() : nullptr;
+    if (!buffer) {
+        return;
+    }
+    qint64 timestamp = 0;
+    {
+        const QImage image = buffer->data();
+        if (image.isNull() || image.sizeInBytes() < qsizetype(sizeof(timestamp))) {
+            return;
+        }
+        std::memcpy(&timestamp, image.constBits(), sizeof(timestamp));
+    }
+    if (timestamp == it->lastTimestamp) {
+        // a commit without a new frame
+        return;
+    }
+    const qint64 latency = monotonicTime() - timestamp;
+    it->lastTimestamp = timestamp;
+    it->pendingFrames++;
+
+    ClientStats &clientStats = stats(surface->client());
+    clientStats.frames++;
+    clientStats.latencies << latency;
+    clientStats.maxQueueDepth = qMax(clientStats.maxQueueDepth, it->pendingFrames);
+    m_intervalLatencies << latency;
+    m_intervalFrames++;
+    m_intervalQueueDepth = qMax(m_intervalQueueDepth, it->pendingFrames);
+}
+
+void LoadServer::repaint()
+{
+    const quint32 time = m_time.elapsed();
+    for (auto it = m_windows.begin(); it != m_windows.end(); ++it) {
+        Server::SurfaceInterface *surface = it.key()->surface();
+        if (it->pendingFrames == 0 || !surface) {
+            continue;
+        }
+        surface->frameRendered(time);
+        it->pendingFrames = 0;
+    }
+}
+
+void LoadServer::rotateFocus()
+{
+    if (m_toplevels.isEmpty()) {
+        return;
+    }
+    m_focusIndex = (m_focusIndex + 1) % m_toplevels.count();
+    Server::SurfaceInterface *surface = m_toplevels.at(m_focusIndex)->surface();
+    if (!surface) {
+        return;
+    }
+    m_seat->setTimestamp(m_time.elapsed());
+    m_seat->setFocusedKeyboardSurface(surface);
+    m_seat->setFocusedPointerSurface(surface);
+}
+
+void LoadServer::measureLag()
+{
+    // how much later than requested the timer fired, i.e. how long the server was busy
+    const qint64 now = m_time.nsecsElapsed();
+    if (m_lastLagCheck != 0) {
+        m_loopLag << qMax<qint64>(0, now - m_lastLagCheck - qint64(s_lagInterval) * 1000000);
+    }
+    m_lastLagCheck = now;
+}
+
+void LoadServer::report()
+{
+    const qint64 now = m_time.nsecsElapsed();
+    const qint64 elapsed = qMax<qint64>(1, now - m_lastReport) / 1000;
+    const qint64 serverCpu = cpuTime(RUSAGE_THREAD);
+    qint64 clientCpu = 0;
+    if (m_processes.isEmpty()) {
+        clientCpu = cpuTime(RUSAGE_SELF) - serverCpu;
+    } else {
+        for (QProcess *process : qAsConst(m_processes)) {
+            clientCpu += processCpuTime(process->processId());
+        }
+    }
+    const qreal seconds = elapsed / 1000000.0;
+
+    qInfo().noquote() << QStringLiteral("%1 s: %2 clients, %3 windows, %4 frames/s, %5 input events/s, %6 selections/s, "
+                                        "latency ms p50 %7 p90 %8 p99 %9 max %10, queue depth %11, loop lag ms p99 %12, "
+                                        "cpu %13 % server %14 % clients")
+                         .arg(now / 1000000000)
+                         .arg(m_clients.count())
+                         .arg(m_toplevels.count())
+                         .arg(qRound(m_intervalFrames / seconds))
+                         .arg(qRound(m_intervalInputEvents / seconds))
+                         .arg(qRound(m_intervalSelections / seconds))
+                         .arg(milliseconds(percentile(m_intervalLatencies, 0.5)))
+                         .arg(milliseconds(percentile(m_intervalLatencies, 0.9)))
+                         .arg(milliseconds(percentile(m_intervalLatencies, 0.99)))
+                         .arg(milliseconds(percentile(m_intervalLatencies, 1)))
+                         .arg(m_intervalQueueDepth)
+                         .arg(milliseconds(percentile(m_loopLag, 0.99)))
+                         .arg(100.0 * (serverCpu - m_lastServerCpu) / elapsed, 0, 'f', 1)
+                         .arg(100.0 * (clientCpu - m_lastClientCpu) / elapsed, 0, 'f', 1);
+
+    m_lastReport = now;
+    m_lastServerCpu = serverCpu;
+    m_lastClientCpu = clientCpu;
+    m_intervalLatencies.clear();
+    m_intervalFrames = 0;
+    m_intervalInputEvents = 0;
+    m_intervalSelections = 0;
+    m_intervalQueueDepth = 0;
+    m_loopLag.clear();
+}
+
+void LoadServer::printFinalReport()
+{
+    QVector<ClientStats> clients = m_disconnectedClients + m_clients.values().toVector();
+    QVector<qint64> latencies;
+    QHash<qint64, int> clientsPerProcess;
+    for (const ClientStats &client : qAsConst(clients)) {
+        latencies << client.latencies;
+        clientsPerProcess[client.pid]++;
+    }
+    qInfo().noquote() << QStringLiteral("%1 clients, %2 frames, latency ms p50 %3 p90 %4 p99 %5 max %6")
+                         .arg(clients.count()).arg(latencies.count())
+                         .arg(milliseconds(percentile(latencies, 0.5)))
+                         .arg(milliseconds(percentile(latencies, 0.9)))
+                         .arg(milliseconds(percentile(latencies, 0.99)))
+                         .arg(milliseconds(percentile(latencies, 1)));
+
+    // the clients with the worst latency
+    for (ClientStats &client : clients) {
+        std::sort(client.latencies.begin(), client.latencies.end());
+    }
+    std::sort(clients.begin(), clients.end(),
+        [] (const ClientStats &a, const ClientStats &b) {
+            const qint64 aP99 = a.latencies.isEmpty() ? 0 : a.latencies.at(qMin(a.latencies.size() - 1, int(0.99 * a.latencies.size())));
+            const qint64 bP99 = b.latencies.isEmpty() ? 0 : b.latencies.at(qMin(b.latencies.size() - 1, int(0.99 * b.latencies.size())));
+            return aP99 > bP99;
+        }
+    );
+    const qint64 serverPid = QCoreApplication::applicationPid();
+    for (int i = 0; i < qMin(10, clients.count()); ++i) {
+        const ClientStats &client = clients.at(i);
+        // the time of a process is split evenly between its clients, in process clients share the server's
+        QString cpu = QStringLiteral("n/a");
+        if (client.pid != serverPid && clientsPerProcess.value(client.pid) > 0) {
+            cpu = QString::number(processCpuTime(client.pid) / 1000.0 / clientsPerProcess.value(client.pid), 'f', 1);
+        }
+        qInfo().noquote() << QStringLiteral("  client of pid %1: %2 frames, %3 input events, %4 selections, %5 windows, "
+                                            "latency ms p50 %6 p99 %7 max %8, queue depth %9, cpu ms %10")
+                             .arg(client.pid).arg(client.frames).arg(client.inputEvents).arg(client.selections).arg(client.windows)
+                             .arg(milliseconds(percentile(client.latencies, 0.5)))
+                             .arg(milliseconds(percentile(client.latencies, 0.99)))
+                             .arg(milliseconds(percentile(client.latencies, 1)))
+                             .arg(client.maxQueueDepth)
+                             .arg(cpu);
+    }
+}
+
+void LoadServer::stop()
+{
+    m_repaintTimer->stop();
+    m_focusTimer->stop();
+    m_lagTimer->stop();
+    m_reportTimer->stop();
+    report();
+    printFinalReport();
+
+    // the clients print their summary once they noticed the server is gone
+    m_toplevels.clear();
+    m_windows.clear();
+    m_seat = nullptr;
+    delete m_display;
+    m_display = nullptr;
+    if (!m_clientThread && m_processes.isEmpty()) {
+        QCoreApplication::quit();
+        return;
+    }
+    QTimer::singleShot(s_shutdownTimeout, this,
+        [this] {
+            qWarning() << "Clients did not finish in time";
+            for (QProcess *process : qAsConst(m_processes)) {
+                process->kill();
+            }
+            clientsFinished();
+        }
+    );
+}
+
+void LoadServer::clientsFinished()
+{
+    if (m_clientThread) {
+        m_clientThread->quit();
+        m_clientThread->wait();
+    }
+    QCoreApplication::quit();
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Generates synthetic load from many clients on a KWayland server"));
+    parser.addHelpOption();
+    QCommandLineOption clientsOption(QStringLiteral("clients"), QStringLiteral("Number of clients."), QStringLiteral("count"), QStringLiteral("100"));
+    QCommandLineOption processesOption(QStringLiteral("processes"),
+                                       QStringLiteral("Number of processes to fork for the clients, 0 runs them in a thread of the server."),
+                                       QStringLiteral("count"), QStringLiteral("0"));
+    QCommandLineOption fpsOption(QStringLiteral("fps"), QStringLiteral("Frames committed per second by each client."), QStringLiteral("rate"), QStringLiteral("60"));
+    QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("Size of the windows."), QStringLiteral("WxH"), QStringLiteral("64x64"));
+    QCommandLineOption inputRateOption(QStringLiteral("input-rate"), QStringLiteral("Fake input events per second sent by each client, 0 disables input."),
+                                       QStringLiteral("rate"), QStringLiteral("100"));
+    QCommandLineOption clipboardOption(QStringLiteral("clipboard-interval"), QStringLiteral("Interval in ms at which each client sets a selection, 0 disables it."),
+                                       QStringLiteral("ms"), QStringLiteral("1000"));
+    QCommandLineOption churnOption(QStringLiteral("churn-interval"), QStringLiteral("Interval in ms at which each client recreates its window, 0 disables it."),
+                                   QStringLiteral("ms"), QStringLiteral("5000"));
+    QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("Run time in seconds."), QStringLiteral("s"), QStringLiteral("10"));
+    QCommandLineOption socketOption(QStringLiteral("socket"), QStringLiteral("Name of the Wayland socket."), QStringLiteral("name"), QStringLiteral("kwayland-load-0"));
+    QCommandLineOption clientModeOption(QStringLiteral("client-mode"), QStringLiteral("Only run clients connecting to --socket, used for the forked processes."));
+    QCommandLineOption firstIndexOption(QStringLiteral("first-index"), QStringLiteral("Index of the first client in client mode."), QStringLiteral("index"), QStringLiteral("0"));
+    parser.addOptions({clientsOption, processesOption, fpsOption, sizeOption, inputRateOption, clipboardOption,
+                       churnOption, durationOption, socketOption, clientModeOption, firstIndexOption});
+    parser.process(app);
+
+    Options options;
+    options.clients = qMax(1, parser.value(clientsOption).toInt());
+    options.processes = qMax(0, parser.value(processesOption).toInt());
+    options.firstIndex = parser.value(firstIndexOption).toInt();
+    options.fps = qMax(1.0, parser.value(fpsOption).toDouble());
+    const QStringList size = parser.value(sizeOption).split(QLatin1Char('x'));
+    if (size.count() == 2 && size.at(0).toInt() > 0 && size.at(1).toInt() > 0) {
+        options.size = QSize(size.at(0).toInt(), size.at(1).toInt());
+    }
+    options.inputRate = qMax(0, parser.value(inputRateOption).toInt());
+    options.clipboardInterval = qMax(0, parser.value(clipboardOption).toInt());
+    options.churnInterval = qMax(0, parser.value(churnOption).toInt());
+    options.duration = qMax(1, parser.value(durationOption).toInt());
+    options.socketName = parser.value(socketOption);
+
+    if (parser.isSet(clientModeOption)) {
+        ClientPool pool(options);
+        QObject::connect(&pool, &ClientPool::finished, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+        pool.start();
+        return app.exec();
+    }
+
+    LoadServer server(options);
+    if (!server.init()) {
+        return 1;
+    }
+    return app.exec();
+}
+
+#include "loadgenerator.moc"